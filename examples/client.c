@@ -13,6 +13,14 @@
 #define GRID_WIDTH 4
 #define GRID_HEIGHT 4
 
+/* Command line options, see entries */
+static gboolean overlay = FALSE;
+static gboolean automatic = FALSE;
+static gchar *record_path = NULL;
+static gchar *replay_path = NULL;
+static gboolean replay_fast = FALSE;
+static gchar *telemetry_path = NULL;
+
 typedef struct Example
 {
   GMainLoop *loop;
@@ -25,8 +33,6 @@ typedef struct Example
   guint64 move_source;
   guint64 keyboard_source;
   guint64 quit_source;
-  guint render_source;
-  bool shutdown;
 
   GdkPixbuf *window_pixbuf;
   GdkPixbuf *child_window_pixbuf;
@@ -37,6 +43,9 @@ typedef struct Example
    * update function for each desktop window in a imer. */
   GSList *desktop_window_list;
   gint64 desktop_window_manager_update_loop;
+
+  XrdInputTrace *input_trace;
+  gint64 replay_start;
 } Example;
 
 
@@ -228,16 +237,8 @@ perform_switch (gpointer data)
   /* disconnect all event callbacks */
   _cleanup_client (self);
 
-  /* gulkan textures become invalid in a new client instance */
-  GSList *windows = xrd_client_get_windows (self->client);
-  for (GSList *l = windows; l != NULL; l = l->next)
-    {
-      XrdWindow *window = l->data;
-      WindowWrapper *native = NULL;
-      g_object_get (window, "native", &native, NULL);
-      g_clear_object (&native->gulkan_texture);
-    }
-
+  /* gulkan textures stay valid, the uploader is kept across the switch
+   * and the textures are transitioned to the new upload layout. */
   self->client = xrd_client_switch_mode (self->client);
 
   /* set up the example on the new client */
@@ -371,8 +372,8 @@ _init_windows (Example *self)
 static void
 _cleanup_client (Example *self)
 {
-  if (self->render_source != 0)
-    g_source_remove (self->render_source);
+  if (XRD_IS_SCENE_CLIENT (self->client))
+    xrd_scene_client_stop_render_loop (XRD_SCENE_CLIENT (self->client));
   g_signal_handler_disconnect (self->client, self->click_source);
   g_signal_handler_disconnect (self->client, self->move_source);
   g_signal_handler_disconnect (self->client, self->keyboard_source);
@@ -381,14 +382,11 @@ _cleanup_client (Example *self)
   self->move_source = 0;
   self->keyboard_source = 0;
   self->quit_source = 0;
-  self->render_source = 0;
 }
 
 static void
 _cleanup (Example *self)
 {
-  self->shutdown = true;
-
   _cleanup_client (self);
 
   GSList *windows = xrd_client_get_windows (self->client);
@@ -481,18 +479,6 @@ _request_quit_cb (XrdClient *client,
   }
 }
 
-static gboolean
-_iterate_cb (gpointer _self)
-{
-  Example *self = (Example*) _self;
-
-  if (self->shutdown)
-    return FALSE;
-
-  xrd_scene_client_render (XRD_SCENE_CLIENT (self->client));
-  return TRUE;
-}
-
 static gboolean
 _init_client (Example *self, XrdClient *client)
 {
@@ -512,9 +498,8 @@ _init_client (Example *self, XrdClient *client)
   self->quit_source = g_signal_connect (client, "request-quit-event",
                                         (GCallback) _request_quit_cb, self);
 
-  self->render_source = 0;
   if (XRD_IS_SCENE_CLIENT (client))
-    self->render_source = g_timeout_add (1, _iterate_cb, self);
+    xrd_scene_client_start_render_loop (XRD_SCENE_CLIENT (client));
 
   GulkanClient *gc = xrd_client_get_uploader (client);
   if (!_init_cursor (self, gc))
@@ -525,6 +510,45 @@ _init_client (Example *self, XrdClient *client)
   return TRUE;
 }
 
+static void
+_replay_finished_cb (XrdInputTrace *trace,
+                     Example       *self)
+{
+  gint64 elapsed = g_get_monotonic_time () - self->replay_start;
+  g_print ("Replayed %u input records of %.2fs in %.2fs\n",
+           xrd_input_trace_get_n_records (trace),
+           xrd_input_trace_get_duration (trace) / 1000000.0,
+           elapsed / 1000000.0);
+  g_main_loop_quit (self->loop);
+}
+
+static gboolean
+_init_input_trace (Example *self)
+{
+  self->input_trace = NULL;
+
+  if (replay_path)
+    {
+      self->input_trace = xrd_input_trace_new_from_file (replay_path);
+      if (!self->input_trace)
+        return FALSE;
+
+      g_signal_connect (self->input_trace, "finished-event",
+                        (GCallback) _replay_finished_cb, self);
+      self->replay_start = g_get_monotonic_time ();
+      xrd_client_replay_input_trace (self->client, self->input_trace,
+                                     !replay_fast);
+    }
+  else if (record_path)
+    {
+      self->input_trace = xrd_input_trace_new ();
+      xrd_client_set_input_trace (self->client, self->input_trace);
+      xrd_input_trace_start_recording (self->input_trace);
+    }
+
+  return TRUE;
+}
+
 static gboolean
 _init_example (Example *self, XrdClient *client)
 {
@@ -536,8 +560,6 @@ _init_example (Example *self, XrdClient *client)
     if (!xrd_scene_client_initialize (XRD_SCENE_CLIENT (client)))
       return FALSE;
 
-  self->shutdown = false;
-
   if (!_init_client (self, client))
     return FALSE;
 
@@ -549,12 +571,12 @@ _init_example (Example *self, XrdClient *client)
   self->desktop_window_manager_update_loop =
     g_timeout_add (16, _desktop_window_manager_update_loop_cb, self);
 
+  if (!_init_input_trace (self))
+    return FALSE;
+
   return TRUE;
 }
 
-static gboolean overlay = FALSE;
-static gboolean automatic = FALSE;
-
 static GOptionEntry entries[] =
 {
   { "overlay", 'o', 0, G_OPTION_ARG_NONE, &overlay,
@@ -562,6 +584,15 @@ static GOptionEntry entries[] =
   { "auto", 'a', 0, G_OPTION_ARG_NONE, &automatic,
       "Launch overlay client if another scene app is already running,\n"
       "else launch scene client.", NULL },
+  { "record", 'r', 0, G_OPTION_ARG_FILENAME, &record_path,
+      "Record controller input into a trace file.", "FILE" },
+  { "replay", 'p', 0, G_OPTION_ARG_FILENAME, &replay_path,
+      "Replay controller input from a trace file.", "FILE" },
+  { "replay-fast", 'f', 0, G_OPTION_ARG_NONE, &replay_fast,
+      "Replay the trace as fast as possible instead of in realtime.", NULL },
+  { "telemetry", 't', 0, G_OPTION_ARG_FILENAME, &telemetry_path,
+      "Measure input and render timings and write a Chrome trace.", "FILE" },
+  { NULL }
 };
 
 int
@@ -580,6 +611,9 @@ main (int argc, char *argv[])
     }
   g_option_context_free (context);
 
+  if (telemetry_path)
+    xrd_telemetry_set_enabled (TRUE);
+
   Example self = {
     .loop = g_main_loop_new (NULL, FALSE),
     .window_pixbuf = load_gdk_pixbuf ("/res/hawk.jpg"),
@@ -622,6 +656,34 @@ main (int argc, char *argv[])
   /* start glib main loop */
   g_main_loop_run (self.loop);
 
+  if (self.input_trace)
+    {
+      if (xrd_input_trace_is_recording (self.input_trace))
+        {
+          xrd_input_trace_stop_recording (self.input_trace);
+          if (xrd_input_trace_save (self.input_trace, record_path))
+            g_print ("Recorded %u input records to %s\n",
+                     xrd_input_trace_get_n_records (self.input_trace),
+                     record_path);
+        }
+      g_clear_object (&self.input_trace);
+    }
+
+  if (telemetry_path)
+    {
+      xrd_telemetry_print_summary ();
+      xrd_telemetry_write_chrome_trace (telemetry_path);
+
+      if (self.client != NULL && XRD_IS_SCENE_CLIENT (self.client))
+        {
+          guint64 recorded, reused;
+          xrd_scene_renderer_get_command_stats (
+            xrd_scene_renderer_get_instance (), &recorded, &reused);
+          g_print ("Frames recorded: %" G_GUINT64_FORMAT
+                   ", reused: %" G_GUINT64_FORMAT "\n", recorded, reused);
+        }
+    }
+
   /* don't clean up when quitting during switching */
   if (self.client != NULL)
     _cleanup (&self);
@@ -12,6 +12,9 @@
 
 static VkImageLayout upload_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 
+static gchar *log_path = NULL;
+static gchar *log_label = "click";
+
 typedef struct Example
 {
   GMainLoop *loop;
@@ -238,9 +241,10 @@ _init_windows (Example *self)
   self->tutorial_label =
     XRD_WINDOW (xrd_overlay_window_new_from_pixels ("Tutorial", 400, 256, 450));
 
+  gboolean drag = g_strcmp0 (log_label, "drag") == 0;
   gchar *tutorial_string[] = {
-    "Press A or B below",
-    "without shaking"
+    drag ? "Hold A or B and" : "Press A or B below",
+    drag ? "draw short lines" : "without shaking"
   };
   xrd_button_set_text (self->tutorial_label, gc,
                        upload_layout, 2, tutorial_string);
@@ -427,9 +431,39 @@ _request_quit_cb (XrdClient *client,
   g_main_loop_quit (self->loop);
 }
 
+static GOptionEntry entries[] =
+{
+  { "record", 'r', 0, G_OPTION_ARG_FILENAME, &log_path,
+      "Log all presses for tuning with shake-eval.", "FILE" },
+  { "label", 'l', 0, G_OPTION_ARG_STRING, &log_label,
+      "What the presses in the log are meant to be, click or drag.",
+      "LABEL" },
+  { NULL }
+};
+
 int
-main ()
+main (int argc, char *argv[])
 {
+  GError *error = NULL;
+  GOptionContext *context;
+
+  context = g_option_context_new ("- xrdesktop hand shake example.");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_print ("Wrong parameters: %s\n", error->message);
+      g_option_context_free (context);
+      exit (1);
+    }
+  g_option_context_free (context);
+
+  if (g_strcmp0 (log_label, "click") != 0 &&
+      g_strcmp0 (log_label, "drag") != 0)
+    {
+      g_print ("Label must be click or drag.\n");
+      exit (1);
+    }
+
   Example self = {
     .loop = g_main_loop_new (NULL, FALSE),
     .client = XRD_CLIENT (xrd_overlay_client_new ()),
@@ -439,6 +473,14 @@ main ()
 
   _init_windows (&self);
 
+  if (log_path)
+    {
+      XrdInputSynth *synth = xrd_client_get_input_synth (self.client);
+      if (!xrd_input_synth_open_shake_log (synth, log_path, log_label))
+        return 1;
+      g_print ("Logging %s presses to %s\n", log_label, log_path);
+    }
+
   self.click_source = g_signal_connect (self.client, "click-event",
                                         (GCallback) _click_cb, &self);
   self.move_source = g_signal_connect (self.client, "move-cursor-event",
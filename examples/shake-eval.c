@@ -0,0 +1,270 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Tunes the shake compensation offline. Record sessions with
+ *   hand-shake --record clicks.log --label click
+ *   hand-shake --record drags.log --label drag
+ * and run
+ *   shake-eval clicks.log drags.log
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "xrd.h"
+
+typedef struct {
+  gboolean is_drag;
+  GArray *samples;
+  gint64 release_us;
+} Press;
+
+typedef struct {
+  guint clicks;
+  guint false_drags;
+  guint drags;
+  guint missed_drags;
+  double mean_latency_ms;
+} Result;
+
+static double max_false_drags = 0.02;
+
+static GOptionEntry entries[] =
+{
+  { "max-false-drags", 'm', 0, G_OPTION_ARG_DOUBLE, &max_false_drags,
+      "Highest acceptable ratio of clicks taken for drags, default 0.02.",
+      "RATIO" },
+  { NULL }
+};
+
+static void
+_press_free (gpointer data)
+{
+  Press *press = data;
+  g_array_free (press->samples, TRUE);
+  g_free (press);
+}
+
+static gboolean
+_load_log (const gchar *path, GPtrArray *presses)
+{
+  gchar *contents;
+  GError *error = NULL;
+  if (!g_file_get_contents (path, &contents, NULL, &error))
+    {
+      g_printerr ("Could not read %s: %s\n", path, error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  gchar **lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+
+  if (!lines[0] || !g_str_has_prefix (lines[0], "xrdesktop-shake-log 1"))
+    {
+      g_printerr ("%s is not a shake log\n", path);
+      g_strfreev (lines);
+      return FALSE;
+    }
+
+  gboolean is_drag = FALSE;
+  Press *press = NULL;
+  for (gchar **line = lines + 1; *line; line++)
+    {
+      gchar **tokens = g_strsplit (*line, " ", -1);
+      guint n = g_strv_length (tokens);
+
+      if (n == 2 && g_strcmp0 (tokens[0], "label") == 0)
+        is_drag = g_strcmp0 (tokens[1], "drag") == 0;
+      else if (n == 2 && g_strcmp0 (tokens[0], "press") == 0)
+        {
+          if (press)
+            _press_free (press);
+          press = g_malloc (sizeof (Press));
+          press->is_drag = is_drag;
+          press->samples = g_array_new (FALSE, FALSE,
+                                        sizeof (XrdShakeSample));
+        }
+      else if (n == 6 && press && g_strcmp0 (tokens[0], "sample") == 0)
+        {
+          XrdShakeSample sample = {
+            .time_us = g_ascii_strtoll (tokens[1], NULL, 10),
+            .position = {
+              .x = (float) g_ascii_strtod (tokens[2], NULL),
+              .y = (float) g_ascii_strtod (tokens[3], NULL),
+            },
+            .ppm = (float) g_ascii_strtod (tokens[4], NULL),
+            .distance = (float) g_ascii_strtod (tokens[5], NULL),
+          };
+          g_array_append_val (press->samples, sample);
+        }
+      else if (n == 2 && press && g_strcmp0 (tokens[0], "release") == 0)
+        {
+          press->release_us = g_ascii_strtoll (tokens[1], NULL, 10);
+          g_ptr_array_add (presses, press);
+          press = NULL;
+        }
+
+      g_strfreev (tokens);
+    }
+
+  /* a press without release was cut off at the end of the session */
+  if (press)
+    _press_free (press);
+
+  g_strfreev (lines);
+  return TRUE;
+}
+
+static void
+_evaluate (XrdShakeCompensator  *compensator,
+           const XrdShakeParams *params,
+           GPtrArray            *presses,
+           Result               *result)
+{
+  memset (result, 0, sizeof (Result));
+  xrd_shake_compensator_set_params (compensator, params);
+
+  double latency_sum = 0;
+  for (guint i = 0; i < presses->len; i++)
+    {
+      Press *press = g_ptr_array_index (presses, i);
+
+      xrd_shake_compensator_start_recording (compensator, 1);
+      gint64 decided_us = -1;
+      for (guint j = 0; j < press->samples->len && decided_us < 0; j++)
+        {
+          XrdShakeSample *sample =
+            &g_array_index (press->samples, XrdShakeSample, j);
+          if (xrd_shake_compensator_add_sample (compensator, sample) ==
+              XRD_SHAKE_DECISION_DRAG)
+            decided_us = sample->time_us;
+        }
+      xrd_shake_compensator_reset (compensator);
+
+      if (press->is_drag)
+        {
+          result->drags++;
+          /* undecided drags are only dragged after the release */
+          if (decided_us < 0)
+            {
+              result->missed_drags++;
+              decided_us = press->release_us;
+            }
+          latency_sum += (double) decided_us / 1000.0;
+        }
+      else
+        {
+          result->clicks++;
+          if (decided_us >= 0)
+            result->false_drags++;
+        }
+    }
+
+  if (result->drags > 0)
+    result->mean_latency_ms = latency_sum / result->drags;
+}
+
+static void
+_print (const gchar *name, const XrdShakeParams *params, Result *result)
+{
+  g_print ("%s: threshold %.1f%%, duration %d ms, consistency %.2f, "
+           "min samples %d\n", name, params->threshold_percent,
+           params->duration_ms, params->consistency, params->min_samples);
+  g_print ("  %u/%u clicks taken for drags, %u/%u drags undecided until "
+           "release, mean drag decision after %.1f ms\n",
+           result->false_drags, result->clicks, result->missed_drags,
+           result->drags, result->mean_latency_ms);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+
+  context = g_option_context_new ("LOG... - tune the shake compensation.");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error) || argc < 2)
+    {
+      g_print ("Wrong parameters: %s\n",
+               error ? error->message : "no log files given");
+      g_option_context_free (context);
+      exit (1);
+    }
+  g_option_context_free (context);
+
+  GPtrArray *presses = g_ptr_array_new_with_free_func (_press_free);
+  for (int i = 1; i < argc; i++)
+    if (!_load_log (argv[i], presses))
+      exit (1);
+
+  XrdShakeCompensator *compensator = xrd_shake_compensator_new ();
+
+  XrdShakeParams current;
+  xrd_shake_compensator_get_params (compensator, &current);
+  Result result;
+  _evaluate (compensator, &current, presses, &result);
+  _print ("Current settings", &current, &result);
+
+  const double thresholds[] = { 0.5, 1.0, 1.5, 2.0, 2.5, 3.0, 4.0, 5.0 };
+  const int durations[] = { 120, 150, 180, 220, 260, 300 };
+  /* above 1 disables early decisions */
+  const double consistencies[] = { 0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 1.1 };
+  const int min_samples[] = { 2, 3, 5 };
+
+  XrdShakeParams best = current;
+  Result best_result = result;
+  gboolean found = FALSE;
+
+  for (guint t = 0; t < G_N_ELEMENTS (thresholds); t++)
+    for (guint d = 0; d < G_N_ELEMENTS (durations); d++)
+      for (guint c = 0; c < G_N_ELEMENTS (consistencies); c++)
+        for (guint m = 0; m < G_N_ELEMENTS (min_samples); m++)
+          {
+            XrdShakeParams params = {
+              .threshold_percent = thresholds[t],
+              .duration_ms = durations[d],
+              .consistency = consistencies[c],
+              .min_samples = min_samples[m],
+            };
+            _evaluate (compensator, &params, presses, &result);
+
+            if (result.clicks > 0 &&
+                (double) result.false_drags / result.clicks > max_false_drags)
+              continue;
+
+            if (!found || result.mean_latency_ms < best_result.mean_latency_ms)
+              {
+                best = params;
+                best_result = result;
+                found = TRUE;
+              }
+          }
+
+  if (!found)
+    {
+      g_print ("No parameters keep false drags below %.1f%%\n",
+               max_false_drags * 100.0);
+      exit (1);
+    }
+
+  _print ("Best", &best, &best_result);
+  g_print ("\ngsettings set org.xrdesktop shake-compensation-threshold %.1f\n"
+           "gsettings set org.xrdesktop shake-compensation-duration-ms %d\n"
+           "gsettings set org.xrdesktop shake-compensation-consistency %.2f\n"
+           "gsettings set org.xrdesktop shake-compensation-min-samples %d\n",
+           best.threshold_percent, best.duration_ms, best.consistency,
+           best.min_samples);
+
+  g_object_unref (compensator);
+  g_ptr_array_free (presses, TRUE);
+  return 0;
+}
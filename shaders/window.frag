@@ -12,6 +12,11 @@
 const float shininess = 16.0f;
 const float ambient = 0.5f;
 
+// Set per pipeline, so the unlit path compiles to a plain texture lookup
+layout (constant_id = 0) const bool receive_light = false;
+layout (constant_id = 1) const int max_window_lights = 8;
+layout (constant_id = 2) const bool flip_y = false;
+
 layout (location = 0) in vec4 world_position;
 layout (location = 1) in vec4 view_position;
 layout (location = 2) in vec2 uv;
@@ -27,6 +32,11 @@ layout (binding = 1) uniform sampler2D image;
 layout (binding = 2) uniform Window {
   vec4 color;
   bool flip_y;
+  int light_count;
+  // Indices into lights, culled per window on the CPU
+  ivec4 light_indices[2];
+  // Region of the texture the window shows, xy is the offset, zw the size
+  vec4 uv_rect;
 } window;
 
 struct Light {
@@ -38,7 +48,8 @@ struct Light {
 
 layout (std430, binding = 3) uniform Lights
 {
-  Light lights[2];
+  // One per controller pointer tip
+  Light lights[64];
   int active_lights;
 } lights;
 
@@ -59,10 +70,11 @@ vec3 lighten (vec3 a, vec3 b)
 
 void main ()
 {
-  vec2 uv_b = window.flip_y ? vec2 (uv.x, 1.0f - uv.y) : uv;
+  vec2 uv_b = flip_y ? vec2 (uv.x, 1.0f - uv.y) : uv;
+  uv_b = window.uv_rect.xy + uv_b * window.uv_rect.zw;
   vec4 texture_color = texture (image, uv_b);
 
-  if (!transformation.receive_light)
+  if (!receive_light)
     {
       out_color = texture_color * window.color;
       return;
@@ -74,15 +86,20 @@ void main ()
 
   float view_distance = length (view_position.xyz);
 
-  for (int i = 0; i < lights.active_lights; i++)
+  for (int i = 0; i < max_window_lights; i++)
     {
-      vec3 L = lights.lights[i].position.xyz - world_position.xyz;
+      if (i >= window.light_count)
+        break;
+
+      Light light = lights.lights[window.light_indices[i / 4][i % 4]];
+
+      vec3 L = light.position.xyz - world_position.xyz;
       float d = length (L);
 
-      float radius = lights.lights[i].radius * view_distance;
+      float radius = light.radius * view_distance;
 
       float atten = intensity / ((d / radius) + 1.0);
-      vec3 light_gradient = mix (lights.lights[i].color.xyz,
+      vec3 light_gradient = mix (light.color.xyz,
                                  light_color_max,
                                  atten * 0.5f);
       lit += light_gradient * diffuse.rgb * atten;
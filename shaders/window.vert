@@ -15,6 +15,8 @@ layout (binding = 0) uniform Transformation {
   bool receive_light;
 } transformation;
 
+layout (constant_id = 0) const bool receive_light = false;
+
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec2 uv;
 
@@ -32,7 +34,7 @@ void main() {
   gl_Position.y = -gl_Position.y;
   out_uv = uv;
 
-  if (!transformation.receive_light)
+  if (!receive_light)
     return;
 
   out_world_position = transformation.m * vec4 (position, 1.0f);
@@ -0,0 +1,157 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-headless-client.h"
+
+#include "xrd-headless-pointer.h"
+#include "xrd-headless-pointer-tip.h"
+#include "xrd-telemetry.h"
+#include "xrd-window-manager.h"
+
+struct _XrdHeadlessClient
+{
+  XrdClient parent;
+
+  XrdHeadlessRuntime *runtime;
+
+  /* NULL without rendering */
+  XrdSceneRenderer *renderer;
+};
+
+G_DEFINE_TYPE (XrdHeadlessClient, xrd_headless_client, XRD_TYPE_CLIENT)
+
+static void
+xrd_headless_client_dispose (GObject *gobject);
+
+static void
+xrd_headless_client_finalize (GObject *gobject);
+
+static void
+xrd_headless_client_init (XrdHeadlessClient *self)
+{
+  xrd_client_set_upload_layout (XRD_CLIENT (self),
+                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  self->runtime = NULL;
+  self->renderer = NULL;
+}
+
+/**
+ * xrd_headless_client_new:
+ * @runtime: The #XrdHeadlessRuntime that simulates the controllers.
+ * @renderer: (nullable): An initialized #XrdSceneRenderer to create
+ * #XrdSceneWindow<!-- -->s for, or %NULL to create #XrdHeadlessWindow<!-- -->s.
+ *
+ * Creates a client that takes its input from @runtime instead of OpenVR,
+ * through the same action callbacks as the scene and overlay clients.
+ * It does not synthesize input and can not switch modes.
+ *
+ * Returns: A new #XrdHeadlessClient.
+ */
+XrdHeadlessClient *
+xrd_headless_client_new (XrdHeadlessRuntime *runtime,
+                         XrdSceneRenderer   *renderer)
+{
+  XrdHeadlessClient *self =
+    (XrdHeadlessClient*) g_object_new (XRD_TYPE_HEADLESS_CLIENT, 0);
+
+  self->runtime = g_object_ref (runtime);
+  if (renderer)
+    self->renderer = g_object_ref (renderer);
+
+  xrd_client_connect_headless_runtime (XRD_CLIENT (self), runtime);
+
+  return self;
+}
+
+static void
+xrd_headless_client_dispose (GObject *gobject)
+{
+  XrdHeadlessClient *self = XRD_HEADLESS_CLIENT (gobject);
+
+  if (self->runtime)
+    g_signal_handlers_disconnect_by_data (self->runtime, self);
+  g_clear_object (&self->runtime);
+
+  G_OBJECT_CLASS (xrd_headless_client_parent_class)->dispose (gobject);
+}
+
+static void
+xrd_headless_client_finalize (GObject *gobject)
+{
+  XrdHeadlessClient *self = XRD_HEADLESS_CLIENT (gobject);
+
+  G_OBJECT_CLASS (xrd_headless_client_parent_class)->finalize (gobject);
+
+  /* Windows are freed with the client, before the device */
+  g_clear_object (&self->renderer);
+}
+
+/**
+ * xrd_headless_client_get_runtime:
+ * @self: The #XrdHeadlessClient
+ *
+ * Returns: (transfer none): The #XrdHeadlessRuntime input comes from.
+ */
+XrdHeadlessRuntime *
+xrd_headless_client_get_runtime (XrdHeadlessClient *self)
+{
+  return self->runtime;
+}
+
+/**
+ * xrd_headless_client_step:
+ * @self: The #XrdHeadlessClient
+ *
+ * Simulates one input poll like xrd_client_poll_input_events() does it:
+ * steps the runtime by one frame and lets the window manager handle the
+ * resulting window events, moving each window only once.
+ */
+void
+xrd_headless_client_step (XrdHeadlessClient *self)
+{
+  XrdWindowManager *manager = xrd_client_get_manager (XRD_CLIENT (self));
+
+  gint64 telemetry_start = xrd_telemetry_begin ();
+
+  xrd_window_begin_transform_batch ();
+  xrd_headless_runtime_step (self->runtime);
+  xrd_window_manager_poll_window_events (manager);
+  xrd_window_end_transform_batch ();
+
+  xrd_telemetry_end (XRD_TELEMETRY_POLL_INPUT, telemetry_start);
+}
+
+static GulkanClient *
+_get_uploader (XrdClient *client)
+{
+  XrdHeadlessClient *self = XRD_HEADLESS_CLIENT (client);
+  return self->renderer ? GULKAN_CLIENT (self->renderer) : NULL;
+}
+
+static void
+_init_controller (XrdClient     *client,
+                  XrdController *controller)
+{
+  (void) client;
+  xrd_controller_set_pointer (controller,
+                              XRD_POINTER (xrd_headless_pointer_new ()));
+  xrd_controller_set_pointer_tip (
+    controller, XRD_POINTER_TIP (xrd_headless_pointer_tip_new ()));
+}
+
+static void
+xrd_headless_client_class_init (XrdHeadlessClientClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = xrd_headless_client_dispose;
+  object_class->finalize = xrd_headless_client_finalize;
+
+  XrdClientClass *xrd_client_class = XRD_CLIENT_CLASS (klass);
+  xrd_client_class->get_uploader = _get_uploader;
+  xrd_client_class->init_controller = _init_controller;
+}
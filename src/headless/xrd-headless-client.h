@@ -0,0 +1,39 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_HEADLESS_CLIENT_H_
+#define XRD_HEADLESS_CLIENT_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+
+#include "xrd-client.h"
+#include "xrd-headless-runtime.h"
+#include "xrd-scene-renderer.h"
+
+G_BEGIN_DECLS
+
+#define XRD_TYPE_HEADLESS_CLIENT xrd_headless_client_get_type()
+G_DECLARE_FINAL_TYPE (XrdHeadlessClient, xrd_headless_client,
+                      XRD, HEADLESS_CLIENT, XrdClient)
+
+XrdHeadlessClient *
+xrd_headless_client_new (XrdHeadlessRuntime *runtime,
+                         XrdSceneRenderer   *renderer);
+
+XrdHeadlessRuntime *
+xrd_headless_client_get_runtime (XrdHeadlessClient *self);
+
+void
+xrd_headless_client_step (XrdHeadlessClient *self);
+
+G_END_DECLS
+
+#endif /* XRD_HEADLESS_CLIENT_H_ */
@@ -0,0 +1,134 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-headless-pointer-tip.h"
+
+struct _XrdHeadlessPointerTip
+{
+  GObject parent;
+
+  graphene_matrix_t transform;
+
+  XrdPointerTipData data;
+};
+
+static void
+xrd_headless_pointer_tip_interface_init (XrdPointerTipInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (XrdHeadlessPointerTip, xrd_headless_pointer_tip,
+                         G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (XRD_TYPE_POINTER_TIP,
+                                                xrd_headless_pointer_tip_interface_init))
+
+static void
+xrd_headless_pointer_tip_class_init (XrdHeadlessPointerTipClass *klass)
+{
+  (void) klass;
+}
+
+/* Without a texture the tip has no active style to render and without
+ * keep_apparent_size it never asks the runtime for the HMD pose. */
+static void
+xrd_headless_pointer_tip_init (XrdHeadlessPointerTip *self)
+{
+  graphene_matrix_init_identity (&self->transform);
+
+  self->data.tip = XRD_POINTER_TIP (self);
+  self->data.active = FALSE;
+  self->data.texture = NULL;
+  self->data.animation = NULL;
+  self->data.settings.keep_apparent_size = FALSE;
+  self->data.settings.width_meters = 0.05f;
+}
+
+/**
+ * xrd_headless_pointer_tip_new:
+ *
+ * Creates a pointer tip that is not rendered anywhere, for the
+ * #XrdHeadlessClient.
+ *
+ * Returns: A new #XrdHeadlessPointerTip.
+ */
+XrdHeadlessPointerTip *
+xrd_headless_pointer_tip_new (void)
+{
+  return (XrdHeadlessPointerTip*) g_object_new (XRD_TYPE_HEADLESS_POINTER_TIP,
+                                                0);
+}
+
+static void
+_set_transformation (XrdPointerTip     *tip,
+                     graphene_matrix_t *matrix)
+{
+  XrdHeadlessPointerTip *self = XRD_HEADLESS_POINTER_TIP (tip);
+  graphene_matrix_init_from_matrix (&self->transform, matrix);
+}
+
+static void
+_get_transformation (XrdPointerTip     *tip,
+                     graphene_matrix_t *matrix)
+{
+  XrdHeadlessPointerTip *self = XRD_HEADLESS_POINTER_TIP (tip);
+  graphene_matrix_init_from_matrix (matrix, &self->transform);
+}
+
+static void
+_show (XrdPointerTip *tip)
+{
+  (void) tip;
+}
+
+static void
+_hide (XrdPointerTip *tip)
+{
+  (void) tip;
+}
+
+static void
+_set_width_meters (XrdPointerTip *tip,
+                   float          meters)
+{
+  XrdHeadlessPointerTip *self = XRD_HEADLESS_POINTER_TIP (tip);
+  self->data.settings.width_meters = meters;
+}
+
+static void
+_submit_texture (XrdPointerTip *tip,
+                 GulkanClient  *client,
+                 GulkanTexture *texture)
+{
+  (void) tip;
+  (void) client;
+  (void) texture;
+}
+
+static XrdPointerTipData*
+_get_data (XrdPointerTip *tip)
+{
+  XrdHeadlessPointerTip *self = XRD_HEADLESS_POINTER_TIP (tip);
+  return &self->data;
+}
+
+static GulkanClient*
+_get_gulkan_client (XrdPointerTip *tip)
+{
+  (void) tip;
+  return NULL;
+}
+
+static void
+xrd_headless_pointer_tip_interface_init (XrdPointerTipInterface *iface)
+{
+  iface->set_transformation = _set_transformation;
+  iface->get_transformation = _get_transformation;
+  iface->show = _show;
+  iface->hide = _hide;
+  iface->set_width_meters = _set_width_meters;
+  iface->submit_texture = _submit_texture;
+  iface->get_data = _get_data;
+  iface->get_gulkan_client = _get_gulkan_client;
+}
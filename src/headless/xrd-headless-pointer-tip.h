@@ -0,0 +1,30 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_HEADLESS_POINTER_TIP_H_
+#define XRD_HEADLESS_POINTER_TIP_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+
+#include "xrd-pointer-tip.h"
+
+G_BEGIN_DECLS
+
+#define XRD_TYPE_HEADLESS_POINTER_TIP xrd_headless_pointer_tip_get_type()
+G_DECLARE_FINAL_TYPE (XrdHeadlessPointerTip, xrd_headless_pointer_tip,
+                      XRD, HEADLESS_POINTER_TIP, GObject)
+
+XrdHeadlessPointerTip *
+xrd_headless_pointer_tip_new (void);
+
+G_END_DECLS
+
+#endif /* XRD_HEADLESS_POINTER_TIP_H_ */
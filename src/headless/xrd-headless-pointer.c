@@ -0,0 +1,137 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-headless-pointer.h"
+
+struct _XrdHeadlessPointer
+{
+  GObject parent;
+
+  graphene_matrix_t transform;
+  XrdWindow *selected_window;
+
+  XrdPointerData data;
+};
+
+static void
+xrd_headless_pointer_pointer_interface_init (XrdPointerInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (XrdHeadlessPointer, xrd_headless_pointer, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (XRD_TYPE_POINTER,
+                                                xrd_headless_pointer_pointer_interface_init))
+
+static void
+xrd_headless_pointer_class_init (XrdHeadlessPointerClass *klass)
+{
+  (void) klass;
+}
+
+static void
+xrd_headless_pointer_init (XrdHeadlessPointer *self)
+{
+  graphene_matrix_init_identity (&self->transform);
+  self->selected_window = NULL;
+  xrd_pointer_init (XRD_POINTER (self));
+}
+
+/**
+ * xrd_headless_pointer_new:
+ *
+ * Creates a pointer ray that is not rendered anywhere, for driving
+ * hover and drag tests without an XR runtime.
+ *
+ * Returns: A new #XrdHeadlessPointer.
+ */
+XrdHeadlessPointer *
+xrd_headless_pointer_new (void)
+{
+  return (XrdHeadlessPointer*) g_object_new (XRD_TYPE_HEADLESS_POINTER, 0);
+}
+
+/**
+ * xrd_headless_pointer_get_selected_window:
+ * @self: The #XrdHeadlessPointer
+ *
+ * Returns: (transfer none): The window last reported as selected, or %NULL.
+ */
+XrdWindow *
+xrd_headless_pointer_get_selected_window (XrdHeadlessPointer *self)
+{
+  return self->selected_window;
+}
+
+static void
+_move (XrdPointer        *pointer,
+       graphene_matrix_t *transform)
+{
+  XrdHeadlessPointer *self = XRD_HEADLESS_POINTER (pointer);
+  graphene_matrix_init_from_matrix (&self->transform, transform);
+}
+
+static void
+_set_length (XrdPointer *pointer,
+             float       length)
+{
+  (void) pointer;
+  (void) length;
+}
+
+static XrdPointerData*
+_get_data (XrdPointer *pointer)
+{
+  XrdHeadlessPointer *self = XRD_HEADLESS_POINTER (pointer);
+  return &self->data;
+}
+
+static void
+_set_transformation (XrdPointer        *pointer,
+                     graphene_matrix_t *matrix)
+{
+  XrdHeadlessPointer *self = XRD_HEADLESS_POINTER (pointer);
+  graphene_matrix_init_from_matrix (&self->transform, matrix);
+}
+
+static void
+_get_transformation (XrdPointer        *pointer,
+                     graphene_matrix_t *matrix)
+{
+  XrdHeadlessPointer *self = XRD_HEADLESS_POINTER (pointer);
+  graphene_matrix_init_from_matrix (matrix, &self->transform);
+}
+
+static void
+_set_selected_window (XrdPointer *pointer,
+                      XrdWindow  *window)
+{
+  XrdHeadlessPointer *self = XRD_HEADLESS_POINTER (pointer);
+  self->selected_window = window;
+}
+
+static void
+_show (XrdPointer *pointer)
+{
+  (void) pointer;
+}
+
+static void
+_hide (XrdPointer *pointer)
+{
+  (void) pointer;
+}
+
+static void
+xrd_headless_pointer_pointer_interface_init (XrdPointerInterface *iface)
+{
+  iface->move = _move;
+  iface->set_length = _set_length;
+  iface->get_data = _get_data;
+  iface->set_transformation = _set_transformation;
+  iface->get_transformation = _get_transformation;
+  iface->set_selected_window = _set_selected_window;
+  iface->show = _show;
+  iface->hide = _hide;
+}
@@ -0,0 +1,33 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_HEADLESS_POINTER_H_
+#define XRD_HEADLESS_POINTER_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+
+#include "xrd-pointer.h"
+
+G_BEGIN_DECLS
+
+#define XRD_TYPE_HEADLESS_POINTER xrd_headless_pointer_get_type()
+G_DECLARE_FINAL_TYPE (XrdHeadlessPointer, xrd_headless_pointer,
+                      XRD, HEADLESS_POINTER, GObject)
+
+XrdHeadlessPointer *
+xrd_headless_pointer_new (void);
+
+XrdWindow *
+xrd_headless_pointer_get_selected_window (XrdHeadlessPointer *self);
+
+G_END_DECLS
+
+#endif /* XRD_HEADLESS_POINTER_H_ */
@@ -0,0 +1,328 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-headless-runtime.h"
+
+#include <math.h>
+#include <gdk/gdk.h>
+
+enum {
+  DEVICE_ACTIVATE_EVENT,
+  DEVICE_DEACTIVATE_EVENT,
+  POSE_EVENT,
+  DIGITAL_EVENT,
+  LAST_SIGNAL
+};
+
+static guint runtime_signals[LAST_SIGNAL] = { 0 };
+
+typedef struct {
+  guint64 frame;
+  guint64 controller_handle;
+  GQuark action;
+  gboolean state;
+} XrdHeadlessDigitalAction;
+
+struct _XrdHeadlessRuntime
+{
+  GObject parent;
+
+  guint64 frame;
+
+  graphene_matrix_t hmd_pose;
+
+  /* controller handle -> last digital state per action, connected if set */
+  GHashTable *controllers;
+
+  /* XrdHeadlessDigitalAction, sorted by frame */
+  GQueue *digital_actions;
+
+  XrdHeadlessPoseFunc pose_func;
+  gpointer pose_func_data;
+};
+
+G_DEFINE_TYPE (XrdHeadlessRuntime, xrd_headless_runtime, G_TYPE_OBJECT)
+
+static void
+xrd_headless_runtime_finalize (GObject *gobject);
+
+static void
+xrd_headless_runtime_class_init (XrdHeadlessRuntimeClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = xrd_headless_runtime_finalize;
+
+  runtime_signals[DEVICE_ACTIVATE_EVENT] =
+    g_signal_new ("device-activate-event",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL, G_TYPE_NONE,
+                  1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+  runtime_signals[DEVICE_DEACTIVATE_EVENT] =
+    g_signal_new ("device-deactivate-event",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL, G_TYPE_NONE,
+                  1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+  runtime_signals[POSE_EVENT] =
+    g_signal_new ("pose-event",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL, G_TYPE_NONE,
+                  1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+  runtime_signals[DIGITAL_EVENT] =
+    g_signal_new ("digital-event",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED,
+                  0, NULL, NULL, NULL, G_TYPE_NONE,
+                  1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
+}
+
+/* Controllers sweep their ray left/right and up/down in front of the user,
+ * offset by handle so multiple controllers don't overlap. */
+static void
+_default_pose_func (guint64            controller_handle,
+                    guint64            frame,
+                    graphene_matrix_t *pose,
+                    gpointer           user_data)
+{
+  (void) user_data;
+
+  float t = (float) frame / 90.f;
+  float side = (controller_handle % 2) ? 1.f : -1.f;
+
+  graphene_point3d_t position = {
+    .x = side * 0.2f,
+    .y = 1.0f,
+    .z = -0.3f
+  };
+
+  graphene_matrix_init_identity (pose);
+  graphene_matrix_rotate_x (pose, 15.f * sinf (t * 0.7f));
+  graphene_matrix_rotate_y (pose, 30.f * sinf (t + side));
+  graphene_matrix_translate (pose, &position);
+}
+
+static void
+xrd_headless_runtime_init (XrdHeadlessRuntime *self)
+{
+  self->frame = 0;
+
+  graphene_point3d_t head = { .x = 0.f, .y = 1.2f, .z = 0.f };
+  graphene_matrix_init_translate (&self->hmd_pose, &head);
+
+  self->controllers =
+    g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free,
+                           (GDestroyNotify) g_hash_table_unref);
+  self->digital_actions = g_queue_new ();
+
+  self->pose_func = _default_pose_func;
+  self->pose_func_data = NULL;
+}
+
+/**
+ * xrd_headless_runtime_new:
+ *
+ * Creates a simulated XR runtime. It does not talk to OpenVR, but emits
+ * pose, digital action and device events with the same payloads as gxr does,
+ * driven by xrd_headless_runtime_step().
+ * Every step corresponds to one frame of a null compositor.
+ *
+ * Returns: A new #XrdHeadlessRuntime.
+ */
+XrdHeadlessRuntime *
+xrd_headless_runtime_new (void)
+{
+  return (XrdHeadlessRuntime*) g_object_new (XRD_TYPE_HEADLESS_RUNTIME, 0);
+}
+
+static void
+xrd_headless_runtime_finalize (GObject *gobject)
+{
+  XrdHeadlessRuntime *self = XRD_HEADLESS_RUNTIME (gobject);
+  g_hash_table_unref (self->controllers);
+  g_queue_free_full (self->digital_actions, g_free);
+  G_OBJECT_CLASS (xrd_headless_runtime_parent_class)->finalize (gobject);
+}
+
+/**
+ * xrd_headless_runtime_set_pose_func:
+ * @self: The #XrdHeadlessRuntime
+ * @func: (nullable): The pose script, %NULL restores the default sweep.
+ * @user_data: Passed to @func.
+ */
+void
+xrd_headless_runtime_set_pose_func (XrdHeadlessRuntime  *self,
+                                    XrdHeadlessPoseFunc  func,
+                                    gpointer             user_data)
+{
+  self->pose_func = func ? func : _default_pose_func;
+  self->pose_func_data = user_data;
+}
+
+void
+xrd_headless_runtime_set_hmd_pose (XrdHeadlessRuntime *self,
+                                   graphene_matrix_t  *pose)
+{
+  graphene_matrix_init_from_matrix (&self->hmd_pose, pose);
+}
+
+void
+xrd_headless_runtime_get_hmd_pose (XrdHeadlessRuntime *self,
+                                   graphene_matrix_t  *pose)
+{
+  graphene_matrix_init_from_matrix (pose, &self->hmd_pose);
+}
+
+void
+xrd_headless_runtime_connect_controller (XrdHeadlessRuntime *self,
+                                         guint64             controller_handle)
+{
+  if (g_hash_table_contains (self->controllers, &controller_handle))
+    return;
+
+  guint64 *key = g_malloc (sizeof (guint64));
+  *key = controller_handle;
+  g_hash_table_insert (self->controllers, key,
+                       g_hash_table_new (g_direct_hash, g_direct_equal));
+
+  OpenVRDeviceIndexEvent *event = g_malloc0 (sizeof (OpenVRDeviceIndexEvent));
+  event->controller_handle = controller_handle;
+  g_signal_emit (self, runtime_signals[DEVICE_ACTIVATE_EVENT], 0, event);
+}
+
+void
+xrd_headless_runtime_disconnect_controller (XrdHeadlessRuntime *self,
+                                            guint64             controller_handle)
+{
+  if (!g_hash_table_remove (self->controllers, &controller_handle))
+    return;
+
+  OpenVRDeviceIndexEvent *event = g_malloc0 (sizeof (OpenVRDeviceIndexEvent));
+  event->controller_handle = controller_handle;
+  g_signal_emit (self, runtime_signals[DEVICE_DEACTIVATE_EVENT], 0, event);
+}
+
+static gint
+_compare_handle (gconstpointer a, gconstpointer b)
+{
+  guint64 handle_a = *(const guint64 *) a;
+  guint64 handle_b = *(const guint64 *) b;
+  if (handle_a < handle_b)
+    return -1;
+  return handle_a > handle_b ? 1 : 0;
+}
+
+static gint
+_compare_frame (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  (void) user_data;
+  const XrdHeadlessDigitalAction *action_a = a;
+  const XrdHeadlessDigitalAction *action_b = b;
+  if (action_a->frame < action_b->frame)
+    return -1;
+  return action_a->frame > action_b->frame ? 1 : 0;
+}
+
+/**
+ * xrd_headless_runtime_queue_digital:
+ * @self: The #XrdHeadlessRuntime
+ * @frame: The frame in which the action state changes.
+ * @controller_handle: The controller the action is on.
+ * @action: The action name, used as detail of the "digital-event" signal.
+ * @state: The new button state.
+ */
+void
+xrd_headless_runtime_queue_digital (XrdHeadlessRuntime *self,
+                                    guint64             frame,
+                                    guint64             controller_handle,
+                                    const gchar        *action,
+                                    gboolean            state)
+{
+  XrdHeadlessDigitalAction *digital = g_malloc (sizeof (XrdHeadlessDigitalAction));
+  digital->frame = frame;
+  digital->controller_handle = controller_handle;
+  digital->action = g_quark_from_string (action);
+  digital->state = state;
+
+  g_queue_insert_sorted (self->digital_actions, digital, _compare_frame, NULL);
+}
+
+static void
+_emit_digital_actions (XrdHeadlessRuntime *self)
+{
+  XrdHeadlessDigitalAction *digital;
+  while ((digital = g_queue_peek_head (self->digital_actions)) != NULL &&
+         digital->frame <= self->frame)
+    {
+      g_queue_pop_head (self->digital_actions);
+
+      GHashTable *states = g_hash_table_lookup (self->controllers,
+                                                &digital->controller_handle);
+      if (states == NULL)
+        {
+          g_free (digital);
+          continue;
+        }
+
+      gpointer key = GUINT_TO_POINTER (digital->action);
+      gboolean last_state =
+        GPOINTER_TO_INT (g_hash_table_lookup (states, key));
+      g_hash_table_insert (states, key, GINT_TO_POINTER (digital->state));
+
+      OpenVRDigitalEvent *event = g_malloc0 (sizeof (OpenVRDigitalEvent));
+      event->controller_handle = digital->controller_handle;
+      event->state = digital->state;
+      event->changed = last_state != digital->state;
+      g_signal_emit (self, runtime_signals[DIGITAL_EVENT], digital->action,
+                     event);
+
+      g_free (digital);
+    }
+}
+
+/**
+ * xrd_headless_runtime_step:
+ * @self: The #XrdHeadlessRuntime
+ *
+ * Simulates one frame: emits scripted digital actions for this frame and
+ * then one "pose-event" per connected controller, in handle order.
+ */
+void
+xrd_headless_runtime_step (XrdHeadlessRuntime *self)
+{
+  _emit_digital_actions (self);
+
+  GList *handles = g_hash_table_get_keys (self->controllers);
+  handles = g_list_sort (handles, _compare_handle);
+  for (GList *l = handles; l; l = l->next)
+    {
+      guint64 handle = *(guint64 *) l->data;
+
+      OpenVRPoseEvent *event = g_malloc0 (sizeof (OpenVRPoseEvent));
+      event->controller_handle = handle;
+      event->active = TRUE;
+      event->valid = TRUE;
+      event->device_connected = TRUE;
+      self->pose_func (handle, self->frame, &event->pose,
+                       self->pose_func_data);
+
+      g_signal_emit (self, runtime_signals[POSE_EVENT], 0, event);
+    }
+  g_list_free (handles);
+
+  self->frame++;
+}
+
+guint64
+xrd_headless_runtime_get_frame (XrdHeadlessRuntime *self)
+{
+  return self->frame;
+}
@@ -0,0 +1,78 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_HEADLESS_RUNTIME_H_
+#define XRD_HEADLESS_RUNTIME_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+#include <graphene.h>
+#include <gxr.h>
+
+G_BEGIN_DECLS
+
+#define XRD_TYPE_HEADLESS_RUNTIME xrd_headless_runtime_get_type()
+G_DECLARE_FINAL_TYPE (XrdHeadlessRuntime, xrd_headless_runtime,
+                      XRD, HEADLESS_RUNTIME, GObject)
+
+/**
+ * XrdHeadlessPoseFunc:
+ * @controller_handle: The controller to generate a pose for.
+ * @frame: The current frame number, starting at 0.
+ * @pose: (out): The pose of the controller in world space.
+ * @user_data: User data passed to xrd_headless_runtime_set_pose_func().
+ *
+ * Scripts the poses of the simulated controllers.
+ */
+typedef void (*XrdHeadlessPoseFunc) (guint64            controller_handle,
+                                     guint64            frame,
+                                     graphene_matrix_t *pose,
+                                     gpointer           user_data);
+
+XrdHeadlessRuntime *
+xrd_headless_runtime_new (void);
+
+void
+xrd_headless_runtime_set_pose_func (XrdHeadlessRuntime  *self,
+                                    XrdHeadlessPoseFunc  func,
+                                    gpointer             user_data);
+
+void
+xrd_headless_runtime_set_hmd_pose (XrdHeadlessRuntime *self,
+                                   graphene_matrix_t  *pose);
+
+void
+xrd_headless_runtime_get_hmd_pose (XrdHeadlessRuntime *self,
+                                   graphene_matrix_t  *pose);
+
+void
+xrd_headless_runtime_connect_controller (XrdHeadlessRuntime *self,
+                                         guint64             controller_handle);
+
+void
+xrd_headless_runtime_disconnect_controller (XrdHeadlessRuntime *self,
+                                            guint64             controller_handle);
+
+void
+xrd_headless_runtime_queue_digital (XrdHeadlessRuntime *self,
+                                    guint64             frame,
+                                    guint64             controller_handle,
+                                    const gchar        *action,
+                                    gboolean            state);
+
+void
+xrd_headless_runtime_step (XrdHeadlessRuntime *self);
+
+guint64
+xrd_headless_runtime_get_frame (XrdHeadlessRuntime *self);
+
+G_END_DECLS
+
+#endif /* XRD_HEADLESS_RUNTIME_H_ */
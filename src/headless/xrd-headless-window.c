@@ -0,0 +1,428 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-headless-window.h"
+
+#include "graphene-ext.h"
+
+struct _XrdHeadlessWindow
+{
+  GObject parent;
+
+  gboolean visible;
+  gboolean flip_y;
+  graphene_vec3_t color;
+
+  guint submit_count;
+
+  XrdWindowData *window_data;
+};
+
+enum
+{
+  PROP_TITLE = 1,
+  PROP_SCALE,
+  PROP_NATIVE,
+  PROP_TEXTURE_WIDTH,
+  PROP_TEXTURE_HEIGHT,
+  PROP_WIDTH_METERS,
+  PROP_HEIGHT_METERS,
+  N_PROPERTIES
+};
+
+static void
+xrd_headless_window_window_interface_init (XrdWindowInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (XrdHeadlessWindow, xrd_headless_window, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (XRD_TYPE_WINDOW,
+                                                xrd_headless_window_window_interface_init))
+
+static void
+xrd_headless_window_set_property (GObject      *object,
+                                  guint         property_id,
+                                  const GValue *value,
+                                  GParamSpec   *pspec)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (object);
+  switch (property_id)
+    {
+    case PROP_TITLE:
+      if (self->window_data->title)
+        g_string_free (self->window_data->title, TRUE);
+      self->window_data->title = g_string_new (g_value_get_string (value));
+      break;
+    case PROP_SCALE:
+      self->window_data->scale = g_value_get_float (value);
+      break;
+    case PROP_NATIVE:
+      self->window_data->native = g_value_get_pointer (value);
+      break;
+    case PROP_TEXTURE_WIDTH:
+      self->window_data->texture_width = g_value_get_uint (value);
+      break;
+    case PROP_TEXTURE_HEIGHT:
+      self->window_data->texture_height = g_value_get_uint (value);
+      break;
+    case PROP_WIDTH_METERS:
+      self->window_data->initial_size_meters.x = g_value_get_float (value);
+      break;
+    case PROP_HEIGHT_METERS:
+      self->window_data->initial_size_meters.y = g_value_get_float (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
+}
+
+static void
+xrd_headless_window_get_property (GObject    *object,
+                                  guint       property_id,
+                                  GValue     *value,
+                                  GParamSpec *pspec)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (object);
+
+  switch (property_id)
+    {
+    case PROP_TITLE:
+      g_value_set_string (value, self->window_data->title->str);
+      break;
+    case PROP_SCALE:
+      g_value_set_float (value, self->window_data->scale);
+      break;
+    case PROP_NATIVE:
+      g_value_set_pointer (value, self->window_data->native);
+      break;
+    case PROP_TEXTURE_WIDTH:
+      g_value_set_uint (value, self->window_data->texture_width);
+      break;
+    case PROP_TEXTURE_HEIGHT:
+      g_value_set_uint (value, self->window_data->texture_height);
+      break;
+    case PROP_WIDTH_METERS:
+      g_value_set_float (value, self->window_data->initial_size_meters.x);
+      break;
+    case PROP_HEIGHT_METERS:
+      g_value_set_float (value, self->window_data->initial_size_meters.y);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
+}
+
+static void
+xrd_headless_window_finalize (GObject *gobject);
+
+static void
+xrd_headless_window_class_init (XrdHeadlessWindowClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = xrd_headless_window_finalize;
+
+  object_class->set_property = xrd_headless_window_set_property;
+  object_class->get_property = xrd_headless_window_get_property;
+
+  g_object_class_override_property (object_class, PROP_TITLE, "title");
+  g_object_class_override_property (object_class, PROP_SCALE, "scale");
+  g_object_class_override_property (object_class, PROP_NATIVE, "native");
+  g_object_class_override_property (object_class, PROP_TEXTURE_WIDTH, "texture-width");
+  g_object_class_override_property (object_class, PROP_TEXTURE_HEIGHT, "texture-height");
+  g_object_class_override_property (object_class, PROP_WIDTH_METERS, "initial-width-meters");
+  g_object_class_override_property (object_class, PROP_HEIGHT_METERS, "initial-height-meters");
+}
+
+static void
+xrd_headless_window_init (XrdHeadlessWindow *self)
+{
+  self->visible = TRUE;
+  self->flip_y = FALSE;
+  self->submit_count = 0;
+  graphene_vec3_init (&self->color, 1.f, 1.f, 1.f);
+
+  self->window_data = g_malloc (sizeof (XrdWindowData));
+  self->window_data->title = NULL;
+  self->window_data->child_window = NULL;
+  self->window_data->parent_window = NULL;
+  self->window_data->native = NULL;
+  self->window_data->texture_width = 0;
+  self->window_data->texture_height = 0;
+  self->window_data->texture = NULL;
+  self->window_data->input_mask = NULL;
+  self->window_data->flip_y = FALSE;
+  graphene_rect_init (&self->window_data->uv_rect, 0.f, 0.f, 1.f, 1.f);
+  self->window_data->transform_pending = FALSE;
+  self->window_data->selected = FALSE;
+  self->window_data->xrd_window = XRD_WINDOW (self);
+  self->window_data->pinned = FALSE;
+  graphene_matrix_init_identity (&self->window_data->transform);
+  graphene_matrix_init_identity (&self->window_data->reset_transform);
+}
+
+/**
+ * xrd_headless_window_new:
+ * @title: The window title.
+ *
+ * Creates a window that only keeps its state on the CPU. It does not need
+ * an XR runtime or a Vulkan device and is meant for tests and benchmarks of
+ * the window management and input code paths.
+ *
+ * Returns: A new #XrdHeadlessWindow.
+ */
+XrdHeadlessWindow *
+xrd_headless_window_new (const gchar *title)
+{
+  XrdHeadlessWindow *self =
+    (XrdHeadlessWindow*) g_object_new (XRD_TYPE_HEADLESS_WINDOW,
+                                       "title", title, NULL);
+  return self;
+}
+
+XrdHeadlessWindow *
+xrd_headless_window_new_from_meters (const gchar *title,
+                                     float        width,
+                                     float        height,
+                                     float        ppm)
+{
+  XrdHeadlessWindow *window = xrd_headless_window_new (title);
+  g_object_set (window,
+                "texture-width", (uint32_t) (width * ppm),
+                "texture-height", (uint32_t) (height * ppm),
+                "initial-width-meters", (double) width,
+                "initial-height-meters", (double) height,
+                NULL);
+  return window;
+}
+
+XrdHeadlessWindow *
+xrd_headless_window_new_from_pixels (const gchar *title,
+                                     uint32_t     width,
+                                     uint32_t     height,
+                                     float        ppm)
+{
+  XrdHeadlessWindow *window = xrd_headless_window_new (title);
+  g_object_set (window,
+                "texture-width", width,
+                "texture-height", height,
+                "initial-width-meters", (double) width / (double) ppm,
+                "initial-height-meters", (double) height / (double) ppm,
+                NULL);
+  return window;
+}
+
+XrdHeadlessWindow *
+xrd_headless_window_new_from_native (const gchar *title,
+                                     gpointer     native,
+                                     uint32_t     width_pixels,
+                                     uint32_t     height_pixels,
+                                     float        ppm)
+{
+  XrdHeadlessWindow *window =
+    xrd_headless_window_new_from_pixels (title, width_pixels, height_pixels,
+                                         ppm);
+  g_object_set (window, "native", native, NULL);
+  return window;
+}
+
+XrdHeadlessWindow *
+xrd_headless_window_new_from_data (XrdWindowData *data)
+{
+  XrdHeadlessWindow *window =
+    (XrdHeadlessWindow*) g_object_new (XRD_TYPE_HEADLESS_WINDOW, NULL);
+
+  g_free (window->window_data);
+
+  window->window_data = data;
+  data->xrd_window = XRD_WINDOW (window);
+
+  return window;
+}
+
+/**
+ * xrd_headless_window_get_submit_count:
+ * @self: The #XrdHeadlessWindow
+ *
+ * Returns: How often a texture has been submitted to this window.
+ */
+guint
+xrd_headless_window_get_submit_count (XrdHeadlessWindow *self)
+{
+  return self->submit_count;
+}
+
+static void
+xrd_headless_window_finalize (GObject *gobject)
+{
+  G_OBJECT_CLASS (xrd_headless_window_parent_class)->finalize (gobject);
+}
+
+static gboolean
+_set_transformation (XrdWindow         *window,
+                     graphene_matrix_t *mat)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+
+  /* Like the other backends, only store the rigid part. */
+  graphene_quaternion_t orientation;
+  graphene_ext_matrix_get_rotation_quaternion (mat, &orientation);
+  graphene_point3d_t position;
+  graphene_ext_matrix_get_translation_point3d (mat, &position);
+
+  graphene_matrix_init_identity (&self->window_data->transform);
+  graphene_matrix_rotate_quaternion (&self->window_data->transform,
+                                     &orientation);
+  graphene_matrix_translate (&self->window_data->transform, &position);
+
+  if (self->window_data->child_window)
+    xrd_window_update_child (window);
+
+  return TRUE;
+}
+
+static gboolean
+_get_transformation_no_scale (XrdWindow         *window,
+                              graphene_matrix_t *mat)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+  graphene_matrix_init_from_matrix (mat, &self->window_data->transform);
+  return TRUE;
+}
+
+static gboolean
+_get_transformation (XrdWindow         *window,
+                     graphene_matrix_t *mat)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+
+  float height_meters = xrd_window_get_current_height_meters (window);
+  graphene_matrix_init_scale (mat, height_meters, height_meters, height_meters);
+  graphene_matrix_multiply (mat, &self->window_data->transform, mat);
+
+  return TRUE;
+}
+
+static void
+_submit_texture (XrdWindow     *window,
+                 GulkanClient  *client,
+                 GulkanTexture *texture)
+{
+  (void) client;
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+
+  self->submit_count++;
+
+  if (texture == NULL || texture == self->window_data->texture)
+    return;
+
+  uint32_t w, h;
+  xrd_window_get_shown_texture_size (window, texture, &w, &h);
+  g_object_set (window,
+                "texture-width", w,
+                "texture-height", h,
+                NULL);
+
+  if (self->window_data->texture)
+    g_object_unref (self->window_data->texture);
+  self->window_data->texture = texture;
+  g_object_ref (self->window_data->texture);
+}
+
+static void
+_poll_event (XrdWindow *window)
+{
+  (void) window;
+}
+
+static void
+_add_child (XrdWindow        *window,
+            XrdWindow        *child,
+            graphene_point_t *offset_center)
+{
+  (void) window;
+  (void) child;
+  (void) offset_center;
+}
+
+static void
+_set_color (XrdWindow *window, const graphene_vec3_t *color)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+  graphene_vec3_init_from_vec3 (&self->color, color);
+}
+
+static void
+_set_flip_y (XrdWindow *window,
+             gboolean   flip_y)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+  self->flip_y = flip_y;
+}
+
+static void
+_set_uv_rect (XrdWindow             *window,
+              const graphene_rect_t *rect)
+{
+  (void) rect;
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+  if (self->window_data->texture == NULL)
+    return;
+
+  uint32_t w, h;
+  xrd_window_get_shown_texture_size (window, self->window_data->texture,
+                                     &w, &h);
+  g_object_set (window,
+                "texture-width", w,
+                "texture-height", h,
+                NULL);
+}
+
+static void
+_show (XrdWindow *window)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+  self->visible = TRUE;
+}
+
+static void
+_hide (XrdWindow *window)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+  self->visible = FALSE;
+}
+
+static gboolean
+_is_visible (XrdWindow *window)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+  return self->visible;
+}
+
+static XrdWindowData*
+_get_data (XrdWindow *window)
+{
+  XrdHeadlessWindow *self = XRD_HEADLESS_WINDOW (window);
+  return self->window_data;
+}
+
+static void
+xrd_headless_window_window_interface_init (XrdWindowInterface *iface)
+{
+  iface->set_transformation = _set_transformation;
+  iface->get_transformation = _get_transformation;
+  iface->get_transformation_no_scale = _get_transformation_no_scale;
+  iface->submit_texture = _submit_texture;
+  iface->poll_event = _poll_event;
+  iface->add_child = _add_child;
+  iface->set_color = _set_color;
+  iface->set_flip_y = _set_flip_y;
+  iface->set_uv_rect = _set_uv_rect;
+  iface->show = _show;
+  iface->hide = _hide;
+  iface->is_visible = _is_visible;
+  iface->get_data = _get_data;
+}
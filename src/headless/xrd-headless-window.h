@@ -0,0 +1,55 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_HEADLESS_WINDOW_H_
+#define XRD_HEADLESS_WINDOW_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+
+#include "xrd-window.h"
+
+G_BEGIN_DECLS
+
+#define XRD_TYPE_HEADLESS_WINDOW xrd_headless_window_get_type()
+G_DECLARE_FINAL_TYPE (XrdHeadlessWindow, xrd_headless_window,
+                      XRD, HEADLESS_WINDOW, GObject)
+
+XrdHeadlessWindow *
+xrd_headless_window_new (const gchar *title);
+
+XrdHeadlessWindow *
+xrd_headless_window_new_from_meters (const gchar *title,
+                                     float        width,
+                                     float        height,
+                                     float        ppm);
+
+XrdHeadlessWindow *
+xrd_headless_window_new_from_pixels (const gchar *title,
+                                     uint32_t     width,
+                                     uint32_t     height,
+                                     float        ppm);
+
+XrdHeadlessWindow *
+xrd_headless_window_new_from_native (const gchar *title,
+                                     gpointer     native,
+                                     uint32_t     width_pixels,
+                                     uint32_t     height_pixels,
+                                     float        ppm);
+
+XrdHeadlessWindow *
+xrd_headless_window_new_from_data (XrdWindowData *data);
+
+guint
+xrd_headless_window_get_submit_count (XrdHeadlessWindow *self);
+
+G_END_DECLS
+
+#endif /* XRD_HEADLESS_WINDOW_H_ */
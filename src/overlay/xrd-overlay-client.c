@@ -17,6 +17,7 @@
 #include "xrd-pointer.h"
 #include "xrd-pointer-tip.h"
 #include "xrd-overlay-desktop-cursor.h"
+#include "xrd-scene-renderer.h"
 
 struct _XrdOverlayClient
 {
@@ -68,13 +69,15 @@ xrd_overlay_client_new (void)
       return NULL;
     }
 
-  self->gc = openvr_compositor_gulkan_client_new ();
-  if (!self->gc)
+  /* Uploads use the renderer's device, so textures survive mode switches. */
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  if (!xrd_scene_renderer_init_vulkan_device (renderer))
     {
       g_printerr ("Unable to initialize Vulkan!\n");
       g_object_unref (self);
       return NULL;
     }
+  self->gc = GULKAN_CLIENT (g_object_ref (renderer));
 
   xrd_client_post_openvr_init (XRD_CLIENT (self));
 
@@ -94,7 +97,10 @@ xrd_overlay_client_finalize (GObject *gobject)
 
   /* Uploader needs to be freed after context! */
   if (self->gc)
-    g_object_unref (self->gc);
+    {
+      g_object_unref (self->gc);
+      xrd_scene_renderer_destroy_instance ();
+    }
 }
 
 static GulkanClient *
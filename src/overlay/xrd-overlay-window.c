@@ -8,19 +8,55 @@
 #include "xrd-overlay-window.h"
 
 #include <glib/gprintf.h>
+#include <math.h>
 
 #include <gxr.h>
 #include "xrd-math.h"
 #include "graphene-ext.h"
 
+/* Changes smaller than this are not sent to the runtime. */
+#define SHADOW_EPSILON 1e-5f
+
+typedef enum {
+  SHADOW_TRANSFORM   = 1 << 0,
+  SHADOW_WIDTH       = 1 << 1,
+  SHADOW_MOUSE_SCALE = 1 << 2,
+  SHADOW_COLOR       = 1 << 3,
+  SHADOW_SORT_ORDER  = 1 << 4,
+  SHADOW_VISIBLE     = 1 << 5,
+  SHADOW_BOUNDS      = 1 << 6
+} ShadowField;
+
+/* The last values sent to the runtime for this overlay. */
+typedef struct {
+  guint sent;
+
+  graphene_matrix_t transform;
+  float width_meters;
+  uint32_t mouse_width;
+  uint32_t mouse_height;
+  graphene_vec3_t color;
+  uint32_t sort_order;
+  gboolean visible;
+  VRTextureBounds_t bounds;
+} OverlayShadow;
+
 struct _XrdOverlayWindow
 {
   OpenVROverlay parent;
   gboolean      recreate;
 
+  OverlayShadow shadow;
+
+  /* openvr-glib only sets whole texture bounds, for flipping */
+  VROverlayHandle_t handle;
+
   XrdWindowData *window_data;
 };
 
+static guint64 ipc_issued = 0;
+static guint64 ipc_suppressed = 0;
+
 enum
 {
   PROP_TITLE = 1,
@@ -33,6 +69,35 @@ enum
   N_PROPERTIES
 };
 
+static void
+_set_flip_y (XrdWindow *window,
+             gboolean   flip_y)
+{
+  (void) flip_y;
+  _update_bounds (XRD_OVERLAY_WINDOW (window));
+}
+
+static void
+_set_uv_rect (XrdWindow             *window,
+              const graphene_rect_t *rect)
+{
+  (void) rect;
+  XrdOverlayWindow *self = XRD_OVERLAY_WINDOW (window);
+  _update_bounds (self);
+
+  if (self->window_data->texture)
+    {
+      uint32_t w, h;
+      xrd_window_get_shown_texture_size (window, self->window_data->texture,
+                                         &w, &h);
+      g_object_set (self,
+                    "texture-width", w,
+                    "texture-height", h,
+                    NULL);
+      _shadow_set_mouse_scale (self, w, h);
+    }
+}
+
 static void
 xrd_overlay_window_window_interface_init (XrdWindowInterface *iface);
 
@@ -115,11 +180,197 @@ xrd_overlay_window_get_property (GObject    *object,
     }
 }
 
+/* Returns TRUE if @field was sent before and is still up to date. */
+static gboolean
+_shadow_is_current (XrdOverlayWindow *self,
+                    ShadowField       field,
+                    gboolean          unchanged)
+{
+  if ((self->shadow.sent & field) && unchanged)
+    {
+      ipc_suppressed++;
+      return TRUE;
+    }
+  return FALSE;
+}
+
+/* Call once the runtime accepted @field, failed calls are not counted. */
+static void
+_shadow_mark_sent (XrdOverlayWindow *self,
+                   ShadowField       field)
+{
+  self->shadow.sent |= field;
+  ipc_issued++;
+}
+
+static gboolean
+_matrix_near (const graphene_matrix_t *a,
+              const graphene_matrix_t *b)
+{
+  float fa[16], fb[16];
+  graphene_matrix_to_float (a, fa);
+  graphene_matrix_to_float (b, fb);
+  for (int i = 0; i < 16; i++)
+    if (fabsf (fa[i] - fb[i]) > SHADOW_EPSILON)
+      return FALSE;
+  return TRUE;
+}
+
+static gboolean
+_shadow_set_transform (XrdOverlayWindow  *self,
+                       graphene_matrix_t *mat)
+{
+  if (_shadow_is_current (self, SHADOW_TRANSFORM,
+                          _matrix_near (&self->shadow.transform, mat)))
+    return TRUE;
+
+  if (!openvr_overlay_set_transform_absolute (OPENVR_OVERLAY (self), mat))
+    return FALSE;
+
+  graphene_matrix_init_from_matrix (&self->shadow.transform, mat);
+  _shadow_mark_sent (self, SHADOW_TRANSFORM);
+  return TRUE;
+}
+
+static void
+_shadow_set_width (XrdOverlayWindow *self,
+                   float             width_meters)
+{
+  if (_shadow_is_current (self, SHADOW_WIDTH,
+                          fabsf (self->shadow.width_meters - width_meters)
+                            <= SHADOW_EPSILON))
+    return;
+
+  if (!openvr_overlay_set_width_meters (OPENVR_OVERLAY (self), width_meters))
+    return;
+
+  self->shadow.width_meters = width_meters;
+  _shadow_mark_sent (self, SHADOW_WIDTH);
+}
+
+static void
+_shadow_set_mouse_scale (XrdOverlayWindow *self,
+                         uint32_t          width,
+                         uint32_t          height)
+{
+  if (_shadow_is_current (self, SHADOW_MOUSE_SCALE,
+                          self->shadow.mouse_width == width &&
+                          self->shadow.mouse_height == height))
+    return;
+
+  if (!openvr_overlay_set_mouse_scale (OPENVR_OVERLAY (self), width, height))
+    return;
+
+  self->shadow.mouse_width = width;
+  self->shadow.mouse_height = height;
+  _shadow_mark_sent (self, SHADOW_MOUSE_SCALE);
+}
+
+static void
+_shadow_set_color (XrdOverlayWindow      *self,
+                   const graphene_vec3_t *color)
+{
+  if (_shadow_is_current (self, SHADOW_COLOR,
+                          graphene_vec3_near (&self->shadow.color, color,
+                                              SHADOW_EPSILON)))
+    return;
+
+  if (!openvr_overlay_set_color (OPENVR_OVERLAY (self), color))
+    return;
+
+  graphene_vec3_init_from_vec3 (&self->shadow.color, color);
+  _shadow_mark_sent (self, SHADOW_COLOR);
+}
+
+static void
+_shadow_set_sort_order (XrdOverlayWindow *self,
+                        uint32_t          sort_order)
+{
+  if (_shadow_is_current (self, SHADOW_SORT_ORDER,
+                          self->shadow.sort_order == sort_order))
+    return;
+
+  if (!openvr_overlay_set_sort_order (OPENVR_OVERLAY (self), sort_order))
+    return;
+
+  self->shadow.sort_order = sort_order;
+  _shadow_mark_sent (self, SHADOW_SORT_ORDER);
+}
+
+static void
+_shadow_set_visible (XrdOverlayWindow *self,
+                     gboolean          visible)
+{
+  if (_shadow_is_current (self, SHADOW_VISIBLE,
+                          self->shadow.visible == visible))
+    return;
+
+  gboolean res = visible ? openvr_overlay_show (OPENVR_OVERLAY (self))
+                         : openvr_overlay_hide (OPENVR_OVERLAY (self));
+  if (!res)
+    return;
+
+  self->shadow.visible = visible;
+  _shadow_mark_sent (self, SHADOW_VISIBLE);
+}
+
+static void
+_shadow_set_bounds (XrdOverlayWindow  *self,
+                    VRTextureBounds_t *bounds)
+{
+  if (_shadow_is_current (self, SHADOW_BOUNDS,
+                          fabsf (self->shadow.bounds.uMin - bounds->uMin)
+                            <= SHADOW_EPSILON &&
+                          fabsf (self->shadow.bounds.vMin - bounds->vMin)
+                            <= SHADOW_EPSILON &&
+                          fabsf (self->shadow.bounds.uMax - bounds->uMax)
+                            <= SHADOW_EPSILON &&
+                          fabsf (self->shadow.bounds.vMax - bounds->vMax)
+                            <= SHADOW_EPSILON))
+    return;
+
+  OpenVRContext *context = openvr_context_get_instance ();
+  EVROverlayError err =
+    context->overlay->SetOverlayTextureBounds (self->handle, bounds);
+  if (err != EVROverlayError_VROverlayError_None)
+    {
+      g_printerr ("Could not set overlay texture bounds: %s\n",
+                  context->overlay->GetOverlayErrorNameFromEnum (err));
+      return;
+    }
+
+  self->shadow.bounds = *bounds;
+  _shadow_mark_sent (self, SHADOW_BOUNDS);
+}
+
+/* Texture bounds cover both the uv rect and the flip, in one call */
+static void
+_update_bounds (XrdOverlayWindow *self)
+{
+  graphene_rect_t *rect = &self->window_data->uv_rect;
+
+  VRTextureBounds_t bounds = {
+    .uMin = rect->origin.x,
+    .uMax = rect->origin.x + rect->size.width,
+    .vMin = rect->origin.y,
+    .vMax = rect->origin.y + rect->size.height
+  };
+
+  if (self->window_data->flip_y)
+    {
+      float v_min = bounds.vMin;
+      bounds.vMin = bounds.vMax;
+      bounds.vMax = v_min;
+    }
+
+  _shadow_set_bounds (self, &bounds);
+}
+
 static void
 _update_dimensions (XrdOverlayWindow *self)
 {
   float width_meters = xrd_window_get_current_width_meters (XRD_WINDOW (self));
-  openvr_overlay_set_width_meters (OPENVR_OVERLAY (self), width_meters);
+  _shadow_set_width (self, width_meters);
 
   uint32_t w, h;
   g_object_get (self,
@@ -127,7 +378,7 @@ _update_dimensions (XrdOverlayWindow *self)
                 "texture-height", &h,
                 NULL);
 
-  openvr_overlay_set_mouse_scale (OPENVR_OVERLAY (self), w, h);
+  _shadow_set_mouse_scale (self, w, h);
 
   if (self->window_data->child_window)
     xrd_window_update_child (XRD_WINDOW (self));
@@ -175,19 +426,43 @@ _set_transformation (XrdWindow         *window,
                      graphene_matrix_t *mat)
 {
   XrdOverlayWindow *self = XRD_OVERLAY_WINDOW (window);
-  gboolean res =
-    openvr_overlay_set_transform_absolute (OPENVR_OVERLAY (self), mat);
+  gboolean res = _shadow_set_transform (self, mat);
+
+  /* Keep the rigid part locally instead of reading it back over IPC. */
+  graphene_quaternion_t orientation;
+  graphene_ext_matrix_get_rotation_quaternion (mat, &orientation);
+  graphene_point3d_t position;
+  graphene_ext_matrix_get_translation_point3d (mat, &position);
+
+  graphene_matrix_init_identity (&self->window_data->transform);
+  graphene_matrix_rotate_quaternion (&self->window_data->transform,
+                                     &orientation);
+  graphene_matrix_translate (&self->window_data->transform, &position);
+
   if (self->window_data->child_window)
     xrd_window_update_child (window);
 
-  XrdWindowData *data = xrd_window_get_data (window);
-  graphene_matrix_t transform_unscaled;
-  xrd_window_get_transformation_no_scale (window, &transform_unscaled);
-  graphene_matrix_init_from_matrix (&data->transform, &transform_unscaled);
-
   return res;
 }
 
+/* The shadow holds what was sent, no need for a round trip. */
+static gboolean
+_get_transformation_no_scale (XrdWindow         *window,
+                              graphene_matrix_t *mat)
+{
+  XrdOverlayWindow *self = XRD_OVERLAY_WINDOW (window);
+  if (self->shadow.sent & SHADOW_TRANSFORM)
+    {
+      graphene_matrix_init_from_matrix (mat, &self->shadow.transform);
+      return TRUE;
+    }
+
+  if (!openvr_overlay_get_transform_absolute (OPENVR_OVERLAY (self), mat))
+    return FALSE;
+
+  return TRUE;
+}
+
 static gboolean
 _get_transformation (XrdWindow         *window,
                      graphene_matrix_t *mat)
@@ -195,13 +470,13 @@ _get_transformation (XrdWindow         *window,
   XrdOverlayWindow *self = XRD_OVERLAY_WINDOW (window);
 
   graphene_matrix_t mat_no_scale;
-  if (!openvr_overlay_get_transform_absolute (OPENVR_OVERLAY (self),
-                                             &mat_no_scale))
+  if (!_get_transformation_no_scale (window, &mat_no_scale))
     return FALSE;
 
   /* Rebuild model matrix to include scale */
-  float width_meters;
-  if (!openvr_overlay_get_width_meters (OPENVR_OVERLAY (self), &width_meters))
+  float width_meters = self->shadow.width_meters;
+  if (!(self->shadow.sent & SHADOW_WIDTH) &&
+      !openvr_overlay_get_width_meters (OPENVR_OVERLAY (self), &width_meters))
     return FALSE;
 
   float height_meters = width_meters / xrd_window_get_aspect_ratio (window);
@@ -220,18 +495,6 @@ _get_transformation (XrdWindow         *window,
 }
 
 
-static gboolean
-_get_transformation_no_scale (XrdWindow         *window,
-                              graphene_matrix_t *mat)
-{
-  XrdOverlayWindow *self = XRD_OVERLAY_WINDOW (window);
-  if (!openvr_overlay_get_transform_absolute (OPENVR_OVERLAY (self), mat))
-    return FALSE;
-
-  return TRUE;
-}
-
-
 static void
 _submit_texture (XrdWindow     *window,
                  GulkanClient  *client,
@@ -245,8 +508,8 @@ _submit_texture (XrdWindow     *window,
                 "texture-height", &current_height,
                 NULL);
 
-  guint new_width = gulkan_texture_get_width (texture);
-  guint new_height = gulkan_texture_get_height (texture);
+  uint32_t new_width, new_height;
+  xrd_window_get_shown_texture_size (window, texture, &new_width, &new_height);
 
   /* update overlay if there is no texture, even if the texture dims
    * are already the same */
@@ -261,11 +524,10 @@ _submit_texture (XrdWindow     *window,
       float width_meters =
         xrd_window_get_current_width_meters (XRD_WINDOW (self));
 
-      openvr_overlay_set_width_meters (OPENVR_OVERLAY (self), width_meters);
+      _shadow_set_width (self, width_meters);
 
       /* Mouse scale is required for the intersection test */
-      openvr_overlay_set_mouse_scale (OPENVR_OVERLAY (self),
-                                      new_width, new_height);
+      _shadow_set_mouse_scale (self, new_width, new_height);
     }
 
   openvr_overlay_submit_texture (OPENVR_OVERLAY (self), client, texture);
@@ -285,7 +547,7 @@ _add_child (XrdWindow        *window,
   (void) window;
   (void) offset_center;
   /* TODO: sort order hierarchy instead od ad hoc values*/
-  openvr_overlay_set_sort_order (OPENVR_OVERLAY (child), 1);
+  _shadow_set_sort_order (XRD_OVERLAY_WINDOW (child), 1);
 }
 
 static void
@@ -298,6 +560,9 @@ _poll_event (XrdWindow *window)
 static void
 xrd_overlay_window_init (XrdOverlayWindow *self)
 {
+  self->shadow.sent = 0;
+  self->handle = k_ulOverlayHandleInvalid;
+
   self->window_data = g_malloc (sizeof (XrdWindowData));
   self->window_data->title = NULL;
   self->window_data->child_window = NULL;
@@ -306,9 +571,14 @@ xrd_overlay_window_init (XrdOverlayWindow *self)
   self->window_data->texture_width = 0;
   self->window_data->texture_height = 0;
   self->window_data->texture = NULL;
+  self->window_data->input_mask = NULL;
+  self->window_data->flip_y = FALSE;
+  graphene_rect_init (&self->window_data->uv_rect, 0.f, 0.f, 1.f, 1.f);
+  self->window_data->transform_pending = FALSE;
   self->window_data->selected = FALSE;
   self->window_data->xrd_window = XRD_WINDOW (self);
   self->window_data->pinned = FALSE;
+  graphene_matrix_init_identity (&self->window_data->transform);
   graphene_matrix_init_identity (&self->window_data->reset_transform);
 }
 
@@ -391,7 +661,7 @@ static void
 _set_color (XrdWindow *window, const graphene_vec3_t *color)
 {
   XrdOverlayWindow *self = XRD_OVERLAY_WINDOW (window);
-  openvr_overlay_set_color (OPENVR_OVERLAY (self), color);
+  _shadow_set_color (self, color);
 }
 
 static void
@@ -417,7 +687,10 @@ xrd_overlay_window_constructed (GObject *gobject)
     return;
   }
 
-  openvr_overlay_show (OPENVR_OVERLAY (self));
+  OpenVRContext *context = openvr_context_get_instance ();
+  context->overlay->FindOverlay (overlay_id_str, &self->handle);
+
+  _shadow_set_visible (self, TRUE);
 
   iface->windows_created++;
 
@@ -434,6 +707,25 @@ xrd_overlay_window_finalize (GObject *gobject)
   G_OBJECT_CLASS (xrd_overlay_window_parent_class)->finalize (gobject);
 }
 
+/**
+ * xrd_overlay_window_get_ipc_stats:
+ * @issued: (out) (optional): How many overlay updates the runtime accepted,
+ * failed calls are not counted.
+ * @suppressed: (out) (optional): How many overlay updates were skipped
+ * because the runtime already had the value.
+ *
+ * The counts are shared by all #XrdOverlayWindow instances.
+ */
+void
+xrd_overlay_window_get_ipc_stats (guint64 *issued,
+                                  guint64 *suppressed)
+{
+  if (issued)
+    *issued = ipc_issued;
+  if (suppressed)
+    *suppressed = ipc_suppressed;
+}
+
 static XrdWindowData*
 _get_data (XrdWindow *window)
 {
@@ -445,14 +737,14 @@ static void
 _hide (XrdWindow *window)
 {
   XrdOverlayWindow *self = XRD_OVERLAY_WINDOW (window);
-  openvr_overlay_hide (OPENVR_OVERLAY (self));
+  _shadow_set_visible (self, FALSE);
 }
 
 static void
 _show (XrdWindow *window)
 {
   XrdOverlayWindow *self = XRD_OVERLAY_WINDOW (window);
-  openvr_overlay_show (OPENVR_OVERLAY (self));
+  _shadow_set_visible (self, TRUE);
 }
 
 static void
@@ -465,7 +757,8 @@ xrd_overlay_window_window_interface_init (XrdWindowInterface *iface)
   iface->poll_event = _poll_event;
   iface->add_child = _add_child;
   iface->set_color = _set_color;
-  iface->set_flip_y = (void (*)(XrdWindow *, gboolean)) openvr_overlay_set_flip_y;
+  iface->set_flip_y = _set_flip_y;
+  iface->set_uv_rect = _set_uv_rect;
   iface->show = _show;
   iface->hide = _hide;
   iface->is_visible = (gboolean (*)(XrdWindow*)) openvr_overlay_is_visible;
@@ -50,6 +50,10 @@ xrd_overlay_window_new_from_native (const gchar *title,
                                     uint32_t     height_pixels,
                                     float        ppm);
 
+void
+xrd_overlay_window_get_ipc_stats (guint64 *issued,
+                                  guint64 *suppressed);
+
 G_END_DECLS
 
 #endif /* XRD_OVERLAY_WINDOW_H_ */
@@ -124,6 +124,7 @@ xrd_scene_background_initialize (XrdSceneBackground    *self,
                                  VkDescriptorSetLayout *layout)
 {
   gulkan_vertex_buffer_reset (self->vertex_buffer);
+  xrd_scene_object_structure_changed ();
 
   graphene_vec3_t color;
   graphene_vec3_init (&color, .6f, .6f, .6f);
@@ -161,9 +162,13 @@ xrd_scene_background_render (XrdSceneBackground *self,
   if (!xrd_scene_object_is_visible (obj))
     return;
 
-  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
   xrd_scene_object_update_mvp_matrix (obj, eye, vp);
+
+  /* Only the uniform buffer is updated for a previously recorded frame */
+  if (cmd_buffer == VK_NULL_HANDLE)
+    return;
+
+  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
   xrd_scene_object_bind (obj, eye, cmd_buffer, pipeline_layout);
   gulkan_vertex_buffer_draw (self->vertex_buffer, cmd_buffer);
 }
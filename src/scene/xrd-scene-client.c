@@ -21,9 +21,36 @@
 #include "xrd-scene-pointer-tip.h"
 #include "xrd-scene-renderer.h"
 #include "xrd-scene-desktop-cursor.h"
+#include "xrd-telemetry.h"
+#include "xrd-settings.h"
+#include "xrd-scene-draw-order.h"
 
 #define DEBUG_GEOMETRY 0
 
+/* Work the render thread hands to the main loop. */
+typedef enum {
+  RENDER_STAGE_NONE,
+  RENDER_STAGE_RECORD,
+  RENDER_STAGE_PRESENT
+} RenderStage;
+
+/* Windows below this count per worker are not worth the hand-off. */
+#define MIN_WINDOWS_PER_CHUNK 16
+
+/* Bounds the chunks on the stack, the range of "render-worker-threads". */
+#define MAX_UNIFORM_WORKERS 16
+
+/* A slice of a window list whose uniform buffers one worker updates. */
+typedef struct {
+  GSList *first;
+  guint count;
+  gboolean shaded;
+  EVREye eye;
+  graphene_matrix_t *vp;
+  graphene_matrix_t *view;
+  graphene_matrix_t *projection;
+} UniformChunk;
+
 struct _XrdSceneClient
 {
   XrdClient parent;
@@ -42,10 +69,48 @@ struct _XrdSceneClient
 #endif
 
   XrdSceneBackground *background;
+
+  GThread *render_thread;
+  GMutex render_mutex;
+  GCond render_cond;
+  gboolean render_running;
+  RenderStage render_stage;
+  GSource *render_source;
+
+  /* Written by the render thread before it requests RENDER_STAGE_RECORD */
+  TrackedDevicePose_t render_poses[k_unMaxTrackedDeviceCount];
+  gint64 render_poses_time;
+
+  GulkanCommandBuffer frame_cmd_buffer;
+  gboolean frame_submitted;
+  guint64 frame_count;
+  /* XRD_TELEMETRY_RENDER spans from recording to presenting a frame */
+  gint64 frame_telemetry_start;
+
+  /* optional uniform update workers, see "render-worker-threads" */
+  GThreadPool *uniform_pool;
+  guint uniform_workers;
+  GMutex uniform_mutex;
+  GCond uniform_cond;
+  guint uniform_chunks_pending;
+
+  /* Per eye draw orders, updated once per frame by _prepare_frame_cb */
+  XrdSceneDrawOrder *window_order[2];
+  XrdSceneDrawOrder *button_order[2];
+  XrdSceneDrawOrder *blended_order[2];
+  GPtrArray *sorted_windows[2];
+  GPtrArray *sorted_buttons[2];
+  GPtrArray *sorted_blended[2];
 };
 
 G_DEFINE_TYPE (XrdSceneClient, xrd_scene_client, XRD_TYPE_CLIENT)
 
+enum {
+  FRAME_EVENT,
+  LAST_SIGNAL
+};
+static guint scene_client_signals[LAST_SIGNAL] = { 0 };
+
 static void xrd_scene_client_finalize (GObject *gobject);
 
 void _init_device_model (XrdSceneClient      *self,
@@ -77,6 +142,36 @@ xrd_scene_client_init (XrdSceneClient *self)
   self->near = 0.1f;
   self->far = 30.0f;
 
+  self->render_thread = NULL;
+  g_mutex_init (&self->render_mutex);
+  g_cond_init (&self->render_cond);
+  self->render_running = FALSE;
+  self->render_stage = RENDER_STAGE_NONE;
+  self->render_source = NULL;
+  self->render_poses_time = 0;
+  self->frame_submitted = FALSE;
+  self->frame_count = 0;
+  self->frame_telemetry_start = 0;
+
+  self->uniform_pool = NULL;
+  self->uniform_workers = 0;
+  g_mutex_init (&self->uniform_mutex);
+  g_cond_init (&self->uniform_cond);
+  self->uniform_chunks_pending = 0;
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      self->window_order[eye] =
+        xrd_scene_draw_order_new (XRD_SCENE_DRAW_ORDER_FRONT_TO_BACK);
+      self->button_order[eye] =
+        xrd_scene_draw_order_new (XRD_SCENE_DRAW_ORDER_FRONT_TO_BACK);
+      self->blended_order[eye] =
+        xrd_scene_draw_order_new (XRD_SCENE_DRAW_ORDER_BACK_TO_FRONT);
+      self->sorted_windows[eye] = NULL;
+      self->sorted_buttons[eye] = NULL;
+      self->sorted_blended[eye] = NULL;
+    }
+
 #if DEBUG_GEOMETRY
   for (uint32_t i = 0; i < G_N_ELEMENTS (self->debug_vectors); i++)
     self->debug_vectors[i] = xrd_scene_vector_new ();
@@ -94,6 +189,23 @@ xrd_scene_client_finalize (GObject *gobject)
 {
   XrdSceneClient *self = XRD_SCENE_CLIENT (gobject);
 
+  xrd_scene_client_stop_render_loop (self);
+  g_mutex_clear (&self->render_mutex);
+  g_cond_clear (&self->render_cond);
+
+  g_signal_handlers_disconnect_by_data (xrd_settings_get_instance (), self);
+  if (self->uniform_pool)
+    g_thread_pool_free (self->uniform_pool, TRUE, TRUE);
+  g_mutex_clear (&self->uniform_mutex);
+  g_cond_clear (&self->uniform_cond);
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      g_object_unref (self->window_order[eye]);
+      g_object_unref (self->button_order[eye]);
+      g_object_unref (self->blended_order[eye]);
+    }
+
   g_object_unref (self->device_manager);
 
   g_object_unref (self->background);
@@ -105,6 +217,14 @@ xrd_scene_client_finalize (GObject *gobject)
 
   G_OBJECT_CLASS (xrd_scene_client_parent_class)->finalize (gobject);
 
+  /* The renderer may outlive this client when switching modes. */
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  xrd_scene_renderer_set_render_cb (renderer, NULL, NULL);
+  xrd_scene_renderer_set_update_lights_cb (renderer, NULL, NULL);
+  xrd_scene_renderer_set_prepare_frame_cb (renderer, NULL, NULL);
+  xrd_scene_renderer_set_record_transfers_cb (renderer, NULL, NULL);
+  xrd_scene_renderer_set_structure_key_cb (renderer, NULL, NULL);
+
   xrd_scene_renderer_destroy_instance ();
 }
 
@@ -193,6 +313,180 @@ _update_lights_cb (gpointer _self)
   g_list_free (controllers);
 }
 
+static void
+_update_uniform_chunk_cb (gpointer data, gpointer user_data)
+{
+  UniformChunk *chunk = data;
+  XrdSceneClient *self = user_data;
+
+  GSList *l = chunk->first;
+  for (guint i = 0; i < chunk->count && l != NULL; i++, l = l->next)
+    {
+      XrdSceneWindow *window = XRD_SCENE_WINDOW (l->data);
+      if (chunk->shaded)
+        xrd_scene_window_update_transformation_buffer (window, chunk->eye,
+                                                       chunk->view,
+                                                       chunk->projection);
+      else
+        xrd_scene_window_update_mvp (window, chunk->eye, chunk->vp);
+    }
+
+  g_mutex_lock (&self->uniform_mutex);
+  if (--self->uniform_chunks_pending == 0)
+    g_cond_signal (&self->uniform_cond);
+  g_mutex_unlock (&self->uniform_mutex);
+}
+
+static guint
+_split_into_chunks (GSList       *list,
+                    guint         max_chunks,
+                    UniformChunk *chunks,
+                    UniformChunk *template)
+{
+  guint length = g_slist_length (list);
+  if (length == 0)
+    return 0;
+
+  guint n_chunks = MIN (max_chunks,
+                        (length + MIN_WINDOWS_PER_CHUNK - 1)
+                          / MIN_WINDOWS_PER_CHUNK);
+  n_chunks = MAX (n_chunks, 1);
+  guint per_chunk = (length + n_chunks - 1) / n_chunks;
+
+  guint n = 0;
+  for (GSList *l = list; l != NULL && n < n_chunks; n++)
+    {
+      chunks[n] = *template;
+      chunks[n].first = l;
+      chunks[n].count = per_chunk;
+      for (guint i = 0; i < per_chunk && l != NULL; i++)
+        l = l->next;
+    }
+  return n;
+}
+
+/*
+ * Updates the per eye uniform buffers of all windows and buttons on the
+ * worker pool. Each window is in exactly one chunk and the main thread
+ * blocks until all chunks are done, so no buffer is written concurrently.
+ */
+static void
+_update_window_uniforms_parallel (XrdSceneClient    *self,
+                                  EVREye             eye,
+                                  GSList            *windows,
+                                  GSList            *buttons,
+                                  graphene_matrix_t *vp,
+                                  graphene_matrix_t *view)
+{
+  /* windows are split across all workers, buttons get one chunk */
+  UniformChunk chunks[MAX_UNIFORM_WORKERS + 1];
+
+  UniformChunk template = {
+    .eye = eye,
+    .vp = vp,
+    .view = view,
+    .projection = &self->mat_projection[eye],
+    .shaded = FALSE
+  };
+  guint n_chunks = _split_into_chunks (windows, self->uniform_workers,
+                                       chunks, &template);
+
+  template.shaded = TRUE;
+  n_chunks += _split_into_chunks (buttons, 1, &chunks[n_chunks], &template);
+
+  if (n_chunks == 0)
+    return;
+
+  g_mutex_lock (&self->uniform_mutex);
+  self->uniform_chunks_pending = n_chunks;
+  g_mutex_unlock (&self->uniform_mutex);
+
+  /* keep one chunk for the main thread instead of idling */
+  for (guint i = 1; i < n_chunks; i++)
+    g_thread_pool_push (self->uniform_pool, &chunks[i], NULL);
+  _update_uniform_chunk_cb (&chunks[0], self);
+
+  g_mutex_lock (&self->uniform_mutex);
+  while (self->uniform_chunks_pending > 0)
+    g_cond_wait (&self->uniform_cond, &self->uniform_mutex);
+  g_mutex_unlock (&self->uniform_mutex);
+}
+
+/* Pointer tips and the desktop cursor, which are alpha blended. */
+static GSList *
+_get_blended_windows (XrdSceneClient *self)
+{
+  GSList *blended = NULL;
+
+  GList *controllers =
+    g_hash_table_get_values (xrd_client_get_controllers (XRD_CLIENT (self)));
+  for (GList *l = controllers; l; l = l->next)
+    {
+      XrdController *controller = XRD_CONTROLLER (l->data);
+      blended = g_slist_prepend (blended,
+                                 xrd_controller_get_pointer_tip (controller));
+    }
+  g_list_free (controllers);
+
+  XrdDesktopCursor *cursor = xrd_client_get_desktop_cursor (XRD_CLIENT (self));
+  blended = g_slist_prepend (blended, cursor);
+
+  return blended;
+}
+
+static void
+_update_draw_orders (XrdSceneClient *self)
+{
+  XrdWindowManager *manager = xrd_client_get_manager (XRD_CLIENT (self));
+  GSList *windows = xrd_window_manager_get_windows (manager);
+  GSList *buttons = xrd_window_manager_get_buttons (manager);
+  GSList *blended = _get_blended_windows (self);
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      graphene_matrix_t view = _get_view_matrix (self, eye);
+      self->sorted_windows[eye] =
+        xrd_scene_draw_order_update (self->window_order[eye], windows, &view);
+      self->sorted_buttons[eye] =
+        xrd_scene_draw_order_update (self->button_order[eye], buttons, &view);
+      self->sorted_blended[eye] =
+        xrd_scene_draw_order_update (self->blended_order[eye], blended, &view);
+    }
+
+  g_slist_free (blended);
+}
+
+/*
+ * Window pipelines are specialized for lighting and flipping, pick the
+ * variant matching the window.
+ */
+static VkPipeline
+_get_window_pipeline (VkPipeline        *pipelines,
+                      XrdSceneWindow    *window,
+                      enum PipelineType  type)
+{
+  if (!xrd_scene_window_get_flip_y (window))
+    return pipelines[type];
+
+  switch (type)
+    {
+    case PIPELINE_WINDOWS:
+      return pipelines[PIPELINE_WINDOWS_FLIP_Y];
+    case PIPELINE_WINDOWS_LIT:
+      return pipelines[PIPELINE_WINDOWS_LIT_FLIP_Y];
+    case PIPELINE_TIP:
+      return pipelines[PIPELINE_TIP_FLIP_Y];
+    default:
+      return pipelines[type];
+    }
+}
+
+/*
+ * Opaque windows and buttons are drawn front to back, so the depth test
+ * rejects hidden fragments before the window shader runs for them. The
+ * cheap line background follows them for the same reason. Blended tips
+ * and the cursor come last, back to front.
+ */
 static void
 _render_eye_cb (uint32_t         eye,
                 VkCommandBuffer  cmd_buffer,
@@ -207,55 +501,81 @@ _render_eye_cb (uint32_t         eye,
 
   XrdWindowManager *manager = xrd_client_get_manager (XRD_CLIENT (self));
 
-  xrd_scene_background_render (self->background, eye,
-                               pipelines[PIPELINE_BACKGROUND],
-                               pipeline_layout, cmd_buffer, &vp);
+  if (self->sorted_windows[eye] == NULL)
+    _update_draw_orders (self);
+
+  GPtrArray *windows = self->sorted_windows[eye];
+  GPtrArray *buttons = self->sorted_buttons[eye];
+  GPtrArray *blended = self->sorted_blended[eye];
 
-  for (GSList *l = xrd_window_manager_get_windows (manager);
-       l != NULL; l = l->next)
+  if (self->uniform_pool != NULL)
     {
-      xrd_scene_window_draw (XRD_SCENE_WINDOW (l->data), eye,
-                             pipelines[PIPELINE_WINDOWS],
-                             pipeline_layout,
-                             cmd_buffer, &vp);
+      _update_window_uniforms_parallel (self, eye,
+                                        xrd_window_manager_get_windows (manager),
+                                        xrd_window_manager_get_buttons (manager),
+                                        &vp, &view);
+
+      for (guint i = 0; i < windows->len; i++)
+        {
+          XrdSceneWindow *window = XRD_SCENE_WINDOW (windows->pdata[i]);
+          xrd_scene_window_record (window, eye,
+                                   _get_window_pipeline (pipelines, window,
+                                                         PIPELINE_WINDOWS),
+                                   pipeline_layout, cmd_buffer);
+        }
+
+      for (guint i = 0; i < buttons->len; i++)
+        {
+          XrdSceneWindow *button = XRD_SCENE_WINDOW (buttons->pdata[i]);
+          xrd_scene_window_record (button, eye,
+                                   _get_window_pipeline (pipelines, button,
+                                                         PIPELINE_WINDOWS_LIT),
+                                   pipeline_layout, cmd_buffer);
+        }
     }
-
-  for (GSList *l = xrd_window_manager_get_buttons (manager);
-       l != NULL; l = l->next)
+  else
     {
-      xrd_scene_window_draw_shaded (XRD_SCENE_WINDOW (l->data), eye,
-                                    pipelines[PIPELINE_WINDOWS],
-                                    pipeline_layout,
-                                    cmd_buffer, &view,
-                                   &self->mat_projection[eye]);
+      for (guint i = 0; i < windows->len; i++)
+        {
+          XrdSceneWindow *window = XRD_SCENE_WINDOW (windows->pdata[i]);
+          xrd_scene_window_draw (window, eye,
+                                 _get_window_pipeline (pipelines, window,
+                                                       PIPELINE_WINDOWS),
+                                 pipeline_layout,
+                                 cmd_buffer, &vp);
+        }
+
+      for (guint i = 0; i < buttons->len; i++)
+        {
+          XrdSceneWindow *button = XRD_SCENE_WINDOW (buttons->pdata[i]);
+          xrd_scene_window_draw_shaded (button, eye,
+                                        _get_window_pipeline (pipelines, button,
+                                                              PIPELINE_WINDOWS_LIT),
+                                        pipeline_layout,
+                                        cmd_buffer, &view,
+                                       &self->mat_projection[eye]);
+        }
     }
 
+  xrd_scene_background_render (self->background, eye,
+                               pipelines[PIPELINE_BACKGROUND],
+                               pipeline_layout, cmd_buffer, &vp);
+
   _render_pointers (self, eye, cmd_buffer, pipelines, pipeline_layout, &vp);
 
   xrd_scene_device_manager_render (self->device_manager, eye, cmd_buffer,
                                    pipelines[PIPELINE_DEVICE_MODELS],
                                    pipeline_layout, &vp);
 
-  GList *controllers =
-    g_hash_table_get_values (xrd_client_get_controllers (XRD_CLIENT (self)));
-  for (GList *l = controllers; l; l = l->next)
+  for (guint i = 0; i < blended->len; i++)
     {
-      XrdController *controller = XRD_CONTROLLER (l->data);
-      XrdScenePointerTip *scene_tip =
-        XRD_SCENE_POINTER_TIP (xrd_controller_get_pointer_tip (controller));
-      xrd_scene_window_draw (XRD_SCENE_WINDOW (scene_tip), eye,
-                             pipelines[PIPELINE_TIP],
+      XrdSceneWindow *window = XRD_SCENE_WINDOW (blended->pdata[i]);
+      xrd_scene_window_draw (window, eye,
+                             _get_window_pipeline (pipelines, window,
+                                                   PIPELINE_TIP),
                              pipeline_layout,
                              cmd_buffer, &vp);
     }
-  g_list_free (controllers);
-
-  XrdDesktopCursor *cursor = xrd_client_get_desktop_cursor (XRD_CLIENT (self));
-  XrdSceneDesktopCursor *scene_cursor = XRD_SCENE_DESKTOP_CURSOR (cursor);
-  xrd_scene_window_draw (XRD_SCENE_WINDOW (scene_cursor), eye,
-                         pipelines[PIPELINE_TIP],
-                         pipeline_layout,
-                         cmd_buffer, &vp);
 
 #if DEBUG_GEOMETRY
   for (uint32_t i = 0; i < G_N_ELEMENTS (self->debug_vectors); i++)
@@ -267,6 +587,145 @@ _render_eye_cb (uint32_t         eye,
 #endif
 }
 
+static guint64
+_mix_key (guint64 key, guint64 value)
+{
+  /* FNV-1a style, order dependent like the draw order */
+  return (key ^ value) * 1099511628211ull;
+}
+
+static guint64
+_mix_sorted (guint64 key, GPtrArray *sorted)
+{
+  for (guint i = 0; i < sorted->len; i++)
+    key = _mix_key (key, (guint64) (guintptr) sorted->pdata[i]);
+  return _mix_key (key, 0);
+}
+
+/* Hysteresis, so windows at the threshold do not switch every frame */
+#define MINIFY_DENSITY 0.5f
+#define MAGNIFY_DENSITY 0.6f
+
+/*
+ * Window textures have no mip maps. A window showing less than half of its
+ * texels on screen samples a mip chain instead, which _record_mips_cb
+ * regenerates for the regions damaged since the last frame.
+ */
+static void
+_update_window_mips (XrdSceneClient *self)
+{
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+
+  uint32_t render_width, render_height;
+  xrd_scene_renderer_get_render_size (renderer, &render_width, &render_height);
+
+  /* Screen pixels covered by one meter at a distance of one meter */
+  float focal_pixels = (float) render_height / 2.0f *
+    graphene_matrix_get_value (&self->mat_projection[EVREye_Eye_Left], 1, 1);
+
+  graphene_matrix_t view = _get_view_matrix (self, EVREye_Eye_Left);
+  graphene_matrix_t inverse_view;
+  graphene_matrix_inverse (&view, &inverse_view);
+  graphene_point3d_t eye_position;
+  graphene_ext_matrix_get_translation_point3d (&inverse_view, &eye_position);
+
+  XrdWindowManager *manager = xrd_client_get_manager (XRD_CLIENT (self));
+
+  for (GSList *l = xrd_window_manager_get_windows (manager); l; l = l->next)
+    {
+      XrdSceneWindow *window = XRD_SCENE_WINDOW (l->data);
+      XrdWindowData *data = xrd_window_get_data (XRD_WINDOW (window));
+      if (data->texture == NULL || data->texture_height == 0)
+        continue;
+
+      graphene_matrix_t model;
+      xrd_scene_object_get_model_matrix (XRD_SCENE_OBJECT (window), &model);
+      graphene_point3d_t center;
+      graphene_ext_matrix_get_translation_point3d (&model, &center);
+
+      float distance = graphene_point3d_distance (&eye_position, &center, NULL);
+      float height_meters =
+        xrd_window_get_current_height_meters (XRD_WINDOW (window));
+      float screen_pixels = height_meters / MAX (distance, 0.01f) * focal_pixels;
+      float density = screen_pixels / (float) data->texture_height;
+
+      if (density < MINIFY_DENSITY)
+        xrd_scene_window_set_minified (window, TRUE);
+      else if (density > MAGNIFY_DENSITY)
+        xrd_scene_window_set_minified (window, FALSE);
+    }
+}
+
+/* Records the mip blits at the start of the frame command buffer */
+static void
+_record_mips_cb (VkCommandBuffer cmd_buffer, gpointer _self)
+{
+  XrdSceneClient *self = XRD_SCENE_CLIENT (_self);
+  XrdWindowManager *manager = xrd_client_get_manager (XRD_CLIENT (self));
+
+  for (GSList *l = xrd_window_manager_get_windows (manager); l; l = l->next)
+    xrd_scene_window_record_mips (XRD_SCENE_WINDOW (l->data), cmd_buffer);
+}
+
+/*
+ * Sorts the scene and switches windows to or from their mip chain, before
+ * the structure key is computed and the eyes are recorded.
+ */
+static void
+_prepare_frame_cb (gpointer _self)
+{
+  XrdSceneClient *self = XRD_SCENE_CLIENT (_self);
+  _update_draw_orders (self);
+  _update_window_mips (self);
+}
+
+/*
+ * Everything that changes which commands _render_eye_cb records. Object
+ * level changes like visibility, textures and vertex buffers, including
+ * switching to a mip chain, are counted by the scene object structure
+ * serial, the lists are hashed here in the per eye draw order of
+ * _prepare_frame_cb. Windows with mip damage are hashed with their damage
+ * serial, so every frame that blits a mip chain, and the frame after it,
+ * is re-recorded. Only reads the scene.
+ */
+static guint64
+_structure_key_cb (gpointer _self)
+{
+  XrdSceneClient *self = XRD_SCENE_CLIENT (_self);
+
+  guint64 key = 14695981039346656037ull;
+  key = _mix_key (key, xrd_scene_object_get_structure_serial ());
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      key = _mix_sorted (key, self->sorted_windows[eye]);
+      key = _mix_sorted (key, self->sorted_buttons[eye]);
+      key = _mix_sorted (key, self->sorted_blended[eye]);
+    }
+
+  XrdWindowManager *manager = xrd_client_get_manager (XRD_CLIENT (self));
+  for (GSList *l = xrd_window_manager_get_windows (manager); l; l = l->next)
+    {
+      guint64 damage =
+        xrd_scene_window_get_mip_damage_serial (XRD_SCENE_WINDOW (l->data));
+      if (damage == 0)
+        continue;
+      key = _mix_key (key, (guint64) (guintptr) l->data);
+      key = _mix_key (key, damage);
+    }
+
+  GList *controllers =
+    g_hash_table_get_values (xrd_client_get_controllers (XRD_CLIENT (self)));
+  for (GList *l = controllers; l; l = l->next)
+    key = _mix_key (key, (guint64) (guintptr) l->data);
+  g_list_free (controllers);
+
+  OpenVRContext *context = openvr_context_get_instance ();
+  key = _mix_key (key, context->system->IsInputAvailable () ? 1 : 2);
+
+  return key;
+}
+
 static bool
 _init_vulkan (XrdSceneClient *self)
 {
@@ -301,6 +760,9 @@ _init_vulkan (XrdSceneClient *self)
 
   xrd_scene_renderer_set_render_cb (renderer, _render_eye_cb, self);
   xrd_scene_renderer_set_update_lights_cb (renderer, _update_lights_cb, self);
+  xrd_scene_renderer_set_prepare_frame_cb (renderer, _prepare_frame_cb, self);
+  xrd_scene_renderer_set_record_transfers_cb (renderer, _record_mips_cb, self);
+  xrd_scene_renderer_set_structure_key_cb (renderer, _structure_key_cb, self);
 
   return true;
 }
@@ -325,6 +787,89 @@ _init_controller (XrdClient     *client,
   xrd_controller_set_pointer_tip (controller, XRD_POINTER_TIP (pointer_tip));
 }
 
+static void
+_update_render_worker_threads (GSettings *settings, gchar *key,
+                               gpointer _self)
+{
+  XrdSceneClient *self = _self;
+  guint workers = MIN (g_settings_get_uint (settings, key),
+                       MAX_UNIFORM_WORKERS);
+
+  if (workers == self->uniform_workers)
+    return;
+
+  /* settings are applied on the main loop, never while a frame records */
+  if (self->uniform_pool)
+    {
+      g_thread_pool_free (self->uniform_pool, TRUE, TRUE);
+      self->uniform_pool = NULL;
+    }
+  self->uniform_workers = 0;
+
+  if (workers == 0)
+    return;
+
+  GError *error = NULL;
+  self->uniform_pool = g_thread_pool_new (_update_uniform_chunk_cb, self,
+                                          (gint) workers, TRUE, &error);
+  if (self->uniform_pool == NULL)
+    {
+      g_printerr ("Could not start render workers: %s\n", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  self->uniform_workers = workers;
+}
+
+static void
+_update_reuse_command_buffers (GSettings *settings, gchar *key,
+                               gpointer _self)
+{
+  (void) _self;
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  xrd_scene_renderer_set_reuse_commands (renderer,
+                                         g_settings_get_boolean (settings,
+                                                                 key));
+}
+
+static void
+_update_submit_depth (GSettings *settings, gchar *key, gpointer _self)
+{
+  XrdSceneClient *self = _self;
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  xrd_scene_renderer_set_depth_range (renderer, self->near, self->far);
+  xrd_scene_renderer_set_submit_depth (renderer,
+                                       g_settings_get_boolean (settings, key));
+}
+
+static void
+_update_msaa_samples (GSettings *settings, gchar *key, gpointer _self)
+{
+  (void) _self;
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  xrd_scene_renderer_set_msaa_samples (renderer,
+                                       g_settings_get_uint (settings, key));
+}
+
+static void
+_update_super_sample_scale (GSettings *settings, gchar *key, gpointer _self)
+{
+  (void) _self;
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  xrd_scene_renderer_set_super_sample_scale (
+    renderer, (float) g_settings_get_double (settings, key));
+}
+
+static void
+_update_foveated_rendering (GSettings *settings, gchar *key, gpointer _self)
+{
+  (void) _self;
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  xrd_scene_renderer_set_foveated (renderer,
+                                   g_settings_get_boolean (settings, key));
+}
+
 bool
 xrd_scene_client_initialize (XrdSceneClient *self)
 {
@@ -348,6 +893,19 @@ xrd_scene_client_initialize (XrdSceneClient *self)
 
   xrd_client_post_openvr_init (XRD_CLIENT (self));
 
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_render_worker_threads),
+                                  "render-worker-threads", self);
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_reuse_command_buffers),
+                                  "reuse-command-buffers", self);
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_submit_depth),
+                                  "submit-depth", self);
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_msaa_samples),
+                                  "msaa-samples", self);
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_super_sample_scale),
+                                  "super-sample-scale", self);
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_foveated_rendering),
+                                  "foveated-rendering", self);
+
   return true;
 }
 
@@ -387,6 +945,203 @@ xrd_scene_client_render (XrdSceneClient *self)
                                         &self->mat_head_pose);
 }
 
+/* Main loop: record and submit a frame with the poses the render thread
+ * received, then hand the fence back. Scene objects, the Vulkan queue and
+ * the command pool are only used from the main loop. */
+static void
+_render_stage_record (XrdSceneClient *self)
+{
+  self->frame_telemetry_start = xrd_telemetry_begin ();
+
+  xrd_scene_device_manager_apply_poses (self->device_manager,
+                                        self->render_poses,
+                                        &self->mat_head_pose);
+
+  XrdSceneFrameEvent *event = g_malloc (sizeof (XrdSceneFrameEvent));
+  event->frame = self->frame_count;
+  event->poses_time_us = self->render_poses_time;
+  g_signal_emit (self, scene_client_signals[FRAME_EVENT], 0, event);
+
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  xrd_scene_renderer_submit_frame (renderer, &self->frame_cmd_buffer);
+  self->frame_submitted = TRUE;
+}
+
+static void
+_render_stage_present (XrdSceneClient *self)
+{
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  if (!xrd_scene_renderer_end_frame (renderer, &self->frame_cmd_buffer, TRUE))
+    g_printerr ("Could not submit frame to the compositor.\n");
+  self->frame_submitted = FALSE;
+  self->frame_count++;
+
+  xrd_telemetry_end (XRD_TELEMETRY_RENDER, self->frame_telemetry_start);
+}
+
+static gboolean
+_render_stage_cb (gpointer _self)
+{
+  XrdSceneClient *self = _self;
+
+  g_mutex_lock (&self->render_mutex);
+  RenderStage stage = self->render_stage;
+  g_mutex_unlock (&self->render_mutex);
+
+  if (stage == RENDER_STAGE_RECORD)
+    _render_stage_record (self);
+  else if (stage == RENDER_STAGE_PRESENT)
+    _render_stage_present (self);
+
+  g_mutex_lock (&self->render_mutex);
+  self->render_stage = RENDER_STAGE_NONE;
+  g_cond_signal (&self->render_cond);
+  g_mutex_unlock (&self->render_mutex);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_render_stage_dispatch (GSource     *source,
+                        GSourceFunc  callback,
+                        gpointer     user_data)
+{
+  g_source_set_ready_time (source, -1);
+  return callback (user_data);
+}
+
+static GSourceFuncs render_stage_funcs = {
+  .dispatch = _render_stage_dispatch,
+};
+
+/* Render thread: blocks until the main loop ran @stage.
+ * Returns FALSE when the loop is stopped. */
+static gboolean
+_run_render_stage (XrdSceneClient *self,
+                   RenderStage     stage)
+{
+  g_mutex_lock (&self->render_mutex);
+  self->render_stage = stage;
+  g_source_set_ready_time (self->render_source, 0);
+  while (self->render_running && self->render_stage != RENDER_STAGE_NONE)
+    g_cond_wait (&self->render_cond, &self->render_mutex);
+  gboolean running = self->render_running;
+  g_mutex_unlock (&self->render_mutex);
+  return running;
+}
+
+static gboolean
+_is_render_loop_running (XrdSceneClient *self)
+{
+  g_mutex_lock (&self->render_mutex);
+  gboolean running = self->render_running;
+  g_mutex_unlock (&self->render_mutex);
+  return running;
+}
+
+/* Render thread: takes the blocking waits for the compositor and the GPU
+ * off the main loop. */
+static gpointer
+_render_thread_run (gpointer _self)
+{
+  XrdSceneClient *self = _self;
+  OpenVRContext *context = openvr_context_get_instance ();
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+
+  while (_is_render_loop_running (self))
+    {
+      context->compositor->WaitGetPoses (self->render_poses,
+                                         k_unMaxTrackedDeviceCount, NULL, 0);
+      self->render_poses_time = g_get_monotonic_time ();
+
+      if (!_run_render_stage (self, RENDER_STAGE_RECORD))
+        break;
+
+      xrd_scene_renderer_wait_frame (renderer, &self->frame_cmd_buffer);
+
+      if (!_run_render_stage (self, RENDER_STAGE_PRESENT))
+        break;
+    }
+
+  return NULL;
+}
+
+/**
+ * xrd_scene_client_start_render_loop:
+ * @self: The #XrdSceneClient
+ *
+ * Renders frames paced by the compositor until
+ * xrd_scene_client_stop_render_loop(). A render thread waits for the poses
+ * and for the GPU, so the main loop stays free for input and settings.
+ * Recording and submitting the frame happens in the main loop, right after
+ * #XrdSceneClient::frame-event. Window transformations and textures can be
+ * changed from the main loop at any time and show up in the next frame.
+ *
+ * Do not call xrd_scene_client_render() while the loop is running.
+ */
+void
+xrd_scene_client_start_render_loop (XrdSceneClient *self)
+{
+  if (self->render_thread != NULL)
+    return;
+
+  self->render_source = g_source_new (&render_stage_funcs, sizeof (GSource));
+  g_source_set_priority (self->render_source, G_PRIORITY_HIGH);
+  g_source_set_callback (self->render_source, _render_stage_cb, self, NULL);
+  g_source_attach (self->render_source, NULL);
+
+  self->render_running = TRUE;
+  self->render_stage = RENDER_STAGE_NONE;
+  self->render_thread = g_thread_new ("xrd-render", _render_thread_run, self);
+}
+
+/**
+ * xrd_scene_client_stop_render_loop:
+ * @self: The #XrdSceneClient
+ *
+ * Stops the render loop and waits for the render thread. Needs to be
+ * called from the main loop thread.
+ */
+void
+xrd_scene_client_stop_render_loop (XrdSceneClient *self)
+{
+  if (self->render_thread == NULL)
+    return;
+
+  g_mutex_lock (&self->render_mutex);
+  self->render_running = FALSE;
+  g_cond_signal (&self->render_cond);
+  g_mutex_unlock (&self->render_mutex);
+
+  g_thread_join (self->render_thread);
+  self->render_thread = NULL;
+
+  g_source_destroy (self->render_source);
+  g_clear_pointer (&self->render_source, g_source_unref);
+
+  /* The thread may have stopped between submitting and presenting */
+  if (self->frame_submitted)
+    {
+      XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+      xrd_scene_renderer_wait_frame (renderer, &self->frame_cmd_buffer);
+      xrd_scene_renderer_end_frame (renderer, &self->frame_cmd_buffer, FALSE);
+      self->frame_submitted = FALSE;
+      xrd_telemetry_end (XRD_TELEMETRY_RENDER, self->frame_telemetry_start);
+    }
+}
+
+/**
+ * xrd_scene_client_is_render_loop_running:
+ * @self: The #XrdSceneClient
+ *
+ * Returns: Whether xrd_scene_client_start_render_loop() is in effect.
+ */
+gboolean
+xrd_scene_client_is_render_loop_running (XrdSceneClient *self)
+{
+  return self->render_thread != NULL;
+}
+
 void
 _update_matrices (XrdSceneClient *self)
 {
@@ -449,6 +1204,22 @@ xrd_scene_client_class_init (XrdSceneClientClass *klass)
 
   object_class->finalize = xrd_scene_client_finalize;
 
+  /**
+   * XrdSceneClient::frame-event:
+   * @self: The #XrdSceneClient
+   * @event: (transfer full): The #XrdSceneFrameEvent, freed by the handler
+   * with g_free().
+   *
+   * Emitted from the main loop by the render loop before each frame is
+   * recorded, after the device poses were updated.
+   */
+  scene_client_signals[FRAME_EVENT] =
+    g_signal_new ("frame-event",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL, G_TYPE_NONE,
+                  1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
+
   XrdClientClass *xrd_client_class = XRD_CLIENT_CLASS (klass);
   xrd_client_class->get_uploader = _get_uploader;
   xrd_client_class->init_controller = _init_controller;
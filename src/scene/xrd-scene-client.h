@@ -29,6 +29,19 @@
 
 G_BEGIN_DECLS
 
+/**
+ * XrdSceneFrameEvent:
+ * @frame: The number of frames the render loop presented before this one.
+ * @poses_time_us: Monotonic time when the compositor returned the poses
+ * for this frame.
+ *
+ * Emitted by the render loop of #XrdSceneClient before a frame is recorded.
+ **/
+typedef struct {
+  guint64 frame;
+  gint64  poses_time_us;
+} XrdSceneFrameEvent;
+
 #define XRD_TYPE_SCENE_CLIENT xrd_scene_client_get_type ()
 G_DECLARE_FINAL_TYPE (XrdSceneClient, xrd_scene_client,
                       XRD, SCENE_CLIENT, XrdClient)
@@ -39,6 +52,15 @@ bool xrd_scene_client_initialize (XrdSceneClient *self);
 
 void xrd_scene_client_render (XrdSceneClient *self);
 
+void
+xrd_scene_client_start_render_loop (XrdSceneClient *self);
+
+void
+xrd_scene_client_stop_render_loop (XrdSceneClient *self);
+
+gboolean
+xrd_scene_client_is_render_loop_running (XrdSceneClient *self);
+
 GulkanClient *
 xrd_scene_client_get_uploader (XrdSceneClient *self);
 
@@ -141,7 +141,8 @@ xrd_scene_device_manager_render (XrdSceneDeviceManager *self,
                                  VkPipelineLayout       layout,
                                  graphene_matrix_t     *vp)
 {
-  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+  if (cmd_buffer != VK_NULL_HANDLE)
+    vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
   GList *devices = g_hash_table_get_values (self->devices);
   for (GList *l = devices; l; l = l->next)
@@ -156,6 +157,20 @@ xrd_scene_device_manager_update_poses (XrdSceneDeviceManager *self,
   OpenVRContext *context = openvr_context_get_instance ();
   context->compositor->WaitGetPoses (poses, k_unMaxTrackedDeviceCount, NULL, 0);
 
+  xrd_scene_device_manager_apply_poses (self, poses, mat_head_pose);
+}
+
+/**
+ * xrd_scene_device_manager_apply_poses:
+ * @self: The #XrdSceneDeviceManager
+ * @poses: k_unMaxTrackedDeviceCount poses from WaitGetPoses.
+ * @mat_head_pose: (out): The inverse HMD pose, unchanged if it is invalid.
+ */
+void
+xrd_scene_device_manager_apply_poses (XrdSceneDeviceManager *self,
+                                      TrackedDevicePose_t   *poses,
+                                      graphene_matrix_t     *mat_head_pose)
+{
   GList *device_keys = g_hash_table_get_keys (self->devices);
   for (GList *l = device_keys; l; l = l->next)
     {
@@ -48,6 +48,11 @@ void
 xrd_scene_device_manager_update_poses (XrdSceneDeviceManager *self,
                                        graphene_matrix_t     *mat_head_pose);
 
+void
+xrd_scene_device_manager_apply_poses (XrdSceneDeviceManager *self,
+                                      TrackedDevicePose_t   *poses,
+                                      graphene_matrix_t     *mat_head_pose);
+
 G_END_DECLS
 
 #endif /* XRD_SCENE_DEVICE_MANAGER_H_ */
@@ -84,6 +84,8 @@ xrd_scene_device_set_is_controller (XrdSceneDevice *self, bool is_controller)
 void
 xrd_scene_device_set_is_pose_valid (XrdSceneDevice *self, bool valid)
 {
+  if (self->pose_valid != valid)
+    xrd_scene_object_structure_changed ();
   self->pose_valid = valid;
 }
 
@@ -106,6 +108,11 @@ xrd_scene_device_draw (XrdSceneDevice    *self,
     return;
 
   xrd_scene_object_update_mvp_matrix (obj, eye, vp);
+
+  /* Only the uniform buffer is updated for a previously recorded frame */
+  if (cmd_buffer == VK_NULL_HANDLE)
+    return;
+
   xrd_scene_object_bind (obj, eye, cmd_buffer, pipeline_layout);
   gulkan_vertex_buffer_draw_indexed (xrd_scene_model_get_vbo (self->model),
                                      cmd_buffer);
@@ -0,0 +1,189 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-scene-draw-order.h"
+
+#include "graphene-ext.h"
+#include "xrd-scene-object.h"
+
+struct _XrdSceneDrawOrder
+{
+  GObject parent;
+
+  XrdSceneDrawOrderDirection direction;
+
+  /* XrdSceneObject pointers in draw order, not owned */
+  GPtrArray *objects;
+  /* The sort key of each object, in the same order */
+  GArray *keys;
+
+  /* Order independent hash of the objects, to notice additions */
+  guint64 membership;
+
+  guint moves;
+};
+
+G_DEFINE_TYPE (XrdSceneDrawOrder, xrd_scene_draw_order, G_TYPE_OBJECT)
+
+static void
+xrd_scene_draw_order_finalize (GObject *gobject);
+
+static void
+xrd_scene_draw_order_class_init (XrdSceneDrawOrderClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = xrd_scene_draw_order_finalize;
+}
+
+static void
+xrd_scene_draw_order_init (XrdSceneDrawOrder *self)
+{
+  self->direction = XRD_SCENE_DRAW_ORDER_FRONT_TO_BACK;
+  self->objects = g_ptr_array_new ();
+  self->keys = g_array_new (FALSE, FALSE, sizeof (float));
+  self->membership = 0;
+  self->moves = 0;
+}
+
+/**
+ * xrd_scene_draw_order_new:
+ * @direction: How to sort the objects.
+ *
+ * Keeps the draw order of a list of #XrdSceneObject from one frame to the
+ * next, so re-sorting is linear while objects do not pass each other.
+ *
+ * Returns: A new #XrdSceneDrawOrder.
+ */
+XrdSceneDrawOrder *
+xrd_scene_draw_order_new (XrdSceneDrawOrderDirection direction)
+{
+  XrdSceneDrawOrder *self =
+    (XrdSceneDrawOrder*) g_object_new (XRD_TYPE_SCENE_DRAW_ORDER, 0);
+  self->direction = direction;
+  return self;
+}
+
+static void
+xrd_scene_draw_order_finalize (GObject *gobject)
+{
+  XrdSceneDrawOrder *self = XRD_SCENE_DRAW_ORDER (gobject);
+  g_ptr_array_unref (self->objects);
+  g_array_unref (self->keys);
+  G_OBJECT_CLASS (xrd_scene_draw_order_parent_class)->finalize (gobject);
+}
+
+static guint64
+_hash_pointer (gpointer pointer)
+{
+  guint64 x = (guint64) (guintptr) pointer;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  return x;
+}
+
+static float
+_get_key (XrdSceneDrawOrder *self,
+          XrdSceneObject    *object,
+          graphene_matrix_t *view)
+{
+  graphene_matrix_t model;
+  xrd_scene_object_get_model_matrix (object, &model);
+
+  graphene_point3d_t position;
+  graphene_ext_matrix_get_translation_point3d (&model, &position);
+
+  graphene_point3d_t view_position;
+  graphene_matrix_transform_point3d (view, &position, &view_position);
+
+  /* The camera looks down -z, nearer objects have a larger z */
+  if (self->direction == XRD_SCENE_DRAW_ORDER_FRONT_TO_BACK)
+    return -view_position.z;
+  else
+    return view_position.z;
+}
+
+/**
+ * xrd_scene_draw_order_update:
+ * @self: The #XrdSceneDrawOrder
+ * @objects: (element-type XrdSceneObject): The objects to draw.
+ * @view: The view matrix of the eye.
+ *
+ * Sorts @objects by the view space depth of their origin. The order of the
+ * previous call is the starting point, so an insertion sort only has work
+ * to do for objects that changed places.
+ *
+ * Returns: (transfer none) (element-type XrdSceneObject): The objects in
+ * draw order, valid until the next call.
+ */
+GPtrArray *
+xrd_scene_draw_order_update (XrdSceneDrawOrder *self,
+                             GSList            *objects,
+                             graphene_matrix_t *view)
+{
+  guint count = 0;
+  guint64 membership = 0;
+  for (GSList *l = objects; l != NULL; l = l->next)
+    {
+      count++;
+      membership += _hash_pointer (l->data);
+    }
+
+  self->moves = 0;
+
+  if (count != self->objects->len || membership != self->membership)
+    {
+      g_ptr_array_set_size (self->objects, 0);
+      for (GSList *l = objects; l != NULL; l = l->next)
+        g_ptr_array_add (self->objects, l->data);
+      self->membership = membership;
+    }
+
+  g_array_set_size (self->keys, self->objects->len);
+
+  gpointer *sorted = self->objects->pdata;
+  float *keys = (float *) self->keys->data;
+
+  for (guint i = 0; i < self->objects->len; i++)
+    keys[i] = _get_key (self, XRD_SCENE_OBJECT (sorted[i]), view);
+
+  for (guint i = 1; i < self->objects->len; i++)
+    {
+      gpointer object = sorted[i];
+      float key = keys[i];
+
+      guint j = i;
+      while (j > 0 && keys[j - 1] > key)
+        {
+          sorted[j] = sorted[j - 1];
+          keys[j] = keys[j - 1];
+          j--;
+        }
+
+      if (j != i)
+        {
+          sorted[j] = object;
+          keys[j] = key;
+          self->moves++;
+        }
+    }
+
+  return self->objects;
+}
+
+/**
+ * xrd_scene_draw_order_get_moves:
+ * @self: The #XrdSceneDrawOrder
+ *
+ * Returns: How many objects changed places in the last
+ * xrd_scene_draw_order_update().
+ */
+guint
+xrd_scene_draw_order_get_moves (XrdSceneDrawOrder *self)
+{
+  return self->moves;
+}
@@ -0,0 +1,50 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_SCENE_DRAW_ORDER_H_
+#define XRD_SCENE_DRAW_ORDER_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+#include <graphene.h>
+
+G_BEGIN_DECLS
+
+/**
+ * XrdSceneDrawOrderDirection:
+ * @XRD_SCENE_DRAW_ORDER_FRONT_TO_BACK: Nearest first, for opaque objects,
+ * so the depth test rejects hidden fragments before they are shaded.
+ * @XRD_SCENE_DRAW_ORDER_BACK_TO_FRONT: Farthest first, for blended objects.
+ *
+ * How an #XrdSceneDrawOrder sorts its objects.
+ **/
+typedef enum {
+  XRD_SCENE_DRAW_ORDER_FRONT_TO_BACK,
+  XRD_SCENE_DRAW_ORDER_BACK_TO_FRONT
+} XrdSceneDrawOrderDirection;
+
+#define XRD_TYPE_SCENE_DRAW_ORDER xrd_scene_draw_order_get_type()
+G_DECLARE_FINAL_TYPE (XrdSceneDrawOrder, xrd_scene_draw_order,
+                      XRD, SCENE_DRAW_ORDER, GObject)
+
+XrdSceneDrawOrder *
+xrd_scene_draw_order_new (XrdSceneDrawOrderDirection direction);
+
+GPtrArray *
+xrd_scene_draw_order_update (XrdSceneDrawOrder *self,
+                             GSList            *objects,
+                             graphene_matrix_t *view);
+
+guint
+xrd_scene_draw_order_get_moves (XrdSceneDrawOrder *self);
+
+G_END_DECLS
+
+#endif /* XRD_SCENE_DRAW_ORDER_H_ */
@@ -0,0 +1,430 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-scene-mip-chain.h"
+
+struct _XrdSceneMipChain
+{
+  GObject parent;
+
+  GulkanDevice *device;
+
+  VkImage image;
+  VkDeviceMemory memory;
+  VkImageView image_view;
+  VkSampler sampler;
+
+  /* Size of the source texture, level 0 is half of it */
+  uint32_t source_width;
+  uint32_t source_height;
+  uint32_t width;
+  uint32_t height;
+  uint32_t levels;
+
+  /* The image has been written once, so partial updates are possible */
+  gboolean has_contents;
+};
+
+G_DEFINE_TYPE (XrdSceneMipChain, xrd_scene_mip_chain, G_TYPE_OBJECT)
+
+static void
+xrd_scene_mip_chain_finalize (GObject *gobject);
+
+static void
+xrd_scene_mip_chain_class_init (XrdSceneMipChainClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = xrd_scene_mip_chain_finalize;
+}
+
+static void
+xrd_scene_mip_chain_init (XrdSceneMipChain *self)
+{
+  self->device = NULL;
+  self->image = VK_NULL_HANDLE;
+  self->memory = VK_NULL_HANDLE;
+  self->image_view = VK_NULL_HANDLE;
+  self->sampler = VK_NULL_HANDLE;
+  self->source_width = 0;
+  self->source_height = 0;
+  self->width = 0;
+  self->height = 0;
+  self->levels = 0;
+  self->has_contents = FALSE;
+}
+
+/**
+ * xrd_scene_mip_chain_new:
+ *
+ * A mip chain for a texture that was created without one. Level 0 has half
+ * the size of the texture, since it is only sampled instead of the texture
+ * when the texture would be minified by at least that much.
+ *
+ * Returns: A new #XrdSceneMipChain.
+ */
+XrdSceneMipChain *
+xrd_scene_mip_chain_new (void)
+{
+  return (XrdSceneMipChain*) g_object_new (XRD_TYPE_SCENE_MIP_CHAIN, 0);
+}
+
+static void
+_destroy (XrdSceneMipChain *self)
+{
+  if (self->device == NULL)
+    return;
+
+  VkDevice device = gulkan_device_get_handle (self->device);
+
+  if (self->sampler != VK_NULL_HANDLE)
+    vkDestroySampler (device, self->sampler, NULL);
+  if (self->image_view != VK_NULL_HANDLE)
+    vkDestroyImageView (device, self->image_view, NULL);
+  if (self->image != VK_NULL_HANDLE)
+    vkDestroyImage (device, self->image, NULL);
+  if (self->memory != VK_NULL_HANDLE)
+    vkFreeMemory (device, self->memory, NULL);
+
+  self->sampler = VK_NULL_HANDLE;
+  self->image_view = VK_NULL_HANDLE;
+  self->image = VK_NULL_HANDLE;
+  self->memory = VK_NULL_HANDLE;
+  self->has_contents = FALSE;
+}
+
+static void
+xrd_scene_mip_chain_finalize (GObject *gobject)
+{
+  XrdSceneMipChain *self = XRD_SCENE_MIP_CHAIN (gobject);
+  _destroy (self);
+  g_clear_object (&self->device);
+  G_OBJECT_CLASS (xrd_scene_mip_chain_parent_class)->finalize (gobject);
+}
+
+/**
+ * xrd_scene_mip_chain_initialize:
+ * @self: The #XrdSceneMipChain
+ * @device: The device the source texture lives on.
+ * @format: The format of the chain, blits convert from the source format.
+ * @source_width: The width of the source texture.
+ * @source_height: The height of the source texture.
+ *
+ * Allocates the chain, its contents are undefined until the first
+ * xrd_scene_mip_chain_record().
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+xrd_scene_mip_chain_initialize (XrdSceneMipChain *self,
+                                GulkanDevice     *device,
+                                VkFormat          format,
+                                uint32_t          source_width,
+                                uint32_t          source_height)
+{
+  _destroy (self);
+
+  if (self->device != device)
+    {
+      g_clear_object (&self->device);
+      self->device = g_object_ref (device);
+    }
+
+  self->source_width = source_width;
+  self->source_height = source_height;
+  self->width = MAX (source_width / 2, 1);
+  self->height = MAX (source_height / 2, 1);
+
+  self->levels = 1;
+  for (uint32_t size = MAX (self->width, self->height); size > 1; size /= 2)
+    self->levels++;
+
+  VkDevice device_handle = gulkan_device_get_handle (device);
+
+  VkImageCreateInfo image_info = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+    .imageType = VK_IMAGE_TYPE_2D,
+    .format = format,
+    .extent = {
+      .width = self->width,
+      .height = self->height,
+      .depth = 1
+    },
+    .mipLevels = self->levels,
+    .arrayLayers = 1,
+    .samples = VK_SAMPLE_COUNT_1_BIT,
+    .tiling = VK_IMAGE_TILING_OPTIMAL,
+    .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+             VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+             VK_IMAGE_USAGE_SAMPLED_BIT,
+    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+  };
+  VkResult res = vkCreateImage (device_handle, &image_info, NULL,
+                                &self->image);
+  vk_check_error ("vkCreateImage", res, FALSE)
+
+  VkMemoryRequirements requirements;
+  vkGetImageMemoryRequirements (device_handle, self->image, &requirements);
+
+  VkMemoryAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    .allocationSize = requirements.size
+  };
+  if (!gulkan_device_memory_type_from_properties (
+        device, requirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &alloc_info.memoryTypeIndex))
+    {
+      g_printerr ("Could not find a memory type for the mip chain.\n");
+      return FALSE;
+    }
+
+  res = vkAllocateMemory (device_handle, &alloc_info, NULL, &self->memory);
+  vk_check_error ("vkAllocateMemory", res, FALSE)
+
+  res = vkBindImageMemory (device_handle, self->image, self->memory, 0);
+  vk_check_error ("vkBindImageMemory", res, FALSE)
+
+  VkImageViewCreateInfo view_info = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+    .image = self->image,
+    .viewType = VK_IMAGE_VIEW_TYPE_2D,
+    .format = format,
+    .subresourceRange = {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = 0,
+      .levelCount = self->levels,
+      .baseArrayLayer = 0,
+      .layerCount = 1
+    }
+  };
+  res = vkCreateImageView (device_handle, &view_info, NULL,
+                           &self->image_view);
+  vk_check_error ("vkCreateImageView", res, FALSE)
+
+  VkSamplerCreateInfo sampler_info = {
+    .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+    .magFilter = VK_FILTER_LINEAR,
+    .minFilter = VK_FILTER_LINEAR,
+    .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+    .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+    .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+    .anisotropyEnable = VK_TRUE,
+    .maxAnisotropy = 16.0f,
+    .minLod = 0.0f,
+    .maxLod = (float) self->levels
+  };
+  res = vkCreateSampler (device_handle, &sampler_info, NULL, &self->sampler);
+  vk_check_error ("vkCreateSampler", res, FALSE)
+
+  return TRUE;
+}
+
+/**
+ * xrd_scene_mip_chain_matches:
+ * @self: The #XrdSceneMipChain
+ * @source_width: The width of a source texture.
+ * @source_height: The height of a source texture.
+ *
+ * Returns: Whether the chain is allocated for a source of this size.
+ */
+gboolean
+xrd_scene_mip_chain_matches (XrdSceneMipChain *self,
+                             uint32_t          source_width,
+                             uint32_t          source_height)
+{
+  return self->image != VK_NULL_HANDLE &&
+         self->source_width == source_width &&
+         self->source_height == source_height;
+}
+
+static void
+_barrier (VkCommandBuffer      cmd_buffer,
+          VkImage              image,
+          uint32_t             level,
+          uint32_t             level_count,
+          VkImageLayout        old_layout,
+          VkImageLayout        new_layout,
+          VkAccessFlags        src_access,
+          VkAccessFlags        dst_access,
+          VkPipelineStageFlags src_stage,
+          VkPipelineStageFlags dst_stage)
+{
+  VkImageMemoryBarrier barrier = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+    .srcAccessMask = src_access,
+    .dstAccessMask = dst_access,
+    .oldLayout = old_layout,
+    .newLayout = new_layout,
+    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .image = image,
+    .subresourceRange = {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = level,
+      .levelCount = level_count,
+      .baseArrayLayer = 0,
+      .layerCount = 1
+    }
+  };
+  vkCmdPipelineBarrier (cmd_buffer, src_stage, dst_stage, 0,
+                        0, NULL, 0, NULL, 1, &barrier);
+}
+
+/**
+ * xrd_scene_mip_chain_record:
+ * @self: The #XrdSceneMipChain
+ * @cmd_buffer: A command buffer outside of a render pass.
+ * @source: Level 0 of the source texture, in
+ * %VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL like all window textures.
+ * @damage: (nullable): The region of @source that changed, %NULL for all.
+ *
+ * Records a blit chain that downsamples @damage through all levels, each
+ * level from the previous one. Only the texels covering @damage are
+ * written, unless the chain has no contents yet.
+ */
+void
+xrd_scene_mip_chain_record (XrdSceneMipChain *self,
+                            VkCommandBuffer   cmd_buffer,
+                            VkImage           source,
+                            const VkRect2D   *damage)
+{
+  if (self->image == VK_NULL_HANDLE)
+    return;
+
+  int32_t x0 = 0;
+  int32_t y0 = 0;
+  int32_t x1 = (int32_t) self->source_width;
+  int32_t y1 = (int32_t) self->source_height;
+
+  if (damage != NULL && self->has_contents)
+    {
+      x0 = CLAMP (damage->offset.x, 0, x1);
+      y0 = CLAMP (damage->offset.y, 0, y1);
+      x1 = CLAMP (damage->offset.x + (int32_t) damage->extent.width, x0, x1);
+      y1 = CLAMP (damage->offset.y + (int32_t) damage->extent.height, y0, y1);
+      if (x0 == x1 || y0 == y1)
+        return;
+    }
+
+  _barrier (cmd_buffer, source, 0, 1,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+  /* Texels outside of the damage are kept, unless there are none yet */
+  _barrier (cmd_buffer, self->image, 0, self->levels,
+            self->has_contents ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                               : VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+  VkImage src_image = source;
+  uint32_t src_level = 0;
+  int32_t src_width = (int32_t) self->source_width;
+  int32_t src_height = (int32_t) self->source_height;
+
+  for (uint32_t level = 0; level < self->levels; level++)
+    {
+      int32_t dst_width = (int32_t) MAX (self->width >> level, 1);
+      int32_t dst_height = (int32_t) MAX (self->height >> level, 1);
+
+      /* The texels of this level covering the damage of the previous one */
+      int32_t dx0 = MIN (x0 / 2, dst_width - 1);
+      int32_t dy0 = MIN (y0 / 2, dst_height - 1);
+      int32_t dx1 = MIN ((x1 + 1) / 2, dst_width);
+      int32_t dy1 = MIN ((y1 + 1) / 2, dst_height);
+
+      /* Full images are blitted as is, regions scaled by two */
+      gboolean full = dx0 == 0 && dy0 == 0 &&
+                      dx1 == dst_width && dy1 == dst_height;
+
+      VkImageBlit blit = {
+        .srcSubresource = {
+          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+          .mipLevel = src_level,
+          .baseArrayLayer = 0,
+          .layerCount = 1
+        },
+        .srcOffsets = {
+          { full ? 0 : dx0 * 2, full ? 0 : dy0 * 2, 0 },
+          { full ? src_width : MIN (dx1 * 2, src_width),
+            full ? src_height : MIN (dy1 * 2, src_height), 1 }
+        },
+        .dstSubresource = {
+          .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+          .mipLevel = level,
+          .baseArrayLayer = 0,
+          .layerCount = 1
+        },
+        .dstOffsets = {
+          { dx0, dy0, 0 },
+          { dx1, dy1, 1 }
+        }
+      };
+
+      vkCmdBlitImage (cmd_buffer,
+                      src_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                      self->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                      1, &blit, VK_FILTER_LINEAR);
+
+      /* Source of the next level */
+      _barrier (cmd_buffer, self->image, level, 1,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+      src_image = self->image;
+      src_level = level;
+      src_width = dst_width;
+      src_height = dst_height;
+      x0 = dx0;
+      y0 = dy0;
+      x1 = dx1;
+      y1 = dy1;
+    }
+
+  _barrier (cmd_buffer, source, 0, 1,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+  _barrier (cmd_buffer, self->image, 0, self->levels,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+  self->has_contents = TRUE;
+}
+
+VkImageView
+xrd_scene_mip_chain_get_image_view (XrdSceneMipChain *self)
+{
+  return self->image_view;
+}
+
+VkSampler
+xrd_scene_mip_chain_get_sampler (XrdSceneMipChain *self)
+{
+  return self->sampler;
+}
+
+uint32_t
+xrd_scene_mip_chain_get_levels (XrdSceneMipChain *self)
+{
+  return self->levels;
+}
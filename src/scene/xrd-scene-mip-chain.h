@@ -0,0 +1,57 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_SCENE_MIP_CHAIN_H_
+#define XRD_SCENE_MIP_CHAIN_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+
+#include <gulkan.h>
+
+G_BEGIN_DECLS
+
+#define XRD_TYPE_SCENE_MIP_CHAIN xrd_scene_mip_chain_get_type()
+G_DECLARE_FINAL_TYPE (XrdSceneMipChain, xrd_scene_mip_chain,
+                      XRD, SCENE_MIP_CHAIN, GObject)
+
+XrdSceneMipChain *
+xrd_scene_mip_chain_new (void);
+
+gboolean
+xrd_scene_mip_chain_initialize (XrdSceneMipChain *self,
+                                GulkanDevice     *device,
+                                VkFormat          format,
+                                uint32_t          source_width,
+                                uint32_t          source_height);
+
+gboolean
+xrd_scene_mip_chain_matches (XrdSceneMipChain *self,
+                             uint32_t          source_width,
+                             uint32_t          source_height);
+
+void
+xrd_scene_mip_chain_record (XrdSceneMipChain *self,
+                            VkCommandBuffer   cmd_buffer,
+                            VkImage           source,
+                            const VkRect2D   *damage);
+
+VkImageView
+xrd_scene_mip_chain_get_image_view (XrdSceneMipChain *self);
+
+VkSampler
+xrd_scene_mip_chain_get_sampler (XrdSceneMipChain *self);
+
+uint32_t
+xrd_scene_mip_chain_get_levels (XrdSceneMipChain *self);
+
+G_END_DECLS
+
+#endif /* XRD_SCENE_MIP_CHAIN_H_ */
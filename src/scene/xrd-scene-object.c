@@ -41,6 +41,9 @@ typedef struct _XrdSceneObjectPrivate
 
 G_DEFINE_TYPE_WITH_PRIVATE (XrdSceneObject, xrd_scene_object, G_TYPE_OBJECT)
 
+/* Bumped whenever recorded draw commands of any object become stale. */
+static guint64 structure_serial = 0;
+
 static void
 xrd_scene_object_finalize (GObject *gobject);
 
@@ -80,6 +83,8 @@ xrd_scene_object_finalize (GObject *gobject)
   if (!priv->initialized)
     return;
 
+  xrd_scene_object_structure_changed ();
+
   XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
   VkDevice device = gulkan_client_get_device_handle (GULKAN_CLIENT (renderer));
   vkDestroyDescriptorPool (device, priv->descriptor_pool, NULL);
@@ -244,6 +249,7 @@ xrd_scene_object_initialize (XrdSceneObject        *self,
       return FALSE;
 
   priv->initialized = TRUE;
+  xrd_scene_object_structure_changed ();
 
   return TRUE;
 }
@@ -292,6 +298,8 @@ xrd_scene_object_update_descriptors_texture (XrdSceneObject *self,
 
       vkUpdateDescriptorSets (device, 2, write_descriptor_sets, 0, NULL);
     }
+
+  xrd_scene_object_structure_changed ();
 }
 
 void
@@ -322,6 +330,8 @@ xrd_scene_object_update_descriptors (XrdSceneObject *self)
 
       vkUpdateDescriptorSets (device, 1, write_descriptor_sets, 0, NULL);
     }
+
+  xrd_scene_object_structure_changed ();
 }
 
 void
@@ -381,6 +391,8 @@ void
 xrd_scene_object_show (XrdSceneObject *self)
 {
   XrdSceneObjectPrivate *priv = xrd_scene_object_get_instance_private (self);
+  if (!priv->visible)
+    xrd_scene_object_structure_changed ();
   priv->visible = true;
 }
 
@@ -388,6 +400,8 @@ void
 xrd_scene_object_hide (XrdSceneObject *self)
 {
   XrdSceneObjectPrivate *priv = xrd_scene_object_get_instance_private (self);
+  if (priv->visible)
+    xrd_scene_object_structure_changed ();
   priv->visible = false;
 }
 
@@ -404,3 +418,29 @@ xrd_scene_object_get_descriptor_set (XrdSceneObject *self, uint32_t eye)
   XrdSceneObjectPrivate *priv = xrd_scene_object_get_instance_private (self);
   return priv->descriptor_sets[eye];
 }
+
+/**
+ * xrd_scene_object_structure_changed:
+ *
+ * Marks recorded draw commands as stale. Call this whenever a change to an
+ * object would record different commands: it was shown or hidden, its
+ * descriptor sets were written or its vertex buffer was reallocated.
+ * Matrix changes only touch uniform buffers and do not need this.
+ */
+void
+xrd_scene_object_structure_changed (void)
+{
+  structure_serial++;
+}
+
+/**
+ * xrd_scene_object_get_structure_serial:
+ *
+ * Returns: A counter that changes with every
+ * xrd_scene_object_structure_changed().
+ */
+guint64
+xrd_scene_object_get_structure_serial (void)
+{
+  return structure_serial;
+}
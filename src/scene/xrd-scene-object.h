@@ -113,6 +113,12 @@ xrd_scene_object_get_transformation_buffer (XrdSceneObject *self, uint32_t eye);
 VkDescriptorSet
 xrd_scene_object_get_descriptor_set (XrdSceneObject *self, uint32_t eye);
 
+void
+xrd_scene_object_structure_changed (void);
+
+guint64
+xrd_scene_object_get_structure_serial (void);
+
 G_END_DECLS
 
 #endif /* XRD_SCENE_OBJECT_H_ */
@@ -72,6 +72,7 @@ xrd_scene_pointer_initialize (XrdScenePointer       *self,
                               VkDescriptorSetLayout *layout)
 {
   gulkan_vertex_buffer_reset (self->vertex_buffer);
+  xrd_scene_object_structure_changed ();
 
   graphene_vec4_t start;
   graphene_vec4_init (&start, 0, 0, self->data.start_offset, 1);
@@ -116,12 +117,17 @@ xrd_scene_pointer_render (XrdScenePointer   *self,
 
   xrd_scene_object_update_mvp_matrix (obj, eye, vp);
 
-  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+  /* Only the uniform buffers are updated for a previously recorded frame */
+  if (cmd_buffer != VK_NULL_HANDLE)
+    vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
   xrd_scene_selection_render (self->selection, eye,
                               selection_pipeline, pipeline_layout,
                               cmd_buffer, vp);
 
+  if (cmd_buffer == VK_NULL_HANDLE)
+    return;
+
   xrd_scene_object_bind (obj, eye, cmd_buffer, pipeline_layout);
   gulkan_vertex_buffer_draw (self->vertex_buffer, cmd_buffer);
 }
@@ -141,6 +147,7 @@ _set_length (XrdPointer *pointer,
 {
   XrdScenePointer *self = XRD_SCENE_POINTER (pointer);
   gulkan_vertex_buffer_reset (self->vertex_buffer);
+  xrd_scene_object_structure_changed ();
 
   graphene_matrix_t identity;
   graphene_matrix_init_identity (&identity);
@@ -17,12 +17,23 @@
 #include "xrd-scene-pointer-tip.h"
 
 #include "graphene-ext.h"
+#include "xrd-telemetry.h"
 
 typedef struct {
   graphene_point3d_t position;
   graphene_point_t   uv;
 } XrdSceneVertex;
 
+/* One per controller pointer tip, the size of lights in window.frag */
+#define XRD_SCENE_MAX_LIGHTS 64
+
+/*
+ * A light is culled from windows farther away than this many radii. The
+ * shader scales the radius with the view distance, beyond it a light adds
+ * less than half of the diffuse color, which the lighten blend hides.
+ */
+#define XRD_SCENE_LIGHT_CULL_RADII 3.0f
+
 typedef struct {
   float position[4];
   float color[4];
@@ -31,10 +42,26 @@ typedef struct {
 } XrdSceneLight;
 
 typedef struct {
-  XrdSceneLight lights[2];
+  XrdSceneLight lights[XRD_SCENE_MAX_LIGHTS];
   int active_lights;
 } XrdSceneLights;
 
+#define XRD_SCENE_DEPTH_FORMAT VK_FORMAT_D32_SFLOAT
+
+/* Resolution of the foveated periphery, relative to the eye render size */
+#define XRD_SCENE_FOVEA_PERIPHERY_SCALE 0.5f
+/* Size of the full resolution inset, relative to the eye render size */
+#define XRD_SCENE_FOVEA_INSET_SCALE 0.5f
+
+/*
+ * VRTextureWithDepth_t as the C++ API lays it out, the C header drops the
+ * Texture_t it derives from.
+ */
+typedef struct {
+  Texture_t texture;
+  VRTextureDepthInfo_t depth;
+} XrdSceneTextureWithDepth;
+
 struct _XrdSceneRenderer
 {
   GulkanClient parent;
@@ -42,6 +69,11 @@ struct _XrdSceneRenderer
   VkSampleCountFlagBits msaa_sample_count;
   float super_sample_scale;
 
+  /* Requested from settings, applied when the next frame is submitted */
+  VkSampleCountFlagBits pending_msaa_sample_count;
+  float pending_super_sample_scale;
+  gboolean render_targets_pending;
+
   VkShaderModule shader_modules[PIPELINE_COUNT * 2];
   VkPipeline pipelines[PIPELINE_COUNT];
   VkDescriptorSetLayout descriptor_set_layout;
@@ -53,6 +85,9 @@ struct _XrdSceneRenderer
   uint32_t render_width;
   uint32_t render_height;
 
+  /* Initialized without a compositor, frames are rendered but not submitted */
+  gboolean headless;
+
   gpointer scene_client;
 
   XrdSceneLights lights;
@@ -66,6 +101,61 @@ struct _XrdSceneRenderer
                  gpointer         data);
 
   void (*update_lights) (gpointer data);
+
+  void (*prepare_frame) (gpointer data);
+
+  void (*record_transfers) (VkCommandBuffer cmd_buffer, gpointer data);
+
+  guint64 (*structure_key) (gpointer data);
+
+  /* Resubmitted while the structure key does not change */
+  gboolean reuse_commands;
+  GulkanCommandBuffer cached_cmd_buffer;
+  gboolean cached_valid;
+  guint64 cached_key;
+
+  guint64 frames_recorded;
+  guint64 frames_reused;
+
+  /* Occlusion queries counting the samples passing the depth test */
+  gboolean count_samples;
+  VkQueryPool sample_query_pool;
+  gboolean frame_counted;
+  guint64 samples_passed;
+
+  /*
+   * Single sampled depth of the scene, drawn in an extra depth only pass
+   * and submitted with the color images for depth aware reprojection.
+   */
+  gboolean submit_depth;
+  gboolean frame_has_depth;
+  VkRenderPass depth_pass;
+  VkImage depth_images[2];
+  VkDeviceMemory depth_memory[2];
+  VkImageView depth_image_views[2];
+  VkFramebuffer depth_framebuffers[2];
+  VkPipeline depth_pipelines[PIPELINE_COUNT];
+  HmdMatrix44_t depth_projection[2];
+  VkQueryPool depth_query_pool;
+  float timestamp_period;
+
+  /*
+   * Fixed foveation. The whole field of view is drawn at reduced
+   * resolution, a full resolution inset around the lens center on top.
+   * Both are composited into a single sampled image per eye, which is
+   * submitted instead of the framebuffer.
+   */
+  gboolean foveated;
+  gboolean frame_foveated;
+  GulkanFrameBuffer *periphery[2];
+  GulkanFrameBuffer *inset[2];
+  uint32_t periphery_width;
+  uint32_t periphery_height;
+  VkRect2D inset_rect[2];
+  VkImage periphery_resolve[2];
+  VkDeviceMemory periphery_resolve_memory[2];
+  VkImage composite[2];
+  VkDeviceMemory composite_memory[2];
 };
 
 G_DEFINE_TYPE (XrdSceneRenderer, xrd_scene_renderer, GULKAN_TYPE_CLIENT)
@@ -85,8 +175,16 @@ xrd_scene_renderer_init (XrdSceneRenderer *self)
 {
   self->msaa_sample_count = VK_SAMPLE_COUNT_4_BIT;
   self->super_sample_scale = 1.0f;
+  self->pending_msaa_sample_count = self->msaa_sample_count;
+  self->pending_super_sample_scale = self->super_sample_scale;
+  self->render_targets_pending = FALSE;
   self->render_eye = NULL;
+  self->update_lights = NULL;
+  self->prepare_frame = NULL;
+  self->record_transfers = NULL;
+  self->structure_key = NULL;
   self->scene_client = NULL;
+  self->headless = FALSE;
   self->lights_buffer = gulkan_uniform_buffer_new ();
 
   self->lights.active_lights = 0;
@@ -96,7 +194,7 @@ xrd_scene_renderer_init (XrdSceneRenderer *self)
   graphene_vec4_t color;
   graphene_vec4_init (&color,.078f, .471f, .675f, 1);
 
-  for (uint32_t i = 0; i < 2; i++)
+  for (uint32_t i = 0; i < XRD_SCENE_MAX_LIGHTS; i++)
     {
       graphene_vec4_to_float (&position, self->lights.lights[i].position);
       graphene_vec4_to_float (&color, self->lights.lights[i].color);
@@ -107,8 +205,111 @@ xrd_scene_renderer_init (XrdSceneRenderer *self)
   self->pipeline_layout = VK_NULL_HANDLE;
   self->pipeline_cache = VK_NULL_HANDLE;
 
+  self->reuse_commands = FALSE;
+  self->cached_cmd_buffer.handle = VK_NULL_HANDLE;
+  self->cached_cmd_buffer.fence = VK_NULL_HANDLE;
+  self->cached_valid = FALSE;
+  self->cached_key = 0;
+  self->frames_recorded = 0;
+  self->frames_reused = 0;
+
+  self->count_samples = FALSE;
+  self->sample_query_pool = VK_NULL_HANDLE;
+  self->frame_counted = FALSE;
+  self->samples_passed = 0;
+
+  self->submit_depth = FALSE;
+  self->frame_has_depth = FALSE;
+  self->depth_pass = VK_NULL_HANDLE;
+  self->depth_query_pool = VK_NULL_HANDLE;
+  self->timestamp_period = 1.0f;
+  for (uint32_t i = 0; i < PIPELINE_COUNT; i++)
+    self->depth_pipelines[i] = VK_NULL_HANDLE;
+
+  self->foveated = FALSE;
+  self->frame_foveated = FALSE;
+  self->periphery_width = 0;
+  self->periphery_height = 0;
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      self->framebuffer[eye] = gulkan_frame_buffer_new();
+      self->depth_images[eye] = VK_NULL_HANDLE;
+      self->depth_memory[eye] = VK_NULL_HANDLE;
+      self->depth_image_views[eye] = VK_NULL_HANDLE;
+      self->depth_framebuffers[eye] = VK_NULL_HANDLE;
+
+      self->periphery[eye] = NULL;
+      self->inset[eye] = NULL;
+      self->periphery_resolve[eye] = VK_NULL_HANDLE;
+      self->periphery_resolve_memory[eye] = VK_NULL_HANDLE;
+      self->composite[eye] = VK_NULL_HANDLE;
+      self->composite_memory[eye] = VK_NULL_HANDLE;
+    }
+}
+
+static void
+_destroy_depth (XrdSceneRenderer *self, VkDevice device)
+{
+  for (uint32_t i = 0; i < PIPELINE_COUNT; i++)
+    if (self->depth_pipelines[i] != VK_NULL_HANDLE)
+      {
+        vkDestroyPipeline (device, self->depth_pipelines[i], NULL);
+        self->depth_pipelines[i] = VK_NULL_HANDLE;
+      }
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      if (self->depth_framebuffers[eye] != VK_NULL_HANDLE)
+        vkDestroyFramebuffer (device, self->depth_framebuffers[eye], NULL);
+      if (self->depth_image_views[eye] != VK_NULL_HANDLE)
+        vkDestroyImageView (device, self->depth_image_views[eye], NULL);
+      if (self->depth_images[eye] != VK_NULL_HANDLE)
+        vkDestroyImage (device, self->depth_images[eye], NULL);
+      if (self->depth_memory[eye] != VK_NULL_HANDLE)
+        vkFreeMemory (device, self->depth_memory[eye], NULL);
+
+      self->depth_framebuffers[eye] = VK_NULL_HANDLE;
+      self->depth_image_views[eye] = VK_NULL_HANDLE;
+      self->depth_images[eye] = VK_NULL_HANDLE;
+      self->depth_memory[eye] = VK_NULL_HANDLE;
+    }
+
+  if (self->depth_pass != VK_NULL_HANDLE)
+    {
+      vkDestroyRenderPass (device, self->depth_pass, NULL);
+      self->depth_pass = VK_NULL_HANDLE;
+    }
+
+  if (self->depth_query_pool != VK_NULL_HANDLE)
+    {
+      vkDestroyQueryPool (device, self->depth_query_pool, NULL);
+      self->depth_query_pool = VK_NULL_HANDLE;
+    }
+}
+
+static void
+_destroy_foveation (XrdSceneRenderer *self, VkDevice device)
+{
   for (uint32_t eye = 0; eye < 2; eye++)
-    self->framebuffer[eye] = gulkan_frame_buffer_new();
+    {
+      g_clear_object (&self->periphery[eye]);
+      g_clear_object (&self->inset[eye]);
+
+      if (self->periphery_resolve[eye] != VK_NULL_HANDLE)
+        vkDestroyImage (device, self->periphery_resolve[eye], NULL);
+      if (self->periphery_resolve_memory[eye] != VK_NULL_HANDLE)
+        vkFreeMemory (device, self->periphery_resolve_memory[eye], NULL);
+      if (self->composite[eye] != VK_NULL_HANDLE)
+        vkDestroyImage (device, self->composite[eye], NULL);
+      if (self->composite_memory[eye] != VK_NULL_HANDLE)
+        vkFreeMemory (device, self->composite_memory[eye], NULL);
+
+      self->periphery_resolve[eye] = VK_NULL_HANDLE;
+      self->periphery_resolve_memory[eye] = VK_NULL_HANDLE;
+      self->composite[eye] = VK_NULL_HANDLE;
+      self->composite_memory[eye] = VK_NULL_HANDLE;
+    }
 }
 
 static void
@@ -124,6 +325,21 @@ xrd_scene_renderer_finalize (GObject *gobject)
     {
       g_object_unref (self->lights_buffer);
 
+      if (self->cached_cmd_buffer.handle != VK_NULL_HANDLE)
+        {
+          vkFreeCommandBuffers (device,
+                                gulkan_client_get_command_pool (
+                                  GULKAN_CLIENT (self)),
+                                1, &self->cached_cmd_buffer.handle);
+          vkDestroyFence (device, self->cached_cmd_buffer.fence, NULL);
+        }
+
+      if (self->sample_query_pool != VK_NULL_HANDLE)
+        vkDestroyQueryPool (device, self->sample_query_pool, NULL);
+
+      _destroy_depth (self, device);
+      _destroy_foveation (self, device);
+
       for (uint32_t eye = 0; eye < 2; eye++)
         g_object_unref (self->framebuffer[eye]);
 
@@ -142,6 +358,7 @@ xrd_scene_renderer_finalize (GObject *gobject)
 }
 
 static XrdSceneRenderer *singleton = NULL;
+static guint singleton_holds = 0;
 
 XrdSceneRenderer *xrd_scene_renderer_get_instance (void)
 {
@@ -153,9 +370,30 @@ XrdSceneRenderer *xrd_scene_renderer_get_instance (void)
 
 void xrd_scene_renderer_destroy_instance (void)
 {
+  if (singleton_holds > 0)
+    return;
   g_clear_object (&singleton);
 }
 
+/**
+ * xrd_scene_renderer_hold_instance:
+ *
+ * Keeps the renderer, and with it the #GulkanClient and its Vulkan device,
+ * alive while clients are destroyed and created, e.g. when switching
+ * between overlay and scene mode.
+ * Every call has to be balanced by xrd_scene_renderer_release_instance().
+ */
+void xrd_scene_renderer_hold_instance (void)
+{
+  singleton_holds++;
+}
+
+void xrd_scene_renderer_release_instance (void)
+{
+  g_return_if_fail (singleton_holds > 0);
+  singleton_holds--;
+}
+
 static bool
 _init_framebuffers (XrdSceneRenderer *self, VkCommandBuffer cmd_buffer)
 {
@@ -193,7 +431,8 @@ static bool
 _init_shaders (XrdSceneRenderer *self)
 {
   const char *shader_names[PIPELINE_COUNT] = {
-    "window", "window", "pointer", "pointer", "pointer", "device_model"
+    "window", "window", "pointer", "pointer", "pointer", "device_model",
+    "window", "window", "window", "window"
   };
   const char *stage_names[2] = {"vert", "frag"};
 
@@ -302,8 +541,29 @@ typedef struct __attribute__((__packed__)) {
   const VkPipelineRasterizationStateCreateInfo *rasterization_state;
 } XrdPipelineConfig;
 
+/* Matches the constant_id declarations in window.vert and window.frag */
+typedef struct {
+  VkBool32 receive_light;
+  int32_t max_window_lights;
+  VkBool32 flip_y;
+} XrdWindowSpecialization;
+
+static const VkSpecializationMapEntry window_specialization_entries[] = {
+  {0, offsetof (XrdWindowSpecialization, receive_light), sizeof (VkBool32)},
+  {1, offsetof (XrdWindowSpecialization, max_window_lights), sizeof (int32_t)},
+  {2, offsetof (XrdWindowSpecialization, flip_y), sizeof (VkBool32)},
+};
+
+/*
+ * The depth only variants have no fragment stage and no color attachment,
+ * for the depth pass of xrd_scene_renderer_set_submit_depth().
+ */
 static bool
-_init_graphics_pipelines (XrdSceneRenderer *self)
+_init_pipelines (XrdSceneRenderer     *self,
+                 VkRenderPass          render_pass,
+                 VkSampleCountFlagBits sample_count,
+                 gboolean              depth_only,
+                 VkPipeline           *pipelines)
 {
   XrdPipelineConfig config[PIPELINE_COUNT] = {
     // PIPELINE_WINDOWS
@@ -471,8 +731,38 @@ _init_graphics_pipelines (XrdSceneRenderer *self)
     }
   };
 
+  /* The window variants only differ in their specialization constants */
+  config[PIPELINE_WINDOWS_LIT] = config[PIPELINE_WINDOWS];
+  config[PIPELINE_WINDOWS_FLIP_Y] = config[PIPELINE_WINDOWS];
+  config[PIPELINE_WINDOWS_LIT_FLIP_Y] = config[PIPELINE_WINDOWS];
+  config[PIPELINE_TIP_FLIP_Y] = config[PIPELINE_TIP];
+
+  const int32_t max_lights = XRD_SCENE_MAX_WINDOW_LIGHTS;
+  XrdWindowSpecialization window_constants[PIPELINE_COUNT] = {
+    [PIPELINE_WINDOWS] = { VK_FALSE, max_lights, VK_FALSE },
+    [PIPELINE_TIP] = { VK_FALSE, max_lights, VK_FALSE },
+    [PIPELINE_WINDOWS_LIT] = { VK_TRUE, max_lights, VK_FALSE },
+    [PIPELINE_WINDOWS_FLIP_Y] = { VK_FALSE, max_lights, VK_TRUE },
+    [PIPELINE_WINDOWS_LIT_FLIP_Y] = { VK_TRUE, max_lights, VK_TRUE },
+    [PIPELINE_TIP_FLIP_Y] = { VK_FALSE, max_lights, VK_TRUE },
+  };
+
   for (uint32_t i = 0; i < PIPELINE_COUNT; i++)
     {
+      gboolean is_window = i == PIPELINE_WINDOWS ||
+                           i == PIPELINE_TIP ||
+                           i == PIPELINE_WINDOWS_LIT ||
+                           i == PIPELINE_WINDOWS_FLIP_Y ||
+                           i == PIPELINE_WINDOWS_LIT_FLIP_Y ||
+                           i == PIPELINE_TIP_FLIP_Y;
+
+      VkSpecializationInfo specialization = {
+        .mapEntryCount = G_N_ELEMENTS (window_specialization_entries),
+        .pMapEntries = window_specialization_entries,
+        .dataSize = sizeof (XrdWindowSpecialization),
+        .pData = &window_constants[i]
+      };
+
       VkGraphicsPipelineCreateInfo pipeline_info = {
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
         .layout = self->pipeline_layout,
@@ -500,7 +790,7 @@ _init_graphics_pipelines (XrdSceneRenderer *self)
         .pRasterizationState = config[i].rasterization_state,
         .pMultisampleState = &(VkPipelineMultisampleStateCreateInfo) {
           .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-          .rasterizationSamples = self->msaa_sample_count,
+          .rasterizationSamples = sample_count,
           .minSampleShading = 0.0f,
           .pSampleMask = &(uint32_t) { 0xFFFFFFFF },
           .alphaToCoverageEnable = VK_FALSE
@@ -509,27 +799,28 @@ _init_graphics_pipelines (XrdSceneRenderer *self)
         .pColorBlendState = &(VkPipelineColorBlendStateCreateInfo) {
           .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
           .logicOpEnable = VK_FALSE,
-          .attachmentCount = 1,
+          .attachmentCount = depth_only ? 0 : 1,
           .blendConstants = {0,0,0,0},
           .pAttachments = config[i].blend_attachments,
         },
-        .stageCount = 2,
+        .stageCount = depth_only ? 1 : 2,
         .pStages = (VkPipelineShaderStageCreateInfo []) {
           {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
             .stage = VK_SHADER_STAGE_VERTEX_BIT,
             .module = self->shader_modules[i * 2],
-            .pName = "main"
+            .pName = "main",
+            .pSpecializationInfo = is_window ? &specialization : NULL
           },
           {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
             .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
             .module = self->shader_modules[i * 2 + 1],
-            .pName = "main"
+            .pName = "main",
+            .pSpecializationInfo = is_window ? &specialization : NULL
           }
         },
-        .renderPass = gulkan_frame_buffer_get_render_pass (
-          self->framebuffer[EVREye_Eye_Left]),
+        .renderPass = render_pass,
         .pDynamicState = &(VkPipelineDynamicStateCreateInfo) {
           .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
           .dynamicStateCount = 2,
@@ -545,16 +836,371 @@ _init_graphics_pipelines (XrdSceneRenderer *self)
                                                   (GULKAN_CLIENT (self)),
                                                 self->pipeline_cache, 1,
                                                &pipeline_info,
-                                                NULL, &self->pipelines[i]);
+                                                NULL, &pipelines[i]);
       vk_check_error ("vkCreateGraphicsPipelines", res, false)
     }
 
   return true;
 }
 
+static bool
+_init_graphics_pipelines (XrdSceneRenderer *self)
+{
+  VkRenderPass render_pass =
+    gulkan_frame_buffer_get_render_pass (self->framebuffer[EVREye_Eye_Left]);
+  return _init_pipelines (self, render_pass, self->msaa_sample_count,
+                          FALSE, self->pipelines);
+}
+
+static bool
+_init_depth_render_pass (XrdSceneRenderer *self, VkDevice device)
+{
+  VkRenderPassCreateInfo info = {
+    .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+    .attachmentCount = 1,
+    .pAttachments = &(VkAttachmentDescription) {
+      .format = XRD_SCENE_DEPTH_FORMAT,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+      .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+      .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      /* The compositor reads submitted images as transfer source */
+      .finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+    },
+    .subpassCount = 1,
+    .pSubpasses = &(VkSubpassDescription) {
+      .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+      .colorAttachmentCount = 0,
+      .pDepthStencilAttachment = &(VkAttachmentReference) {
+        .attachment = 0,
+        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+      }
+    }
+  };
+
+  VkResult res = vkCreateRenderPass (device, &info, NULL, &self->depth_pass);
+  vk_check_error ("vkCreateRenderPass", res, false)
+
+  return true;
+}
+
+static bool
+_init_depth_target (XrdSceneRenderer *self,
+                    GulkanDevice     *device,
+                    uint32_t          eye)
+{
+  VkDevice device_handle = gulkan_device_get_handle (device);
+
+  VkImageCreateInfo image_info = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+    .imageType = VK_IMAGE_TYPE_2D,
+    .format = XRD_SCENE_DEPTH_FORMAT,
+    .extent = {
+      .width = self->render_width,
+      .height = self->render_height,
+      .depth = 1
+    },
+    .mipLevels = 1,
+    .arrayLayers = 1,
+    .samples = VK_SAMPLE_COUNT_1_BIT,
+    .tiling = VK_IMAGE_TILING_OPTIMAL,
+    .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+             VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+             VK_IMAGE_USAGE_SAMPLED_BIT,
+    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+  };
+  VkResult res = vkCreateImage (device_handle, &image_info, NULL,
+                                &self->depth_images[eye]);
+  vk_check_error ("vkCreateImage", res, false)
+
+  VkMemoryRequirements requirements;
+  vkGetImageMemoryRequirements (device_handle, self->depth_images[eye],
+                                &requirements);
+
+  VkMemoryAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    .allocationSize = requirements.size
+  };
+  if (!gulkan_device_memory_type_from_properties (
+        device, requirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &alloc_info.memoryTypeIndex))
+    {
+      g_printerr ("Could not find a memory type for the depth image.\n");
+      return false;
+    }
+
+  res = vkAllocateMemory (device_handle, &alloc_info, NULL,
+                          &self->depth_memory[eye]);
+  vk_check_error ("vkAllocateMemory", res, false)
+
+  res = vkBindImageMemory (device_handle, self->depth_images[eye],
+                           self->depth_memory[eye], 0);
+  vk_check_error ("vkBindImageMemory", res, false)
+
+  VkImageViewCreateInfo view_info = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+    .image = self->depth_images[eye],
+    .viewType = VK_IMAGE_VIEW_TYPE_2D,
+    .format = XRD_SCENE_DEPTH_FORMAT,
+    .subresourceRange = {
+      .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+      .baseMipLevel = 0,
+      .levelCount = 1,
+      .baseArrayLayer = 0,
+      .layerCount = 1
+    }
+  };
+  res = vkCreateImageView (device_handle, &view_info, NULL,
+                           &self->depth_image_views[eye]);
+  vk_check_error ("vkCreateImageView", res, false)
+
+  VkFramebufferCreateInfo framebuffer_info = {
+    .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+    .renderPass = self->depth_pass,
+    .attachmentCount = 1,
+    .pAttachments = &self->depth_image_views[eye],
+    .width = self->render_width,
+    .height = self->render_height,
+    .layers = 1
+  };
+  res = vkCreateFramebuffer (device_handle, &framebuffer_info, NULL,
+                             &self->depth_framebuffers[eye]);
+  vk_check_error ("vkCreateFramebuffer", res, false)
+
+  return true;
+}
+
+/* Created when depth submission is first enabled */
+static bool
+_init_depth (XrdSceneRenderer *self)
+{
+  GulkanDevice *device = gulkan_client_get_device (GULKAN_CLIENT (self));
+  VkDevice device_handle = gulkan_device_get_handle (device);
+
+  if (!_init_depth_render_pass (self, device_handle))
+    return false;
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    if (!_init_depth_target (self, device, eye))
+      return false;
+
+  if (!_init_pipelines (self, self->depth_pass, VK_SAMPLE_COUNT_1_BIT,
+                        TRUE, self->depth_pipelines))
+    return false;
+
+  VkQueryPoolCreateInfo query_info = {
+    .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+    .queryType = VK_QUERY_TYPE_TIMESTAMP,
+    .queryCount = 2
+  };
+  VkResult res = vkCreateQueryPool (device_handle, &query_info, NULL,
+                                    &self->depth_query_pool);
+  vk_check_error ("vkCreateQueryPool", res, false)
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties (gulkan_device_get_physical_handle (device),
+                                 &properties);
+  self->timestamp_period = properties.limits.timestampPeriod;
 
+  return true;
+}
+
+/* A single sampled color image the foveated passes are composited with */
 static bool
-_init_vulkan (XrdSceneRenderer *self)
+_init_color_image (GulkanDevice      *device,
+                   uint32_t           width,
+                   uint32_t           height,
+                   VkImageUsageFlags  usage,
+                   VkImage           *image,
+                   VkDeviceMemory    *memory)
+{
+  VkDevice device_handle = gulkan_device_get_handle (device);
+
+  VkImageCreateInfo image_info = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+    .imageType = VK_IMAGE_TYPE_2D,
+    .format = VK_FORMAT_R8G8B8A8_UNORM,
+    .extent = {
+      .width = width,
+      .height = height,
+      .depth = 1
+    },
+    .mipLevels = 1,
+    .arrayLayers = 1,
+    .samples = VK_SAMPLE_COUNT_1_BIT,
+    .tiling = VK_IMAGE_TILING_OPTIMAL,
+    .usage = usage,
+    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+  };
+  VkResult res = vkCreateImage (device_handle, &image_info, NULL, image);
+  vk_check_error ("vkCreateImage", res, false)
+
+  VkMemoryRequirements requirements;
+  vkGetImageMemoryRequirements (device_handle, *image, &requirements);
+
+  VkMemoryAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+    .allocationSize = requirements.size
+  };
+  if (!gulkan_device_memory_type_from_properties (
+        device, requirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &alloc_info.memoryTypeIndex))
+    {
+      g_printerr ("Could not find a memory type for the color image.\n");
+      return false;
+    }
+
+  res = vkAllocateMemory (device_handle, &alloc_info, NULL, memory);
+  vk_check_error ("vkAllocateMemory", res, false)
+
+  res = vkBindImageMemory (device_handle, *image, *memory, 0);
+  vk_check_error ("vkBindImageMemory", res, false)
+
+  return true;
+}
+
+/*
+ * Centers the inset on the point the lens looks through, which the
+ * asymmetric eye projections move away from the image center.
+ */
+static void
+_init_inset_rects (XrdSceneRenderer *self,
+                   uint32_t          width,
+                   uint32_t          height)
+{
+  OpenVRContext *context = openvr_context_get_instance ();
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      float center_x = 0.5f;
+      float center_y = 0.5f;
+
+      if (openvr_context_is_valid (context))
+        {
+          graphene_matrix_t projection =
+            openvr_system_get_projection_matrix (eye, 0.1f, 100.0f);
+
+          graphene_vec4_t forward;
+          graphene_vec4_init (&forward, 0.0f, 0.0f, -1.0f, 1.0f);
+          graphene_vec4_t clip;
+          graphene_matrix_transform_vec4 (&projection, &forward, &clip);
+
+          float w = graphene_vec4_get_w (&clip);
+          center_x = (graphene_vec4_get_x (&clip) / w + 1.0f) / 2.0f;
+          center_y = (graphene_vec4_get_y (&clip) / w + 1.0f) / 2.0f;
+        }
+
+      int32_t x = (int32_t) (center_x * (float) self->render_width) -
+                  (int32_t) width / 2;
+      int32_t y = (int32_t) (center_y * (float) self->render_height) -
+                  (int32_t) height / 2;
+
+      self->inset_rect[eye] = (VkRect2D) {
+        .offset = {
+          CLAMP (x, 0, (int32_t) (self->render_width - width)),
+          CLAMP (y, 0, (int32_t) (self->render_height - height))
+        },
+        .extent = { width, height }
+      };
+    }
+}
+
+/* Created when foveation is first enabled and with the render targets */
+static bool
+_init_foveation (XrdSceneRenderer *self)
+{
+  GulkanDevice *device = gulkan_client_get_device (GULKAN_CLIENT (self));
+
+  /* The inset pass shifts a full size viewport over the inset */
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties (gulkan_device_get_physical_handle (device),
+                                 &properties);
+  VkPhysicalDeviceLimits *limits = &properties.limits;
+  if (self->render_width > limits->maxViewportDimensions[0] ||
+      self->render_height > limits->maxViewportDimensions[1] ||
+      -(float) MAX (self->render_width, self->render_height) <
+        limits->viewportBoundsRange[0])
+    {
+      g_printerr ("Render size %ux%u exceeds the viewport limits.\n",
+                  self->render_width, self->render_height);
+      return false;
+    }
+
+  self->periphery_width = MAX (1, (uint32_t) (XRD_SCENE_FOVEA_PERIPHERY_SCALE *
+                                              (float) self->render_width));
+  self->periphery_height = MAX (1, (uint32_t) (XRD_SCENE_FOVEA_PERIPHERY_SCALE *
+                                               (float) self->render_height));
+
+  uint32_t inset_width = MAX (1, (uint32_t) (XRD_SCENE_FOVEA_INSET_SCALE *
+                                             (float) self->render_width));
+  uint32_t inset_height = MAX (1, (uint32_t) (XRD_SCENE_FOVEA_INSET_SCALE *
+                                              (float) self->render_height));
+
+  _init_inset_rects (self, inset_width, inset_height);
+
+  GulkanCommandBuffer cmd_buffer;
+  if (!gulkan_client_begin_cmd_buffer (GULKAN_CLIENT (self), &cmd_buffer))
+    {
+      g_printerr ("Could not begin command buffer.\n");
+      return false;
+    }
+
+  /* Same format and samples, so compatible with the scene pipelines */
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      self->periphery[eye] = gulkan_frame_buffer_new ();
+      gulkan_frame_buffer_initialize (self->periphery[eye], device,
+                                      cmd_buffer.handle,
+                                      self->periphery_width,
+                                      self->periphery_height,
+                                      self->msaa_sample_count,
+                                      VK_FORMAT_R8G8B8A8_UNORM);
+
+      self->inset[eye] = gulkan_frame_buffer_new ();
+      gulkan_frame_buffer_initialize (self->inset[eye], device,
+                                      cmd_buffer.handle,
+                                      inset_width, inset_height,
+                                      self->msaa_sample_count,
+                                      VK_FORMAT_R8G8B8A8_UNORM);
+    }
+
+  if (!gulkan_client_submit_cmd_buffer (GULKAN_CLIENT (self), &cmd_buffer))
+    {
+      g_printerr ("Could not submit command buffer.\n");
+      return false;
+    }
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      /* Submitted, the compositor samples or copies it */
+      if (!_init_color_image (device, self->render_width, self->render_height,
+                              VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                              VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                              VK_IMAGE_USAGE_SAMPLED_BIT,
+                              &self->composite[eye],
+                              &self->composite_memory[eye]))
+        return false;
+
+      /* Multisampled images can not be blitted, only resolved */
+      if (self->msaa_sample_count != VK_SAMPLE_COUNT_1_BIT &&
+          !_init_color_image (device,
+                              self->periphery_width, self->periphery_height,
+                              VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                              VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                              &self->periphery_resolve[eye],
+                              &self->periphery_resolve_memory[eye]))
+        return false;
+    }
+
+  return true;
+}
+
+static bool
+_create_framebuffers (XrdSceneRenderer *self)
 {
   GulkanCommandBuffer cmd_buffer;
   if (!gulkan_client_begin_cmd_buffer (GULKAN_CLIENT (self),
@@ -572,6 +1218,93 @@ _init_vulkan (XrdSceneRenderer *self)
       return false;
     }
 
+  return true;
+}
+
+/* The highest count up to @samples that color and depth both support */
+static VkSampleCountFlagBits
+_get_supported_samples (XrdSceneRenderer *self, uint32_t samples)
+{
+  GulkanDevice *device = gulkan_client_get_device (GULKAN_CLIENT (self));
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties (gulkan_device_get_physical_handle (device),
+                                 &properties);
+
+  VkSampleCountFlags supported =
+    properties.limits.framebufferColorSampleCounts &
+    properties.limits.framebufferDepthSampleCounts;
+
+  uint32_t count = VK_SAMPLE_COUNT_8_BIT;
+  while (count > VK_SAMPLE_COUNT_1_BIT &&
+         (count > samples || !(supported & count)))
+    count >>= 1;
+
+  return (VkSampleCountFlagBits) count;
+}
+
+/*
+ * Recreates everything depending on the sample count and the render size,
+ * between two frames on the thread that records them.
+ * Only called from xrd_scene_renderer_submit_frame (), a frame recorded but
+ * not yet presented still uses the old targets.
+ */
+static bool
+_rebuild_render_targets (XrdSceneRenderer *self)
+{
+  VkDevice device = gulkan_client_get_device_handle (GULKAN_CLIENT (self));
+  vkDeviceWaitIdle (device);
+
+  /* Recorded against the old framebuffers, freed by the next recording */
+  self->cached_valid = FALSE;
+
+  for (uint32_t i = 0; i < PIPELINE_COUNT; i++)
+    {
+      vkDestroyPipeline (device, self->pipelines[i], NULL);
+      self->pipelines[i] = VK_NULL_HANDLE;
+    }
+
+  gboolean had_depth = self->depth_pass != VK_NULL_HANDLE;
+  _destroy_depth (self, device);
+  _destroy_foveation (self, device);
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      g_object_unref (self->framebuffer[eye]);
+      self->framebuffer[eye] = gulkan_frame_buffer_new ();
+    }
+
+  if (!_create_framebuffers (self))
+    return false;
+  if (!_init_graphics_pipelines (self))
+    return false;
+
+  if (had_depth && !_init_depth (self))
+    {
+      g_printerr ("Could not recreate depth targets, not submitting depth.\n");
+      _destroy_depth (self, device);
+      self->submit_depth = FALSE;
+    }
+
+  if (self->foveated && !_init_foveation (self))
+    {
+      g_printerr ("Could not recreate foveation targets, not foveating.\n");
+      _destroy_foveation (self, device);
+      self->foveated = FALSE;
+    }
+
+  return true;
+}
+
+static bool
+_init_vulkan (XrdSceneRenderer *self)
+{
+  self->msaa_sample_count =
+    _get_supported_samples (self, self->msaa_sample_count);
+  self->pending_msaa_sample_count = self->msaa_sample_count;
+
+  if (!_create_framebuffers (self))
+    return false;
+
   if (!_init_shaders (self))
     return false;
 
@@ -589,13 +1322,24 @@ _init_vulkan (XrdSceneRenderer *self)
   if (!_init_graphics_pipelines (self))
     return false;
 
+  /* Rendering works without, at full resolution */
+  if (self->foveated && !_init_foveation (self))
+    {
+      g_printerr ("Could not init foveation, not foveating.\n");
+      _destroy_foveation (self, gulkan_device_get_handle (device));
+      self->foveated = FALSE;
+    }
+
   return true;
 }
 
 bool
 xrd_scene_renderer_init_vulkan_simple (XrdSceneRenderer *self)
 {
-  gulkan_client_init_vulkan (GULKAN_CLIENT (self), NULL, NULL);
+  if (!gulkan_client_init_vulkan (GULKAN_CLIENT (self), NULL, NULL))
+    return false;
+
+  self->headless = TRUE;
 
   if (!_init_vulkan (self))
     return false;
@@ -603,12 +1347,34 @@ xrd_scene_renderer_init_vulkan_simple (XrdSceneRenderer *self)
   return true;
 }
 
+/**
+ * xrd_scene_renderer_init_vulkan_device:
+ * @self: The #XrdSceneRenderer
+ *
+ * Initializes only the Vulkan device with the extensions OpenVR requires,
+ * without any of the rendering resources. Used by overlay mode, where the
+ * renderer is only used for uploads.
+ * Does nothing if the device is already initialized.
+ */
+bool
+xrd_scene_renderer_init_vulkan_device (XrdSceneRenderer *self)
+{
+  if (gulkan_client_get_device_handle (GULKAN_CLIENT (self)) != VK_NULL_HANDLE)
+    return true;
+
+  return openvr_compositor_gulkan_client_init (GULKAN_CLIENT (self));
+}
+
 bool
 xrd_scene_renderer_init_vulkan_openvr (XrdSceneRenderer *self)
 {
-  if (!openvr_compositor_gulkan_client_init (GULKAN_CLIENT (self)))
+  if (!xrd_scene_renderer_init_vulkan_device (self))
     return false;
 
+  /* The device may have been created in overlay mode before. */
+  if (self->pipeline_layout != VK_NULL_HANDLE)
+    return true;
+
   if (!_init_vulkan (self))
     return false;
 
@@ -621,47 +1387,353 @@ xrd_scene_renderer_get_descriptor_set_layout (XrdSceneRenderer *self)
   return &self->descriptor_set_layout;
 }
 
+/*
+ * The scene is drawn once more with the depth only pipelines, since the
+ * depth attachment of GulkanFrameBuffer is multisampled and not exposed.
+ * The render callback does not know the difference.
+ */
 static void
-_render_stereo (XrdSceneRenderer *self, VkCommandBuffer cmd_buffer)
+_render_depth (XrdSceneRenderer *self, VkCommandBuffer cmd_buffer)
 {
-  VkViewport viewport = {
-    0.0f, 0.0f,
-    self->render_width, self->render_height,
-    0.0f, 1.0f
-  };
-  vkCmdSetViewport (cmd_buffer, 0, 1, &viewport);
-  VkRect2D scissor = {
-    .offset = {0, 0},
-    .extent = {self->render_width, self->render_height}
-  };
-  vkCmdSetScissor (cmd_buffer, 0, 1, &scissor);
+  vkCmdResetQueryPool (cmd_buffer, self->depth_query_pool, 0, 2);
+  vkCmdWriteTimestamp (cmd_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       self->depth_query_pool, 0);
 
   for (uint32_t eye = 0; eye < 2; eye++)
     {
-      gulkan_frame_buffer_begin_pass (self->framebuffer[eye], cmd_buffer);
+      VkRenderPassBeginInfo begin_info = {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .renderPass = self->depth_pass,
+        .framebuffer = self->depth_framebuffers[eye],
+        .renderArea = {
+          .offset = {0, 0},
+          .extent = {self->render_width, self->render_height}
+        },
+        .clearValueCount = 1,
+        .pClearValues = &(VkClearValue) {
+          .depthStencil = { .depth = 1.0f, .stencil = 0 }
+        }
+      };
+      vkCmdBeginRenderPass (cmd_buffer, &begin_info,
+                            VK_SUBPASS_CONTENTS_INLINE);
 
       if (self->render_eye)
         self->render_eye (eye, cmd_buffer, self->pipeline_layout,
-                          self->pipelines, self->scene_client);
+                          self->depth_pipelines, self->scene_client);
+
+      vkCmdEndRenderPass (cmd_buffer);
+    }
+
+  vkCmdWriteTimestamp (cmd_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                       self->depth_query_pool, 1);
+}
+
+static void
+_image_barrier (VkCommandBuffer      cmd_buffer,
+                VkImage              image,
+                VkImageLayout        old_layout,
+                VkImageLayout        new_layout,
+                VkAccessFlags        src_access,
+                VkAccessFlags        dst_access,
+                VkPipelineStageFlags src_stage)
+{
+  VkImageMemoryBarrier barrier = {
+    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+    .srcAccessMask = src_access,
+    .dstAccessMask = dst_access,
+    .oldLayout = old_layout,
+    .newLayout = new_layout,
+    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .image = image,
+    .subresourceRange = {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel = 0,
+      .levelCount = 1,
+      .baseArrayLayer = 0,
+      .layerCount = 1
+    }
+  };
+  vkCmdPipelineBarrier (cmd_buffer, src_stage, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+/*
+ * Upscales the periphery into the submitted image and copies the inset
+ * over it. Multisampled passes are resolved on the way, so the submitted
+ * image is always single sampled.
+ */
+static void
+_composite_foveated (XrdSceneRenderer *self,
+                     VkCommandBuffer   cmd_buffer,
+                     uint32_t          eye)
+{
+  VkImage periphery =
+    gulkan_frame_buffer_get_color_image (self->periphery[eye]);
+  VkImage inset = gulkan_frame_buffer_get_color_image (self->inset[eye]);
+  VkImage composite = self->composite[eye];
+  VkRect2D *rect = &self->inset_rect[eye];
+  gboolean multisampled = self->msaa_sample_count != VK_SAMPLE_COUNT_1_BIT;
+
+  /* The passes leave their color in the transfer source layout */
+  _image_barrier (cmd_buffer, periphery,
+                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                  VK_ACCESS_TRANSFER_READ_BIT,
+                  VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+  _image_barrier (cmd_buffer, inset,
+                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                  VK_ACCESS_TRANSFER_READ_BIT,
+                  VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+  /* Completely overwritten, the previous frame was submitted already */
+  _image_barrier (cmd_buffer, composite,
+                  VK_IMAGE_LAYOUT_UNDEFINED,
+                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                  0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+  VkImageSubresourceLayers layers = {
+    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+    .mipLevel = 0,
+    .baseArrayLayer = 0,
+    .layerCount = 1
+  };
+
+  VkImage periphery_source = periphery;
+  if (multisampled)
+    {
+      VkImage resolve = self->periphery_resolve[eye];
+      _image_barrier (cmd_buffer, resolve,
+                      VK_IMAGE_LAYOUT_UNDEFINED,
+                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                      0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+      VkImageResolve region = {
+        .srcSubresource = layers,
+        .srcOffset = { 0, 0, 0 },
+        .dstSubresource = layers,
+        .dstOffset = { 0, 0, 0 },
+        .extent = { self->periphery_width, self->periphery_height, 1 }
+      };
+      vkCmdResolveImage (cmd_buffer,
+                         periphery, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         resolve, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         1, &region);
+
+      _image_barrier (cmd_buffer, resolve,
+                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                      VK_ACCESS_TRANSFER_WRITE_BIT,
+                      VK_ACCESS_TRANSFER_READ_BIT,
+                      VK_PIPELINE_STAGE_TRANSFER_BIT);
+      periphery_source = resolve;
+    }
+
+  VkImageBlit blit = {
+    .srcSubresource = layers,
+    .srcOffsets = {
+      { 0, 0, 0 },
+      { (int32_t) self->periphery_width,
+        (int32_t) self->periphery_height, 1 }
+    },
+    .dstSubresource = layers,
+    .dstOffsets = {
+      { 0, 0, 0 },
+      { (int32_t) self->render_width, (int32_t) self->render_height, 1 }
+    }
+  };
+  vkCmdBlitImage (cmd_buffer,
+                  periphery_source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                  composite, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                  1, &blit, VK_FILTER_LINEAR);
+
+  /* The inset overwrites part of the upscaled periphery */
+  _image_barrier (cmd_buffer, composite,
+                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                  VK_ACCESS_TRANSFER_WRITE_BIT,
+                  VK_ACCESS_TRANSFER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+  VkOffset3D inset_offset = { rect->offset.x, rect->offset.y, 0 };
+  VkExtent3D inset_extent = { rect->extent.width, rect->extent.height, 1 };
+
+  if (multisampled)
+    {
+      VkImageResolve region = {
+        .srcSubresource = layers,
+        .srcOffset = { 0, 0, 0 },
+        .dstSubresource = layers,
+        .dstOffset = inset_offset,
+        .extent = inset_extent
+      };
+      vkCmdResolveImage (cmd_buffer,
+                         inset, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         composite, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         1, &region);
+    }
+  else
+    {
+      VkImageCopy region = {
+        .srcSubresource = layers,
+        .srcOffset = { 0, 0, 0 },
+        .dstSubresource = layers,
+        .dstOffset = inset_offset,
+        .extent = inset_extent
+      };
+      vkCmdCopyImage (cmd_buffer,
+                      inset, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                      composite, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                      1, &region);
+    }
+
+  /* Like the framebuffer images, submitted as transfer source */
+  _image_barrier (cmd_buffer, composite,
+                  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                  VK_ACCESS_TRANSFER_WRITE_BIT,
+                  VK_ACCESS_TRANSFER_READ_BIT,
+                  VK_PIPELINE_STAGE_TRANSFER_BIT);
+}
+
+/*
+ * Draws each eye twice, the render callback does not know the difference.
+ * The inset pass uses the same projection as the periphery, with a full
+ * size viewport shifted so only the inset lands in its framebuffer. That
+ * is the off axis sub frustum of the eye projection, without separate
+ * uniform buffers for it.
+ */
+static void
+_render_foveated (XrdSceneRenderer *self, VkCommandBuffer cmd_buffer)
+{
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      VkViewport viewport = {
+        0.0f, 0.0f,
+        self->periphery_width, self->periphery_height,
+        0.0f, 1.0f
+      };
+      vkCmdSetViewport (cmd_buffer, 0, 1, &viewport);
+      VkRect2D scissor = {
+        .offset = {0, 0},
+        .extent = {self->periphery_width, self->periphery_height}
+      };
+      vkCmdSetScissor (cmd_buffer, 0, 1, &scissor);
+
+      gulkan_frame_buffer_begin_pass (self->periphery[eye], cmd_buffer);
+
+      if (self->count_samples)
+        vkCmdBeginQuery (cmd_buffer, self->sample_query_pool, eye, 0);
+
+      if (self->render_eye)
+        self->render_eye (eye, cmd_buffer, self->pipeline_layout,
+                          self->pipelines, self->scene_client);
+
+      if (self->count_samples)
+        vkCmdEndQuery (cmd_buffer, self->sample_query_pool, eye);
+
+      vkCmdEndRenderPass (cmd_buffer);
+
+      VkRect2D *rect = &self->inset_rect[eye];
+      viewport = (VkViewport) {
+        -(float) rect->offset.x, -(float) rect->offset.y,
+        self->render_width, self->render_height,
+        0.0f, 1.0f
+      };
+      vkCmdSetViewport (cmd_buffer, 0, 1, &viewport);
+      scissor.extent = rect->extent;
+      vkCmdSetScissor (cmd_buffer, 0, 1, &scissor);
+
+      gulkan_frame_buffer_begin_pass (self->inset[eye], cmd_buffer);
+
+      if (self->render_eye)
+        self->render_eye (eye, cmd_buffer, self->pipeline_layout,
+                          self->pipelines, self->scene_client);
+
+      vkCmdEndRenderPass (cmd_buffer);
+
+      _composite_foveated (self, cmd_buffer, eye);
+    }
+}
+
+static void
+_set_full_viewport (XrdSceneRenderer *self, VkCommandBuffer cmd_buffer)
+{
+  VkViewport viewport = {
+    0.0f, 0.0f,
+    self->render_width, self->render_height,
+    0.0f, 1.0f
+  };
+  vkCmdSetViewport (cmd_buffer, 0, 1, &viewport);
+  VkRect2D scissor = {
+    .offset = {0, 0},
+    .extent = {self->render_width, self->render_height}
+  };
+  vkCmdSetScissor (cmd_buffer, 0, 1, &scissor);
+}
+
+static void
+_render_full (XrdSceneRenderer *self, VkCommandBuffer cmd_buffer)
+{
+  _set_full_viewport (self, cmd_buffer);
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      gulkan_frame_buffer_begin_pass (self->framebuffer[eye], cmd_buffer);
+
+      if (self->count_samples)
+        vkCmdBeginQuery (cmd_buffer, self->sample_query_pool, eye, 0);
+
+      if (self->render_eye)
+        self->render_eye (eye, cmd_buffer, self->pipeline_layout,
+                          self->pipelines, self->scene_client);
+
+      if (self->count_samples)
+        vkCmdEndQuery (cmd_buffer, self->sample_query_pool, eye);
 
       vkCmdEndRenderPass (cmd_buffer);
     }
 }
 
+static void
+_render_stereo (XrdSceneRenderer *self, VkCommandBuffer cmd_buffer)
+{
+  if (self->count_samples)
+    vkCmdResetQueryPool (cmd_buffer, self->sample_query_pool, 0, 2);
+
+  if (self->foveated)
+    _render_foveated (self, cmd_buffer);
+  else
+    _render_full (self, cmd_buffer);
+
+  if (self->submit_depth)
+    {
+      /* Depth is not foveated, it is submitted at full size */
+      _set_full_viewport (self, cmd_buffer);
+      _render_depth (self, cmd_buffer);
+    }
+}
+
 void
 xrd_scene_renderer_update_lights (XrdSceneRenderer  *self,
                                   GList             *controllers)
 {
   self->lights.active_lights = (int) g_list_length (controllers);
-  if (self->lights.active_lights > 2)
+  if (self->lights.active_lights > XRD_SCENE_MAX_LIGHTS)
     {
-      g_warning ("Update lights received more than 2 controllers.\n");
-      self->lights.active_lights = 2;
+      g_warning ("Update lights received more than %d controllers.\n",
+                 XRD_SCENE_MAX_LIGHTS);
+      self->lights.active_lights = XRD_SCENE_MAX_LIGHTS;
     }
 
-  for (int i = 0; i < self->lights.active_lights; i++)
+  GList *l = controllers;
+  for (int i = 0; i < self->lights.active_lights; i++, l = l->next)
     {
-      GList *l = g_list_nth (controllers, (guint) i);
       XrdController *controller = XRD_CONTROLLER (l->data);
 
       XrdScenePointerTip *scene_tip =
@@ -679,60 +1751,444 @@ xrd_scene_renderer_update_lights (XrdSceneRenderer  *self,
                                        (gpointer) &self->lights);
 }
 
+/* The point of @rect on the z = 0 plane of @model nearest to @point */
 static void
-_draw (XrdSceneRenderer *self)
+_get_nearest_point (const graphene_matrix_t  *model,
+                    const graphene_matrix_t  *inverse_model,
+                    const graphene_rect_t    *rect,
+                    const graphene_point3d_t *point,
+                    graphene_point3d_t       *nearest)
 {
-  GulkanCommandBuffer cmd_buffer;
-  gulkan_client_begin_cmd_buffer (GULKAN_CLIENT (self), &cmd_buffer);
+  graphene_point3d_t local;
+  graphene_matrix_transform_point3d (inverse_model, point, &local);
+
+  graphene_point3d_t clamped = {
+    .x = CLAMP (local.x, rect->origin.x, rect->origin.x + rect->size.width),
+    .y = CLAMP (local.y, rect->origin.y, rect->origin.y + rect->size.height),
+    .z = 0.0f
+  };
+  graphene_matrix_transform_point3d (model, &clamped, nearest);
+}
+
+/**
+ * xrd_scene_renderer_cull_lights:
+ * @self: The #XrdSceneRenderer
+ * @model: The model matrix of a quad.
+ * @rect: The extent of the quad on the z = 0 plane of @model.
+ * @eye_position: The position the quad is viewed from.
+ * @indices: (out caller-allocates) (array length=max_indices): The lights
+ * that can affect the quad, nearest first.
+ * @max_indices: The size of @indices.
+ *
+ * Bounds the radius of each light, scaled by the largest view distance of
+ * the quad like in the shader, against the quad. Only reads the lights, so
+ * it can be called from several threads while recording.
+ *
+ * Returns: The number of indices written.
+ */
+guint
+xrd_scene_renderer_cull_lights (XrdSceneRenderer         *self,
+                                const graphene_matrix_t  *model,
+                                const graphene_rect_t    *rect,
+                                const graphene_point3d_t *eye_position,
+                                int32_t                  *indices,
+                                guint                     max_indices)
+{
+  if (self->lights.active_lights == 0 || max_indices == 0)
+    return 0;
+
+  graphene_matrix_t inverse_model;
+  if (!graphene_matrix_inverse (model, &inverse_model))
+    return 0;
+
+  /* The quad is convex, its farthest point from the eye is a corner */
+  float max_view_distance = 0.0f;
+  for (int i = 0; i < 4; i++)
+    {
+      graphene_point3d_t corner = {
+        .x = rect->origin.x + (i & 1 ? rect->size.width : 0.0f),
+        .y = rect->origin.y + (i & 2 ? rect->size.height : 0.0f),
+        .z = 0.0f
+      };
+      graphene_point3d_t world_corner;
+      graphene_matrix_transform_point3d (model, &corner, &world_corner);
+      max_view_distance = MAX (max_view_distance,
+                               graphene_point3d_distance (&world_corner,
+                                                          eye_position,
+                                                          NULL));
+    }
+
+  float distances[XRD_SCENE_MAX_LIGHTS];
+  guint count = 0;
+
+  for (int i = 0; i < self->lights.active_lights; i++)
+    {
+      XrdSceneLight *light = &self->lights.lights[i];
+      graphene_point3d_t position = {
+        .x = light->position[0],
+        .y = light->position[1],
+        .z = light->position[2]
+      };
+
+      graphene_point3d_t nearest;
+      _get_nearest_point (model, &inverse_model, rect, &position, &nearest);
+      float distance = graphene_point3d_distance (&position, &nearest, NULL);
+
+      float reach =
+        XRD_SCENE_LIGHT_CULL_RADII * light->radius * max_view_distance;
+      if (distance > reach)
+        continue;
+
+      /* Insert sorted by distance, dropping the farthest when full */
+      guint j = MIN (count, max_indices - 1);
+      if (count == max_indices && distance >= distances[j])
+        continue;
+      while (j > 0 && distances[j - 1] > distance)
+        {
+          distances[j] = distances[j - 1];
+          indices[j] = indices[j - 1];
+          j--;
+        }
+      distances[j] = distance;
+      indices[j] = i;
+      count = MIN (count + 1, max_indices);
+    }
+
+  return count;
+}
+
+static void
+_record_frame (XrdSceneRenderer *self, VkCommandBuffer cmd_buffer)
+{
+  if (self->record_transfers)
+    self->record_transfers (cmd_buffer, self->scene_client);
+
+  _render_stereo (self, cmd_buffer);
+  vkEndCommandBuffer (cmd_buffer);
+  self->frames_recorded++;
+}
+
+/*
+ * Prepares the persistent command buffer, re-recorded only if the structure
+ * key changed since it was recorded. Otherwise the scene callbacks only
+ * update the uniform buffers, they get VK_NULL_HANDLE as command buffer.
+ * The previous submission finished, frames are never in flight in parallel.
+ */
+static void
+_prepare_cached_frame (XrdSceneRenderer *self)
+{
+  GulkanClient *client = GULKAN_CLIENT (self);
+  VkDevice device = gulkan_client_get_device_handle (client);
+  GulkanCommandBuffer *cached = &self->cached_cmd_buffer;
+
+  gboolean has_key = self->structure_key != NULL;
+  guint64 key = has_key ? self->structure_key (self->scene_client) : 0;
+
+  if (has_key && self->cached_valid && key == self->cached_key)
+    {
+      if (self->render_eye)
+        for (uint32_t eye = 0; eye < 2; eye++)
+          self->render_eye (eye, VK_NULL_HANDLE, self->pipeline_layout,
+                            self->pipelines, self->scene_client);
+
+      vkResetFences (device, 1, &cached->fence);
+      self->frames_reused++;
+      return;
+    }
+
+  if (cached->handle != VK_NULL_HANDLE)
+    {
+      vkFreeCommandBuffers (device, gulkan_client_get_command_pool (client),
+                            1, &cached->handle);
+      cached->handle = VK_NULL_HANDLE;
+    }
+
+  if (cached->fence == VK_NULL_HANDLE)
+    {
+      VkFenceCreateInfo fence_info = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        .flags = 0
+      };
+      vkCreateFence (device, &fence_info, NULL, &cached->fence);
+    }
+  else
+    {
+      vkResetFences (device, 1, &cached->fence);
+    }
 
-  self->update_lights (self->scene_client);
+  /* Not one time submit, unlike gulkan_client_begin_cmd_buffer() */
+  VkCommandBufferAllocateInfo alloc_info = {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+    .commandPool = gulkan_client_get_command_pool (client),
+    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+    .commandBufferCount = 1
+  };
+  vkAllocateCommandBuffers (device, &alloc_info, &cached->handle);
+
+  VkCommandBufferBeginInfo begin_info = {
+    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+    .flags = 0
+  };
+  vkBeginCommandBuffer (cached->handle, &begin_info);
 
-  _render_stereo (self, cmd_buffer.handle);
+  _record_frame (self, cached->handle);
 
-  vkEndCommandBuffer (cmd_buffer.handle);
+  self->cached_key = key;
+  self->cached_valid = has_key;
+}
+
+/**
+ * xrd_scene_renderer_submit_frame:
+ * @self: The #XrdSceneRenderer
+ * @cmd_buffer: (out): The command buffer of the frame, its fence is
+ * signaled when the GPU finished it.
+ *
+ * Records both eyes and submits them without waiting for the GPU.
+ * Finish the frame with xrd_scene_renderer_end_frame() on the same thread.
+ * With xrd_scene_renderer_set_reuse_commands() the frame recorded last is
+ * submitted again if the scene structure did not change.
+ */
+void
+xrd_scene_renderer_submit_frame (XrdSceneRenderer    *self,
+                                 GulkanCommandBuffer *cmd_buffer)
+{
+  if (self->render_targets_pending)
+    {
+      self->render_targets_pending = FALSE;
+      self->msaa_sample_count = self->pending_msaa_sample_count;
+      self->super_sample_scale = self->pending_super_sample_scale;
+      if (!_rebuild_render_targets (self))
+        g_printerr ("Could not rebuild the render targets.\n");
+    }
+
+  if (self->update_lights)
+    self->update_lights (self->scene_client);
+
+  if (self->prepare_frame)
+    self->prepare_frame (self->scene_client);
+
+  /* A reused command buffer contains queries if it was recorded with them */
+  self->frame_counted = self->count_samples;
+  self->frame_has_depth = self->submit_depth;
+  self->frame_foveated = self->foveated;
+
+  if (self->reuse_commands)
+    {
+      _prepare_cached_frame (self);
+      *cmd_buffer = self->cached_cmd_buffer;
+    }
+  else
+    {
+      gulkan_client_begin_cmd_buffer (GULKAN_CLIENT (self), cmd_buffer);
+      _record_frame (self, cmd_buffer->handle);
+    }
 
   VkSubmitInfo submit_info = {
     .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
     .commandBufferCount = 1,
-    .pCommandBuffers = &cmd_buffer.handle,
+    .pCommandBuffers = &cmd_buffer->handle,
     .waitSemaphoreCount = 0,
     .pWaitSemaphores = NULL,
     .signalSemaphoreCount = 0
   };
 
   GulkanDevice *device = gulkan_client_get_device (GULKAN_CLIENT (self));
-  VkDevice device_handle = gulkan_device_get_handle (device);
   vkQueueSubmit (gulkan_device_get_queue_handle (device), 1,
-                &submit_info, cmd_buffer.fence);
+                &submit_info, cmd_buffer->fence);
+}
 
-  vkQueueWaitIdle (gulkan_device_get_queue_handle (device));
+/**
+ * xrd_scene_renderer_wait_frame:
+ * @self: The #XrdSceneRenderer
+ * @cmd_buffer: A command buffer from xrd_scene_renderer_submit_frame().
+ *
+ * Blocks until the GPU finished the frame. Only waits on the fence of the
+ * frame, so it can be called from any thread.
+ */
+void
+xrd_scene_renderer_wait_frame (XrdSceneRenderer    *self,
+                               GulkanCommandBuffer *cmd_buffer)
+{
+  GulkanDevice *device = gulkan_client_get_device (GULKAN_CLIENT (self));
+  vkWaitForFences (gulkan_device_get_handle (device), 1, &cmd_buffer->fence,
+                   VK_TRUE, UINT64_MAX);
+}
+
+static void
+_record_depth_pass_time (XrdSceneRenderer *self, VkDevice device)
+{
+  guint64 timestamps[2] = { 0, 0 };
+  VkResult res = vkGetQueryPoolResults (device, self->depth_query_pool,
+                                        0, 2, sizeof (timestamps), timestamps,
+                                        sizeof (guint64),
+                                        VK_QUERY_RESULT_64_BIT);
+  if (res != VK_SUCCESS || timestamps[1] < timestamps[0])
+    return;
+
+  double ns = (double) (timestamps[1] - timestamps[0]) *
+              (double) self->timestamp_period;
+  gint64 duration_us = (gint64) (ns / 1000.0);
+  xrd_telemetry_record (XRD_TELEMETRY_DEPTH_PASS,
+                        g_get_monotonic_time () - duration_us, duration_us);
+}
+
+/* The image submitted for @eye, composited if the frame was foveated */
+static VkImage
+_get_eye_image (XrdSceneRenderer *self, uint32_t eye)
+{
+  if (self->frame_foveated)
+    return self->composite[eye];
+  return gulkan_frame_buffer_get_color_image (self->framebuffer[eye]);
+}
+
+static VkSampleCountFlagBits
+_get_eye_samples (XrdSceneRenderer *self)
+{
+  if (self->frame_foveated)
+    return VK_SAMPLE_COUNT_1_BIT;
+  return self->msaa_sample_count;
+}
+
+static bool
+_submit_with_depth (XrdSceneRenderer *self)
+{
+  OpenVRContext *context = openvr_context_get_instance ();
+  GulkanClient *client = GULKAN_CLIENT (self);
+  GulkanDevice *device = gulkan_client_get_device (client);
+
+  VRTextureBounds_t bounds = { 0.0f, 0.0f, 1.0f, 1.0f };
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    {
+      VRVulkanTextureData_t color_data = {
+        .m_nImage = (uint64_t) _get_eye_image (self, eye),
+        .m_pDevice = gulkan_device_get_handle (device),
+        .m_pPhysicalDevice = gulkan_device_get_physical_handle (device),
+        .m_pInstance = gulkan_client_get_instance_handle (client),
+        .m_pQueue = gulkan_device_get_queue_handle (device),
+        .m_nQueueFamilyIndex = gulkan_device_get_queue_family_index (device),
+        .m_nWidth = self->render_width,
+        .m_nHeight = self->render_height,
+        .m_nFormat = VK_FORMAT_R8G8B8A8_UNORM,
+        .m_nSampleCount = _get_eye_samples (self)
+      };
+
+      VRVulkanTextureData_t depth_data = color_data;
+      depth_data.m_nImage = (uint64_t) self->depth_images[eye];
+      depth_data.m_nFormat = XRD_SCENE_DEPTH_FORMAT;
+      depth_data.m_nSampleCount = VK_SAMPLE_COUNT_1_BIT;
+
+      XrdSceneTextureWithDepth texture = {
+        .texture = {
+          .handle = &color_data,
+          .eType = ETextureType_TextureType_Vulkan,
+          .eColorSpace = EColorSpace_ColorSpace_Auto
+        },
+        .depth = {
+          .handle = &depth_data,
+          .mProjection = self->depth_projection[eye],
+          .vRange = { .v = { 0.0f, 1.0f } }
+        }
+      };
+
+      EVRCompositorError error =
+        context->compositor->Submit ((EVREye) eye, (Texture_t *) &texture,
+                                     &bounds,
+                                     EVRSubmitFlags_Submit_TextureWithDepth);
+      if (error != EVRCompositorError_VRCompositorError_None)
+        {
+          g_printerr ("Submit with depth failed: %d\n", error);
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/**
+ * xrd_scene_renderer_end_frame:
+ * @self: The #XrdSceneRenderer
+ * @cmd_buffer: A command buffer from xrd_scene_renderer_submit_frame()
+ * that finished executing.
+ * @present: Whether to submit the eye images to the compositor.
+ *
+ * Returns: %FALSE if the compositor rejected the frame.
+ */
+bool
+xrd_scene_renderer_end_frame (XrdSceneRenderer    *self,
+                              GulkanCommandBuffer *cmd_buffer,
+                              gboolean             present)
+{
+  GulkanDevice *device = gulkan_client_get_device (GULKAN_CLIENT (self));
+  VkDevice device_handle = gulkan_device_get_handle (device);
+
+  /* The persistent command buffer is kept for the next frame */
+  if (cmd_buffer->handle != self->cached_cmd_buffer.handle)
+    {
+      vkFreeCommandBuffers (device_handle,
+                            gulkan_client_get_command_pool (
+                              GULKAN_CLIENT (self)),
+                            1, &cmd_buffer->handle);
+      vkDestroyFence (device_handle, cmd_buffer->fence, NULL);
+    }
 
-  vkFreeCommandBuffers (device_handle,
-                        gulkan_client_get_command_pool (GULKAN_CLIENT (self)),
-                        1, &cmd_buffer.handle);
-  vkDestroyFence (device_handle, cmd_buffer.fence, NULL);
+  if (self->frame_counted)
+    {
+      guint64 samples[2] = { 0, 0 };
+      VkResult res = vkGetQueryPoolResults (device_handle,
+                                            self->sample_query_pool,
+                                            0, 2, sizeof (samples), samples,
+                                            sizeof (guint64),
+                                            VK_QUERY_RESULT_64_BIT);
+      if (res == VK_SUCCESS)
+        self->samples_passed = samples[0] + samples[1];
+    }
+
+  if (self->frame_has_depth)
+    _record_depth_pass_time (self, device_handle);
+
+  if (!present || self->headless)
+    return true;
+
+  if (self->frame_has_depth)
+    {
+      if (_submit_with_depth (self))
+        return true;
+
+      /* Keep presenting rather than dropping frames */
+      g_printerr ("Compositor rejected depth, submitting color only.\n");
+      self->submit_depth = FALSE;
+      self->cached_valid = FALSE;
+    }
+
+  VkImage left = _get_eye_image (self, EVREye_Eye_Left);
+  VkImage right = _get_eye_image (self, EVREye_Eye_Right);
+
+  return openvr_compositor_submit (GULKAN_CLIENT(self),
+                                   self->render_width,
+                                   self->render_height,
+                                   VK_FORMAT_R8G8B8A8_UNORM,
+                                   _get_eye_samples (self),
+                                   left, right);
 }
 
 bool
 xrd_scene_renderer_draw (XrdSceneRenderer *self)
 {
-  _draw (self);
+  gint64 telemetry_start = xrd_telemetry_begin ();
+
+  GulkanCommandBuffer cmd_buffer;
+  xrd_scene_renderer_submit_frame (self, &cmd_buffer);
 
-  VkImage left =
-    gulkan_frame_buffer_get_color_image (self->framebuffer[EVREye_Eye_Left]);
+  /* Also waits for uploads that were submitted to the queue */
+  GulkanDevice *device = gulkan_client_get_device (GULKAN_CLIENT (self));
+  vkQueueWaitIdle (gulkan_device_get_queue_handle (device));
 
-  VkImage right =
-    gulkan_frame_buffer_get_color_image (self->framebuffer[EVREye_Eye_Right]);
+  bool presented = xrd_scene_renderer_end_frame (self, &cmd_buffer, TRUE);
 
-  if (!openvr_compositor_submit (GULKAN_CLIENT(self),
-                                 self->render_width,
-                                 self->render_height,
-                                 VK_FORMAT_R8G8B8A8_UNORM,
-                                 self->msaa_sample_count,
-                                 left, right))
-    return false;
+  xrd_telemetry_end (XRD_TELEMETRY_RENDER, telemetry_start);
 
-  return true;
+  return presented;
 }
 
 void
@@ -757,6 +2213,343 @@ xrd_scene_renderer_set_update_lights_cb (XrdSceneRenderer *self,
   self->scene_client = scene_client;
 }
 
+/**
+ * xrd_scene_renderer_set_prepare_frame_cb:
+ * @self: The #XrdSceneRenderer
+ * @prepare_frame: Updates the per frame state of the scene, e.g. sorts it.
+ * @scene_client: The data passed to @prepare_frame.
+ *
+ * @prepare_frame is called once per frame after the lights are updated and
+ * before the structure key is computed and the render callback is called,
+ * whether or not commands are reused.
+ */
+void
+xrd_scene_renderer_set_prepare_frame_cb (XrdSceneRenderer *self,
+                                         void (*prepare_frame) (gpointer data),
+                                         gpointer scene_client)
+{
+  self->prepare_frame = prepare_frame;
+  self->scene_client = scene_client;
+}
+
+/**
+ * xrd_scene_renderer_set_record_transfers_cb:
+ * @self: The #XrdSceneRenderer
+ * @record_transfers: Records transfers into the frame command buffer,
+ * outside of a render pass, before the eyes are rendered.
+ * @scene_client: The data passed to @record_transfers.
+ *
+ * @record_transfers is only called when the frame is recorded. When
+ * commands are reused, the structure key has to change with every frame
+ * that needs transfers, and again with the frame after it.
+ */
+void
+xrd_scene_renderer_set_record_transfers_cb (XrdSceneRenderer *self,
+                                            void (*record_transfers) (VkCommandBuffer cmd_buffer,
+                                                                      gpointer        data),
+                                            gpointer scene_client)
+{
+  self->record_transfers = record_transfers;
+  self->scene_client = scene_client;
+}
+
+/**
+ * xrd_scene_renderer_set_structure_key_cb:
+ * @self: The #XrdSceneRenderer
+ * @structure_key: Returns a value that changes whenever the draw commands
+ * recorded by the render callback would change.
+ * @scene_client: The data passed to @structure_key.
+ *
+ * @structure_key is only called when commands are reused, after the prepare
+ * callback, and must not change the scene.
+ * Without this callback, every frame is recorded from scratch.
+ */
+void
+xrd_scene_renderer_set_structure_key_cb (XrdSceneRenderer *self,
+                                         guint64 (*structure_key) (gpointer data),
+                                         gpointer scene_client)
+{
+  self->structure_key = structure_key;
+  self->scene_client = scene_client;
+}
+
+/**
+ * xrd_scene_renderer_set_reuse_commands:
+ * @self: The #XrdSceneRenderer
+ * @reuse: Whether to resubmit the previous frame's command buffer while
+ * the structure key is unchanged.
+ *
+ * When a frame is reused, the render callback is still called for both
+ * eyes, with %VK_NULL_HANDLE as command buffer, and only updates the
+ * uniform buffers.
+ */
+void
+xrd_scene_renderer_set_reuse_commands (XrdSceneRenderer *self,
+                                       gboolean          reuse)
+{
+  self->reuse_commands = reuse;
+  /* The buffer is freed by the next re-record, it may still be in flight. */
+  self->cached_valid = FALSE;
+}
+
+/**
+ * xrd_scene_renderer_get_command_stats:
+ * @self: The #XrdSceneRenderer
+ * @recorded: (out) (optional): The number of frames recorded from scratch.
+ * @reused: (out) (optional): The number of frames that resubmitted the
+ * previous command buffer.
+ */
+void
+xrd_scene_renderer_get_command_stats (XrdSceneRenderer *self,
+                                      guint64          *recorded,
+                                      guint64          *reused)
+{
+  if (recorded)
+    *recorded = self->frames_recorded;
+  if (reused)
+    *reused = self->frames_reused;
+}
+
+/**
+ * xrd_scene_renderer_set_count_samples:
+ * @self: The #XrdSceneRenderer
+ * @count: Whether to count the samples that pass the depth test.
+ *
+ * Wraps both eyes in occlusion queries. Samples that fail the depth test
+ * before the fragment shader runs are not counted, so this measures how
+ * much shading the draw order saves.
+ * Without the occlusionQueryPrecise feature, an implementation may report
+ * any nonzero number instead of the exact count. Common drivers are exact.
+ */
+void
+xrd_scene_renderer_set_count_samples (XrdSceneRenderer *self,
+                                      gboolean          count)
+{
+  VkDevice device = gulkan_client_get_device_handle (GULKAN_CLIENT (self));
+
+  if (count && self->sample_query_pool == VK_NULL_HANDLE)
+    {
+      VkQueryPoolCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_OCCLUSION,
+        .queryCount = 2
+      };
+      VkResult res = vkCreateQueryPool (device, &info, NULL,
+                                        &self->sample_query_pool);
+      if (res != VK_SUCCESS)
+        {
+          g_printerr ("Could not create occlusion query pool.\n");
+          self->sample_query_pool = VK_NULL_HANDLE;
+          return;
+        }
+    }
+
+  self->count_samples = count;
+  self->samples_passed = 0;
+  self->cached_valid = FALSE;
+}
+
+/**
+ * xrd_scene_renderer_get_samples_passed:
+ * @self: The #XrdSceneRenderer
+ *
+ * Returns: The samples of both eyes that passed the depth test in the last
+ * finished frame, see xrd_scene_renderer_set_count_samples().
+ */
+guint64
+xrd_scene_renderer_get_samples_passed (XrdSceneRenderer *self)
+{
+  return self->samples_passed;
+}
+
+/**
+ * xrd_scene_renderer_set_submit_depth:
+ * @self: The #XrdSceneRenderer
+ * @submit: Whether to submit depth along with the eye images.
+ *
+ * With depth, the compositor can reproject the last frame per pixel when
+ * a frame is missed, instead of judder from a rotation only reprojection.
+ * The depth is drawn in an extra depth only pass, its GPU time is recorded
+ * as %XRD_TELEMETRY_DEPTH_PASS. Set the depth range with
+ * xrd_scene_renderer_set_depth_range().
+ *
+ * Returns: %FALSE if the depth targets could not be created.
+ */
+bool
+xrd_scene_renderer_set_submit_depth (XrdSceneRenderer *self,
+                                     gboolean          submit)
+{
+  if (submit && self->depth_pass == VK_NULL_HANDLE)
+    {
+      if (!_init_depth (self))
+        {
+          g_printerr ("Could not init depth submission.\n");
+          _destroy_depth (self, gulkan_client_get_device_handle (
+                                  GULKAN_CLIENT (self)));
+          return false;
+        }
+    }
+
+  self->submit_depth = submit;
+  self->cached_valid = FALSE;
+  return true;
+}
+
+/**
+ * xrd_scene_renderer_set_depth_range:
+ * @self: The #XrdSceneRenderer
+ * @near: The near plane of the eye projections.
+ * @far: The far plane of the eye projections.
+ *
+ * Tells the compositor how to interpret the submitted depth, has to match
+ * the projection the scene is rendered with.
+ */
+void
+xrd_scene_renderer_set_depth_range (XrdSceneRenderer *self,
+                                    float             near,
+                                    float             far)
+{
+  OpenVRContext *context = openvr_context_get_instance ();
+  if (!openvr_context_is_valid (context))
+    return;
+
+  for (uint32_t eye = 0; eye < 2; eye++)
+    self->depth_projection[eye] =
+      context->system->GetProjectionMatrix ((EVREye) eye, near, far);
+}
+
+/**
+ * xrd_scene_renderer_set_msaa_samples:
+ * @self: The #XrdSceneRenderer
+ * @samples: The MSAA sample count, 1, 2, 4 or 8.
+ *
+ * Rounded down to a count the device supports for color and depth.
+ * If rendering is initialized, framebuffers and pipelines are rebuilt when
+ * the next frame is submitted, so a frame that is recorded but not yet
+ * presented keeps its targets.
+ *
+ * Returns: %FALSE if @samples is invalid.
+ */
+bool
+xrd_scene_renderer_set_msaa_samples (XrdSceneRenderer *self,
+                                     uint32_t          samples)
+{
+  g_return_val_if_fail (samples > 0, false);
+
+  if (self->pipeline_layout == VK_NULL_HANDLE)
+    {
+      /* Checked against the device in _init_vulkan () */
+      self->msaa_sample_count = (VkSampleCountFlagBits) MIN (samples, 8);
+      self->pending_msaa_sample_count = self->msaa_sample_count;
+      return true;
+    }
+
+  VkSampleCountFlagBits count = _get_supported_samples (self, samples);
+  if (count == self->pending_msaa_sample_count)
+    return true;
+
+  self->pending_msaa_sample_count = count;
+  self->render_targets_pending = TRUE;
+  return true;
+}
+
+/**
+ * xrd_scene_renderer_get_msaa_samples:
+ * @self: The #XrdSceneRenderer
+ *
+ * Returns: The sample count in use, after rounding to what the device
+ * supports.
+ */
+uint32_t
+xrd_scene_renderer_get_msaa_samples (XrdSceneRenderer *self)
+{
+  return (uint32_t) self->msaa_sample_count;
+}
+
+/**
+ * xrd_scene_renderer_set_super_sample_scale:
+ * @self: The #XrdSceneRenderer
+ * @scale: Factor applied to the render target size the runtime recommends.
+ *
+ * Like xrd_scene_renderer_set_msaa_samples(), framebuffers and pipelines
+ * are rebuilt when the next frame is submitted if rendering is initialized.
+ *
+ * Returns: %FALSE if @scale is invalid.
+ */
+bool
+xrd_scene_renderer_set_super_sample_scale (XrdSceneRenderer *self,
+                                           float             scale)
+{
+  g_return_val_if_fail (scale > 0.0f, false);
+
+  if (scale == self->pending_super_sample_scale)
+    return true;
+
+  self->pending_super_sample_scale = scale;
+
+  if (self->pipeline_layout == VK_NULL_HANDLE)
+    {
+      self->super_sample_scale = scale;
+      return true;
+    }
+
+  self->render_targets_pending = TRUE;
+  return true;
+}
+
+/**
+ * xrd_scene_renderer_set_foveated:
+ * @self: The #XrdSceneRenderer
+ * @foveated: Whether to render the periphery at reduced resolution.
+ *
+ * Fixed foveation for GPUs that can not fill the render size at the
+ * display rate. Each eye is drawn at half resolution, plus a full
+ * resolution inset of half the size around the lens center, which is
+ * half of the pixels in total. Both are composited into a single sampled
+ * image that is submitted instead of the eye framebuffer.
+ * The targets are created when foveation is first enabled, and kept
+ * afterwards, since a frame using them may still be in flight.
+ *
+ * Returns: %FALSE if the foveation targets could not be created.
+ */
+bool
+xrd_scene_renderer_set_foveated (XrdSceneRenderer *self,
+                                 gboolean          foveated)
+{
+  if (foveated && self->pipeline_layout != VK_NULL_HANDLE &&
+      self->composite[0] == VK_NULL_HANDLE)
+    {
+      if (!_init_foveation (self))
+        {
+          g_printerr ("Could not init foveation.\n");
+          _destroy_foveation (self, gulkan_client_get_device_handle (
+                                      GULKAN_CLIENT (self)));
+          return false;
+        }
+    }
+
+  self->foveated = foveated;
+  self->cached_valid = FALSE;
+  return true;
+}
+
+/**
+ * xrd_scene_renderer_get_render_size:
+ * @self: The #XrdSceneRenderer
+ * @width: (out): The width of one eye in pixels.
+ * @height: (out): The height of one eye in pixels.
+ *
+ * The size of the eye framebuffers, including the super sample scale.
+ */
+void
+xrd_scene_renderer_get_render_size (XrdSceneRenderer *self,
+                                    uint32_t         *width,
+                                    uint32_t         *height)
+{
+  *width = self->render_width;
+  *height = self->render_height;
+}
+
 GulkanDevice*
 xrd_scene_renderer_get_device ()
 {
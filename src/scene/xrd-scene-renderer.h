@@ -15,9 +15,13 @@
 #include <glib-object.h>
 
 #include <gulkan.h>
+#include <graphene.h>
 
 G_BEGIN_DECLS
 
+/* The most lights evaluated for one window, see window.frag */
+#define XRD_SCENE_MAX_WINDOW_LIGHTS 8
+
 enum PipelineType
 {
   PIPELINE_WINDOWS = 0,
@@ -26,6 +30,10 @@ enum PipelineType
   PIPELINE_SELECTION,
   PIPELINE_BACKGROUND,
   PIPELINE_DEVICE_MODELS,
+  PIPELINE_WINDOWS_LIT,
+  PIPELINE_WINDOWS_FLIP_Y,
+  PIPELINE_WINDOWS_LIT_FLIP_Y,
+  PIPELINE_TIP_FLIP_Y,
   PIPELINE_COUNT
 };
 
@@ -37,12 +45,19 @@ XrdSceneRenderer *xrd_scene_renderer_get_instance (void);
 
 void xrd_scene_renderer_destroy_instance (void);
 
+void xrd_scene_renderer_hold_instance (void);
+
+void xrd_scene_renderer_release_instance (void);
+
 GulkanDevice*
 xrd_scene_renderer_get_device (void);
 
 bool
 xrd_scene_renderer_init_vulkan_simple (XrdSceneRenderer *self);
 
+bool
+xrd_scene_renderer_init_vulkan_device (XrdSceneRenderer *self);
+
 bool
 xrd_scene_renderer_init_vulkan_openvr (XrdSceneRenderer *self);
 
@@ -52,6 +67,19 @@ xrd_scene_renderer_get_descriptor_set_layout (XrdSceneRenderer *self);
 bool
 xrd_scene_renderer_draw (XrdSceneRenderer *self);
 
+void
+xrd_scene_renderer_submit_frame (XrdSceneRenderer    *self,
+                                 GulkanCommandBuffer *cmd_buffer);
+
+void
+xrd_scene_renderer_wait_frame (XrdSceneRenderer    *self,
+                               GulkanCommandBuffer *cmd_buffer);
+
+bool
+xrd_scene_renderer_end_frame (XrdSceneRenderer    *self,
+                              GulkanCommandBuffer *cmd_buffer,
+                              gboolean             present);
+
 void
 xrd_scene_renderer_set_render_cb (XrdSceneRenderer *self,
                                   void (*render_eye) (uint32_t         eye,
@@ -66,6 +94,67 @@ xrd_scene_renderer_set_update_lights_cb (XrdSceneRenderer *self,
                                          void (*update_lights) (gpointer data),
                                          gpointer scene_client);
 
+void
+xrd_scene_renderer_set_prepare_frame_cb (XrdSceneRenderer *self,
+                                         void (*prepare_frame) (gpointer data),
+                                         gpointer scene_client);
+
+void
+xrd_scene_renderer_set_record_transfers_cb (XrdSceneRenderer *self,
+                                            void (*record_transfers) (VkCommandBuffer cmd_buffer,
+                                                                      gpointer        data),
+                                            gpointer scene_client);
+
+void
+xrd_scene_renderer_set_structure_key_cb (XrdSceneRenderer *self,
+                                         guint64 (*structure_key) (gpointer data),
+                                         gpointer scene_client);
+
+void
+xrd_scene_renderer_set_reuse_commands (XrdSceneRenderer *self,
+                                       gboolean          reuse);
+
+void
+xrd_scene_renderer_get_command_stats (XrdSceneRenderer *self,
+                                      guint64          *recorded,
+                                      guint64          *reused);
+
+void
+xrd_scene_renderer_set_count_samples (XrdSceneRenderer *self,
+                                      gboolean          count);
+
+guint64
+xrd_scene_renderer_get_samples_passed (XrdSceneRenderer *self);
+
+bool
+xrd_scene_renderer_set_submit_depth (XrdSceneRenderer *self,
+                                     gboolean          submit);
+
+void
+xrd_scene_renderer_set_depth_range (XrdSceneRenderer *self,
+                                    float             near,
+                                    float             far);
+
+bool
+xrd_scene_renderer_set_msaa_samples (XrdSceneRenderer *self,
+                                     uint32_t          samples);
+
+uint32_t
+xrd_scene_renderer_get_msaa_samples (XrdSceneRenderer *self);
+
+bool
+xrd_scene_renderer_set_super_sample_scale (XrdSceneRenderer *self,
+                                           float             scale);
+
+bool
+xrd_scene_renderer_set_foveated (XrdSceneRenderer *self,
+                                 gboolean          foveated);
+
+void
+xrd_scene_renderer_get_render_size (XrdSceneRenderer *self,
+                                    uint32_t         *width,
+                                    uint32_t         *height);
+
 VkBuffer
 xrd_scene_renderer_get_lights_buffer_handle (XrdSceneRenderer *self);
 
@@ -73,6 +162,14 @@ void
 xrd_scene_renderer_update_lights (XrdSceneRenderer  *self,
                                   GList             *controllers);
 
+guint
+xrd_scene_renderer_cull_lights (XrdSceneRenderer         *self,
+                                const graphene_matrix_t  *model,
+                                const graphene_rect_t    *rect,
+                                const graphene_point3d_t *eye_position,
+                                int32_t                  *indices,
+                                guint                     max_indices);
+
 G_END_DECLS
 
 #endif /* XRD_SCENE_RENDERER_H_ */
@@ -78,6 +78,7 @@ xrd_scene_selection_set_aspect_ratio (XrdSceneSelection *self,
                                       float              aspect_ratio)
 {
   gulkan_vertex_buffer_reset (self->vertex_buffer);
+  xrd_scene_object_structure_changed ();
 
   graphene_vec3_t color;
   graphene_vec3_init (&color, .078f, .471f, .675f);
@@ -93,6 +94,7 @@ xrd_scene_selection_initialize (XrdSceneSelection     *self,
                                 VkDescriptorSetLayout *layout)
 {
   gulkan_vertex_buffer_reset (self->vertex_buffer);
+  xrd_scene_object_structure_changed ();
 
   graphene_vec3_t color;
   graphene_vec3_init (&color, .078f, .471f, .675f);
@@ -129,9 +131,13 @@ xrd_scene_selection_render (XrdSceneSelection *self,
   if (!xrd_scene_object_is_visible (obj))
     return;
 
-  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
   xrd_scene_object_update_mvp_matrix (obj, eye, vp);
+
+  /* Only the uniform buffer is updated for a previously recorded frame */
+  if (cmd_buffer == VK_NULL_HANDLE)
+    return;
+
+  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
   xrd_scene_object_bind (obj, eye, cmd_buffer, pipeline_layout);
   gulkan_vertex_buffer_draw (self->vertex_buffer, cmd_buffer);
 }
@@ -88,6 +88,7 @@ xrd_scene_vector_initialize (XrdSceneVector        *self,
                              VkDescriptorSetLayout *layout)
 {
   gulkan_vertex_buffer_reset (self->vertex_buffer);
+  xrd_scene_object_structure_changed ();
 
   graphene_vec4_t start;
   graphene_vec4_init (&start, 0, 0, 0, 1);
@@ -122,6 +123,7 @@ xrd_scene_vector_update (XrdSceneVector  *self,
                          graphene_vec3_t *color)
 {
   gulkan_vertex_buffer_reset (self->vertex_buffer);
+  xrd_scene_object_structure_changed ();
   _append_vector (self->vertex_buffer, start, end, color);
   gulkan_vertex_buffer_map_array (self->vertex_buffer);
 }
@@ -150,6 +152,7 @@ xrd_scene_vector_update_from_ray (XrdSceneVector  *self,
   graphene_vec4_add (&start, &direction_vec4, &end);
 
   gulkan_vertex_buffer_reset (self->vertex_buffer);
+  xrd_scene_object_structure_changed ();
   _append_vector (self->vertex_buffer, &start, &end, color);
   gulkan_vertex_buffer_map_array (self->vertex_buffer);
 }
@@ -160,6 +163,7 @@ xrd_scene_vector_update_from_plane (XrdSceneVector   *self,
                                     graphene_vec3_t  *color)
 {
   gulkan_vertex_buffer_reset (self->vertex_buffer);
+  xrd_scene_object_structure_changed ();
   _append_plane (self->vertex_buffer, plane, color);
   gulkan_vertex_buffer_map_array (self->vertex_buffer);
 }
@@ -179,9 +183,13 @@ xrd_scene_vector_render (XrdSceneVector    *self,
   if (!xrd_scene_object_is_visible (obj))
     return;
 
-  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
   xrd_scene_object_update_mvp_matrix (obj, eye, vp);
+
+  /* Only the uniform buffer is updated for a previously recorded frame */
+  if (cmd_buffer == VK_NULL_HANDLE)
+    return;
+
+  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
   xrd_scene_object_bind (obj, eye, cmd_buffer, pipeline_layout);
   gulkan_vertex_buffer_draw (self->vertex_buffer, cmd_buffer);
 }
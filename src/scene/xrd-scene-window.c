@@ -26,9 +26,14 @@ enum
 static void
 xrd_scene_window_window_interface_init (XrdWindowInterface *iface);
 
+/* std140 layout of the Window block in window.frag */
 typedef struct {
   float color[4];
-  bool flip_y;
+  uint32_t flip_y;
+  int32_t light_count;
+  int32_t padding[2];
+  int32_t light_indices[XRD_SCENE_MAX_WINDOW_LIGHTS];
+  float uv_rect[4];
 } XrdWindowUniformBuffer;
 
 typedef struct _XrdSceneWindowPrivate
@@ -46,6 +51,15 @@ typedef struct _XrdSceneWindowPrivate
   XrdWindowUniformBuffer shading_buffer_data;
 
   XrdWindowData *window_data;
+
+  /* Sampled instead of the texture while it is minified, see
+   * xrd_scene_window_set_minified () */
+  XrdSceneMipChain *mip_chain;
+  gboolean minified;
+  gboolean mips_dirty;
+  VkRect2D damage;
+  /* bumped by every xrd_scene_window_add_damage () */
+  guint64 damage_serial;
 } XrdSceneWindowPrivate;
 
 G_DEFINE_TYPE_WITH_CODE (XrdSceneWindow, xrd_scene_window, XRD_TYPE_SCENE_OBJECT,
@@ -164,7 +178,17 @@ xrd_scene_window_init (XrdSceneWindow *self)
   priv->aspect_ratio = 1.0;
   priv->window_data->texture = NULL;
   priv->shading_buffer = gulkan_uniform_buffer_new ();
-  priv->shading_buffer_data.flip_y = false;
+  priv->flip_y = FALSE;
+  priv->shading_buffer_data.flip_y = 0;
+  priv->shading_buffer_data.light_count = 0;
+  priv->shading_buffer_data.uv_rect[0] = 0.f;
+  priv->shading_buffer_data.uv_rect[1] = 0.f;
+  priv->shading_buffer_data.uv_rect[2] = 1.f;
+  priv->shading_buffer_data.uv_rect[3] = 1.f;
+  priv->mip_chain = NULL;
+  priv->minified = FALSE;
+  priv->mips_dirty = FALSE;
+  priv->damage_serial = 0;
 
   priv->window_data->title = NULL;
   priv->window_data->child_window = NULL;
@@ -173,9 +197,14 @@ xrd_scene_window_init (XrdSceneWindow *self)
   priv->window_data->texture_width = 0;
   priv->window_data->texture_height = 0;
   priv->window_data->texture = NULL;
+  priv->window_data->input_mask = NULL;
+  priv->window_data->flip_y = FALSE;
+  graphene_rect_init (&priv->window_data->uv_rect, 0.f, 0.f, 1.f, 1.f);
+  priv->window_data->transform_pending = FALSE;
   priv->window_data->selected = FALSE;
   priv->window_data->xrd_window = XRD_WINDOW (self);
   priv->window_data->pinned = FALSE;
+  graphene_matrix_init_identity (&priv->window_data->transform);
   graphene_matrix_init_identity (&priv->window_data->reset_transform);
 }
 
@@ -268,6 +297,7 @@ xrd_scene_window_finalize (GObject *gobject)
                     priv->sampler, NULL);
   g_object_unref (priv->vertex_buffer);
   g_object_unref (priv->shading_buffer);
+  g_clear_object (&priv->mip_chain);
 
   G_OBJECT_CLASS (xrd_scene_window_parent_class)->finalize (gobject);
 }
@@ -314,33 +344,150 @@ xrd_scene_window_initialize (XrdSceneWindow *self)
   return TRUE;
 }
 
-void
-xrd_scene_window_draw (XrdSceneWindow    *self,
-                       EVREye             eye,
-                       VkPipeline         pipeline,
-                       VkPipelineLayout   pipeline_layout,
-                       VkCommandBuffer    cmd_buffer,
-                       graphene_matrix_t *vp)
+static gboolean
+_is_drawable (XrdSceneWindow *self)
 {
   XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
   if (!priv->window_data->texture)
     {
       /* g_warning ("Trying to draw window with no texture.\n"); */
-      return;
+      return FALSE;
     }
 
-  XrdSceneObject *obj = XRD_SCENE_OBJECT (self);
-  if (!xrd_scene_object_is_visible (obj))
+  return xrd_scene_object_is_visible (XRD_SCENE_OBJECT (self));
+}
+
+/**
+ * xrd_scene_window_update_mvp:
+ * @self: The #XrdSceneWindow
+ * @eye: The eye the uniform buffer is used for.
+ * @vp: The view projection matrix of @eye.
+ *
+ * Writes the transformation uniform buffer of @eye for unlit drawing. Only
+ * touches buffers owned by @self, so different windows can be updated from
+ * different threads, as long as nothing else modifies them meanwhile.
+ *
+ * Returns: %FALSE if the window would not be drawn.
+ */
+gboolean
+xrd_scene_window_update_mvp (XrdSceneWindow    *self,
+                             EVREye             eye,
+                             graphene_matrix_t *vp)
+{
+  if (!_is_drawable (self))
+    return FALSE;
+
+  xrd_scene_object_update_mvp_matrix (XRD_SCENE_OBJECT (self), eye, vp);
+  return TRUE;
+}
+
+/* Writes the lights that can reach the window into its buffer */
+static void
+_update_lights (XrdSceneWindow *self, graphene_matrix_t *view)
+{
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+
+  graphene_matrix_t model;
+  xrd_scene_object_get_model_matrix (XRD_SCENE_OBJECT (self), &model);
+
+  graphene_matrix_t inverse_view;
+  graphene_matrix_inverse (view, &inverse_view);
+  graphene_point3d_t eye_position;
+  graphene_ext_matrix_get_translation_point3d (&inverse_view, &eye_position);
+
+  /* The plane of _append_plane () */
+  graphene_rect_t rect;
+  graphene_rect_init (&rect, -priv->aspect_ratio / 2.0f, -0.5f,
+                      priv->aspect_ratio, 1.0f);
+
+  priv->shading_buffer_data.light_count = (int32_t)
+    xrd_scene_renderer_cull_lights (renderer, &model, &rect, &eye_position,
+                                    priv->shading_buffer_data.light_indices,
+                                    XRD_SCENE_MAX_WINDOW_LIGHTS);
+
+  gulkan_uniform_buffer_update_struct (priv->shading_buffer,
+                                       (gpointer) &priv->shading_buffer_data);
+}
+
+/**
+ * xrd_scene_window_update_transformation_buffer:
+ * @self: The #XrdSceneWindow
+ * @eye: The eye the uniform buffer is used for.
+ * @view: The view matrix of @eye.
+ * @projection: The projection matrix of @eye.
+ *
+ * Like xrd_scene_window_update_mvp(), for lit drawing. With the left eye,
+ * also culls the lights the window is shaded with.
+ *
+ * Returns: %FALSE if the window would not be drawn.
+ */
+gboolean
+xrd_scene_window_update_transformation_buffer (XrdSceneWindow    *self,
+                                               EVREye             eye,
+                                               graphene_matrix_t *view,
+                                               graphene_matrix_t *projection)
+{
+  if (!_is_drawable (self))
+    return FALSE;
+
+  xrd_scene_object_update_transformation_buffer (XRD_SCENE_OBJECT (self), eye,
+                                                 view, projection);
+
+  /* Both eyes share the window buffer, the eyes are close enough */
+  if (eye == EVREye_Eye_Left)
+    _update_lights (self, view);
+
+  return TRUE;
+}
+
+/**
+ * xrd_scene_window_record:
+ * @self: The #XrdSceneWindow
+ * @eye: The eye to draw.
+ * @pipeline: The pipeline to bind.
+ * @pipeline_layout: The layout of @pipeline.
+ * @cmd_buffer: The command buffer to record into.
+ *
+ * Records the draw commands without updating the uniform buffer. Call
+ * xrd_scene_window_update_mvp() or
+ * xrd_scene_window_update_transformation_buffer() for @eye first.
+ * Does nothing if @cmd_buffer is %VK_NULL_HANDLE, so the draw functions
+ * only update the uniform buffers of a previously recorded frame then.
+ */
+void
+xrd_scene_window_record (XrdSceneWindow    *self,
+                         EVREye             eye,
+                         VkPipeline         pipeline,
+                         VkPipelineLayout   pipeline_layout,
+                         VkCommandBuffer    cmd_buffer)
+{
+  if (cmd_buffer == VK_NULL_HANDLE || !_is_drawable (self))
     return;
 
-  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
 
-  xrd_scene_object_update_mvp_matrix (obj, eye, vp);
+  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
-  xrd_scene_object_bind (obj, eye, cmd_buffer, pipeline_layout);
+  xrd_scene_object_bind (XRD_SCENE_OBJECT (self), eye,
+                         cmd_buffer, pipeline_layout);
   gulkan_vertex_buffer_draw (priv->vertex_buffer, cmd_buffer);
 }
 
+void
+xrd_scene_window_draw (XrdSceneWindow    *self,
+                       EVREye             eye,
+                       VkPipeline         pipeline,
+                       VkPipelineLayout   pipeline_layout,
+                       VkCommandBuffer    cmd_buffer,
+                       graphene_matrix_t *vp)
+{
+  if (!xrd_scene_window_update_mvp (self, eye, vp))
+    return;
+
+  xrd_scene_window_record (self, eye, pipeline, pipeline_layout, cmd_buffer);
+}
+
 void
 xrd_scene_window_draw_shaded (XrdSceneWindow    *self,
                               EVREye             eye,
@@ -350,23 +497,11 @@ xrd_scene_window_draw_shaded (XrdSceneWindow    *self,
                               graphene_matrix_t *view,
                               graphene_matrix_t *projection)
 {
-  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
-  if (!priv->window_data->texture)
-    {
-      /* g_warning ("Trying to draw window with no texture.\n"); */
-      return;
-    }
-
-  XrdSceneObject *obj = XRD_SCENE_OBJECT (self);
-  if (!xrd_scene_object_is_visible (obj))
+  if (!xrd_scene_window_update_transformation_buffer (self, eye,
+                                                      view, projection))
     return;
 
-  vkCmdBindPipeline (cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
-  xrd_scene_object_update_transformation_buffer (obj, eye, view, projection);
-
-  xrd_scene_object_bind (obj, eye, cmd_buffer, pipeline_layout);
-  gulkan_vertex_buffer_draw (priv->vertex_buffer, cmd_buffer);
+  xrd_scene_window_record (self, eye, pipeline, pipeline_layout, cmd_buffer);
 }
 
 void
@@ -393,6 +528,19 @@ xrd_scene_window_update_descriptors (XrdSceneWindow *self)
   XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
   VkBuffer lights = xrd_scene_renderer_get_lights_buffer_handle (renderer);
 
+  VkDescriptorImageInfo image_info = {
+    .sampler = priv->sampler,
+    .imageView = gulkan_texture_get_image_view (priv->window_data->texture),
+    .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+  };
+
+  if (priv->minified)
+    {
+      image_info.sampler = xrd_scene_mip_chain_get_sampler (priv->mip_chain);
+      image_info.imageView =
+        xrd_scene_mip_chain_get_image_view (priv->mip_chain);
+    }
+
   for (uint32_t eye = 0; eye < 2; eye++)
     {
       VkBuffer transformation_buffer =
@@ -422,11 +570,7 @@ xrd_scene_window_update_descriptors (XrdSceneWindow *self)
           .dstBinding = 1,
           .descriptorCount = 1,
           .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-          .pImageInfo = &(VkDescriptorImageInfo) {
-            .sampler = priv->sampler,
-            .imageView = gulkan_texture_get_image_view (priv->window_data->texture),
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-          },
+          .pImageInfo = &image_info,
           .pBufferInfo = NULL,
           .pTexelBufferView = NULL
         },
@@ -460,6 +604,191 @@ xrd_scene_window_update_descriptors (XrdSceneWindow *self)
 
       vkUpdateDescriptorSets (device, 4, write_descriptor_sets, 0, NULL);
     }
+
+  xrd_scene_object_structure_changed ();
+}
+
+/**
+ * xrd_scene_window_add_damage:
+ * @self: The #XrdSceneWindow
+ * @damage: (nullable): The region of the texture that changed, in pixels.
+ * %NULL for the whole texture.
+ *
+ * Marks texels the mip chain needs to regenerate, call after uploading to
+ * the texture.
+ *
+ * No uploader reports damage yet. Submitting the same texture again damages
+ * all of it, so a minified window regenerates its whole mip chain after
+ * every update.
+ */
+void
+xrd_scene_window_add_damage (XrdSceneWindow *self,
+                             const VkRect2D *damage)
+{
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+
+  VkRect2D full = {
+    .offset = { 0, 0 },
+    .extent = {
+      priv->window_data->texture_width,
+      priv->window_data->texture_height
+    }
+  };
+
+  if (damage == NULL)
+    damage = &full;
+
+  priv->damage_serial++;
+
+  if (!priv->mips_dirty)
+    {
+      priv->damage = *damage;
+      priv->mips_dirty = TRUE;
+      return;
+    }
+
+  /* Bounding rectangle of both */
+  int32_t x0 = MIN (priv->damage.offset.x, damage->offset.x);
+  int32_t y0 = MIN (priv->damage.offset.y, damage->offset.y);
+  int32_t x1 = MAX (priv->damage.offset.x + (int32_t) priv->damage.extent.width,
+                    damage->offset.x + (int32_t) damage->extent.width);
+  int32_t y1 = MAX (priv->damage.offset.y +
+                    (int32_t) priv->damage.extent.height,
+                    damage->offset.y + (int32_t) damage->extent.height);
+
+  priv->damage.offset.x = x0;
+  priv->damage.offset.y = y0;
+  priv->damage.extent.width = (uint32_t) (x1 - x0);
+  priv->damage.extent.height = (uint32_t) (y1 - y0);
+}
+
+/* Allocates the mip chain for the current texture, if it changed size */
+static gboolean
+_init_mip_chain (XrdSceneWindow *self)
+{
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+  GulkanTexture *texture = priv->window_data->texture;
+
+  uint32_t w = gulkan_texture_get_width (texture);
+  uint32_t h = gulkan_texture_get_height (texture);
+
+  if (priv->mip_chain == NULL)
+    priv->mip_chain = xrd_scene_mip_chain_new ();
+
+  if (!xrd_scene_mip_chain_matches (priv->mip_chain, w, h))
+    {
+      XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+      GulkanDevice *device = gulkan_client_get_device (GULKAN_CLIENT (renderer));
+
+      /* The blits convert from whatever format the texture has */
+      if (!xrd_scene_mip_chain_initialize (priv->mip_chain, device,
+                                           VK_FORMAT_R8G8B8A8_UNORM, w, h))
+        {
+          g_printerr ("Could not allocate mip chain for window %p.\n",
+                      (void*) self);
+          g_clear_object (&priv->mip_chain);
+          return FALSE;
+        }
+    }
+
+  /* Contents are stale or undefined */
+  xrd_scene_window_add_damage (self, NULL);
+
+  return TRUE;
+}
+
+/**
+ * xrd_scene_window_set_minified:
+ * @self: The #XrdSceneWindow
+ * @minified: Whether the window covers less than half of its texture
+ * resolution on screen.
+ *
+ * Window textures are uploaded without mip maps. A minified window samples
+ * a mip chain instead, which xrd_scene_window_record_mips() keeps up to
+ * date with the damaged regions of the texture. The chain is kept when the
+ * window is magnified again, so crossing the threshold does not reallocate.
+ */
+void
+xrd_scene_window_set_minified (XrdSceneWindow *self,
+                               gboolean        minified)
+{
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+
+  if (priv->minified == minified || priv->window_data->texture == NULL)
+    return;
+
+  if (minified && !_init_mip_chain (self))
+    return;
+
+  priv->minified = minified;
+  xrd_scene_window_update_descriptors (self);
+}
+
+gboolean
+xrd_scene_window_get_minified (XrdSceneWindow *self)
+{
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+  return priv->minified;
+}
+
+/**
+ * xrd_scene_window_has_mip_damage:
+ * @self: The #XrdSceneWindow
+ *
+ * Returns: Whether xrd_scene_window_record_mips() has work to do.
+ */
+gboolean
+xrd_scene_window_has_mip_damage (XrdSceneWindow *self)
+{
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+  return priv->minified && priv->mips_dirty;
+}
+
+/**
+ * xrd_scene_window_get_mip_damage_serial:
+ * @self: The #XrdSceneWindow
+ *
+ * A frame that records the mips can not be resubmitted for the next damage,
+ * mix this into the structure key, see
+ * xrd_scene_renderer_set_structure_key_cb().
+ *
+ * Returns: 0 if xrd_scene_window_record_mips() has no work to do, otherwise
+ * a value that changes with every xrd_scene_window_add_damage().
+ */
+guint64
+xrd_scene_window_get_mip_damage_serial (XrdSceneWindow *self)
+{
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+  if (!xrd_scene_window_has_mip_damage (self))
+    return 0;
+  return priv->damage_serial;
+}
+
+/**
+ * xrd_scene_window_record_mips:
+ * @self: The #XrdSceneWindow
+ * @cmd_buffer: A command buffer outside of a render pass, e.g. the frame
+ * command buffer before the eyes are rendered.
+ *
+ * Regenerates the damaged region of the mip chain of a minified window.
+ *
+ * Returns: %TRUE if commands were recorded.
+ */
+gboolean
+xrd_scene_window_record_mips (XrdSceneWindow  *self,
+                              VkCommandBuffer  cmd_buffer)
+{
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+
+  if (!xrd_scene_window_has_mip_damage (self))
+    return FALSE;
+
+  VkImage image = gulkan_texture_get_image (priv->window_data->texture);
+  xrd_scene_mip_chain_record (priv->mip_chain, cmd_buffer, image,
+                              &priv->damage);
+  priv->mips_dirty = FALSE;
+
+  return TRUE;
 }
 
 /* XrdWindow Interface functions */
@@ -476,15 +805,15 @@ _set_transformation (XrdWindow         *window,
 
   xrd_scene_object_set_scale (XRD_SCENE_OBJECT (self), height_meters);
 
-  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
-  if (priv->window_data->child_window)
-    xrd_window_update_child (window);
-
   XrdWindowData *data = xrd_window_get_data (window);
   graphene_matrix_t transform_unscaled;
   xrd_window_get_transformation_no_scale (window, &transform_unscaled);
   graphene_matrix_init_from_matrix (&data->transform, &transform_unscaled);
 
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+  if (priv->window_data->child_window)
+    xrd_window_update_child (window);
+
   return TRUE;
 }
 
@@ -506,29 +835,17 @@ _get_transformation_no_scale (XrdWindow         *window,
   return TRUE;
 }
 
+/* Sizes the plane to the region of @texture the window shows */
 static void
-_submit_texture (XrdWindow     *window,
-                 GulkanClient  *client,
-                 GulkanTexture *texture)
+_update_texture_size (XrdSceneWindow *self,
+                      GulkanTexture  *texture)
 {
-  XrdSceneWindow *self = XRD_SCENE_WINDOW (window);
-
   XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
-  if (texture == priv->window_data->texture)
-    {
-      gchar *title;
-      g_object_get (window, "title", &title, NULL);
-      g_debug ("Texture %p was already submitted to window %p (%s).\n",
-               (void*) texture, (void*) window, title);
-      return;
-    }
 
-  VkDevice device = gulkan_client_get_device_handle (client);
+  uint32_t w, h;
+  xrd_window_get_shown_texture_size (XRD_WINDOW (self), texture, &w, &h);
 
-  uint32_t w = gulkan_texture_get_width (texture);
-  uint32_t h = gulkan_texture_get_height (texture);
-
-  g_object_set (window,
+  g_object_set (self,
                 "texture-width", w,
                 "texture-height", h,
                 NULL);
@@ -539,9 +856,30 @@ _submit_texture (XrdWindow     *window,
     {
       priv->aspect_ratio = aspect_ratio;
       gulkan_vertex_buffer_reset (priv->vertex_buffer);
+      xrd_scene_object_structure_changed ();
       _append_plane (priv->vertex_buffer, priv->aspect_ratio);
       gulkan_vertex_buffer_map_array (priv->vertex_buffer);
     }
+}
+
+static void
+_submit_texture (XrdWindow     *window,
+                 GulkanClient  *client,
+                 GulkanTexture *texture)
+{
+  XrdSceneWindow *self = XRD_SCENE_WINDOW (window);
+
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+  /* The texture contents were updated in place */
+  if (texture == priv->window_data->texture)
+    {
+      xrd_scene_window_add_damage (self, NULL);
+      return;
+    }
+
+  VkDevice device = gulkan_client_get_device_handle (client);
+
+  _update_texture_size (self, texture);
 
   if (priv->window_data->texture)
     g_object_unref (priv->window_data->texture);
@@ -569,6 +907,9 @@ _submit_texture (XrdWindow     *window,
 
   vkCreateSampler (device, &sampler_info, NULL, &priv->sampler);
 
+  if (priv->minified && !_init_mip_chain (self))
+    priv->minified = FALSE;
+
   xrd_scene_window_update_descriptors (self);
 }
 
@@ -594,6 +935,11 @@ _set_flip_y (XrdWindow *window,
 {
   XrdSceneWindow *self = XRD_SCENE_WINDOW (window);
   XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+
+  /* Flipping selects a different pipeline variant */
+  if (priv->flip_y != flip_y)
+    xrd_scene_object_structure_changed ();
+
   priv->flip_y = flip_y;
   priv->shading_buffer_data.flip_y = flip_y;
 
@@ -601,6 +947,39 @@ _set_flip_y (XrdWindow *window,
                                        (gpointer) &priv->shading_buffer_data);
 }
 
+static void
+_set_uv_rect (XrdWindow             *window,
+              const graphene_rect_t *rect)
+{
+  XrdSceneWindow *self = XRD_SCENE_WINDOW (window);
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+
+  priv->shading_buffer_data.uv_rect[0] = rect->origin.x;
+  priv->shading_buffer_data.uv_rect[1] = rect->origin.y;
+  priv->shading_buffer_data.uv_rect[2] = rect->size.width;
+  priv->shading_buffer_data.uv_rect[3] = rect->size.height;
+
+  gulkan_uniform_buffer_update_struct (priv->shading_buffer,
+                                       (gpointer) &priv->shading_buffer_data);
+
+  if (priv->window_data->texture)
+    _update_texture_size (self, priv->window_data->texture);
+}
+
+/**
+ * xrd_scene_window_get_flip_y:
+ * @self: The #XrdSceneWindow
+ *
+ * Returns: Whether the texture is drawn upside down, which needs one of the
+ * flipped window pipelines.
+ */
+gboolean
+xrd_scene_window_get_flip_y (XrdSceneWindow *self)
+{
+  XrdSceneWindowPrivate *priv = xrd_scene_window_get_instance_private (self);
+  return priv->flip_y;
+}
+
 void
 xrd_scene_window_set_width_meters (XrdSceneWindow *self,
                                    float           width_meters)
@@ -636,6 +1015,7 @@ xrd_scene_window_window_interface_init (XrdWindowInterface *iface)
   iface->add_child = _add_child;
   iface->set_color = (void (*)(XrdWindow*, const graphene_vec3_t*)) xrd_scene_window_set_color;
   iface->set_flip_y = _set_flip_y;
+  iface->set_uv_rect = _set_uv_rect;
   iface->show = (void (*)(XrdWindow*)) xrd_scene_object_show;
   iface->hide = (void (*)(XrdWindow*)) xrd_scene_object_hide;
   iface->is_visible = (gboolean (*)(XrdWindow*)) xrd_scene_object_is_visible;
@@ -18,6 +18,7 @@
 
 #include <gulkan.h>
 
+#include "xrd-scene-mip-chain.h"
 #include "xrd-scene-object.h"
 #include "xrd-window.h"
 
@@ -83,6 +84,27 @@ xrd_scene_window_draw_shaded (XrdSceneWindow    *self,
                               graphene_matrix_t *view,
                               graphene_matrix_t *projection);
 
+gboolean
+xrd_scene_window_update_mvp (XrdSceneWindow    *self,
+                             EVREye             eye,
+                             graphene_matrix_t *vp);
+
+gboolean
+xrd_scene_window_update_transformation_buffer (XrdSceneWindow    *self,
+                                               EVREye             eye,
+                                               graphene_matrix_t *view,
+                                               graphene_matrix_t *projection);
+
+void
+xrd_scene_window_record (XrdSceneWindow    *self,
+                         EVREye             eye,
+                         VkPipeline         pipeline,
+                         VkPipelineLayout   pipeline_layout,
+                         VkCommandBuffer    cmd_buffer);
+
+gboolean
+xrd_scene_window_get_flip_y (XrdSceneWindow *self);
+
 void
 xrd_scene_window_set_width_meters (XrdSceneWindow *self,
                                    float           width_meters);
@@ -94,6 +116,27 @@ xrd_scene_window_set_color (XrdSceneWindow        *self,
 void
 xrd_scene_window_update_descriptors (XrdSceneWindow *self);
 
+void
+xrd_scene_window_add_damage (XrdSceneWindow *self,
+                             const VkRect2D *damage);
+
+void
+xrd_scene_window_set_minified (XrdSceneWindow *self,
+                               gboolean        minified);
+
+gboolean
+xrd_scene_window_get_minified (XrdSceneWindow *self);
+
+gboolean
+xrd_scene_window_has_mip_damage (XrdSceneWindow *self);
+
+guint64
+xrd_scene_window_get_mip_damage_serial (XrdSceneWindow *self);
+
+gboolean
+xrd_scene_window_record_mips (XrdSceneWindow  *self,
+                              VkCommandBuffer  cmd_buffer);
+
 G_END_DECLS
 
 #endif /* XRD_SCENE_WINDOW_H_ */
@@ -9,6 +9,17 @@
 
 #include <gdk/gdk.h>
 
+#include "xrd-icon-atlas.h"
+
+/*
+ * tile size in pixels -> XrdIconAtlas. The atlas textures belong to one
+ * uploader, the table is dropped when it goes away or a different one is
+ * used.
+ */
+static GHashTable *icon_atlases = NULL;
+static GulkanClient *icon_atlas_client = NULL;
+static VkImageLayout icon_atlas_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
 static GdkPixbuf *
 _load_pixbuf (const gchar* name)
 {
@@ -195,6 +206,10 @@ _submit_cairo_surface (XrdWindow    *button,
                        VkImageLayout upload_layout,
                        cairo_surface_t* surface)
 {
+  /* The button may have shown an atlas tile before */
+  graphene_rect_t whole;
+  graphene_rect_init (&whole, 0.f, 0.f, 1.f, 1.f);
+
   GulkanTexture *texture =
     gulkan_client_texture_new_from_cairo_surface (client,
                                                   surface,
@@ -207,6 +222,10 @@ _submit_cairo_surface (XrdWindow    *button,
       return;
     }
 
+  XrdWindowData *data = xrd_window_get_data (button);
+  if (!graphene_rect_equal (&data->uv_rect, &whole))
+    xrd_window_set_uv_rect (button, &whole);
+
   xrd_window_submit_texture (button, client, texture);
 
   g_object_unref (texture);
@@ -240,6 +259,102 @@ xrd_button_set_text (XrdWindow    *button,
   cairo_surface_destroy (surface);
 }
 
+static void
+_draw_icon_tile (cairo_t   *cr,
+                 GdkPixbuf *icon,
+                 uint32_t   tile_size)
+{
+  _draw_background (cr, tile_size, tile_size);
+  _draw_icon (cr, icon, tile_size, 100);
+}
+
+/* Runs before the uploader destroys its device, so the textures go first. */
+static void
+_icon_atlas_client_disposed (gpointer data, GObject *client)
+{
+  (void) data;
+  (void) client;
+  g_clear_pointer (&icon_atlases, g_hash_table_unref);
+  icon_atlas_client = NULL;
+}
+
+static void
+_clear_icon_atlases (void)
+{
+  if (icon_atlas_client)
+    g_object_weak_unref (G_OBJECT (icon_atlas_client),
+                         _icon_atlas_client_disposed, NULL);
+  _icon_atlas_client_disposed (NULL, NULL);
+}
+
+static XrdIconAtlas *
+_get_icon_atlas (GulkanClient *client,
+                 VkImageLayout upload_layout,
+                 uint32_t      tile_size)
+{
+  if (icon_atlas_client != client || icon_atlas_layout != upload_layout)
+    _clear_icon_atlases ();
+
+  if (!icon_atlases)
+    {
+      icon_atlases = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                            NULL, g_object_unref);
+      icon_atlas_client = client;
+      icon_atlas_layout = upload_layout;
+      g_object_weak_ref (G_OBJECT (client), _icon_atlas_client_disposed, NULL);
+    }
+
+  gpointer key = GUINT_TO_POINTER (tile_size);
+  XrdIconAtlas *atlas = g_hash_table_lookup (icon_atlases, key);
+  if (!atlas)
+    {
+      atlas = xrd_icon_atlas_new (client, upload_layout, "/icons",
+                                  tile_size, _draw_icon_tile);
+      if (!atlas)
+        return NULL;
+      g_hash_table_insert (icon_atlases, key, atlas);
+    }
+
+  return atlas;
+}
+
+static gboolean
+_set_icon_from_atlas (XrdWindow    *button,
+                      GulkanClient *client,
+                      VkImageLayout upload_layout,
+                      XrdPixelSize *dim,
+                      const gchar  *url)
+{
+  if (dim->width != dim->height)
+    return FALSE;
+
+  XrdIconAtlas *atlas = _get_icon_atlas (client, upload_layout, dim->width);
+  if (!atlas)
+    return FALSE;
+
+  graphene_rect_t uv_rect;
+  if (!xrd_icon_atlas_get_uv_rect (atlas, url, &uv_rect))
+    return FALSE;
+
+  /* Set the region first, so the window is sized to the tile */
+  xrd_window_set_uv_rect (button, &uv_rect);
+  xrd_window_submit_texture (button, client,
+                             xrd_icon_atlas_get_texture (atlas));
+
+  return TRUE;
+}
+
+/**
+ * xrd_button_set_icon:
+ * @button: The button
+ * @client: The #GulkanClient used for the upload
+ * @upload_layout: The #VkImageLayout the texture will be in after the upload
+ * @url: The resource url of the icon, e.g. "/icons/edit-undo-symbolic.svg"
+ *
+ * Square buttons showing an icon from the "/icons" resource share one
+ * #XrdIconAtlas texture per size and only differ in their uv rect. Other
+ * icons are rendered into a texture of their own on every call.
+ */
 void
 xrd_button_set_icon (XrdWindow    *button,
                      GulkanClient *client,
@@ -249,6 +364,9 @@ xrd_button_set_icon (XrdWindow    *button,
 
   XrdPixelSize dim = _get_texture_size (button);
 
+  if (_set_icon_from_atlas (button, client, upload_layout, &dim, url))
+    return;
+
   gsize size = sizeof(unsigned char) * 4 * dim.width * dim.height;
   unsigned char* image = g_malloc (size);
 
@@ -258,6 +376,7 @@ xrd_button_set_icon (XrdWindow    *button,
   if (!surface)
     {
       g_printerr ("Could not create cairo surface.\n");
+      g_free (image);
       return;
     }
 
@@ -21,14 +21,27 @@
 #include "xrd-container.h"
 #include "xrd-math.h"
 #include "xrd-button.h"
+#include "xrd-scene-renderer.h"
+#include "xrd-telemetry.h"
+#include "xrd-input-ring.h"
+#include "xrd-headless-client.h"
+#include "xrd-headless-window.h"
 
 #define WINDOW_MIN_DIST .05f
 #define WINDOW_MAX_DIST 15.f
 
+/* Controllers moving less than this count as idle, see xrd_math_pose_distance */
+#define CONTROLLER_MOTION_THRESHOLD 0.01f
+/* A headset that did not move for this long is most likely not worn */
+#define HMD_IDLE_TIMEOUT_US (10 * G_USEC_PER_SEC)
+#define HMD_MOTION_THRESHOLD 0.005f
+#define HMD_CHECK_INTERVAL_US (250 * 1000)
+
 enum {
   KEYBOARD_PRESS_EVENT,
   CLICK_EVENT,
   MOVE_CURSOR_EVENT,
+  SCROLL_EVENT,
   REQUEST_QUIT_EVENT,
   LAST_SIGNAL
 };
@@ -63,11 +76,25 @@ typedef struct _XrdClientPrivate
   guint poll_input_source_id;
   guint poll_input_rate_ms;
 
+  /* see "input-poll-adaptive" */
+  gboolean poll_input_adaptive;
+  guint poll_input_idle_rate_ms;
+  guint poll_input_idle_timeout_ms;
+  guint poll_input_current_rate_ms;
+  gint64 last_input_activity;
+  gboolean hmd_idle;
+  gint64 hmd_last_check;
+  gint64 hmd_last_motion;
+  graphene_matrix_t hmd_motion_anchor;
+
   double analog_threshold;
 
   double scroll_to_push_ratio;
   double scroll_to_scale_ratio;
 
+  gboolean pose_filter_enabled;
+  XrdPoseFilterSettings pose_filter_settings;
+
   double pixel_per_meter;
 
   XrdDesktopCursor *cursor;
@@ -78,11 +105,30 @@ typedef struct _XrdClientPrivate
   XrdContainer *wm_control_container;
 
   gint64 last_poll_timestamp;
+  gint64 last_poll_start;
 
   gboolean always_show_overlay_pointer;
 
   /* maps a key to desktop #XrdWindows, but not buttons. */
   GHashTable *window_mapping;
+
+  /* input is recorded into input_trace while it is recording */
+  XrdInputTrace *input_trace;
+  XrdInputTrace *replay_trace;
+  /* the records of one replayed poll are handled in one transform batch */
+  gboolean replay_batch_open;
+
+  /* optional thread polling the wm and synth actions, see
+   * "input-thread-enabled" */
+  GThread *input_thread;
+  volatile gint input_thread_running;
+  volatile gint input_thread_poll_rate_us;
+  volatile gint input_thread_poll_synth;
+  OpenVRActionSet *input_thread_actions;
+  OpenVRActionSet *input_thread_synth_actions;
+  XrdInputRing *input_ring;
+  GSource *input_drain_source;
+  XrdInputRingEvent *input_drain_buffer;
 } XrdClientPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (XrdClient, xrd_client, G_TYPE_OBJECT)
@@ -96,6 +142,9 @@ _init_buttons (XrdClient *self, XrdController *controller);
 static void
 _destroy_buttons (XrdClient *self);
 
+static void
+_stop_input_thread (XrdClient *self, gboolean dispatch_queued);
+
 static void
 xrd_client_class_init (XrdClientClass *klass)
 {
@@ -124,6 +173,14 @@ xrd_client_class_init (XrdClientClass *klass)
                    0, NULL, NULL, NULL, G_TYPE_NONE,
                    1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
 
+  signals[SCROLL_EVENT] =
+    g_signal_new ("scroll-event",
+                   G_TYPE_FROM_CLASS (klass),
+                   G_SIGNAL_RUN_LAST,
+                   0, g_signal_accumulator_true_handled, NULL, NULL,
+                   G_TYPE_BOOLEAN,
+                   1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
+
   signals[REQUEST_QUIT_EVENT] =
     g_signal_new ("request-quit-event",
                    G_TYPE_FROM_CLASS (klass),
@@ -410,6 +467,17 @@ _lookup_controller (XrdClient *self,
   return controller;
 }
 
+/* Headless clients have neither input synth nor desktop cursor */
+static gboolean
+_is_synth_controller (XrdClient *self,
+                      guint64    controller_handle)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  return priv->input_synth != NULL &&
+    xrd_input_synth_synthing_controller (priv->input_synth) ==
+      controller_handle;
+}
+
 /**
  * xrd_client_get_keyboard_window
  * @self: The #XrdClient
@@ -518,6 +586,23 @@ xrd_client_emit_move_cursor (XrdClient *self,
   g_signal_emit (self, signals[MOVE_CURSOR_EVENT], 0, event);
 }
 
+/**
+ * xrd_client_emit_scroll:
+ * @self: The #XrdClient
+ * @event: The #XrdScrollEvent, owned by the caller.
+ *
+ * Returns: %TRUE if a "scroll-event" handler handled the event. Otherwise
+ * the scroll should be delivered as wheel button clicks.
+ */
+gboolean
+xrd_client_emit_scroll (XrdClient *self,
+                        XrdScrollEvent *event)
+{
+  gboolean handled = FALSE;
+  g_signal_emit (self, signals[SCROLL_EVENT], 0, event, &handled);
+  return handled;
+}
+
 void
 xrd_client_emit_system_quit (XrdClient *self,
                              OpenVRQuitEvent *event)
@@ -552,6 +637,24 @@ xrd_client_finalize (GObject *gobject)
   if (priv->poll_input_source_id > 0)
     g_source_remove (priv->poll_input_source_id);
 
+  _stop_input_thread (self, FALSE);
+
+  if (priv->replay_trace)
+    {
+      xrd_input_trace_stop (priv->replay_trace);
+      g_signal_handlers_disconnect_by_data (priv->replay_trace, self);
+      if (priv->input_synth)
+        g_signal_handlers_disconnect_by_data (priv->replay_trace,
+                                              priv->input_synth);
+      g_clear_object (&priv->replay_trace);
+    }
+  if (priv->replay_batch_open)
+    {
+      xrd_window_end_transform_batch ();
+      priv->replay_batch_open = FALSE;
+    }
+  g_clear_object (&priv->input_trace);
+
   g_object_unref (priv->manager);
   g_clear_object (&priv->wm_actions);
 
@@ -661,36 +764,170 @@ xrd_client_poll_runtime_events (XrdClient *self)
   return TRUE;
 }
 
+static void
+_schedule_input_poll (XrdClient *self, guint rate_ms)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+
+  /* restarted when the replay finishes */
+  if (priv->replay_trace)
+    return;
+
+  if (priv->poll_input_source_id != 0)
+    g_source_remove (priv->poll_input_source_id);
+
+  priv->poll_input_current_rate_ms = rate_ms;
+  priv->poll_input_source_id =
+      g_timeout_add (rate_ms,
+      (GSourceFunc) xrd_client_poll_input_events,
+      self);
+}
+
+/* Any user input switches back to the full poll rate right away. */
+static void
+_note_input_activity (XrdClient *self)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  priv->last_input_activity = g_get_monotonic_time ();
+  priv->hmd_idle = FALSE;
+  priv->hmd_last_motion = priv->last_input_activity;
+
+  if (priv->poll_input_source_id != 0 &&
+      priv->poll_input_current_rate_ms != priv->poll_input_rate_ms)
+    _schedule_input_poll (self, priv->poll_input_rate_ms);
+}
+
+static void
+_update_hmd_idle (XrdClient *self, gint64 now)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (now - priv->hmd_last_check < HMD_CHECK_INTERVAL_US)
+    return;
+  priv->hmd_last_check = now;
+
+  graphene_matrix_t hmd_pose;
+  if (!openvr_system_get_hmd_pose (&hmd_pose))
+    {
+      priv->hmd_idle = TRUE;
+      return;
+    }
+
+  if (xrd_math_pose_distance (&hmd_pose, &priv->hmd_motion_anchor) >
+      HMD_MOTION_THRESHOLD)
+    {
+      graphene_matrix_init_from_matrix (&priv->hmd_motion_anchor, &hmd_pose);
+      priv->hmd_last_motion = now;
+    }
+
+  priv->hmd_idle = now - priv->hmd_last_motion > HMD_IDLE_TIMEOUT_US;
+}
+
+/*
+ * Poll at the full rate while windows are hovered or grabbed and shortly
+ * after any input, back off to the idle rate otherwise or when the
+ * headset is not worn.
+ */
+static void
+_adapt_input_poll_rate (XrdClient *self)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+
+  guint rate_ms = priv->poll_input_rate_ms;
+  if (priv->poll_input_adaptive)
+    {
+      gint64 now = g_get_monotonic_time ();
+      _update_hmd_idle (self, now);
+
+      if (!priv->hmd_idle &&
+          (xrd_client_is_hovering (self) || xrd_client_is_grabbing (self)))
+        priv->last_input_activity = now;
+
+      gboolean idle = priv->hmd_idle ||
+        now - priv->last_input_activity >
+          (gint64) priv->poll_input_idle_timeout_ms * 1000;
+
+      if (idle && priv->poll_input_idle_rate_ms > rate_ms)
+        rate_ms = priv->poll_input_idle_rate_ms;
+    }
+
+  if (rate_ms != priv->poll_input_current_rate_ms)
+    _schedule_input_poll (self, rate_ms);
+}
+
+/* Returning FALSE removes the source being dispatched. Input activity
+ * during the poll may have replaced it already, the new one stays. */
+static void
+_forget_poll_source (XrdClient *self)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  GSource *source = g_main_current_source ();
+  if (source != NULL &&
+      priv->poll_input_source_id == g_source_get_id (source))
+    priv->poll_input_source_id = 0;
+}
+
 gboolean
 xrd_client_poll_input_events (XrdClient *self)
 {
   XrdClientPrivate *priv = xrd_client_get_instance_private (self);
 
+  /* start to start, 0 while telemetry is disabled */
+  gint64 telemetry_start = xrd_telemetry_begin ();
+  if (telemetry_start != 0 && priv->last_poll_start != 0)
+    xrd_telemetry_record (XRD_TELEMETRY_POLL_INTERVAL,
+                          priv->last_poll_start,
+                          telemetry_start - priv->last_poll_start);
+  priv->last_poll_start = telemetry_start;
+
   if (!priv->context)
     {
       g_printerr ("Error polling events: No OpenVR Context\n");
-      priv->poll_input_source_id = 0;
+      _forget_poll_source (self);
       return FALSE;
     }
 
-  if (!openvr_action_set_poll (priv->wm_actions))
+  /* Drags, containers and child windows move each window only once */
+  xrd_window_begin_transform_batch ();
+
+  gboolean poll_synth =
+    xrd_client_is_hovering (self) && !xrd_client_is_grabbing (self);
+
+  /* Each action set poll only activates its own set. The input thread
+   * polls both, so they never interleave with polls on the main loop. */
+  if (priv->input_thread != NULL)
+    g_atomic_int_set (&priv->input_thread_poll_synth, poll_synth);
+  else if (!openvr_action_set_poll (priv->wm_actions))
     {
       g_printerr ("Error polling wm actions\n");
-      priv->poll_input_source_id = 0;
+      xrd_window_end_transform_batch ();
+      _forget_poll_source (self);
       return FALSE;
     }
 
-  if (xrd_client_is_hovering (self) && !xrd_client_is_grabbing (self) &&
+  if (priv->input_thread == NULL && poll_synth &&
       !xrd_input_synth_poll_events (priv->input_synth))
     {
       g_printerr ("Error polling synth actions\n");
-      priv->poll_input_source_id = 0;
+      xrd_window_end_transform_batch ();
+      _forget_poll_source (self);
       return FALSE;
     }
 
   xrd_window_manager_poll_window_events (priv->manager);
 
+  xrd_window_end_transform_batch ();
+
   priv->last_poll_timestamp = g_get_monotonic_time ();
+
+  if (priv->input_trace)
+    xrd_input_trace_record_poll (priv->input_trace);
+
+  xrd_telemetry_end (XRD_TELEMETRY_POLL_INPUT, telemetry_start);
+
+  /* may replace this source with one at a different rate */
+  if (priv->poll_input_source_id != 0)
+    _adapt_input_poll_rate (self);
+
   return TRUE;
 }
 
@@ -701,19 +938,24 @@ xrd_client_get_cursor (XrdClient *self)
   return priv->cursor;
 }
 
+/* @time_us is when the pose was sampled, the pose filter derives its
+ * velocity from it */
 static void
-_action_hand_pose_cb (OpenVRAction            *action,
-                      OpenVRPoseEvent         *event,
-                      XrdClient               *self)
+_handle_hand_pose (XrdClient       *self,
+                   OpenVRPoseEvent *event,
+                   gint64           time_us)
 {
-  (void) action;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->input_trace)
+    xrd_input_trace_record_pose (priv->input_trace,
+                                 XRD_INPUT_TRACE_HAND_POSE, event);
+
   if (!event->device_connected || !event->valid || !event->active)
     {
       g_free (event);
       return;
     }
 
-  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
   XrdController *controller = _lookup_controller (self,
                                                   event->controller_handle);
   if (controller == NULL)
@@ -730,6 +972,15 @@ _action_hand_pose_cb (OpenVRAction            *action,
       return;
     }
 
+  if (priv->pose_filter_enabled)
+    xrd_pose_filter_apply (xrd_controller_get_pose_filter (controller),
+                           &priv->pose_filter_settings, time_us,
+                           &event->pose, &event->pose);
+
+  if (xrd_controller_moved (controller, &event->pose,
+                            CONTROLLER_MOTION_THRESHOLD))
+    _note_input_activity (self);
+
   xrd_window_manager_update_pose (priv->manager, &event->pose, controller);
 
   xrd_pointer_move (xrd_controller_get_pointer (controller), &event->pose);
@@ -743,8 +994,7 @@ _action_hand_pose_cb (OpenVRAction            *action,
     g_slist_find (buttons, hovered_window) == NULL;
 
   /* show cursor while synth controller hovers window, but doesn't grab */
-  if (xrd_controller_get_handle (controller) ==
-          xrd_input_synth_synthing_controller (priv->input_synth) &&
+  if (_is_synth_controller (self, xrd_controller_get_handle (controller)) &&
       hovering_window_for_input &&
       xrd_controller_get_grab_state (controller)->window == NULL)
     xrd_desktop_cursor_show (priv->cursor);
@@ -753,11 +1003,36 @@ _action_hand_pose_cb (OpenVRAction            *action,
 }
 
 static void
-_action_hand_pose_hand_grip_cb (OpenVRAction    *action,
-                                OpenVRPoseEvent *event,
-                                XrdClient       *self)
+_update_hand_pose (XrdClient       *self,
+                   OpenVRPoseEvent *event,
+                   gint64           time_us)
+{
+  gint64 telemetry_start = xrd_telemetry_begin ();
+  _handle_hand_pose (self, event, time_us);
+  xrd_telemetry_end (XRD_TELEMETRY_ACTION_HAND_POSE, telemetry_start);
+}
+
+/* Live poses are dispatched from the poll, right after sampling them */
+static void
+_action_hand_pose_cb (OpenVRAction    *action,
+                      OpenVRPoseEvent *event,
+                      XrdClient       *self)
 {
   (void) action;
+  _update_hand_pose (self, event, g_get_monotonic_time ());
+}
+
+static void
+_handle_hand_pose_hand_grip (OpenVRAction    *action,
+                             OpenVRPoseEvent *event,
+                             XrdClient       *self)
+{
+  (void) action;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->input_trace)
+    xrd_input_trace_record_pose (priv->input_trace,
+                                 XRD_INPUT_TRACE_HAND_POSE_HAND_GRIP, event);
+
   if (!event->device_connected || !event->valid || !event->active)
     {
       g_free (event);
@@ -777,6 +1052,16 @@ _action_hand_pose_hand_grip_cb (OpenVRAction    *action,
   g_free (event);
 }
 
+static void
+_action_hand_pose_hand_grip_cb (OpenVRAction    *action,
+                                OpenVRPoseEvent *event,
+                                XrdClient       *self)
+{
+  gint64 telemetry_start = xrd_telemetry_begin ();
+  _handle_hand_pose_hand_grip (action, event, self);
+  xrd_telemetry_end (XRD_TELEMETRY_ACTION_HAND_POSE_HAND_GRIP, telemetry_start);
+}
+
 
 static void
 _perform_push_pull (XrdClient *self,
@@ -807,12 +1092,16 @@ _perform_push_pull (XrdClient *self,
 }
 
 static void
-_action_push_pull_scale_cb (OpenVRAction        *action,
-                            OpenVRAnalogEvent   *event,
-                            XrdClient           *self)
+_handle_push_pull_scale (OpenVRAction      *action,
+                         OpenVRAnalogEvent *event,
+                         XrdClient         *self)
 {
   (void) action;
   XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->input_trace)
+    xrd_input_trace_record_analog (priv->input_trace,
+                                   XRD_INPUT_TRACE_PUSH_PULL_SCALE, event);
+
   XrdController *controller = _lookup_controller (self,
                                                   event->controller_handle);
   if (controller == NULL)
@@ -864,12 +1153,26 @@ _action_push_pull_scale_cb (OpenVRAction        *action,
 }
 
 static void
-_action_push_pull_cb (OpenVRAction        *action,
-                      OpenVRAnalogEvent   *event,
-                      XrdClient           *self)
+_action_push_pull_scale_cb (OpenVRAction      *action,
+                            OpenVRAnalogEvent *event,
+                            XrdClient         *self)
+{
+  gint64 telemetry_start = xrd_telemetry_begin ();
+  _handle_push_pull_scale (action, event, self);
+  xrd_telemetry_end (XRD_TELEMETRY_ACTION_PUSH_PULL_SCALE, telemetry_start);
+}
+
+static void
+_handle_push_pull (OpenVRAction      *action,
+                   OpenVRAnalogEvent *event,
+                   XrdClient         *self)
 {
   (void) action;
   XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->input_trace)
+    xrd_input_trace_record_analog (priv->input_trace,
+                                   XRD_INPUT_TRACE_PUSH_PULL, event);
+
   XrdController *controller = _lookup_controller (self,
                                                   event->controller_handle);
   if (controller == NULL)
@@ -892,12 +1195,26 @@ _action_push_pull_cb (OpenVRAction        *action,
 }
 
 static void
-_action_grab_cb (OpenVRAction        *action,
-                 OpenVRDigitalEvent  *event,
-                 XrdClient           *self)
+_action_push_pull_cb (OpenVRAction      *action,
+                      OpenVRAnalogEvent *event,
+                      XrdClient         *self)
+{
+  gint64 telemetry_start = xrd_telemetry_begin ();
+  _handle_push_pull (action, event, self);
+  xrd_telemetry_end (XRD_TELEMETRY_ACTION_PUSH_PULL, telemetry_start);
+}
+
+static void
+_handle_grab (OpenVRAction       *action,
+              OpenVRDigitalEvent *event,
+              XrdClient          *self)
 {
   (void) action;
   XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->input_trace)
+    xrd_input_trace_record_digital (priv->input_trace,
+                                    XRD_INPUT_TRACE_GRAB_WINDOW, event);
+
   XrdController *controller = _lookup_controller (self,
                                                   event->controller_handle);
   if (controller == NULL)
@@ -905,6 +1222,7 @@ _action_grab_cb (OpenVRAction        *action,
 
   if (event->changed)
     {
+      _note_input_activity (self);
       if (event->state == 1)
         xrd_window_manager_check_grab (priv->manager, controller);
       else
@@ -915,20 +1233,37 @@ _action_grab_cb (OpenVRAction        *action,
 }
 
 static void
-_action_menu_cb (OpenVRAction        *action,
-                 OpenVRDigitalEvent  *event,
-                 XrdClient           *self)
+_action_grab_cb (OpenVRAction       *action,
+                 OpenVRDigitalEvent *event,
+                 XrdClient          *self)
+{
+  gint64 telemetry_start = xrd_telemetry_begin ();
+  _handle_grab (action, event, self);
+  xrd_telemetry_end (XRD_TELEMETRY_ACTION_GRAB, telemetry_start);
+}
+
+static void
+_handle_menu (OpenVRAction       *action,
+              OpenVRDigitalEvent *event,
+              XrdClient          *self)
 {
   (void) action;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->input_trace)
+    xrd_input_trace_record_digital (priv->input_trace,
+                                    XRD_INPUT_TRACE_MENU, event);
+
   XrdController *controller = _lookup_controller (self,
                                                   event->controller_handle);
   if (controller == NULL)
     return;
 
+  if (event->changed)
+    _note_input_activity (self);
+
   if (event->changed && event->state == 1 &&
       !xrd_controller_get_hover_state (controller)->window)
     {
-      XrdClientPrivate *priv = xrd_client_get_instance_private (self);
       if (priv->wm_control_container)
         _destroy_buttons (self);
       else
@@ -937,6 +1272,16 @@ _action_menu_cb (OpenVRAction        *action,
   g_free (event);
 }
 
+static void
+_action_menu_cb (OpenVRAction       *action,
+                 OpenVRDigitalEvent *event,
+                 XrdClient          *self)
+{
+  gint64 telemetry_start = xrd_telemetry_begin ();
+  _handle_menu (action, event, self);
+  xrd_telemetry_end (XRD_TELEMETRY_ACTION_MENU, telemetry_start);
+}
+
 typedef struct {
   XrdGrabState *grab_state;
   graphene_quaternion_t from;
@@ -985,11 +1330,15 @@ _interpolate_orientation_cb (gpointer _transition)
 }
 
 static void
-_action_reset_orientation_cb (OpenVRAction       *action,
-                              OpenVRDigitalEvent *event,
-                              XrdClient          *self)
+_handle_reset_orientation (OpenVRAction       *action,
+                           OpenVRDigitalEvent *event,
+                           XrdClient          *self)
 {
   (void) action;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->input_trace)
+    xrd_input_trace_record_digital (priv->input_trace,
+                                    XRD_INPUT_TRACE_RESET_ORIENTATION, event);
 
   if (!(event->changed && event->state == 1))
     return;
@@ -1023,6 +1372,16 @@ _action_reset_orientation_cb (OpenVRAction       *action,
   g_free (event);
 }
 
+static void
+_action_reset_orientation_cb (OpenVRAction       *action,
+                              OpenVRDigitalEvent *event,
+                              XrdClient          *self)
+{
+  gint64 telemetry_start = xrd_telemetry_begin ();
+  _handle_reset_orientation (action, event, self);
+  xrd_telemetry_end (XRD_TELEMETRY_ACTION_RESET_ORIENTATION, telemetry_start);
+}
+
 static void
 _mark_windows_for_selection_mode (XrdClient *self);
 
@@ -1055,8 +1414,7 @@ _window_grab_start_cb (XrdWindow               *window,
 
   xrd_window_manager_drag_start (priv->manager, controller);
 
-  if (event->controller_handle ==
-      xrd_input_synth_synthing_controller (priv->input_synth))
+  if (_is_synth_controller (self, event->controller_handle))
     xrd_desktop_cursor_hide (priv->cursor);
 
   g_free (event);
@@ -1170,11 +1528,10 @@ _window_hover_end_cb (XrdWindow               *window,
       xrd_pointer_tip_hide (xrd_controller_get_pointer_tip (controller));
     }
 
-  XrdInputSynth *input_synth = xrd_client_get_input_synth (self);
-  xrd_input_synth_reset_press_state (input_synth);
+  if (priv->input_synth)
+    xrd_input_synth_reset_press_state (priv->input_synth);
 
-  if (event->controller_handle ==
-      xrd_input_synth_synthing_controller (input_synth))
+  if (_is_synth_controller (self, event->controller_handle))
     xrd_desktop_cursor_hide (priv->cursor);
 
   g_free (event);
@@ -1525,14 +1882,21 @@ _keyboard_close_cb (OpenVRContext *context,
 }
 
 static void
-_action_show_keyboard_cb (OpenVRAction       *action,
-                          OpenVRDigitalEvent *event,
-                          XrdClient          *self)
+_handle_show_keyboard (OpenVRAction       *action,
+                       OpenVRDigitalEvent *event,
+                       XrdClient          *self)
 {
   (void) action;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->input_trace)
+    xrd_input_trace_record_digital (priv->input_trace,
+                                    XRD_INPUT_TRACE_SHOW_KEYBOARD, event);
+
+  if (event->changed)
+    _note_input_activity (self);
+
   if (!event->state && event->changed)
     {
-      XrdClientPrivate *priv = xrd_client_get_instance_private (self);
 
       OpenVRContext *context = openvr_context_get_instance ();
       openvr_context_show_system_keyboard (context);
@@ -1556,6 +1920,16 @@ _action_show_keyboard_cb (OpenVRAction       *action,
   g_free (event);
 }
 
+static void
+_action_show_keyboard_cb (OpenVRAction       *action,
+                          OpenVRDigitalEvent *event,
+                          XrdClient          *self)
+{
+  gint64 telemetry_start = xrd_telemetry_begin ();
+  _handle_show_keyboard (action, event, self);
+  xrd_telemetry_end (XRD_TELEMETRY_ACTION_SHOW_KEYBOARD, telemetry_start);
+}
+
 static void
 _window_hover_cb (XrdWindow     *window,
                   XrdHoverEvent *event,
@@ -1574,8 +1948,7 @@ _window_hover_cb (XrdWindow     *window,
 
   xrd_controller_get_hover_state (controller)->window = window;
 
-  if (event->controller_handle ==
-      xrd_input_synth_synthing_controller (priv->input_synth))
+  if (_is_synth_controller (self, event->controller_handle))
     {
       xrd_input_synth_move_cursor (priv->input_synth, window,
                                    &event->pose, &event->point);
@@ -1654,8 +2027,7 @@ _manager_no_hover_cb (XrdWindowManager *manager,
 
   xrd_pointer_tip_set_active (pointer_tip, FALSE);
 
-  if (xrd_input_synth_synthing_controller (priv->input_synth) ==
-      event->controller_handle)
+  if (_is_synth_controller (self, event->controller_handle))
     xrd_input_synth_reset_scroll (priv->input_synth);
 
   xrd_controller_reset_hover_state (controller);
@@ -1669,14 +2041,366 @@ _update_input_poll_rate (GSettings *settings, gchar *key, gpointer _self)
   XrdClient *self = _self;
   XrdClientPrivate *priv = xrd_client_get_instance_private (self);
 
-  if (priv->poll_input_source_id != 0)
-    g_source_remove (priv->poll_input_source_id);
   priv->poll_input_rate_ms = g_settings_get_uint (settings, key);
 
-  priv->poll_input_source_id =
-      g_timeout_add (priv->poll_input_rate_ms,
-      (GSourceFunc) xrd_client_poll_input_events,
-      self);
+  _schedule_input_poll (self, priv->poll_input_rate_ms);
+}
+
+#define INPUT_RING_CAPACITY 256
+
+typedef struct {
+  XrdClient *client;
+  XrdInputTraceAction action;
+} XrdInputThreadAction;
+
+/* One per connected action, passed as user data to the input thread
+ * callbacks. Only the client differs between instances. */
+static XrdInputThreadAction *
+_input_thread_action_new (XrdClient *self, XrdInputTraceAction action)
+{
+  XrdInputThreadAction *thread_action = g_malloc (sizeof (XrdInputThreadAction));
+  thread_action->client = self;
+  thread_action->action = action;
+  return thread_action;
+}
+
+/* Input thread: copy the event into the ring and wake up the main loop.
+ * Poses replace the previous one, so only button and analog events can
+ * find the ring full. Those must not get lost, so the thread waits for the
+ * main loop to drain the ring. */
+static void
+_input_thread_push (XrdInputThreadAction *thread_action,
+                    XrdInputRingEvent    *ring_event)
+{
+  XrdClientPrivate *priv =
+    xrd_client_get_instance_private (thread_action->client);
+
+  ring_event->action = thread_action->action;
+  ring_event->time_us = g_get_monotonic_time ();
+  while (!xrd_input_ring_push (priv->input_ring, ring_event))
+    {
+      if (!g_atomic_int_get (&priv->input_thread_running))
+        return;
+      g_source_set_ready_time (priv->input_drain_source, 0);
+      g_usleep (1000);
+    }
+
+  g_source_set_ready_time (priv->input_drain_source, 0);
+}
+
+static void
+_input_thread_pose_cb (OpenVRAction         *action,
+                       OpenVRPoseEvent      *event,
+                       XrdInputThreadAction *thread_action)
+{
+  (void) action;
+  XrdInputRingEvent ring_event;
+  ring_event.event.pose = *event;
+  g_free (event);
+  _input_thread_push (thread_action, &ring_event);
+}
+
+static void
+_input_thread_digital_cb (OpenVRAction         *action,
+                          OpenVRDigitalEvent   *event,
+                          XrdInputThreadAction *thread_action)
+{
+  (void) action;
+  XrdInputRingEvent ring_event;
+  ring_event.event.digital = *event;
+  g_free (event);
+  _input_thread_push (thread_action, &ring_event);
+}
+
+static void
+_input_thread_analog_cb (OpenVRAction         *action,
+                         OpenVRAnalogEvent    *event,
+                         XrdInputThreadAction *thread_action)
+{
+  (void) action;
+  XrdInputRingEvent ring_event;
+  ring_event.event.analog = *event;
+  g_free (event);
+  _input_thread_push (thread_action, &ring_event);
+}
+
+static gpointer
+_input_thread_run (gpointer _self)
+{
+  XrdClient *self = _self;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+
+  while (g_atomic_int_get (&priv->input_thread_running))
+    {
+      gint64 start = g_get_monotonic_time ();
+
+      if (!openvr_action_set_poll (priv->input_thread_actions))
+        g_printerr ("Error polling wm actions on the input thread\n");
+
+      if (g_atomic_int_get (&priv->input_thread_poll_synth) &&
+          !openvr_action_set_poll (priv->input_thread_synth_actions))
+        g_printerr ("Error polling synth actions on the input thread\n");
+
+      gint64 remaining = g_atomic_int_get (&priv->input_thread_poll_rate_us) -
+                         (g_get_monotonic_time () - start);
+      if (remaining > 0)
+        g_usleep ((gulong) remaining);
+    }
+
+  return NULL;
+}
+
+/* The action callbacks free their event, they get a copy of the ring's */
+static OpenVRPoseEvent *
+_copy_pose (XrdInputRingEvent *ring_event)
+{
+  OpenVRPoseEvent *event = g_malloc (sizeof (OpenVRPoseEvent));
+  *event = ring_event->event.pose;
+  return event;
+}
+
+static OpenVRDigitalEvent *
+_copy_digital (XrdInputRingEvent *ring_event)
+{
+  OpenVRDigitalEvent *event = g_malloc (sizeof (OpenVRDigitalEvent));
+  *event = ring_event->event.digital;
+  return event;
+}
+
+static OpenVRAnalogEvent *
+_copy_analog (XrdInputRingEvent *ring_event)
+{
+  OpenVRAnalogEvent *event = g_malloc (sizeof (OpenVRAnalogEvent));
+  *event = ring_event->event.analog;
+  return event;
+}
+
+static void
+_dispatch_input_event (XrdClient *self, XrdInputRingEvent *ring_event)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+
+  switch (ring_event->action)
+    {
+    case XRD_INPUT_TRACE_HAND_POSE:
+      _update_hand_pose (self, _copy_pose (ring_event), ring_event->time_us);
+      break;
+    case XRD_INPUT_TRACE_HAND_POSE_HAND_GRIP:
+      _action_hand_pose_hand_grip_cb (NULL, _copy_pose (ring_event), self);
+      break;
+    case XRD_INPUT_TRACE_GRAB_WINDOW:
+      _action_grab_cb (NULL, _copy_digital (ring_event), self);
+      break;
+    case XRD_INPUT_TRACE_RESET_ORIENTATION:
+      _action_reset_orientation_cb (NULL, _copy_digital (ring_event), self);
+      break;
+    case XRD_INPUT_TRACE_MENU:
+      _action_menu_cb (NULL, _copy_digital (ring_event), self);
+      break;
+    case XRD_INPUT_TRACE_SHOW_KEYBOARD:
+      _action_show_keyboard_cb (NULL, _copy_digital (ring_event), self);
+      break;
+    case XRD_INPUT_TRACE_PUSH_PULL_SCALE:
+      _action_push_pull_scale_cb (NULL, _copy_analog (ring_event), self);
+      break;
+    case XRD_INPUT_TRACE_PUSH_PULL:
+      _action_push_pull_cb (NULL, _copy_analog (ring_event), self);
+      break;
+    case XRD_INPUT_TRACE_LEFT_CLICK:
+    case XRD_INPUT_TRACE_RIGHT_CLICK:
+      xrd_input_synth_handle_event (priv->input_synth, ring_event->action,
+                                    _copy_digital (ring_event));
+      break;
+    case XRD_INPUT_TRACE_SCROLL:
+      xrd_input_synth_handle_event (priv->input_synth, ring_event->action,
+                                    _copy_analog (ring_event));
+      break;
+    default:
+      break;
+    }
+}
+
+/* Main loop: handle everything the input thread queued. The latest pose
+ * per controller and pose action is handled first, so buttons act on the
+ * current pointer, then buttons and analog events in order. */
+static gboolean
+_drain_input_ring_cb (gpointer _self)
+{
+  XrdClient *self = _self;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+
+  XrdInputRingEvent *events = priv->input_drain_buffer;
+
+  xrd_window_begin_transform_batch ();
+
+  guint n_poses = xrd_input_ring_take_poses (priv->input_ring, events,
+                                             INPUT_RING_CAPACITY);
+  for (guint i = 0; i < n_poses; i++)
+    _dispatch_input_event (self, &events[i]);
+
+  guint n_events = 0;
+  while (n_events < INPUT_RING_CAPACITY &&
+         xrd_input_ring_pop (priv->input_ring, &events[n_events]))
+    n_events++;
+
+  for (guint i = 0; i < n_events; i++)
+    _dispatch_input_event (self, &events[i]);
+
+  xrd_window_end_transform_batch ();
+
+  /* the thread may have refilled the ring meanwhile, come back */
+  if (n_events == INPUT_RING_CAPACITY)
+    g_source_set_ready_time (priv->input_drain_source, 0);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_input_drain_dispatch (GSource     *source,
+                       GSourceFunc  callback,
+                       gpointer     user_data)
+{
+  g_source_set_ready_time (source, -1);
+  return callback (user_data);
+}
+
+static GSourceFuncs input_drain_funcs = {
+  .dispatch = _input_drain_dispatch,
+};
+
+static void
+_connect_input_thread_action (XrdClient           *self,
+                              OpenVRActionSet     *action_set,
+                              OpenVRActionType     type,
+                              const gchar         *url,
+                              XrdInputTraceAction  action)
+{
+  GCallback callback;
+  switch (type)
+    {
+    case OPENVR_ACTION_POSE:
+      callback = (GCallback) _input_thread_pose_cb;
+      break;
+    case OPENVR_ACTION_ANALOG:
+      callback = (GCallback) _input_thread_analog_cb;
+      break;
+    default:
+      callback = (GCallback) _input_thread_digital_cb;
+      break;
+    }
+
+  XrdInputThreadAction *thread_action = _input_thread_action_new (self, action);
+  g_object_set_data_full (G_OBJECT (action_set), url, thread_action, g_free);
+  openvr_action_set_connect (action_set, type, url, callback, thread_action);
+}
+
+static void
+_start_input_thread (XrdClient *self)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->input_thread != NULL)
+    return;
+
+  priv->input_ring = xrd_input_ring_new (INPUT_RING_CAPACITY);
+  priv->input_drain_buffer =
+    g_malloc (sizeof (XrdInputRingEvent) * INPUT_RING_CAPACITY);
+
+  priv->input_drain_source = g_source_new (&input_drain_funcs,
+                                           sizeof (GSource));
+  g_source_set_priority (priv->input_drain_source, G_PRIORITY_HIGH);
+  g_source_set_callback (priv->input_drain_source,
+                         _drain_input_ring_cb, self, NULL);
+  g_source_attach (priv->input_drain_source, NULL);
+
+  /* Separate action sets, so the thread only reaches the ring callbacks */
+  priv->input_thread_actions = openvr_action_set_new_from_url ("/actions/wm");
+  OpenVRActionSet *wm = priv->input_thread_actions;
+  _connect_input_thread_action (self, wm, OPENVR_ACTION_POSE,
+                                "/actions/wm/in/hand_pose",
+                                XRD_INPUT_TRACE_HAND_POSE);
+  _connect_input_thread_action (self, wm, OPENVR_ACTION_POSE,
+                                "/actions/wm/in/hand_pose_hand_grip",
+                                XRD_INPUT_TRACE_HAND_POSE_HAND_GRIP);
+  _connect_input_thread_action (self, wm, OPENVR_ACTION_DIGITAL,
+                                "/actions/wm/in/grab_window",
+                                XRD_INPUT_TRACE_GRAB_WINDOW);
+  _connect_input_thread_action (self, wm, OPENVR_ACTION_DIGITAL,
+                                "/actions/wm/in/reset_orientation",
+                                XRD_INPUT_TRACE_RESET_ORIENTATION);
+  _connect_input_thread_action (self, wm, OPENVR_ACTION_DIGITAL,
+                                "/actions/wm/in/menu",
+                                XRD_INPUT_TRACE_MENU);
+  _connect_input_thread_action (self, wm, OPENVR_ACTION_ANALOG,
+                                "/actions/wm/in/push_pull_scale",
+                                XRD_INPUT_TRACE_PUSH_PULL_SCALE);
+  _connect_input_thread_action (self, wm, OPENVR_ACTION_ANALOG,
+                                "/actions/wm/in/push_pull",
+                                XRD_INPUT_TRACE_PUSH_PULL);
+  _connect_input_thread_action (self, wm, OPENVR_ACTION_DIGITAL,
+                                "/actions/wm/in/show_keyboard",
+                                XRD_INPUT_TRACE_SHOW_KEYBOARD);
+
+  priv->input_thread_synth_actions =
+    openvr_action_set_new_from_url ("/actions/mouse_synth");
+  OpenVRActionSet *synth = priv->input_thread_synth_actions;
+  _connect_input_thread_action (self, synth, OPENVR_ACTION_DIGITAL,
+                                "/actions/mouse_synth/in/left_click",
+                                XRD_INPUT_TRACE_LEFT_CLICK);
+  _connect_input_thread_action (self, synth, OPENVR_ACTION_DIGITAL,
+                                "/actions/mouse_synth/in/right_click",
+                                XRD_INPUT_TRACE_RIGHT_CLICK);
+  _connect_input_thread_action (self, synth, OPENVR_ACTION_ANALOG,
+                                "/actions/mouse_synth/in/scroll",
+                                XRD_INPUT_TRACE_SCROLL);
+
+  g_atomic_int_set (&priv->input_thread_running, 1);
+  priv->input_thread = g_thread_new ("xrd-input", _input_thread_run, self);
+}
+
+/* When the thread is stopped from the settings the client stays alive, so
+ * what the thread queued before it stopped is still handled. On finalize
+ * the queued events are discarded. */
+static void
+_stop_input_thread (XrdClient *self, gboolean dispatch_queued)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->input_thread == NULL)
+    return;
+
+  g_atomic_int_set (&priv->input_thread_running, 0);
+  g_thread_join (priv->input_thread);
+  priv->input_thread = NULL;
+
+  /* the ring holds at most INPUT_RING_CAPACITY, one drain takes it all */
+  if (dispatch_queued)
+    _drain_input_ring_cb (self);
+
+  g_source_destroy (priv->input_drain_source);
+  g_clear_pointer (&priv->input_drain_source, g_source_unref);
+  g_clear_object (&priv->input_thread_actions);
+  g_clear_object (&priv->input_thread_synth_actions);
+  g_clear_object (&priv->input_ring);
+  g_clear_pointer (&priv->input_drain_buffer, g_free);
+}
+
+static void
+_update_input_thread (GSettings *settings, gchar *key, gpointer _self)
+{
+  XrdClient *self = _self;
+  if (g_settings_get_boolean (settings, key))
+    _start_input_thread (self);
+  else
+    _stop_input_thread (self, TRUE);
+}
+
+static void
+_update_input_thread_poll_rate (GSettings *settings, gchar *key,
+                                gpointer _self)
+{
+  XrdClient *self = _self;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  g_atomic_int_set (&priv->input_thread_poll_rate_us,
+                    (gint) g_settings_get_uint (settings, key));
 }
 
 static void
@@ -1710,6 +2434,29 @@ _synth_click_cb (XrdInputSynth *synth,
   g_free (event);
 }
 
+static gboolean
+_synth_scroll_cb (XrdInputSynth  *synth,
+                  XrdScrollEvent *event,
+                  XrdClient      *self)
+{
+  (void) synth;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->selection_mode)
+    return TRUE;
+
+  XrdController *controller = _lookup_controller (self,
+                                                  event->controller_handle);
+  if (controller == NULL)
+    return TRUE;
+
+  XrdWindow *window = xrd_controller_get_hover_state (controller)->window;
+  if (window == NULL)
+    return TRUE;
+
+  event->window = window;
+  return xrd_client_emit_scroll (self, event);
+}
+
 static void
 _synth_move_cursor_cb (XrdInputSynth      *synth,
                        XrdMoveCursorEvent *event,
@@ -1726,6 +2473,15 @@ _synth_move_cursor_cb (XrdInputSynth      *synth,
   g_free (event);
 }
 
+/* Headless clients with an uploader render scene windows offscreen */
+static gboolean
+_uses_scene_windows (XrdClient *client)
+{
+  if (XRD_IS_HEADLESS_CLIENT (client))
+    return xrd_client_get_uploader (client) != NULL;
+  return XRD_IS_SCENE_CLIENT (client);
+}
+
 XrdWindow *
 xrd_client_window_new_from_meters (XrdClient  *client,
                                    const char *title,
@@ -1734,12 +2490,17 @@ xrd_client_window_new_from_meters (XrdClient  *client,
                                    float       ppm)
 {
   XrdWindow *window;
-  if (XRD_IS_SCENE_CLIENT (client))
+  if (_uses_scene_windows (client))
     {
       window = XRD_WINDOW (xrd_scene_window_new_from_meters (title, width,
                                                              height, ppm));
       xrd_scene_window_initialize (XRD_SCENE_WINDOW (window));
     }
+  else if (XRD_IS_HEADLESS_CLIENT (client))
+    {
+      window = XRD_WINDOW (xrd_headless_window_new_from_meters (title, width,
+                                                                height, ppm));
+    }
   else
     {
       window = XRD_WINDOW (xrd_overlay_window_new_from_meters (title, width,
@@ -1753,15 +2514,24 @@ xrd_client_window_new_from_data (XrdClient  *client,
                                  XrdWindowData *data)
 {
   XrdWindow *window;
-  if (XRD_IS_SCENE_CLIENT (client))
+  if (_uses_scene_windows (client))
     {
       window = XRD_WINDOW (xrd_scene_window_new_from_data (data));
       xrd_scene_window_initialize (XRD_SCENE_WINDOW (window));
     }
+  else if (XRD_IS_HEADLESS_CLIENT (client))
+    {
+      window = XRD_WINDOW (xrd_headless_window_new_from_data (data));
+    }
   else
     {
       window = XRD_WINDOW (xrd_overlay_window_new_from_data (data));
     }
+
+  /* The new window starts unflipped, showing the whole texture */
+  xrd_window_set_flip_y (window, data->flip_y);
+  xrd_window_set_uv_rect (window, &data->uv_rect);
+
   return window;
 }
 
@@ -1773,12 +2543,17 @@ xrd_client_window_new_from_pixels (XrdClient  *client,
                                    float       ppm)
 {
   XrdWindow *window;
-  if (XRD_IS_SCENE_CLIENT (client))
+  if (_uses_scene_windows (client))
     {
       window = XRD_WINDOW (xrd_scene_window_new_from_pixels (title, width,
                                                              height, ppm));
       xrd_scene_window_initialize (XRD_SCENE_WINDOW (window));
     }
+  else if (XRD_IS_HEADLESS_CLIENT (client))
+    {
+      window = XRD_WINDOW (xrd_headless_window_new_from_pixels (title, width,
+                                                                height, ppm));
+    }
   else
     {
       window = XRD_WINDOW (xrd_overlay_window_new_from_pixels (title, width,
@@ -1796,7 +2571,7 @@ xrd_client_window_new_from_native (XrdClient   *client,
                                    float        ppm)
 {
   XrdWindow *window;
-  if (XRD_IS_SCENE_CLIENT (client))
+  if (_uses_scene_windows (client))
     {
       window = XRD_WINDOW (xrd_scene_window_new_from_native (title, native,
                                                              width_pixels,
@@ -1804,6 +2579,13 @@ xrd_client_window_new_from_native (XrdClient   *client,
                                                              ppm));
       xrd_scene_window_initialize (XRD_SCENE_WINDOW (window));
     }
+  else if (XRD_IS_HEADLESS_CLIENT (client))
+    {
+      window = XRD_WINDOW (xrd_headless_window_new_from_native (title, native,
+                                                                width_pixels,
+                                                                height_pixels,
+                                                                ppm));
+    }
   else
     {
       window = XRD_WINDOW (xrd_overlay_window_new_from_native (title, native,
@@ -1894,7 +2676,7 @@ _device_activate_cb (OpenVRContext          *context,
 
   xrd_client_init_controller (self, controller);
 
-  if (g_hash_table_size (priv->controllers) == 1)
+  if (priv->input_synth && g_hash_table_size (priv->controllers) == 1)
     xrd_input_synth_hand_off_to_controller (priv->input_synth, handle);
 
   if (!priv->always_show_overlay_pointer && XRD_IS_OVERLAY_CLIENT (self))
@@ -1920,7 +2702,7 @@ _device_deactivate_cb (OpenVRContext          *context,
 
   g_hash_table_remove (priv->controllers, &handle);
 
-  if (xrd_input_synth_synthing_controller (priv->input_synth) == handle &&
+  if (_is_synth_controller (self, handle) &&
       g_hash_table_size (priv->controllers) > 0)
     {
       GList *controllers = g_hash_table_get_values (priv->controllers);
@@ -1971,6 +2753,42 @@ _update_show_overlay_pointer (GSettings *settings, gchar *key, gpointer _data)
   g_list_free (controllers);
 }
 
+static void
+_update_input_poll_adaptive (GSettings *settings, gchar *key, gpointer _data)
+{
+  XrdClient *self = _data;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  priv->poll_input_adaptive = g_settings_get_boolean (settings, key);
+  _note_input_activity (self);
+}
+
+static void
+_update_input_poll_idle (GSettings *settings, gchar *key, gpointer _data)
+{
+  (void) key;
+  XrdClient *self = _data;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  priv->poll_input_idle_rate_ms =
+    g_settings_get_uint (settings, "input-poll-idle-rate-ms");
+  priv->poll_input_idle_timeout_ms =
+    g_settings_get_uint (settings, "input-poll-idle-timeout-ms");
+}
+
+static void
+_update_pose_filter_enabled (GSettings *settings, gchar *key, gpointer _data)
+{
+  XrdClient *self = _data;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+
+  priv->pose_filter_enabled = g_settings_get_boolean (settings, key);
+
+  /* don't filter against poses from before the filter was disabled */
+  GList *controllers = g_hash_table_get_values (priv->controllers);
+  for (GList *l = controllers; l; l = l->next)
+    xrd_pose_filter_reset (xrd_controller_get_pose_filter (l->data));
+  g_list_free (controllers);
+}
+
 static void
 xrd_client_init (XrdClient *self)
 {
@@ -1992,6 +2810,18 @@ xrd_client_init (XrdClient *self)
   xrd_settings_connect_and_apply (G_CALLBACK (_update_show_overlay_pointer),
                                   "always-show-overlay-pointer", self);
 
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_pose_filter_enabled),
+                                  "pose-filter-enabled", self);
+  xrd_settings_connect_and_apply (G_CALLBACK (xrd_settings_update_double_val),
+                                  "pose-filter-min-cutoff",
+                                  &priv->pose_filter_settings.min_cutoff);
+  xrd_settings_connect_and_apply (G_CALLBACK (xrd_settings_update_double_val),
+                                  "pose-filter-beta",
+                                  &priv->pose_filter_settings.beta);
+  xrd_settings_connect_and_apply (G_CALLBACK (xrd_settings_update_double_val),
+                                  "pose-prediction-ms",
+                                  &priv->pose_filter_settings.prediction_ms);
+
 
   priv->poll_runtime_event_source_id = 0;
   priv->poll_input_source_id = 0;
@@ -2004,11 +2834,37 @@ xrd_client_init (XrdClient *self)
   priv->wm_actions = NULL;
   priv->cursor = NULL;
   priv->wm_control_container = NULL;
+  priv->input_trace = NULL;
+  priv->replay_trace = NULL;
+  priv->replay_batch_open = FALSE;
+  priv->input_thread = NULL;
+  priv->input_thread_running = 0;
+  priv->input_thread_poll_rate_us = 1000;
+  priv->input_thread_poll_synth = 0;
+  priv->input_thread_actions = NULL;
+  priv->input_thread_synth_actions = NULL;
+  priv->input_ring = NULL;
+  priv->input_drain_source = NULL;
+  priv->input_drain_buffer = NULL;
+  priv->poll_input_current_rate_ms = 0;
+  priv->last_input_activity = g_get_monotonic_time ();
+  priv->hmd_idle = FALSE;
+  priv->hmd_last_check = 0;
+  priv->hmd_last_motion = priv->last_input_activity;
+  graphene_matrix_init_identity (&priv->hmd_motion_anchor);
+
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_input_poll_adaptive),
+                                  "input-poll-adaptive", self);
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_input_poll_idle),
+                                  "input-poll-idle-rate-ms", self);
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_input_poll_idle),
+                                  "input-poll-idle-timeout-ms", self);
 
   priv->context = openvr_context_get_instance ();
   priv->manager = xrd_window_manager_new ();
 
   priv->last_poll_timestamp = g_get_monotonic_time ();
+  priv->last_poll_start = 0;
 
   g_signal_connect (priv->context, "device-activate-event",
                     (GCallback) _device_activate_cb, self);
@@ -2091,6 +2947,10 @@ xrd_client_post_openvr_init (XrdClient *self)
 
   xrd_settings_connect_and_apply (G_CALLBACK (_update_input_poll_rate),
                                   "input-poll-rate-ms", self);
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_input_thread_poll_rate),
+                                  "input-thread-poll-rate-us", self);
+  xrd_settings_connect_and_apply (G_CALLBACK (_update_input_thread),
+                                  "input-thread-enabled", self);
 
   priv->poll_runtime_event_source_id =
       g_timeout_add (20,
@@ -2102,8 +2962,229 @@ xrd_client_post_openvr_init (XrdClient *self)
                     (GCallback) _synth_click_cb, self);
   g_signal_connect (priv->input_synth, "move-cursor-event",
                     (GCallback) _synth_move_cursor_cb, self);
+  g_signal_connect (priv->input_synth, "scroll-event",
+                    (GCallback) _synth_scroll_cb, self);
+
+  if (priv->input_trace)
+    xrd_input_synth_set_input_trace (priv->input_synth, priv->input_trace);
 }
 
+/**
+ * xrd_client_set_input_trace:
+ * @self: The #XrdClient
+ * @trace: (nullable): The #XrdInputTrace to record into, %NULL to detach.
+ *
+ * Poses, actions and input polls are written into @trace while it is
+ * recording, see xrd_input_trace_start_recording().
+ * The trace stays attached across xrd_client_switch_mode().
+ */
+void
+xrd_client_set_input_trace (XrdClient     *self,
+                            XrdInputTrace *trace)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  g_clear_object (&priv->input_trace);
+  if (trace)
+    priv->input_trace = g_object_ref (trace);
+
+  if (priv->input_synth)
+    xrd_input_synth_set_input_trace (priv->input_synth, trace);
+}
+
+XrdInputTrace *
+xrd_client_get_input_trace (XrdClient *self)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  return priv->input_trace;
+}
+
+/* Replayed as fast as possible, the dispatch time says nothing about the
+ * pose, so the filter gets the recorded time. */
+static void
+_trace_hand_pose_cb (XrdInputTrace   *trace,
+                     OpenVRPoseEvent *event,
+                     XrdClient       *self)
+{
+  _update_hand_pose (self, event, xrd_input_trace_get_play_timestamp (trace));
+}
+
+/* Connected before the action callbacks, so like the live poll, the
+ * records of one poll only move each window once */
+static void
+_trace_record_cb (XrdInputTrace *trace,
+                  gpointer       event,
+                  XrdClient     *self)
+{
+  (void) trace;
+  (void) event;
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (priv->replay_batch_open)
+    return;
+
+  xrd_window_begin_transform_batch ();
+  priv->replay_batch_open = TRUE;
+}
+
+static void
+_end_replay_batch (XrdClient *self)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  if (!priv->replay_batch_open)
+    return;
+
+  xrd_window_end_transform_batch ();
+  priv->replay_batch_open = FALSE;
+}
+
+static void
+_trace_poll_cb (XrdInputTrace *trace,
+                XrdClient     *self)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+  _trace_record_cb (trace, NULL, self);
+  xrd_window_manager_poll_window_events (priv->manager);
+  _end_replay_batch (self);
+  priv->last_poll_timestamp = g_get_monotonic_time ();
+}
+
+static void
+_trace_finished_cb (XrdInputTrace *trace,
+                    XrdClient     *self)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+
+  _end_replay_batch (self);
+
+  g_signal_handlers_disconnect_by_data (trace, self);
+  if (priv->input_synth)
+    g_signal_handlers_disconnect_by_data (trace, priv->input_synth);
+  g_clear_object (&priv->replay_trace);
+
+  /* resume live input */
+  if (priv->wm_actions && priv->poll_input_source_id == 0)
+    _schedule_input_poll (self, priv->poll_input_rate_ms);
+}
+
+/**
+ * xrd_client_replay_input_trace:
+ * @self: The #XrdClient
+ * @trace: A recorded #XrdInputTrace.
+ * @realtime: %TRUE to replay with the recorded timing, %FALSE to replay
+ * as fast as the main loop allows.
+ *
+ * Feeds the recorded input through the same callbacks as live OpenVR
+ * actions. Live input polling is paused until the trace finished.
+ */
+void
+xrd_client_replay_input_trace (XrdClient     *self,
+                               XrdInputTrace *trace,
+                               gboolean       realtime)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+
+  if (priv->replay_trace)
+    {
+      xrd_input_trace_stop (priv->replay_trace);
+      _trace_finished_cb (priv->replay_trace, self);
+    }
+
+  if (priv->poll_input_source_id != 0)
+    {
+      g_source_remove (priv->poll_input_source_id);
+      priv->poll_input_source_id = 0;
+    }
+
+  priv->replay_trace = g_object_ref (trace);
+
+  /* The action callbacks ignore their first argument, so they can be
+   * connected to the trace directly. Only the hand pose needs the
+   * recorded time. */
+  g_signal_connect (trace, "pose-event", (GCallback) _trace_record_cb, self);
+  g_signal_connect (trace, "digital-event",
+                    (GCallback) _trace_record_cb, self);
+  g_signal_connect (trace, "analog-event",
+                    (GCallback) _trace_record_cb, self);
+  g_signal_connect (trace, "pose-event::hand-pose",
+                    (GCallback) _trace_hand_pose_cb, self);
+  g_signal_connect (trace, "pose-event::hand-pose-hand-grip",
+                    (GCallback) _action_hand_pose_hand_grip_cb, self);
+  g_signal_connect (trace, "digital-event::grab-window",
+                    (GCallback) _action_grab_cb, self);
+  g_signal_connect (trace, "digital-event::reset-orientation",
+                    (GCallback) _action_reset_orientation_cb, self);
+  g_signal_connect (trace, "digital-event::menu",
+                    (GCallback) _action_menu_cb, self);
+  g_signal_connect (trace, "digital-event::show-keyboard",
+                    (GCallback) _action_show_keyboard_cb, self);
+  g_signal_connect (trace, "analog-event::push-pull-scale",
+                    (GCallback) _action_push_pull_scale_cb, self);
+  g_signal_connect (trace, "analog-event::push-pull",
+                    (GCallback) _action_push_pull_cb, self);
+  g_signal_connect (trace, "poll-event",
+                    (GCallback) _trace_poll_cb, self);
+  g_signal_connect (trace, "finished-event",
+                    (GCallback) _trace_finished_cb, self);
+
+  if (priv->input_synth)
+    xrd_input_synth_replay_input_trace (priv->input_synth, trace);
+
+  xrd_input_trace_play (trace, realtime);
+}
+
+/* The runtime allocates device events like gxr does, but
+ * _device_activate_cb () is also called with events on the stack */
+static void
+_headless_device_activate_cb (XrdHeadlessRuntime     *runtime,
+                              OpenVRDeviceIndexEvent *event,
+                              XrdClient              *self)
+{
+  (void) runtime;
+  _device_activate_cb (NULL, event, self);
+  g_free (event);
+}
+
+static void
+_headless_device_deactivate_cb (XrdHeadlessRuntime     *runtime,
+                                OpenVRDeviceIndexEvent *event,
+                                XrdClient              *self)
+{
+  (void) runtime;
+  _device_deactivate_cb (NULL, event, self);
+  g_free (event);
+}
+
+/**
+ * xrd_client_connect_headless_runtime:
+ * @self: The #XrdClient
+ * @runtime: The #XrdHeadlessRuntime to take input from.
+ *
+ * Feeds the controllers, poses and window actions simulated by @runtime
+ * through the same callbacks as live OpenVR actions, in place of
+ * xrd_client_post_openvr_init(). No input is synthesized.
+ * Disconnect with g_signal_handlers_disconnect_by_data() on @runtime.
+ */
+void
+xrd_client_connect_headless_runtime (XrdClient          *self,
+                                     XrdHeadlessRuntime *runtime)
+{
+  XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+
+  g_signal_connect (runtime, "device-activate-event",
+                    (GCallback) _headless_device_activate_cb, self);
+  g_signal_connect (runtime, "device-deactivate-event",
+                    (GCallback) _headless_device_deactivate_cb, self);
+
+  /* The action callbacks ignore their first argument, like for traces */
+  g_signal_connect (runtime, "pose-event",
+                    (GCallback) _action_hand_pose_cb, self);
+  g_signal_connect (runtime, "digital-event::grab_window",
+                    (GCallback) _action_grab_cb, self);
+  g_signal_connect (runtime, "digital-event::reset_orientation",
+                    (GCallback) _action_reset_orientation_cb, self);
+
+  g_signal_connect (priv->manager, "no-hover-event",
+                    (GCallback) _manager_no_hover_cb, self);
+}
 
 gboolean
 xrd_client_is_hovering (XrdClient *self)
@@ -2236,10 +3317,17 @@ _get_new_window_data_list (XrdClient *self)
  * xrd_client_switch_mode() replaces each #XrdWindow with an appropriate new
  * one, preserving its transformation matrix, scaling, pinned status, etc.
  *
+ * The #GulkanClient used for uploads is kept alive across the switch, so the
+ * last submitted texture of each window is handed to its new #XrdWindow
+ * without a re-upload. Only the image layout is transitioned to the upload
+ * layout of the new mode.
+ *
  * The caller is responsible for reconnecting callbacks to #XrdClient signals.
  * The caller is responsible to not use references to any previous #XrdWindow.
  * Pointers to #XrdWindowData will remain valid, however
  * #XrdWindowData->xrd_window will point to a new #XrdWindow.
+ * The caller should keep using xrd_client_get_uploader() of the returned
+ * client for further uploads.
  *
  * Returns: A new #XrdClient of the opposite mode than the passed one.
  */
@@ -2247,6 +3335,13 @@ struct _XrdClient *
 xrd_client_switch_mode (XrdClient *self)
 {
   XrdClientPrivate *priv = xrd_client_get_instance_private (self);
+
+  if (XRD_IS_HEADLESS_CLIENT (self))
+    {
+      g_printerr ("Headless clients can not switch modes.\n");
+      return self;
+    }
+
   gboolean show_only_pinned = priv->pinned_only;
   gboolean ignore_input = priv->ignore_input;
 
@@ -2256,13 +3351,27 @@ xrd_client_switch_mode (XrdClient *self)
 
   XrdWindowManager *manager = xrd_client_get_manager (self);
 
+  GulkanClient *old_uploader = xrd_client_get_uploader (self);
+  VkImageLayout old_layout = xrd_client_get_upload_layout (self);
+
+  XrdInputTrace *input_trace = NULL;
+  if (priv->input_trace)
+    input_trace = g_object_ref (priv->input_trace);
+
+  /* Keep the Vulkan device, and thus all window textures, alive. */
+  xrd_scene_renderer_hold_instance ();
+
   /* this list preserves the order in which windows were added */
   GSList *window_data_list = _get_new_window_data_list (self);
+
+  /* Steal the textures from the window data, so the new windows do not
+   * consider them already submitted. */
+  GSList *textures = NULL;
   for (GSList *l = window_data_list; l; l = l->next)
     {
       XrdWindowData *window_data = l->data;
-      if (window_data->texture)
-         g_clear_object (&window_data->texture);
+      textures = g_slist_append (textures, window_data->texture);
+      window_data->texture = NULL;
       xrd_client_remove_window (self, window_data->xrd_window);
       g_clear_object (&window_data->xrd_window);
     }
@@ -2272,23 +3381,55 @@ xrd_client_switch_mode (XrdClient *self)
   priv = xrd_client_get_instance_private (ret);
   priv->window_mapping = window_mapping;
 
-  for (GSList *l = window_data_list; l; l = l->next)
+  GulkanClient *uploader = xrd_client_get_uploader (ret);
+  VkImageLayout layout = xrd_client_get_upload_layout (ret);
+  gboolean keep_textures = uploader == old_uploader;
+  if (!keep_textures)
+    g_printerr ("Uploader changed during mode switch, "
+                "window textures need to be uploaded again.\n");
+
+  GSList *t = textures;
+  for (GSList *l = window_data_list; l; l = l->next, t = t->next)
     {
       XrdWindowData *window_data = l->data;
+      GulkanTexture *texture = t->data;
+
       XrdWindow *window = xrd_client_window_new_from_data (ret, window_data);
       window_data->xrd_window = window;
       gboolean draggable = window_data->parent_window == NULL;
 
       xrd_client_add_window (ret, window, draggable, NULL);
+
+      if (texture == NULL)
+        continue;
+
+      if (keep_textures)
+        {
+          if (old_layout != layout)
+            gulkan_client_transfer_layout (uploader, texture,
+                                           old_layout, layout);
+          xrd_window_submit_texture (window, uploader, texture);
+        }
+
+      g_object_unref (texture);
     }
+  g_slist_free (textures);
   g_slist_free (window_data_list);
 
+  xrd_scene_renderer_release_instance ();
+
   xrd_client_show_pinned_only (ret, show_only_pinned);
 
   priv->ignore_input = ignore_input;
   xrd_window_manager_set_hover_mode (manager, ignore_input ?
                                          XRD_HOVER_MODE_BUTTONS :
                                          XRD_HOVER_MODE_EVERYTHING);
+
+  if (input_trace)
+    {
+      xrd_client_set_input_trace (ret, input_trace);
+      g_object_unref (input_trace);
+    }
+
   return ret;
 }
-
@@ -19,10 +19,12 @@
 
 #include "xrd-window.h"
 #include "xrd-input-synth.h"
+#include "xrd-input-trace.h"
 #include "xrd-window-manager.h"
 #include "xrd-desktop-cursor.h"
 #include "xrd-pointer.h"
 #include "xrd-pointer-tip.h"
+#include "xrd-headless-runtime.h"
 
 G_BEGIN_DECLS
 
@@ -149,6 +151,10 @@ void
 xrd_client_emit_move_cursor (XrdClient *self,
                              XrdMoveCursorEvent *event);
 
+gboolean
+xrd_client_emit_scroll (XrdClient *self,
+                        XrdScrollEvent *event);
+
 void
 xrd_client_emit_system_quit (XrdClient *self,
                              OpenVRQuitEvent *event);
@@ -269,6 +275,22 @@ xrd_client_get_windows (XrdClient *self);
 struct _XrdClient *
 xrd_client_switch_mode (XrdClient *self);
 
+void
+xrd_client_set_input_trace (XrdClient     *self,
+                            XrdInputTrace *trace);
+
+XrdInputTrace *
+xrd_client_get_input_trace (XrdClient *self);
+
+void
+xrd_client_replay_input_trace (XrdClient     *self,
+                               XrdInputTrace *trace,
+                               gboolean       realtime);
+
+void
+xrd_client_connect_headless_runtime (XrdClient          *self,
+                                     XrdHeadlessRuntime *runtime);
+
 G_END_DECLS
 
 #endif /* XRD_CLIENT_H_ */
@@ -7,6 +7,8 @@
 
 #include "xrd-controller.h"
 
+#include "xrd-math.h"
+
 struct _XrdController
 {
   GObject parent;
@@ -18,6 +20,12 @@ struct _XrdController
   XrdGrabState grab_state;
 
   graphene_matrix_t pose_hand_grip;
+
+  XrdPoseFilter *pose_filter;
+
+  /* pose at the last xrd_controller_moved () that returned TRUE */
+  gboolean has_motion_anchor;
+  graphene_matrix_t motion_anchor;
 };
 
 G_DEFINE_TYPE (XrdController, xrd_controller, G_TYPE_OBJECT)
@@ -40,6 +48,8 @@ xrd_controller_init (XrdController *self)
   self->hover_state.window = NULL;
   self->grab_state.window = NULL;
   self->grab_state.transform_lock = XRD_TRANSFORM_LOCK_NONE;
+  self->pose_filter = xrd_pose_filter_new ();
+  self->has_motion_anchor = FALSE;
 }
 
 XrdController *
@@ -55,9 +65,10 @@ static void
 xrd_controller_finalize (GObject *gobject)
 {
   XrdController *self = XRD_CONTROLLER (gobject);
-  g_object_unref (self->pointer_ray);
-  g_object_unref (self->pointer_tip);
-  (void) self;
+  g_clear_object (&self->pointer_ray);
+  g_clear_object (&self->pointer_tip);
+  g_clear_object (&self->pose_filter);
+  G_OBJECT_CLASS (xrd_controller_parent_class)->finalize (gobject);
 }
 
 XrdPointer *
@@ -136,3 +147,35 @@ xrd_controller_get_pose_hand_grip (XrdController *self,
   graphene_matrix_init_from_matrix (pose, &self->pose_hand_grip);
 }
 
+XrdPoseFilter *
+xrd_controller_get_pose_filter (XrdController *self)
+{
+  return self->pose_filter;
+}
+
+/**
+ * xrd_controller_moved:
+ * @self: The #XrdController
+ * @pose: The current pose of the controller.
+ * @threshold: Distance in meters, see xrd_math_pose_distance().
+ *
+ * Tells slow drifting and jitter apart from intentional movement by
+ * comparing @pose to the pose of the last detected movement.
+ *
+ * Returns: %TRUE if the controller moved more than @threshold since the last
+ * time this function returned %TRUE.
+ */
+gboolean
+xrd_controller_moved (XrdController           *self,
+                      const graphene_matrix_t *pose,
+                      float                    threshold)
+{
+  if (self->has_motion_anchor &&
+      xrd_math_pose_distance (&self->motion_anchor, pose) < threshold)
+    return FALSE;
+
+  graphene_matrix_init_from_matrix (&self->motion_anchor, pose);
+  self->has_motion_anchor = TRUE;
+  return TRUE;
+}
+
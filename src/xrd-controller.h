@@ -13,6 +13,7 @@
 #include "xrd-window.h"
 #include "xrd-pointer.h"
 #include "xrd-pointer-tip.h"
+#include "xrd-pose-filter.h"
 
 G_BEGIN_DECLS
 
@@ -92,6 +93,14 @@ void
 xrd_controller_get_pose_hand_grip (XrdController *self,
                                    graphene_matrix_t *pose);
 
+XrdPoseFilter *
+xrd_controller_get_pose_filter (XrdController *self);
+
+gboolean
+xrd_controller_moved (XrdController           *self,
+                      const graphene_matrix_t *pose,
+                      float                    threshold);
+
 G_END_DECLS
 
 #endif /* XRD_CONTROLLER_H_ */
@@ -0,0 +1,431 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Lubosz Sarnecki <lubosz.sarnecki@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-icon-atlas.h"
+
+#include <math.h>
+#include <string.h>
+#include <gdk/gdk.h>
+
+/* Bump this when the tile rendering changes, so stale caches are ignored. */
+#define XRD_ICON_ATLAS_CACHE_VERSION 2
+#define XRD_ICON_ATLAS_CACHE_MAGIC 0x41444958 /* "XIDA" */
+
+/* Length of a hex SHA1 digest */
+#define CHECKSUM_LENGTH 40
+
+typedef struct {
+  guint32 magic;
+  guint32 version;
+  guint32 width;
+  guint32 height;
+  guint32 stride;
+  gchar checksum[CHECKSUM_LENGTH];
+} XrdIconAtlasCacheHeader;
+
+struct _XrdIconAtlas
+{
+  GObject parent;
+
+  GulkanTexture *texture;
+  uint32_t width;
+  uint32_t height;
+  uint32_t tile_size;
+  uint32_t columns;
+
+  /* resource url -> tile index + 1 */
+  GHashTable *tiles;
+};
+
+G_DEFINE_TYPE (XrdIconAtlas, xrd_icon_atlas, G_TYPE_OBJECT)
+
+static void
+xrd_icon_atlas_finalize (GObject *gobject);
+
+static void
+xrd_icon_atlas_class_init (XrdIconAtlasClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = xrd_icon_atlas_finalize;
+}
+
+static void
+xrd_icon_atlas_init (XrdIconAtlas *self)
+{
+  self->texture = NULL;
+  self->width = 0;
+  self->height = 0;
+  self->tile_size = 0;
+  self->columns = 0;
+  self->tiles = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+}
+
+static gint
+_compare_names (gconstpointer a, gconstpointer b)
+{
+  return g_strcmp0 (*(const gchar **) a, *(const gchar **) b);
+}
+
+/* Returns a sorted, NULL terminated list of full resource urls. */
+static gchar **
+_list_icons (const gchar *resource_path)
+{
+  GError *error = NULL;
+  gchar **names = g_resources_enumerate_children (resource_path,
+                                                  G_RESOURCE_LOOKUP_FLAGS_NONE,
+                                                  &error);
+  if (error != NULL)
+    {
+      g_printerr ("Unable to list icons in %s: %s\n",
+                  resource_path, error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  guint count = g_strv_length (names);
+  qsort (names, count, sizeof (gchar *), _compare_names);
+
+  gchar **urls = g_new0 (gchar *, count + 1);
+  for (guint i = 0; i < count; i++)
+    urls[i] = g_build_path ("/", resource_path, names[i], NULL);
+
+  g_strfreev (names);
+  return urls;
+}
+
+/* Covers the icon names and their content, the tile size is in the path. */
+static gchar *
+_get_checksum (gchar **urls)
+{
+  GChecksum *checksum = g_checksum_new (G_CHECKSUM_SHA1);
+
+  for (guint i = 0; urls[i] != NULL; i++)
+    {
+      GBytes *bytes = g_resources_lookup_data (urls[i],
+                                               G_RESOURCE_LOOKUP_FLAGS_NONE,
+                                               NULL);
+      g_checksum_update (checksum, (const guchar *) urls[i], -1);
+      if (bytes != NULL)
+        {
+          gsize size;
+          const guchar *data = g_bytes_get_data (bytes, &size);
+          g_checksum_update (checksum, data, (gssize) size);
+          g_bytes_unref (bytes);
+        }
+    }
+
+  gchar *ret = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+  return ret;
+}
+
+/*
+ * One file per tile size, a changed icon set overwrites it instead of
+ * leaving the old one behind.
+ */
+static gchar *
+_get_cache_path (uint32_t tile_size)
+{
+  gchar *file_name = g_strdup_printf ("icons-%u.argb", tile_size);
+  gchar *path = g_build_filename (g_get_user_cache_dir (), "xrdesktop",
+                                  file_name, NULL);
+  g_free (file_name);
+  return path;
+}
+
+/* Loads the premultiplied Cairo pixels straight into a new surface. */
+static cairo_surface_t *
+_load_cache (const gchar *path,
+             const gchar *checksum,
+             uint32_t     width,
+             uint32_t     height)
+{
+  gchar *contents;
+  gsize length;
+  if (!g_file_get_contents (path, &contents, &length, NULL))
+    return NULL;
+
+  int stride = cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, (int) width);
+  gsize pixel_size = (gsize) stride * height;
+
+  XrdIconAtlasCacheHeader header;
+  if (length != sizeof (header) + pixel_size)
+    {
+      g_free (contents);
+      return NULL;
+    }
+
+  memcpy (&header, contents, sizeof (header));
+  if (header.magic != XRD_ICON_ATLAS_CACHE_MAGIC ||
+      header.version != XRD_ICON_ATLAS_CACHE_VERSION ||
+      header.width != width || header.height != height ||
+      header.stride != (guint32) stride ||
+      memcmp (header.checksum, checksum, CHECKSUM_LENGTH) != 0)
+    {
+      g_free (contents);
+      return NULL;
+    }
+
+  cairo_surface_t *surface =
+    cairo_image_surface_create (CAIRO_FORMAT_ARGB32, (int) width, (int) height);
+  if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS ||
+      cairo_image_surface_get_stride (surface) != stride)
+    {
+      cairo_surface_destroy (surface);
+      g_free (contents);
+      return NULL;
+    }
+
+  cairo_surface_flush (surface);
+  memcpy (cairo_image_surface_get_data (surface),
+          contents + sizeof (header), pixel_size);
+  cairo_surface_mark_dirty (surface);
+
+  g_free (contents);
+  return surface;
+}
+
+static void
+_store_cache (const gchar     *path,
+              const gchar     *checksum,
+              cairo_surface_t *surface)
+{
+  cairo_surface_flush (surface);
+
+  uint32_t height = (uint32_t) cairo_image_surface_get_height (surface);
+  int stride = cairo_image_surface_get_stride (surface);
+
+  XrdIconAtlasCacheHeader header = {
+    .magic = XRD_ICON_ATLAS_CACHE_MAGIC,
+    .version = XRD_ICON_ATLAS_CACHE_VERSION,
+    .width = (guint32) cairo_image_surface_get_width (surface),
+    .height = height,
+    .stride = (guint32) stride
+  };
+  memcpy (header.checksum, checksum, CHECKSUM_LENGTH);
+
+  gsize pixel_size = (gsize) stride * height;
+  gsize length = sizeof (header) + pixel_size;
+  guchar *contents = g_malloc (length);
+  memcpy (contents, &header, sizeof (header));
+  memcpy (contents + sizeof (header),
+          cairo_image_surface_get_data (surface), pixel_size);
+
+  gchar *dir = g_path_get_dirname (path);
+  g_mkdir_with_parents (dir, 0755);
+  g_free (dir);
+
+  GError *error = NULL;
+  if (!g_file_set_contents (path, (const gchar *) contents,
+                            (gssize) length, &error))
+    {
+      g_printerr ("Unable to write icon atlas cache: %s\n", error->message);
+      g_error_free (error);
+    }
+
+  g_free (contents);
+}
+
+static cairo_surface_t *
+_render (gchar              **urls,
+         uint32_t             columns,
+         uint32_t             width,
+         uint32_t             height,
+         uint32_t             tile_size,
+         XrdIconAtlasDrawFunc draw_tile)
+{
+  cairo_surface_t *surface =
+    cairo_image_surface_create (CAIRO_FORMAT_ARGB32, (int) width, (int) height);
+  if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+    {
+      cairo_surface_destroy (surface);
+      return NULL;
+    }
+
+  cairo_t *cr = cairo_create (surface);
+  cairo_set_source_rgba (cr, 0, 0, 0, 0);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+
+  for (uint32_t i = 0; urls[i] != NULL; i++)
+    {
+      GError *error = NULL;
+      GdkPixbuf *icon = gdk_pixbuf_new_from_resource (urls[i], &error);
+      if (error != NULL)
+        {
+          g_printerr ("Unable to read file: %s\n", error->message);
+          g_error_free (error);
+          continue;
+        }
+
+      cairo_save (cr);
+      cairo_translate (cr, (i % columns) * tile_size, (i / columns) * tile_size);
+      cairo_rectangle (cr, 0, 0, tile_size, tile_size);
+      cairo_clip (cr);
+      draw_tile (cr, icon, tile_size);
+      cairo_restore (cr);
+
+      g_object_unref (icon);
+    }
+
+  cairo_destroy (cr);
+
+  return surface;
+}
+
+/**
+ * xrd_icon_atlas_new:
+ * @client: The #GulkanClient used for the upload.
+ * @upload_layout: The #VkImageLayout the texture will be in after the upload.
+ * @resource_path: The resource directory containing the icons, e.g. "/icons".
+ * @tile_size: Width and height of one icon tile in pixels.
+ * @draw_tile: The function rasterizing an icon into its tile.
+ *
+ * Packs all icons found in @resource_path into a single texture, which
+ * windows share by showing the region from xrd_icon_atlas_get_uv_rect().
+ * The rasterized atlas is cached in the user cache directory, so the icons
+ * only need to be drawn again when the icon set changes.
+ *
+ * Returns: A new #XrdIconAtlas or %NULL on failure.
+ */
+XrdIconAtlas *
+xrd_icon_atlas_new (GulkanClient         *client,
+                    VkImageLayout         upload_layout,
+                    const gchar          *resource_path,
+                    uint32_t              tile_size,
+                    XrdIconAtlasDrawFunc  draw_tile)
+{
+  if (tile_size == 0)
+    return NULL;
+
+  gchar **urls = _list_icons (resource_path);
+  if (urls == NULL)
+    return NULL;
+
+  guint count = g_strv_length (urls);
+  if (count == 0)
+    {
+      g_strfreev (urls);
+      return NULL;
+    }
+
+  XrdIconAtlas *self = (XrdIconAtlas*) g_object_new (XRD_TYPE_ICON_ATLAS, 0);
+  self->tile_size = tile_size;
+  self->columns = (uint32_t) ceil (sqrt ((double) count));
+  uint32_t rows = (count + self->columns - 1) / self->columns;
+
+  self->width = self->columns * tile_size;
+  self->height = rows * tile_size;
+
+  for (guint i = 0; i < count; i++)
+    g_hash_table_insert (self->tiles, g_strdup (urls[i]),
+                         GUINT_TO_POINTER (i + 1));
+
+  gchar *checksum = _get_checksum (urls);
+  gchar *cache_path = _get_cache_path (tile_size);
+
+  cairo_surface_t *surface = _load_cache (cache_path, checksum,
+                                          self->width, self->height);
+  if (surface == NULL)
+    {
+      surface = _render (urls, self->columns, self->width, self->height,
+                         tile_size, draw_tile);
+      if (surface != NULL)
+        _store_cache (cache_path, checksum, surface);
+    }
+
+  g_free (cache_path);
+  g_free (checksum);
+  g_strfreev (urls);
+
+  if (surface == NULL)
+    {
+      g_printerr ("Could not create icon atlas surface.\n");
+      g_object_unref (self);
+      return NULL;
+    }
+
+  /* Same upload as the per button Cairo surfaces, premultiplied alpha */
+  self->texture =
+    gulkan_client_texture_new_from_cairo_surface (client,
+                                                  surface,
+                                                  VK_FORMAT_R8G8B8A8_UNORM,
+                                                  upload_layout);
+  cairo_surface_destroy (surface);
+
+  if (self->texture == NULL)
+    {
+      g_printerr ("Could not create texture from icon atlas.\n");
+      g_object_unref (self);
+      return NULL;
+    }
+
+  return self;
+}
+
+uint32_t
+xrd_icon_atlas_get_tile_size (XrdIconAtlas *self)
+{
+  return self->tile_size;
+}
+
+/**
+ * xrd_icon_atlas_get_texture:
+ * @self: The #XrdIconAtlas
+ *
+ * Returns: (transfer none): The texture holding all icons.
+ */
+GulkanTexture *
+xrd_icon_atlas_get_texture (XrdIconAtlas *self)
+{
+  return self->texture;
+}
+
+/**
+ * xrd_icon_atlas_get_uv_rect:
+ * @self: The #XrdIconAtlas
+ * @url: The resource url of the icon.
+ * @rect: (out): The normalized texture coordinates of the icon's tile.
+ *
+ * The rect is inset by half a texel, so linear filtering does not pick up
+ * the neighbouring tiles.
+ *
+ * Returns: %TRUE if the icon is part of the atlas.
+ */
+gboolean
+xrd_icon_atlas_get_uv_rect (XrdIconAtlas    *self,
+                            const gchar     *url,
+                            graphene_rect_t *rect)
+{
+  guint index = GPOINTER_TO_UINT (g_hash_table_lookup (self->tiles, url));
+  if (index == 0)
+    return FALSE;
+
+  index--;
+  uint32_t x = (index % self->columns) * self->tile_size;
+  uint32_t y = (index / self->columns) * self->tile_size;
+
+  float width = (float) self->width;
+  float height = (float) self->height;
+
+  graphene_rect_init (rect,
+                      ((float) x + 0.5f) / width,
+                      ((float) y + 0.5f) / height,
+                      ((float) self->tile_size - 1.0f) / width,
+                      ((float) self->tile_size - 1.0f) / height);
+  return TRUE;
+}
+
+static void
+xrd_icon_atlas_finalize (GObject *gobject)
+{
+  XrdIconAtlas *self = XRD_ICON_ATLAS (gobject);
+  g_clear_object (&self->texture);
+  g_hash_table_unref (self->tiles);
+  G_OBJECT_CLASS (xrd_icon_atlas_parent_class)->finalize (gobject);
+}
@@ -0,0 +1,58 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Lubosz Sarnecki <lubosz.sarnecki@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_ICON_ATLAS_H_
+#define XRD_ICON_ATLAS_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <graphene.h>
+#include <cairo.h>
+#include <gulkan.h>
+
+G_BEGIN_DECLS
+
+#define XRD_TYPE_ICON_ATLAS xrd_icon_atlas_get_type()
+G_DECLARE_FINAL_TYPE (XrdIconAtlas, xrd_icon_atlas, XRD, ICON_ATLAS, GObject)
+
+/**
+ * XrdIconAtlasDrawFunc:
+ * @cr: A cairo context, translated and clipped to the tile.
+ * @icon: The icon loaded from the resource.
+ * @tile_size: The width and height of the tile in pixels.
+ *
+ * Rasterizes a single icon into its atlas tile.
+ */
+typedef void (*XrdIconAtlasDrawFunc) (cairo_t   *cr,
+                                      GdkPixbuf *icon,
+                                      uint32_t   tile_size);
+
+XrdIconAtlas *
+xrd_icon_atlas_new (GulkanClient         *client,
+                    VkImageLayout         upload_layout,
+                    const gchar          *resource_path,
+                    uint32_t              tile_size,
+                    XrdIconAtlasDrawFunc  draw_tile);
+
+uint32_t
+xrd_icon_atlas_get_tile_size (XrdIconAtlas *self);
+
+GulkanTexture *
+xrd_icon_atlas_get_texture (XrdIconAtlas *self);
+
+gboolean
+xrd_icon_atlas_get_uv_rect (XrdIconAtlas    *self,
+                            const gchar     *url,
+                            graphene_rect_t *rect);
+
+G_END_DECLS
+
+#endif /* XRD_ICON_ATLAS_H_ */
@@ -0,0 +1,236 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-input-mask.h"
+
+#include <string.h>
+
+struct _XrdInputMask
+{
+  GObject parent;
+
+  uint32_t width;
+  uint32_t height;
+
+  /* One bit per cell, rows padded to whole words. */
+  uint32_t stride;
+  guint32 *bits;
+};
+
+G_DEFINE_TYPE (XrdInputMask, xrd_input_mask, G_TYPE_OBJECT)
+
+static void
+xrd_input_mask_finalize (GObject *gobject);
+
+static void
+xrd_input_mask_class_init (XrdInputMaskClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = xrd_input_mask_finalize;
+}
+
+static void
+xrd_input_mask_init (XrdInputMask *self)
+{
+  self->width = 0;
+  self->height = 0;
+  self->stride = 0;
+  self->bits = NULL;
+}
+
+/**
+ * xrd_input_mask_new:
+ * @width: The number of cells per row.
+ * @height: The number of rows.
+ *
+ * Creates a mask in which every cell receives input.
+ *
+ * Returns: A new #XrdInputMask.
+ */
+XrdInputMask *
+xrd_input_mask_new (uint32_t width, uint32_t height)
+{
+  XrdInputMask *self =
+    (XrdInputMask*) g_object_new (XRD_TYPE_INPUT_MASK, 0);
+
+  self->width = MAX (width, 1);
+  self->height = MAX (height, 1);
+  self->stride = (self->width + 31) / 32;
+
+  guint words = self->stride * self->height;
+  self->bits = g_malloc (sizeof (guint32) * words);
+  memset (self->bits, 0xff, sizeof (guint32) * words);
+
+  return self;
+}
+
+static gboolean
+_is_block_solid (const guchar *pixels,
+                 int           rowstride,
+                 uint32_t      x0,
+                 uint32_t      y0,
+                 uint32_t      x1,
+                 uint32_t      y1,
+                 guint8        alpha_threshold)
+{
+  for (uint32_t y = y0; y < y1; y++)
+    {
+      const guchar *row = pixels + y * (gsize) rowstride;
+      for (uint32_t x = x0; x < x1; x++)
+        if (row[x * 4 + 3] > alpha_threshold)
+          return TRUE;
+    }
+  return FALSE;
+}
+
+/**
+ * xrd_input_mask_new_from_pixbuf:
+ * @pixbuf: A RGBA #GdkPixbuf with the window contents.
+ * @max_cells: The number of cells along the longer side of the pixbuf.
+ * @alpha_threshold: Pixels with an alpha at or below this do not take input.
+ *
+ * Downsamples the alpha channel of @pixbuf into a bit mask. A cell is
+ * solid when any pixel it covers is above @alpha_threshold, so the mask
+ * never cuts away visible content.
+ *
+ * Returns: A new #XrdInputMask, or %NULL if @pixbuf has no alpha channel.
+ */
+XrdInputMask *
+xrd_input_mask_new_from_pixbuf (GdkPixbuf *pixbuf,
+                                uint32_t   max_cells,
+                                guint8     alpha_threshold)
+{
+  if (!gdk_pixbuf_get_has_alpha (pixbuf)
+      || gdk_pixbuf_get_n_channels (pixbuf) != 4
+      || gdk_pixbuf_get_bits_per_sample (pixbuf) != 8)
+    return NULL;
+
+  uint32_t pixel_width = (uint32_t) gdk_pixbuf_get_width (pixbuf);
+  uint32_t pixel_height = (uint32_t) gdk_pixbuf_get_height (pixbuf);
+  if (pixel_width == 0 || pixel_height == 0)
+    return NULL;
+
+  uint32_t longer = MAX (pixel_width, pixel_height);
+  max_cells = MAX (max_cells, 1);
+
+  uint32_t width = pixel_width;
+  uint32_t height = pixel_height;
+  if (longer > max_cells)
+    {
+      width = (uint32_t) (((guint64) pixel_width * max_cells
+                           + longer - 1) / longer);
+      height = (uint32_t) (((guint64) pixel_height * max_cells
+                            + longer - 1) / longer);
+    }
+
+  XrdInputMask *self = xrd_input_mask_new (width, height);
+
+  const guchar *pixels = gdk_pixbuf_read_pixels (pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+  for (uint32_t y = 0; y < self->height; y++)
+    {
+      uint32_t y0 = (uint32_t) ((guint64) y * pixel_height / self->height);
+      uint32_t y1 =
+        (uint32_t) ((guint64) (y + 1) * pixel_height / self->height);
+      for (uint32_t x = 0; x < self->width; x++)
+        {
+          uint32_t x0 = (uint32_t) ((guint64) x * pixel_width / self->width);
+          uint32_t x1 =
+            (uint32_t) ((guint64) (x + 1) * pixel_width / self->width);
+          if (!_is_block_solid (pixels, rowstride, x0, y0, x1, y1,
+                                alpha_threshold))
+            xrd_input_mask_set (self, x, y, FALSE);
+        }
+    }
+
+  return self;
+}
+
+static void
+xrd_input_mask_finalize (GObject *gobject)
+{
+  XrdInputMask *self = XRD_INPUT_MASK (gobject);
+  g_free (self->bits);
+  G_OBJECT_CLASS (xrd_input_mask_parent_class)->finalize (gobject);
+}
+
+uint32_t
+xrd_input_mask_get_width (XrdInputMask *self)
+{
+  return self->width;
+}
+
+uint32_t
+xrd_input_mask_get_height (XrdInputMask *self)
+{
+  return self->height;
+}
+
+/**
+ * xrd_input_mask_set:
+ * @self: The #XrdInputMask
+ * @x: The cell column.
+ * @y: The cell row, 0 is the top row.
+ * @solid: Whether the cell receives input.
+ */
+void
+xrd_input_mask_set (XrdInputMask *self,
+                    uint32_t      x,
+                    uint32_t      y,
+                    gboolean      solid)
+{
+  g_return_if_fail (x < self->width && y < self->height);
+
+  guint32 *word = &self->bits[y * self->stride + x / 32];
+  guint32 bit = 1u << (x % 32);
+  if (solid)
+    *word |= bit;
+  else
+    *word &= ~bit;
+}
+
+/**
+ * xrd_input_mask_get:
+ * @self: The #XrdInputMask
+ * @x: The cell column.
+ * @y: The cell row, 0 is the top row.
+ *
+ * Returns: Whether the cell receives input.
+ */
+gboolean
+xrd_input_mask_get (XrdInputMask *self,
+                    uint32_t      x,
+                    uint32_t      y)
+{
+  if (x >= self->width || y >= self->height)
+    return FALSE;
+
+  return (self->bits[y * self->stride + x / 32] >> (x % 32)) & 1u;
+}
+
+/**
+ * xrd_input_mask_test:
+ * @self: The #XrdInputMask
+ * @u: The horizontal position in [0, 1], left to right.
+ * @v: The vertical position in [0, 1], top to bottom.
+ *
+ * Returns: Whether the cell under the normalized position receives input.
+ */
+gboolean
+xrd_input_mask_test (XrdInputMask *self,
+                     float         u,
+                     float         v)
+{
+  if (u < 0.0f || u > 1.0f || v < 0.0f || v > 1.0f)
+    return FALSE;
+
+  uint32_t x = MIN ((uint32_t) (u * (float) self->width), self->width - 1);
+  uint32_t y = MIN ((uint32_t) (v * (float) self->height), self->height - 1);
+
+  return xrd_input_mask_get (self, x, y);
+}
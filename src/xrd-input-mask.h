@@ -0,0 +1,72 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_INPUT_MASK_H_
+#define XRD_INPUT_MASK_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+/**
+ * XRD_INPUT_MASK_DEFAULT_CELLS:
+ *
+ * The number of cells along the longer side of a mask that is built from a
+ * pixbuf with xrd_window_set_input_mask_from_pixbuf(). 64x64 cells are 512
+ * bytes.
+ */
+#define XRD_INPUT_MASK_DEFAULT_CELLS 64
+
+/**
+ * XRD_INPUT_MASK_DEFAULT_ALPHA_THRESHOLD:
+ *
+ * Pixels with an alpha value at or below this threshold do not receive
+ * input. Drop shadows are usually faint enough to fall below it.
+ */
+#define XRD_INPUT_MASK_DEFAULT_ALPHA_THRESHOLD 32
+
+#define XRD_TYPE_INPUT_MASK xrd_input_mask_get_type()
+G_DECLARE_FINAL_TYPE (XrdInputMask, xrd_input_mask, XRD, INPUT_MASK, GObject)
+
+XrdInputMask *
+xrd_input_mask_new (uint32_t width, uint32_t height);
+
+XrdInputMask *
+xrd_input_mask_new_from_pixbuf (GdkPixbuf *pixbuf,
+                                uint32_t   max_cells,
+                                guint8     alpha_threshold);
+
+uint32_t
+xrd_input_mask_get_width (XrdInputMask *self);
+
+uint32_t
+xrd_input_mask_get_height (XrdInputMask *self);
+
+void
+xrd_input_mask_set (XrdInputMask *self,
+                    uint32_t      x,
+                    uint32_t      y,
+                    gboolean      solid);
+
+gboolean
+xrd_input_mask_get (XrdInputMask *self,
+                    uint32_t      x,
+                    uint32_t      y);
+
+gboolean
+xrd_input_mask_test (XrdInputMask *self,
+                     float         u,
+                     float         v);
+
+G_END_DECLS
+
+#endif /* XRD_INPUT_MASK_H_ */
@@ -0,0 +1,248 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-input-ring.h"
+
+/* Two pose actions for a handful of controllers and trackers */
+#define MAX_POSE_SLOTS 32
+
+typedef struct {
+  /* seqlock, odd while the producer writes the pose */
+  volatile gint serial;
+  XrdInputRingEvent pose;
+  /* Only used by the consumer, the serial of the last pose taken */
+  gint taken_serial;
+} XrdInputRingPoseSlot;
+
+struct _XrdInputRing
+{
+  GObject parent;
+
+  XrdInputRingEvent *events;
+  guint mask;
+
+  /* Only written by the producer. */
+  volatile gint head;
+  /* Only written by the consumer. */
+  volatile gint tail;
+
+  /* Latest pose per controller and pose action, replaced in place.
+   * Slots are only claimed by the producer, published by n_pose_slots. */
+  XrdInputRingPoseSlot pose_slots[MAX_POSE_SLOTS];
+  volatile gint n_pose_slots;
+  gboolean pose_slots_full;
+};
+
+G_DEFINE_TYPE (XrdInputRing, xrd_input_ring, G_TYPE_OBJECT)
+
+static void
+xrd_input_ring_finalize (GObject *gobject);
+
+static void
+xrd_input_ring_class_init (XrdInputRingClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = xrd_input_ring_finalize;
+}
+
+static void
+xrd_input_ring_init (XrdInputRing *self)
+{
+  self->events = NULL;
+  self->mask = 0;
+  self->head = 0;
+  self->tail = 0;
+  self->n_pose_slots = 0;
+  self->pose_slots_full = FALSE;
+}
+
+/**
+ * xrd_input_ring_new:
+ * @capacity: The number of events the ring can hold, rounded up to a power
+ * of two.
+ *
+ * Creates a lock-free single producer, single consumer ring buffer for
+ * button and analog events. Poses are not queued, only the latest one per
+ * controller and pose action is kept in a slot guarded by a sequence
+ * counter, see xrd_input_ring_take_poses().
+ * xrd_input_ring_push() must only be called from one thread and
+ * xrd_input_ring_pop() and xrd_input_ring_take_poses() only from one other
+ * thread.
+ *
+ * Returns: A new #XrdInputRing.
+ */
+XrdInputRing *
+xrd_input_ring_new (guint capacity)
+{
+  XrdInputRing *self =
+    (XrdInputRing*) g_object_new (XRD_TYPE_INPUT_RING, 0);
+
+  guint size = 2;
+  while (size < capacity)
+    size <<= 1;
+
+  self->events = g_malloc0 (sizeof (XrdInputRingEvent) * size);
+  self->mask = size - 1;
+
+  return self;
+}
+
+static void
+xrd_input_ring_finalize (GObject *gobject)
+{
+  XrdInputRing *self = XRD_INPUT_RING (gobject);
+  g_free (self->events);
+  G_OBJECT_CLASS (xrd_input_ring_parent_class)->finalize (gobject);
+}
+
+static gboolean
+_is_pose_action (XrdInputTraceAction action)
+{
+  return action == XRD_INPUT_TRACE_HAND_POSE ||
+         action == XRD_INPUT_TRACE_HAND_POSE_HAND_GRIP;
+}
+
+static void
+_push_pose (XrdInputRing            *self,
+            const XrdInputRingEvent *event)
+{
+  /* only the producer claims slots, it can read the count and keys plainly */
+  gint n_slots = self->n_pose_slots;
+
+  gint i = 0;
+  for (; i < n_slots; i++)
+    {
+      XrdInputRingEvent *pose = &self->pose_slots[i].pose;
+      if (pose->action == event->action &&
+          pose->event.pose.controller_handle ==
+          event->event.pose.controller_handle)
+        break;
+    }
+
+  if (i == MAX_POSE_SLOTS)
+    {
+      if (!self->pose_slots_full)
+        g_printerr ("Input ring: more than %d poses, dropping new ones.\n",
+                    MAX_POSE_SLOTS);
+      self->pose_slots_full = TRUE;
+      return;
+    }
+
+  XrdInputRingPoseSlot *slot = &self->pose_slots[i];
+
+  /* g_atomic_int_inc is a full barrier */
+  g_atomic_int_inc (&slot->serial);
+  slot->pose = *event;
+  g_atomic_int_inc (&slot->serial);
+
+  if (i == n_slots)
+    g_atomic_int_set (&self->n_pose_slots, n_slots + 1);
+}
+
+/**
+ * xrd_input_ring_push:
+ * @self: The #XrdInputRing
+ * @event: The event to copy into the ring.
+ *
+ * Pose events replace the previous pose of their controller and action and
+ * always succeed. Other events are queued in order.
+ *
+ * Returns: %FALSE if the ring is full and the event was not queued, the
+ * caller has to retry, since button events must not get lost.
+ */
+gboolean
+xrd_input_ring_push (XrdInputRing            *self,
+                     const XrdInputRingEvent *event)
+{
+  if (_is_pose_action (event->action))
+    {
+      _push_pose (self, event);
+      return TRUE;
+    }
+
+  guint head = (guint) self->head;
+  guint tail = (guint) g_atomic_int_get (&self->tail);
+
+  if (head - tail > self->mask)
+    return FALSE;
+
+  self->events[head & self->mask] = *event;
+
+  /* publishes the event, g_atomic_int_set is a full barrier */
+  g_atomic_int_set (&self->head, (gint) (head + 1));
+  return TRUE;
+}
+
+/**
+ * xrd_input_ring_pop:
+ * @self: The #XrdInputRing
+ * @event: (out): The oldest event in the ring.
+ *
+ * Returns: %FALSE if the ring was empty.
+ */
+gboolean
+xrd_input_ring_pop (XrdInputRing      *self,
+                    XrdInputRingEvent *event)
+{
+  guint tail = (guint) self->tail;
+  guint head = (guint) g_atomic_int_get (&self->head);
+
+  if (head == tail)
+    return FALSE;
+
+  *event = self->events[tail & self->mask];
+
+  g_atomic_int_set (&self->tail, (gint) (tail + 1));
+  return TRUE;
+}
+
+/**
+ * xrd_input_ring_take_poses:
+ * @self: The #XrdInputRing
+ * @poses: (out caller-allocates) (array length=max_poses): The latest poses.
+ * @max_poses: The length of @poses.
+ *
+ * Takes the poses pushed since the last call, one per controller and pose
+ * action. Retries a slot the producer is writing meanwhile, never blocks it.
+ *
+ * Returns: The number of poses written to @poses.
+ */
+guint
+xrd_input_ring_take_poses (XrdInputRing      *self,
+                           XrdInputRingEvent *poses,
+                           guint              max_poses)
+{
+  guint n_poses = 0;
+  gint n_slots = g_atomic_int_get (&self->n_pose_slots);
+
+  for (gint i = 0; i < n_slots && n_poses < max_poses; i++)
+    {
+      XrdInputRingPoseSlot *slot = &self->pose_slots[i];
+
+      gint serial = 0;
+      gint serial_after = 0;
+      do
+        {
+          serial = g_atomic_int_get (&slot->serial);
+          if (serial % 2 != 0)
+            continue;
+
+          poses[n_poses] = slot->pose;
+
+          serial_after = g_atomic_int_get (&slot->serial);
+        }
+      while (serial % 2 != 0 || serial != serial_after);
+
+      if (serial == slot->taken_serial)
+        continue;
+
+      slot->taken_serial = serial;
+      n_poses++;
+    }
+
+  return n_poses;
+}
@@ -0,0 +1,62 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_INPUT_RING_H_
+#define XRD_INPUT_RING_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+
+#include <gxr.h>
+
+#include "xrd-input-trace.h"
+
+G_BEGIN_DECLS
+
+#define XRD_TYPE_INPUT_RING xrd_input_ring_get_type()
+G_DECLARE_FINAL_TYPE (XrdInputRing, xrd_input_ring, XRD, INPUT_RING, GObject)
+
+/**
+ * XrdInputRingEvent:
+ * @action: The action the event belongs to, also selects the member of @event.
+ * @time_us: The monotonic time the input thread received the event at.
+ * @event: A copy of the OpenVR action event.
+ *
+ * An input event handed from the input thread to the main loop.
+ **/
+typedef struct {
+  XrdInputTraceAction action;
+  gint64 time_us;
+  union {
+    OpenVRPoseEvent pose;
+    OpenVRDigitalEvent digital;
+    OpenVRAnalogEvent analog;
+  } event;
+} XrdInputRingEvent;
+
+XrdInputRing *
+xrd_input_ring_new (guint capacity);
+
+gboolean
+xrd_input_ring_push (XrdInputRing            *self,
+                     const XrdInputRingEvent *event);
+
+gboolean
+xrd_input_ring_pop (XrdInputRing      *self,
+                    XrdInputRingEvent *event);
+
+guint
+xrd_input_ring_take_poses (XrdInputRing      *self,
+                           XrdInputRingEvent *poses,
+                           guint              max_poses);
+
+G_END_DECLS
+
+#endif /* XRD_INPUT_RING_H_ */
@@ -8,6 +8,7 @@
 #include "xrd-input-synth.h"
 
 #include <gdk/gdk.h>
+#include <math.h>
 
 #include "xrd-settings.h"
 #include "graphene-ext.h"
@@ -32,6 +33,20 @@ struct _XrdInputSynth
 
   XrdShakeCompensator *compensator;
   gboolean compensator_enabled;
+
+  XrdInputTrace *input_trace;
+
+  /* last "move-cursor-event", only emitted when the pixel changes */
+  XrdWindow *cursor_window;
+  graphene_point_t cursor_position;
+  int cursor_pixel_x;
+  int cursor_pixel_y;
+  gboolean cursor_ignore;
+
+  /* seqlock for xrd_input_synth_get_cursor_position(), odd while writing */
+  volatile gint cursor_slot_serial;
+  XrdWindow *cursor_slot_window;
+  graphene_point_t cursor_slot_position;
 };
 
 #define LEFT_BUTTON 1
@@ -47,6 +62,7 @@ G_DEFINE_TYPE (XrdInputSynth, xrd_input_synth, G_TYPE_OBJECT)
 enum {
   CLICK_EVENT,
   MOVE_CURSOR_EVENT,
+  SCROLL_EVENT,
   LAST_SIGNAL
 };
 static guint signals[LAST_SIGNAL] = { 0 };
@@ -74,6 +90,19 @@ xrd_input_synth_class_init (XrdInputSynthClass *klass)
                    G_SIGNAL_RUN_LAST,
                    0, NULL, NULL, NULL, G_TYPE_NONE,
                    1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+  /*
+   * Unlike the other events, the #XrdScrollEvent is owned by the emitter.
+   * Handlers return %TRUE when they handled it, otherwise the scroll is
+   * synthesized as wheel button "click-event" pairs.
+   */
+  signals[SCROLL_EVENT] =
+    g_signal_new ("scroll-event",
+                   G_TYPE_FROM_CLASS (klass),
+                   G_SIGNAL_RUN_LAST,
+                   0, g_signal_accumulator_true_handled, NULL, NULL,
+                   G_TYPE_BOOLEAN,
+                   1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
 }
 
 XrdInputSynth *
@@ -88,6 +117,7 @@ xrd_input_synth_finalize (GObject *gobject)
   XrdInputSynth *self = XRD_INPUT_SYNTH (gobject);
   g_object_unref (self->synth_actions);
   g_object_unref (self->compensator);
+  g_clear_object (&self->input_trace);
 
   G_OBJECT_CLASS (xrd_input_synth_parent_class)->finalize (gobject);
 }
@@ -107,6 +137,14 @@ _emit_click (XrdInputSynth    *self,
            xrd_shake_compensator_get_button (self->compensator))
     xrd_shake_compensator_reset (self->compensator);
 
+  if (button == LEFT_BUTTON || button == RIGHT_BUTTON)
+    {
+      if (state)
+        xrd_shake_compensator_log_press (self->compensator, button);
+      else
+        xrd_shake_compensator_log_release (self->compensator, button);
+    }
+
   XrdClickEvent *click_event = g_malloc (sizeof (XrdClickEvent));
   click_event->position = position;
   click_event->button = button;
@@ -150,6 +188,10 @@ _action_left_click_cb (OpenVRAction             *action,
 {
   (void) action;
 
+  if (self->input_trace)
+    xrd_input_trace_record_digital (self->input_trace,
+                                    XRD_INPUT_TRACE_LEFT_CLICK, event);
+
   /* when left clicking with a controller that is *not* used to do input
    * synth, make this controller do input synth */
   if (event->state && self->synthing_controller_handle !=
@@ -187,6 +229,10 @@ _action_right_click_cb (OpenVRAction            *action,
 {
   (void) action;
 
+  if (self->input_trace)
+    xrd_input_trace_record_digital (self->input_trace,
+                                    XRD_INPUT_TRACE_RIGHT_CLICK, event);
+
   if (self->synthing_controller_handle != event->controller_handle)
     {
       g_free (event);
@@ -206,8 +252,28 @@ _action_right_click_cb (OpenVRAction            *action,
 }
 
 static void
-_do_scroll (XrdInputSynth *self, int steps_x, int steps_y)
+_do_scroll (XrdInputSynth *self,
+            float          dx,
+            float          dy,
+            int            steps_x,
+            int            steps_y)
 {
+  XrdScrollEvent scroll_event = {
+    .window = NULL,
+    .position = &self->hover_position,
+    .dx = dx,
+    .dy = dy,
+    .steps_x = steps_x,
+    .steps_y = steps_y,
+    .controller_handle = self->synthing_controller_handle,
+  };
+
+  gboolean handled = FALSE;
+  g_signal_emit (self, signals[SCROLL_EVENT], 0, &scroll_event, &handled);
+  if (handled)
+    return;
+
+  /* fallback for consumers that only handle wheel buttons */
   for (int i = 0; i < abs(steps_y); i++)
     {
       int btn;
@@ -243,6 +309,10 @@ _action_scroll_cb (OpenVRAction            *action,
 {
   (void) action;
 
+  if (self->input_trace)
+    xrd_input_trace_record_analog (self->input_trace,
+                                   XRD_INPUT_TRACE_SCROLL, event);
+
   if (self->synthing_controller_handle != event->controller_handle)
     {
       g_free (event);
@@ -274,6 +344,9 @@ _action_scroll_cb (OpenVRAction            *action,
   graphene_vec3_add (&self->scroll_accumulator, &event->delta,
                      &self->scroll_accumulator);
 
+  float dx = graphene_vec3_get_x (&event->delta) / self->scroll_threshold;
+  float dy = graphene_vec3_get_y (&event->delta) / self->scroll_threshold;
+
   float x_acc = graphene_vec3_get_x (&self->scroll_accumulator);
   float y_acc = graphene_vec3_get_y (&self->scroll_accumulator);
 
@@ -292,11 +365,28 @@ _action_scroll_cb (OpenVRAction            *action,
   float rest_y = y_acc - (float)steps_y * self->scroll_threshold;
   graphene_vec3_init (&self->scroll_accumulator, rest_x, rest_y, 0);
 
-  _do_scroll (self, steps_x, steps_y);
+  if (dx != 0.0f || dy != 0.0f)
+    _do_scroll (self, dx, dy, steps_x, steps_y);
 
   g_free (event);
 }
 
+static void
+_publish_cursor_position (XrdInputSynth    *self,
+                          XrdWindow        *window,
+                          graphene_point_t *position)
+{
+  if (window == self->cursor_slot_window &&
+      graphene_point_equal (position, &self->cursor_slot_position))
+    return;
+
+  /* g_atomic_int_inc is a full barrier */
+  g_atomic_int_inc (&self->cursor_slot_serial);
+  self->cursor_slot_window = window;
+  graphene_point_init_from_point (&self->cursor_slot_position, position);
+  g_atomic_int_inc (&self->cursor_slot_serial);
+}
+
 void
 xrd_input_synth_move_cursor (XrdInputSynth    *self,
                              XrdWindow *window,
@@ -306,15 +396,15 @@ xrd_input_synth_move_cursor (XrdInputSynth    *self,
   graphene_point_t intersection_pixels;
   xrd_window_get_intersection_2d_pixels (window, intersection,
                                         &intersection_pixels);
-  
-  XrdMoveCursorEvent *event = g_malloc (sizeof (XrdMoveCursorEvent));
-  event->window = window;
-  event->position = &intersection_pixels;
-  event->ignore = FALSE;
+
+  gboolean ignore = FALSE;
 
   graphene_point_init_from_point (&self->hover_position, &intersection_pixels);
   self->hover_window = window;
 
+  xrd_shake_compensator_log_sample (self->compensator, window, controller_pose,
+                                    intersection, &intersection_pixels);
+
   if (xrd_shake_compensator_is_recording (self->compensator))
     {
       xrd_shake_compensator_record (self->compensator, &intersection_pixels);
@@ -336,13 +426,72 @@ xrd_input_synth_move_cursor (XrdInputSynth    *self,
         }
       else
         {
-          event->ignore = TRUE;
+          ignore = TRUE;
         }
     }
 
+  if (!ignore)
+    _publish_cursor_position (self, window, &intersection_pixels);
+
+  /* Most pose updates don't move the cursor by a whole pixel. */
+  int pixel_x = (int) floorf (intersection_pixels.x);
+  int pixel_y = (int) floorf (intersection_pixels.y);
+  if (window == self->cursor_window && ignore == self->cursor_ignore &&
+      pixel_x == self->cursor_pixel_x && pixel_y == self->cursor_pixel_y)
+    return;
+
+  self->cursor_window = window;
+  self->cursor_pixel_x = pixel_x;
+  self->cursor_pixel_y = pixel_y;
+  self->cursor_ignore = ignore;
+  graphene_point_init_from_point (&self->cursor_position,
+                                  &intersection_pixels);
+
+  XrdMoveCursorEvent *event = g_malloc (sizeof (XrdMoveCursorEvent));
+  event->window = window;
+  event->position = &self->cursor_position;
+  event->ignore = ignore;
+
   g_signal_emit (self, signals[MOVE_CURSOR_EVENT], 0, event);
 }
 
+/**
+ * xrd_input_synth_get_cursor_position:
+ * @self: The #XrdInputSynth
+ * @window: (out) (optional): The window the cursor is on.
+ * @position: (out): The cursor position on @window in pixels.
+ *
+ * Reads the latest synthesized cursor position without waiting for a
+ * "move-cursor-event", e.g. once per frame of the desktop compositor.
+ * Safe to call from any thread, the position is published lock-free.
+ *
+ * Returns: A serial that changes whenever the position changes, 0 if there
+ * was no position yet.
+ */
+guint
+xrd_input_synth_get_cursor_position (XrdInputSynth    *self,
+                                     XrdWindow       **window,
+                                     graphene_point_t *position)
+{
+  gint serial;
+  gint serial_after = 0;
+  do
+    {
+      serial = g_atomic_int_get (&self->cursor_slot_serial);
+      if (serial % 2 != 0)
+        continue;
+
+      if (window)
+        *window = self->cursor_slot_window;
+      graphene_point_init_from_point (position, &self->cursor_slot_position);
+
+      serial_after = g_atomic_int_get (&self->cursor_slot_serial);
+    }
+  while (serial % 2 != 0 || serial != serial_after);
+
+  return (guint) serial / 2;
+}
+
 static void
 _update_scroll_threshold (GSettings *settings, gchar *key, gpointer _self)
 {
@@ -366,6 +515,15 @@ xrd_input_synth_init (XrdInputSynth *self)
   self->button_press_state = 0;
   graphene_point_init (&self->hover_position, 0, 0);
 
+  self->cursor_window = NULL;
+  graphene_point_init (&self->cursor_position, 0, 0);
+  self->cursor_pixel_x = -1;
+  self->cursor_pixel_y = -1;
+  self->cursor_ignore = FALSE;
+  self->cursor_slot_serial = 0;
+  self->cursor_slot_window = NULL;
+  graphene_point_init (&self->cursor_slot_position, 0, 0);
+
   self->compensator = xrd_shake_compensator_new ();
 
   self->synth_actions = openvr_action_set_new_from_url ("/actions/mouse_synth");
@@ -389,6 +547,7 @@ xrd_input_synth_init (XrdInputSynth *self)
        self);
 
   self->synthing_controller_handle = 0;
+  self->input_trace = NULL;
 }
 
 /**
@@ -403,6 +562,25 @@ xrd_input_synth_synthing_controller (XrdInputSynth *self)
   return self->synthing_controller_handle;
 }
 
+/**
+ * xrd_input_synth_open_shake_log:
+ * @self: The #XrdInputSynth
+ * @path: The file to write to.
+ * @label: What the user is asked to do, "click" or "drag".
+ *
+ * Logs all left and right button presses for tuning the shake compensation,
+ * see xrd_shake_compensator_open_log().
+ *
+ * Returns: %FALSE if the file could not be opened.
+ */
+gboolean
+xrd_input_synth_open_shake_log (XrdInputSynth *self,
+                                const gchar   *path,
+                                const gchar   *label)
+{
+  return xrd_shake_compensator_open_log (self->compensator, path, label);
+}
+
 /**
  * xrd_input_synth_hand_off_to_controller:
  * @self: The #XrdInputSynth
@@ -432,6 +610,39 @@ xrd_input_synth_poll_events (XrdInputSynth *self)
   return TRUE;
 }
 
+/**
+ * xrd_input_synth_handle_event:
+ * @self: The #XrdInputSynth
+ * @action: %XRD_INPUT_TRACE_LEFT_CLICK, %XRD_INPUT_TRACE_RIGHT_CLICK or
+ * %XRD_INPUT_TRACE_SCROLL.
+ * @event: (transfer full): The #OpenVRDigitalEvent or #OpenVRAnalogEvent of
+ * @action.
+ *
+ * Handles a synth action event that was polled elsewhere, like on the input
+ * thread of #XrdClient, through the same code paths as the live actions.
+ */
+void
+xrd_input_synth_handle_event (XrdInputSynth       *self,
+                              XrdInputTraceAction  action,
+                              gpointer             event)
+{
+  switch (action)
+    {
+    case XRD_INPUT_TRACE_LEFT_CLICK:
+      _action_left_click_cb (NULL, event, self);
+      break;
+    case XRD_INPUT_TRACE_RIGHT_CLICK:
+      _action_right_click_cb (NULL, event, self);
+      break;
+    case XRD_INPUT_TRACE_SCROLL:
+      _action_scroll_cb (NULL, event, self);
+      break;
+    default:
+      g_free (event);
+      break;
+    }
+}
+
 /**
  * xrd_input_synth_reset_scroll:
  * @self: The #XrdInputSynth
@@ -447,3 +658,40 @@ xrd_input_synth_reset_scroll (XrdInputSynth *self)
   graphene_vec3_init (&self->scroll_accumulator, 0, 0, 0);
 }
 
+
+/**
+ * xrd_input_synth_set_input_trace:
+ * @self: The #XrdInputSynth
+ * @trace: (nullable): The #XrdInputTrace to record into while it is recording.
+ */
+void
+xrd_input_synth_set_input_trace (XrdInputSynth *self,
+                                 XrdInputTrace *trace)
+{
+  g_clear_object (&self->input_trace);
+  if (trace)
+    self->input_trace = g_object_ref (trace);
+}
+
+/**
+ * xrd_input_synth_replay_input_trace:
+ * @self: The #XrdInputSynth
+ * @trace: The #XrdInputTrace that will be played.
+ *
+ * Connects the synth actions to the trace, so the recorded clicks and
+ * scrolling go through the same code paths as the live actions.
+ * Disconnect with g_signal_handlers_disconnect_by_data().
+ */
+void
+xrd_input_synth_replay_input_trace (XrdInputSynth *self,
+                                    XrdInputTrace *trace)
+{
+  /* The action callbacks ignore their first argument, so they can be
+   * connected to the trace directly. */
+  g_signal_connect (trace, "digital-event::left-click",
+                    (GCallback) _action_left_click_cb, self);
+  g_signal_connect (trace, "digital-event::right-click",
+                    (GCallback) _action_right_click_cb, self);
+  g_signal_connect (trace, "analog-event::scroll",
+                    (GCallback) _action_scroll_cb, self);
+}
@@ -18,6 +18,7 @@
 
 #include "xrd-window.h"
 #include "xrd-overlay-window.h"
+#include "xrd-input-trace.h"
 
 G_BEGIN_DECLS
 
@@ -42,13 +43,41 @@ typedef struct {
   guint64           controller_handle;
 } XrdClickEvent;
 
+/**
+ * XrdScrollEvent:
+ * @window: The #XrdWindow that was scrolled.
+ * @position: A #graphene_point_t 2D screen position of the cursor.
+ * @dx: Horizontal scroll distance since the last event in wheel steps,
+ * positive to the right.
+ * @dy: Vertical scroll distance since the last event in wheel steps,
+ * positive upwards.
+ * @steps_x: Whole horizontal wheel steps that completed with this event.
+ * @steps_y: Whole vertical wheel steps that completed with this event.
+ * @controller_handle: A #guint64 with the OpenVR handle to the controller.
+ *
+ * A high resolution scroll event carrying all touchpad movement of one poll.
+ * @dx and @dy are fractional and suitable for smooth scrolling, @steps_x
+ * and @steps_y are for consumers that only know discrete wheel clicks.
+ **/
+typedef struct {
+  XrdWindow        *window;
+  graphene_point_t *position;
+  float             dx;
+  float             dy;
+  int               steps_x;
+  int               steps_y;
+  guint64           controller_handle;
+} XrdScrollEvent;
+
 /**
  * XrdMoveCursorEvent:
  * @window: The #XrdWindow on which the cursor was moved.
  * @position: A #graphene_point_t with the current 2D screen position.
  * @ignore: A #gboolean wheather the synthesis should be ignored.
  *
- * A 2D mouse move event.
+ * A 2D mouse move event. It is only emitted when the cursor moved to
+ * another pixel. @position is owned by the #XrdInputSynth and valid until
+ * the next event.
  *
  * Ignoring this events means only updating the cursor position in VR so it
  * does not appear frozen, but don't actually synthesize mouse move events.
@@ -81,10 +110,33 @@ xrd_input_synth_move_cursor (XrdInputSynth    *self,
 guint64
 xrd_input_synth_synthing_controller (XrdInputSynth *self);
 
+guint
+xrd_input_synth_get_cursor_position (XrdInputSynth    *self,
+                                     XrdWindow       **window,
+                                     graphene_point_t *position);
+
+gboolean
+xrd_input_synth_open_shake_log (XrdInputSynth *self,
+                                const gchar   *path,
+                                const gchar   *label);
+
 void
 xrd_input_synth_hand_off_to_controller (XrdInputSynth *self,
                                         guint64 controller_handle);
 
+void
+xrd_input_synth_set_input_trace (XrdInputSynth *self,
+                                 XrdInputTrace *trace);
+
+void
+xrd_input_synth_replay_input_trace (XrdInputSynth *self,
+                                    XrdInputTrace *trace);
+
+void
+xrd_input_synth_handle_event (XrdInputSynth       *self,
+                              XrdInputTraceAction  action,
+                              gpointer             event);
+
 
 G_END_DECLS
 
@@ -0,0 +1,620 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-input-trace.h"
+
+#include <string.h>
+#include <gdk/gdk.h>
+
+/*
+ * Trace file layout, in native byte order:
+ *
+ * header: guint32 magic, guint32 version
+ * record: gint64 timestamp in us since the start of the recording,
+ *         guint64 controller handle, guint8 action, payload
+ *
+ * payload for pose actions: guint8 flags, float[16] pose
+ * payload for digital actions: guint8 flags
+ * payload for analog actions: float[3] state, float[3] delta
+ * payload for poll: none
+ */
+
+#define TRACE_MAGIC 0x54445258 /* "XRDT" */
+#define TRACE_VERSION 1
+
+#define RECORD_HEADER_SIZE (sizeof (gint64) + sizeof (guint64) + 1)
+
+#define POSE_FLAG_CONNECTED (1 << 0)
+#define POSE_FLAG_VALID     (1 << 1)
+#define POSE_FLAG_ACTIVE    (1 << 2)
+
+#define DIGITAL_FLAG_STATE   (1 << 0)
+#define DIGITAL_FLAG_CHANGED (1 << 1)
+
+typedef enum {
+  PAYLOAD_POSE,
+  PAYLOAD_DIGITAL,
+  PAYLOAD_ANALOG,
+  PAYLOAD_NONE
+} PayloadType;
+
+static const struct {
+  const gchar *name;
+  PayloadType payload;
+} actions[XRD_INPUT_TRACE_ACTION_COUNT] = {
+  [XRD_INPUT_TRACE_HAND_POSE] = { "hand-pose", PAYLOAD_POSE },
+  [XRD_INPUT_TRACE_HAND_POSE_HAND_GRIP] =
+    { "hand-pose-hand-grip", PAYLOAD_POSE },
+  [XRD_INPUT_TRACE_GRAB_WINDOW] = { "grab-window", PAYLOAD_DIGITAL },
+  [XRD_INPUT_TRACE_RESET_ORIENTATION] =
+    { "reset-orientation", PAYLOAD_DIGITAL },
+  [XRD_INPUT_TRACE_MENU] = { "menu", PAYLOAD_DIGITAL },
+  [XRD_INPUT_TRACE_SHOW_KEYBOARD] = { "show-keyboard", PAYLOAD_DIGITAL },
+  [XRD_INPUT_TRACE_PUSH_PULL_SCALE] = { "push-pull-scale", PAYLOAD_ANALOG },
+  [XRD_INPUT_TRACE_PUSH_PULL] = { "push-pull", PAYLOAD_ANALOG },
+  [XRD_INPUT_TRACE_LEFT_CLICK] = { "left-click", PAYLOAD_DIGITAL },
+  [XRD_INPUT_TRACE_RIGHT_CLICK] = { "right-click", PAYLOAD_DIGITAL },
+  [XRD_INPUT_TRACE_SCROLL] = { "scroll", PAYLOAD_ANALOG },
+  [XRD_INPUT_TRACE_POLL] = { "poll", PAYLOAD_NONE },
+};
+
+static const gsize payload_sizes[] = {
+  [PAYLOAD_POSE] = 1 + 16 * sizeof (float),
+  [PAYLOAD_DIGITAL] = 1,
+  [PAYLOAD_ANALOG] = 6 * sizeof (float),
+  [PAYLOAD_NONE] = 0,
+};
+
+enum {
+  POSE_EVENT,
+  DIGITAL_EVENT,
+  ANALOG_EVENT,
+  POLL_EVENT,
+  FINISHED_EVENT,
+  LAST_SIGNAL
+};
+
+static guint trace_signals[LAST_SIGNAL] = { 0 };
+
+static GQuark action_quarks[XRD_INPUT_TRACE_ACTION_COUNT];
+
+struct _XrdInputTrace
+{
+  GObject parent;
+
+  GByteArray *records;
+  guint n_records;
+  gint64 last_timestamp;
+
+  gboolean recording;
+  gint64 record_start;
+
+  guint play_source;
+  gboolean play_realtime;
+  gint64 play_start;
+  gsize play_offset;
+  gint64 play_timestamp;
+};
+
+G_DEFINE_TYPE (XrdInputTrace, xrd_input_trace, G_TYPE_OBJECT)
+
+static void
+xrd_input_trace_finalize (GObject *gobject);
+
+static void
+xrd_input_trace_class_init (XrdInputTraceClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  object_class->finalize = xrd_input_trace_finalize;
+
+  for (int i = 0; i < XRD_INPUT_TRACE_ACTION_COUNT; i++)
+    action_quarks[i] = g_quark_from_static_string (actions[i].name);
+
+  trace_signals[POSE_EVENT] =
+    g_signal_new ("pose-event",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED,
+                  0, NULL, NULL, NULL, G_TYPE_NONE,
+                  1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+  trace_signals[DIGITAL_EVENT] =
+    g_signal_new ("digital-event",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED,
+                  0, NULL, NULL, NULL, G_TYPE_NONE,
+                  1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+  trace_signals[ANALOG_EVENT] =
+    g_signal_new ("analog-event",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED,
+                  0, NULL, NULL, NULL, G_TYPE_NONE,
+                  1, GDK_TYPE_EVENT | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+  trace_signals[POLL_EVENT] =
+    g_signal_new ("poll-event",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+
+  trace_signals[FINISHED_EVENT] =
+    g_signal_new ("finished-event",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL, G_TYPE_NONE, 0);
+}
+
+static void
+xrd_input_trace_init (XrdInputTrace *self)
+{
+  self->records = g_byte_array_new ();
+  self->n_records = 0;
+  self->last_timestamp = 0;
+  self->recording = FALSE;
+  self->record_start = 0;
+  self->play_source = 0;
+  self->play_realtime = FALSE;
+  self->play_start = 0;
+  self->play_offset = 0;
+  self->play_timestamp = 0;
+}
+
+/**
+ * xrd_input_trace_new:
+ *
+ * Creates an empty trace of controller input, to be filled with
+ * xrd_input_trace_start_recording() and the record functions.
+ *
+ * Returns: A new #XrdInputTrace.
+ */
+XrdInputTrace *
+xrd_input_trace_new (void)
+{
+  return (XrdInputTrace*) g_object_new (XRD_TYPE_INPUT_TRACE, 0);
+}
+
+static void
+xrd_input_trace_finalize (GObject *gobject)
+{
+  XrdInputTrace *self = XRD_INPUT_TRACE (gobject);
+  xrd_input_trace_stop (self);
+  g_byte_array_unref (self->records);
+  G_OBJECT_CLASS (xrd_input_trace_parent_class)->finalize (gobject);
+}
+
+/* Returns the size of the record at offset, or 0 if it is malformed. */
+static gsize
+_get_record_size (GByteArray *records, gsize offset)
+{
+  if (offset + RECORD_HEADER_SIZE > records->len)
+    return 0;
+
+  guint8 action = records->data[offset + RECORD_HEADER_SIZE - 1];
+  if (action >= XRD_INPUT_TRACE_ACTION_COUNT)
+    return 0;
+
+  gsize size = RECORD_HEADER_SIZE + payload_sizes[actions[action].payload];
+  if (offset + size > records->len)
+    return 0;
+
+  return size;
+}
+
+/**
+ * xrd_input_trace_new_from_file:
+ * @path: A trace written by xrd_input_trace_save().
+ *
+ * Returns: (nullable): The loaded #XrdInputTrace, or %NULL on error.
+ */
+XrdInputTrace *
+xrd_input_trace_new_from_file (const gchar *path)
+{
+  gchar *contents;
+  gsize length;
+  GError *error = NULL;
+  if (!g_file_get_contents (path, &contents, &length, &error))
+    {
+      g_printerr ("Unable to read input trace: %s\n", error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  guint32 header[2];
+  if (length < sizeof (header))
+    {
+      g_printerr ("Input trace %s is too short.\n", path);
+      g_free (contents);
+      return NULL;
+    }
+
+  memcpy (header, contents, sizeof (header));
+  if (header[0] != TRACE_MAGIC || header[1] != TRACE_VERSION)
+    {
+      g_printerr ("%s is not a version %d input trace.\n", path, TRACE_VERSION);
+      g_free (contents);
+      return NULL;
+    }
+
+  XrdInputTrace *self = xrd_input_trace_new ();
+  g_byte_array_append (self->records,
+                       (guint8 *) contents + sizeof (header),
+                       (guint) (length - sizeof (header)));
+  g_free (contents);
+
+  gsize offset = 0;
+  while (offset < self->records->len)
+    {
+      gsize size = _get_record_size (self->records, offset);
+      if (size == 0)
+        {
+          g_printerr ("Input trace %s is corrupt after %u records.\n",
+                      path, self->n_records);
+          g_object_unref (self);
+          return NULL;
+        }
+      memcpy (&self->last_timestamp, self->records->data + offset,
+              sizeof (gint64));
+      self->n_records++;
+      offset += size;
+    }
+
+  return self;
+}
+
+/**
+ * xrd_input_trace_save:
+ * @self: The #XrdInputTrace
+ * @path: The file to write.
+ *
+ * Returns: %TRUE if the trace was written.
+ */
+gboolean
+xrd_input_trace_save (XrdInputTrace *self,
+                      const gchar   *path)
+{
+  guint32 header[2] = { TRACE_MAGIC, TRACE_VERSION };
+
+  GByteArray *file = g_byte_array_sized_new (
+    (guint) sizeof (header) + self->records->len);
+  g_byte_array_append (file, (guint8 *) header, sizeof (header));
+  g_byte_array_append (file, self->records->data, self->records->len);
+
+  GError *error = NULL;
+  gboolean res = g_file_set_contents (path, (gchar *) file->data,
+                                      file->len, &error);
+  g_byte_array_unref (file);
+
+  if (!res)
+    {
+      g_printerr ("Unable to write input trace: %s\n", error->message);
+      g_error_free (error);
+    }
+
+  return res;
+}
+
+/**
+ * xrd_input_trace_start_recording:
+ * @self: The #XrdInputTrace
+ *
+ * Discards previously recorded input and starts recording. Timestamps are
+ * relative to this call.
+ */
+void
+xrd_input_trace_start_recording (XrdInputTrace *self)
+{
+  xrd_input_trace_stop (self);
+  g_byte_array_set_size (self->records, 0);
+  self->n_records = 0;
+  self->last_timestamp = 0;
+  self->record_start = g_get_monotonic_time ();
+  self->recording = TRUE;
+}
+
+void
+xrd_input_trace_stop_recording (XrdInputTrace *self)
+{
+  self->recording = FALSE;
+}
+
+gboolean
+xrd_input_trace_is_recording (XrdInputTrace *self)
+{
+  return self->recording;
+}
+
+static void
+_append_header (XrdInputTrace       *self,
+                XrdInputTraceAction  action,
+                guint64              controller_handle)
+{
+  gint64 timestamp = g_get_monotonic_time () - self->record_start;
+  guint8 action_byte = (guint8) action;
+
+  g_byte_array_append (self->records, (guint8 *) &timestamp, sizeof (gint64));
+  g_byte_array_append (self->records,
+                       (guint8 *) &controller_handle, sizeof (guint64));
+  g_byte_array_append (self->records, &action_byte, 1);
+
+  self->last_timestamp = timestamp;
+  self->n_records++;
+}
+
+void
+xrd_input_trace_record_pose (XrdInputTrace       *self,
+                             XrdInputTraceAction  action,
+                             OpenVRPoseEvent     *event)
+{
+  if (!self->recording)
+    return;
+
+  g_return_if_fail (actions[action].payload == PAYLOAD_POSE);
+
+  _append_header (self, action, event->controller_handle);
+
+  guint8 flags = 0;
+  if (event->device_connected)
+    flags |= POSE_FLAG_CONNECTED;
+  if (event->valid)
+    flags |= POSE_FLAG_VALID;
+  if (event->active)
+    flags |= POSE_FLAG_ACTIVE;
+  g_byte_array_append (self->records, &flags, 1);
+
+  float pose[16];
+  graphene_matrix_to_float (&event->pose, pose);
+  g_byte_array_append (self->records, (guint8 *) pose, sizeof (pose));
+}
+
+void
+xrd_input_trace_record_digital (XrdInputTrace       *self,
+                                XrdInputTraceAction  action,
+                                OpenVRDigitalEvent  *event)
+{
+  if (!self->recording)
+    return;
+
+  g_return_if_fail (actions[action].payload == PAYLOAD_DIGITAL);
+
+  _append_header (self, action, event->controller_handle);
+
+  guint8 flags = 0;
+  if (event->state)
+    flags |= DIGITAL_FLAG_STATE;
+  if (event->changed)
+    flags |= DIGITAL_FLAG_CHANGED;
+  g_byte_array_append (self->records, &flags, 1);
+}
+
+void
+xrd_input_trace_record_analog (XrdInputTrace       *self,
+                               XrdInputTraceAction  action,
+                               OpenVRAnalogEvent   *event)
+{
+  if (!self->recording)
+    return;
+
+  g_return_if_fail (actions[action].payload == PAYLOAD_ANALOG);
+
+  _append_header (self, action, event->controller_handle);
+
+  float values[6];
+  graphene_vec3_to_float (&event->state, values);
+  graphene_vec3_to_float (&event->delta, values + 3);
+  g_byte_array_append (self->records, (guint8 *) values, sizeof (values));
+}
+
+/**
+ * xrd_input_trace_record_poll:
+ * @self: The #XrdInputTrace
+ *
+ * Marks the end of an input poll. When playing at maximum speed, the
+ * records of one poll are emitted per main loop iteration.
+ */
+void
+xrd_input_trace_record_poll (XrdInputTrace *self)
+{
+  if (!self->recording)
+    return;
+
+  _append_header (self, XRD_INPUT_TRACE_POLL, 0);
+}
+
+/* Emits the record at play_offset and returns its action. */
+static XrdInputTraceAction
+_emit_record (XrdInputTrace *self)
+{
+  const guint8 *record = self->records->data + self->play_offset;
+  gsize size = _get_record_size (self->records, self->play_offset);
+  self->play_offset += size;
+
+  memcpy (&self->play_timestamp, record, sizeof (gint64));
+
+  guint64 controller_handle;
+  memcpy (&controller_handle, record + sizeof (gint64), sizeof (guint64));
+  XrdInputTraceAction action = record[RECORD_HEADER_SIZE - 1];
+  const guint8 *payload = record + RECORD_HEADER_SIZE;
+
+  switch (actions[action].payload)
+    {
+    case PAYLOAD_POSE:
+      {
+        OpenVRPoseEvent *event = g_malloc0 (sizeof (OpenVRPoseEvent));
+        event->controller_handle = controller_handle;
+        event->device_connected = (payload[0] & POSE_FLAG_CONNECTED) != 0;
+        event->valid = (payload[0] & POSE_FLAG_VALID) != 0;
+        event->active = (payload[0] & POSE_FLAG_ACTIVE) != 0;
+
+        float pose[16];
+        memcpy (pose, payload + 1, sizeof (pose));
+        graphene_matrix_init_from_float (&event->pose, pose);
+
+        g_signal_emit (self, trace_signals[POSE_EVENT],
+                       action_quarks[action], event);
+      } break;
+    case PAYLOAD_DIGITAL:
+      {
+        OpenVRDigitalEvent *event = g_malloc0 (sizeof (OpenVRDigitalEvent));
+        event->controller_handle = controller_handle;
+        event->state = (payload[0] & DIGITAL_FLAG_STATE) != 0;
+        event->changed = (payload[0] & DIGITAL_FLAG_CHANGED) != 0;
+
+        g_signal_emit (self, trace_signals[DIGITAL_EVENT],
+                       action_quarks[action], event);
+      } break;
+    case PAYLOAD_ANALOG:
+      {
+        OpenVRAnalogEvent *event = g_malloc0 (sizeof (OpenVRAnalogEvent));
+        event->controller_handle = controller_handle;
+
+        float values[6];
+        memcpy (values, payload, sizeof (values));
+        graphene_vec3_init_from_float (&event->state, values);
+        graphene_vec3_init_from_float (&event->delta, values + 3);
+
+        g_signal_emit (self, trace_signals[ANALOG_EVENT],
+                       action_quarks[action], event);
+      } break;
+    case PAYLOAD_NONE:
+      g_signal_emit (self, trace_signals[POLL_EVENT], 0);
+      break;
+    }
+
+  return action;
+}
+
+static gboolean
+_finish_if_done (XrdInputTrace *self)
+{
+  if (self->play_offset < self->records->len)
+    return FALSE;
+
+  self->play_source = 0;
+  g_signal_emit (self, trace_signals[FINISHED_EVENT], 0);
+  return TRUE;
+}
+
+static gboolean
+_play_cb (gpointer _self)
+{
+  XrdInputTrace *self = _self;
+
+  g_object_ref (self);
+
+  if (self->play_realtime)
+    {
+      gint64 elapsed = g_get_monotonic_time () - self->play_start;
+      while (self->play_source != 0 &&
+             self->play_offset < self->records->len)
+        {
+          gint64 timestamp;
+          memcpy (&timestamp, self->records->data + self->play_offset,
+                  sizeof (gint64));
+          if (timestamp > elapsed)
+            break;
+          _emit_record (self);
+        }
+    }
+  else
+    {
+      /* One recorded poll per iteration, so rendering keeps interleaving */
+      while (self->play_source != 0 &&
+             self->play_offset < self->records->len)
+        if (_emit_record (self) == XRD_INPUT_TRACE_POLL)
+          break;
+    }
+
+  /* stopped from a signal handler */
+  if (self->play_source == 0)
+    {
+      g_object_unref (self);
+      return FALSE;
+    }
+
+  gboolean done = _finish_if_done (self);
+  g_object_unref (self);
+  return !done;
+}
+
+/**
+ * xrd_input_trace_play:
+ * @self: The #XrdInputTrace
+ * @realtime: %TRUE to play with the recorded timing, %FALSE to play one
+ * recorded input poll per main loop iteration.
+ *
+ * Replays the trace from the main loop by emitting the recorded events
+ * on the "pose-event", "digital-event" and "analog-event" signals, detailed
+ * with the action name, e.g. "pose-event::hand-pose".
+ * Like OpenVR action events, the event is owned by the handler.
+ * "finished-event" is emitted after the last record.
+ */
+void
+xrd_input_trace_play (XrdInputTrace *self,
+                      gboolean       realtime)
+{
+  xrd_input_trace_stop (self);
+  self->recording = FALSE;
+
+  self->play_realtime = realtime;
+  self->play_start = g_get_monotonic_time ();
+  self->play_offset = 0;
+  self->play_timestamp = 0;
+
+  if (realtime)
+    self->play_source = g_timeout_add (1, _play_cb, self);
+  else
+    self->play_source = g_idle_add (_play_cb, self);
+}
+
+void
+xrd_input_trace_stop (XrdInputTrace *self)
+{
+  if (self->play_source == 0)
+    return;
+
+  g_source_remove (self->play_source);
+  self->play_source = 0;
+}
+
+gboolean
+xrd_input_trace_is_playing (XrdInputTrace *self)
+{
+  return self->play_source != 0;
+}
+
+guint
+xrd_input_trace_get_n_records (XrdInputTrace *self)
+{
+  return self->n_records;
+}
+
+/**
+ * xrd_input_trace_get_play_timestamp:
+ * @self: The #XrdInputTrace
+ *
+ * Valid in the event handlers during playback.
+ *
+ * Returns: The recorded timestamp of the event being emitted, in
+ * microseconds since the start of the recording.
+ */
+gint64
+xrd_input_trace_get_play_timestamp (XrdInputTrace *self)
+{
+  return self->play_timestamp;
+}
+
+/**
+ * xrd_input_trace_get_duration:
+ * @self: The #XrdInputTrace
+ *
+ * Returns: The timestamp of the last record in microseconds.
+ */
+gint64
+xrd_input_trace_get_duration (XrdInputTrace *self)
+{
+  return self->last_timestamp;
+}
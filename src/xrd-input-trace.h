@@ -0,0 +1,116 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_INPUT_TRACE_H_
+#define XRD_INPUT_TRACE_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+
+#include <gxr.h>
+
+G_BEGIN_DECLS
+
+#define XRD_TYPE_INPUT_TRACE xrd_input_trace_get_type()
+G_DECLARE_FINAL_TYPE (XrdInputTrace, xrd_input_trace, XRD, INPUT_TRACE, GObject)
+
+/**
+ * XrdInputTraceAction:
+ * @XRD_INPUT_TRACE_HAND_POSE: /actions/wm/in/hand_pose
+ * @XRD_INPUT_TRACE_HAND_POSE_HAND_GRIP: /actions/wm/in/hand_pose_hand_grip
+ * @XRD_INPUT_TRACE_GRAB_WINDOW: /actions/wm/in/grab_window
+ * @XRD_INPUT_TRACE_RESET_ORIENTATION: /actions/wm/in/reset_orientation
+ * @XRD_INPUT_TRACE_MENU: /actions/wm/in/menu
+ * @XRD_INPUT_TRACE_SHOW_KEYBOARD: /actions/wm/in/show_keyboard
+ * @XRD_INPUT_TRACE_PUSH_PULL_SCALE: /actions/wm/in/push_pull_scale
+ * @XRD_INPUT_TRACE_PUSH_PULL: /actions/wm/in/push_pull
+ * @XRD_INPUT_TRACE_LEFT_CLICK: /actions/mouse_synth/in/left_click
+ * @XRD_INPUT_TRACE_RIGHT_CLICK: /actions/mouse_synth/in/right_click
+ * @XRD_INPUT_TRACE_SCROLL: /actions/mouse_synth/in/scroll
+ * @XRD_INPUT_TRACE_POLL: The end of an input poll, carries no payload.
+ *
+ * The actions an #XrdInputTrace records. The values are stored in trace
+ * files, new actions must be appended.
+ **/
+typedef enum {
+  XRD_INPUT_TRACE_HAND_POSE,
+  XRD_INPUT_TRACE_HAND_POSE_HAND_GRIP,
+  XRD_INPUT_TRACE_GRAB_WINDOW,
+  XRD_INPUT_TRACE_RESET_ORIENTATION,
+  XRD_INPUT_TRACE_MENU,
+  XRD_INPUT_TRACE_SHOW_KEYBOARD,
+  XRD_INPUT_TRACE_PUSH_PULL_SCALE,
+  XRD_INPUT_TRACE_PUSH_PULL,
+  XRD_INPUT_TRACE_LEFT_CLICK,
+  XRD_INPUT_TRACE_RIGHT_CLICK,
+  XRD_INPUT_TRACE_SCROLL,
+  XRD_INPUT_TRACE_POLL,
+  XRD_INPUT_TRACE_ACTION_COUNT
+} XrdInputTraceAction;
+
+XrdInputTrace *
+xrd_input_trace_new (void);
+
+XrdInputTrace *
+xrd_input_trace_new_from_file (const gchar *path);
+
+gboolean
+xrd_input_trace_save (XrdInputTrace *self,
+                      const gchar   *path);
+
+void
+xrd_input_trace_start_recording (XrdInputTrace *self);
+
+void
+xrd_input_trace_stop_recording (XrdInputTrace *self);
+
+gboolean
+xrd_input_trace_is_recording (XrdInputTrace *self);
+
+void
+xrd_input_trace_record_pose (XrdInputTrace       *self,
+                             XrdInputTraceAction  action,
+                             OpenVRPoseEvent     *event);
+
+void
+xrd_input_trace_record_digital (XrdInputTrace       *self,
+                                XrdInputTraceAction  action,
+                                OpenVRDigitalEvent  *event);
+
+void
+xrd_input_trace_record_analog (XrdInputTrace       *self,
+                               XrdInputTraceAction  action,
+                               OpenVRAnalogEvent   *event);
+
+void
+xrd_input_trace_record_poll (XrdInputTrace *self);
+
+void
+xrd_input_trace_play (XrdInputTrace *self,
+                      gboolean       realtime);
+
+void
+xrd_input_trace_stop (XrdInputTrace *self);
+
+gboolean
+xrd_input_trace_is_playing (XrdInputTrace *self);
+
+guint
+xrd_input_trace_get_n_records (XrdInputTrace *self);
+
+gint64
+xrd_input_trace_get_play_timestamp (XrdInputTrace *self);
+
+gint64
+xrd_input_trace_get_duration (XrdInputTrace *self);
+
+G_END_DECLS
+
+#endif /* XRD_INPUT_TRACE_H_ */
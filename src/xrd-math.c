@@ -1,6 +1,7 @@
 #include "xrd-math.h"
 
 #include <inttypes.h>
+#include <math.h>
 
 #include <gxr.h>
 
@@ -265,3 +266,30 @@ xrd_math_hmd_window_distance (XrdWindow *window)
 
   return graphene_point3d_distance (&hmd_location, &window_location, NULL);
 }
+
+/**
+ * xrd_math_pose_distance:
+ * @a: A rigid pose.
+ * @b: Another rigid pose.
+ *
+ * Measures how far apart two poses are in meters, including rotation.
+ *
+ * Returns: The larger of the distance between the origins and the distance
+ * between the points one meter in front of the poses.
+ */
+float
+xrd_math_pose_distance (const graphene_matrix_t *a,
+                        const graphene_matrix_t *b)
+{
+  graphene_point3d_t origin_a, origin_b;
+  graphene_ext_matrix_get_translation_point3d (a, &origin_a);
+  graphene_ext_matrix_get_translation_point3d (b, &origin_b);
+
+  graphene_point3d_t forward = { 0, 0, -1 };
+  graphene_point3d_t forward_a, forward_b;
+  graphene_matrix_transform_point3d (a, &forward, &forward_a);
+  graphene_matrix_transform_point3d (b, &forward, &forward_b);
+
+  return fmaxf (graphene_point3d_distance (&origin_a, &origin_b, NULL),
+                graphene_point3d_distance (&forward_a, &forward_b, NULL));
+}
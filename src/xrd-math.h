@@ -59,4 +59,8 @@ xrd_math_sphere_to_3d_coords (float azimuth,
 float
 xrd_math_hmd_window_distance (XrdWindow *window);
 
+float
+xrd_math_pose_distance (const graphene_matrix_t *a,
+                        const graphene_matrix_t *b);
+
 #endif /* XRD_MATH_H_ */
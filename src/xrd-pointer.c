@@ -163,11 +163,22 @@ xrd_pointer_get_intersection (XrdPointer      *self,
   /* Test if we are in [0-aspect_ratio, 0-1] plane coordinates */
   float aspect_ratio = xrd_window_get_aspect_ratio (window);
 
-  if (f[0] >= -aspect_ratio / 2.0f && f[0] <= aspect_ratio / 2.0f
-      && f[1] >= -0.5f && f[1] <= 0.5f)
-    return TRUE;
+  if (f[0] < -aspect_ratio / 2.0f || f[0] > aspect_ratio / 2.0f
+      || f[1] < -0.5f || f[1] > 0.5f)
+    return FALSE;
 
-  return FALSE;
+  /* Shaped windows let the pointer through their transparent cells */
+  XrdInputMask *mask = xrd_window_get_input_mask (window);
+  if (mask)
+    {
+      /* The mask is in texture rows, the top row is shown at the bottom
+       * of flipped windows */
+      XrdWindowData *data = xrd_window_get_data (window);
+      float v = data->flip_y ? 0.5f + f[1] : 0.5f - f[1];
+      return xrd_input_mask_test (mask, f[0] / aspect_ratio + 0.5f, v);
+    }
+
+  return TRUE;
 }
 
 void
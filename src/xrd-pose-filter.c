@@ -0,0 +1,257 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-pose-filter.h"
+
+#include <math.h>
+
+#include "graphene-ext.h"
+
+/* Cutoff for the velocity estimate, as recommended by the One Euro paper */
+#define DERIVATIVE_CUTOFF 1.0
+
+/* Gaps longer than this (tracking loss, paused polling) restart the filter,
+ * as does time going backwards when switching between live and replayed
+ * input */
+#define MAX_DELTA_S 0.25
+
+struct _XrdPoseFilter
+{
+  GObject parent;
+
+  gboolean initialized;
+  gint64 last_time_us;
+
+  graphene_vec3_t position;
+  /* m/s */
+  graphene_vec3_t velocity;
+
+  graphene_quaternion_t rotation;
+  /* rotation axis scaled by rad/s */
+  graphene_vec3_t angular_velocity;
+};
+
+G_DEFINE_TYPE (XrdPoseFilter, xrd_pose_filter, G_TYPE_OBJECT)
+
+static void
+xrd_pose_filter_class_init (XrdPoseFilterClass *klass)
+{
+  (void) klass;
+}
+
+static void
+xrd_pose_filter_init (XrdPoseFilter *self)
+{
+  xrd_pose_filter_reset (self);
+}
+
+/**
+ * xrd_pose_filter_new:
+ *
+ * Creates a One Euro filter for the pose of one controller.
+ * The filter smoothes jitter when the controller is held still while
+ * keeping the lag low during fast movements, and can extrapolate the pose
+ * with the filtered velocity.
+ *
+ * Returns: A new #XrdPoseFilter.
+ */
+XrdPoseFilter *
+xrd_pose_filter_new (void)
+{
+  return (XrdPoseFilter*) g_object_new (XRD_TYPE_POSE_FILTER, 0);
+}
+
+/**
+ * xrd_pose_filter_reset:
+ * @self: The #XrdPoseFilter
+ *
+ * Forget the pose history, the next pose will pass through unfiltered.
+ */
+void
+xrd_pose_filter_reset (XrdPoseFilter *self)
+{
+  self->initialized = FALSE;
+  self->last_time_us = 0;
+  graphene_vec3_init_from_vec3 (&self->position, graphene_vec3_zero ());
+  graphene_vec3_init_from_vec3 (&self->velocity, graphene_vec3_zero ());
+  graphene_quaternion_init_identity (&self->rotation);
+  graphene_vec3_init_from_vec3 (&self->angular_velocity,
+                                graphene_vec3_zero ());
+}
+
+static float
+_alpha (double cutoff, double dt)
+{
+  double tau = 1.0 / (2.0 * M_PI * cutoff);
+  return (float) (1.0 / (1.0 + tau / dt));
+}
+
+/* res = a * b */
+static void
+_quaternion_multiply (const graphene_quaternion_t *a,
+                      const graphene_quaternion_t *b,
+                      graphene_quaternion_t       *res)
+{
+  float q[4], r[4];
+  graphene_ext_quaternion_to_float (a, q);
+  graphene_ext_quaternion_to_float (b, r);
+
+  graphene_quaternion_init (res,
+                            q[3] * r[0] + q[0] * r[3] + q[1] * r[2] - q[2] * r[1],
+                            q[3] * r[1] - q[0] * r[2] + q[1] * r[3] + q[2] * r[0],
+                            q[3] * r[2] + q[0] * r[1] - q[1] * r[0] + q[2] * r[3],
+                            q[3] * r[3] - q[0] * r[0] - q[1] * r[1] - q[2] * r[2]);
+}
+
+static void
+_rotation_from_vec3 (const graphene_vec3_t *v,
+                     float                  scale,
+                     graphene_quaternion_t *res)
+{
+  float angle = graphene_vec3_length (v) * scale;
+  if (angle < 1e-6f)
+    {
+      graphene_quaternion_init_identity (res);
+      return;
+    }
+
+  graphene_vec3_t axis;
+  graphene_vec3_normalize (v, &axis);
+  graphene_quaternion_init_from_angle_vec3 (res, angle * 180.0f / (float) M_PI,
+                                            &axis);
+}
+
+static void
+_filter_position (XrdPoseFilter               *self,
+                  const XrdPoseFilterSettings *settings,
+                  double                       dt,
+                  const graphene_vec3_t       *position)
+{
+  graphene_vec3_t raw_velocity;
+  graphene_vec3_subtract (position, &self->position, &raw_velocity);
+  graphene_vec3_scale (&raw_velocity, (float) (1.0 / dt), &raw_velocity);
+
+  graphene_vec3_interpolate (&self->velocity, &raw_velocity,
+                             _alpha (DERIVATIVE_CUTOFF, dt), &self->velocity);
+
+  double cutoff = settings->min_cutoff +
+                  settings->beta * graphene_vec3_length (&self->velocity);
+
+  graphene_vec3_interpolate (&self->position, position,
+                             _alpha (cutoff, dt), &self->position);
+}
+
+static void
+_filter_rotation (XrdPoseFilter               *self,
+                  const XrdPoseFilterSettings *settings,
+                  double                       dt,
+                  const graphene_quaternion_t *rotation)
+{
+  /* take the short way around */
+  graphene_quaternion_t target;
+  if (graphene_quaternion_dot (rotation, &self->rotation) < 0)
+    {
+      graphene_vec4_t v;
+      graphene_quaternion_to_vec4 (rotation, &v);
+      graphene_vec4_negate (&v, &v);
+      graphene_quaternion_init_from_vec4 (&target, &v);
+    }
+  else
+    graphene_quaternion_init_from_quaternion (&target, rotation);
+
+  graphene_quaternion_t inverse;
+  graphene_quaternion_invert (&self->rotation, &inverse);
+  graphene_quaternion_t delta;
+  _quaternion_multiply (&target, &inverse, &delta);
+
+  float angle_deg;
+  graphene_vec3_t raw_angular_velocity;
+  graphene_quaternion_to_angle_vec3 (&delta, &angle_deg,
+                                     &raw_angular_velocity);
+  float angle = angle_deg * (float) M_PI / 180.0f;
+  if (angle > (float) M_PI)
+    angle -= 2.0f * (float) M_PI;
+  graphene_vec3_scale (&raw_angular_velocity, (float) (angle / dt),
+                       &raw_angular_velocity);
+
+  graphene_vec3_interpolate (&self->angular_velocity, &raw_angular_velocity,
+                             _alpha (DERIVATIVE_CUTOFF, dt),
+                             &self->angular_velocity);
+
+  /* rad/s and m/s share beta, which is about right for a ray pointing at
+   * windows one meter away */
+  double cutoff = settings->min_cutoff +
+                  settings->beta * graphene_vec3_length (&self->angular_velocity);
+
+  graphene_quaternion_slerp (&self->rotation, &target,
+                             _alpha (cutoff, dt), &self->rotation);
+  graphene_quaternion_normalize (&self->rotation, &self->rotation);
+}
+
+/**
+ * xrd_pose_filter_apply:
+ * @self: The #XrdPoseFilter
+ * @settings: The filter parameters.
+ * @time_us: The time the pose was sampled at, in microseconds. Not the
+ * time it is handled at, poses handled in a batch would get no velocity.
+ * @pose: The raw rigid pose.
+ * @filtered: (out): The filtered and extrapolated pose.
+ *
+ * @pose and @filtered may point to the same matrix.
+ */
+void
+xrd_pose_filter_apply (XrdPoseFilter               *self,
+                       const XrdPoseFilterSettings *settings,
+                       gint64                       time_us,
+                       const graphene_matrix_t     *pose,
+                       graphene_matrix_t           *filtered)
+{
+  graphene_vec3_t position;
+  graphene_ext_matrix_get_translation_vec3 (pose, &position);
+  graphene_quaternion_t rotation;
+  graphene_ext_matrix_get_rotation_quaternion (pose, &rotation);
+
+  double dt = (double) (time_us - self->last_time_us) / G_USEC_PER_SEC;
+
+  if (!self->initialized || dt < 0.0 || dt > MAX_DELTA_S)
+    {
+      xrd_pose_filter_reset (self);
+      self->initialized = TRUE;
+      self->last_time_us = time_us;
+      graphene_vec3_init_from_vec3 (&self->position, &position);
+      graphene_quaternion_init_from_quaternion (&self->rotation, &rotation);
+      graphene_matrix_init_from_matrix (filtered, pose);
+      return;
+    }
+
+  /* a second pose with the same timestamp only gets the prediction */
+  if (dt > 0.0)
+    {
+      self->last_time_us = time_us;
+      _filter_position (self, settings, dt, &position);
+      _filter_rotation (self, settings, dt, &rotation);
+    }
+
+  graphene_point3d_t predicted_position;
+  graphene_quaternion_t predicted_rotation;
+  float prediction_s = (float) (settings->prediction_ms / 1000.0);
+
+  graphene_vec3_t offset;
+  graphene_vec3_scale (&self->velocity, prediction_s, &offset);
+  graphene_vec3_add (&self->position, &offset, &offset);
+  graphene_point3d_init_from_vec3 (&predicted_position, &offset);
+
+  graphene_quaternion_t predicted_delta;
+  _rotation_from_vec3 (&self->angular_velocity, prediction_s,
+                       &predicted_delta);
+  _quaternion_multiply (&predicted_delta, &self->rotation,
+                        &predicted_rotation);
+
+  graphene_matrix_init_identity (filtered);
+  graphene_matrix_rotate_quaternion (filtered, &predicted_rotation);
+  graphene_matrix_translate (filtered, &predicted_position);
+}
@@ -0,0 +1,55 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_POSE_FILTER_H_
+#define XRD_POSE_FILTER_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib-object.h>
+#include <graphene.h>
+
+G_BEGIN_DECLS
+
+#define XRD_TYPE_POSE_FILTER xrd_pose_filter_get_type()
+G_DECLARE_FINAL_TYPE (XrdPoseFilter, xrd_pose_filter,
+                      XRD, POSE_FILTER, GObject)
+
+/**
+ * XrdPoseFilterSettings:
+ * @min_cutoff: The cutoff frequency in Hz when the controller is still.
+ * Lower values remove more jitter.
+ * @beta: How fast the cutoff frequency rises with speed.
+ * Higher values reduce lag during fast movements.
+ * @prediction_ms: How far the filtered pose is extrapolated into the future.
+ *
+ * Parameters of the One Euro filter shared by all controllers.
+ **/
+typedef struct {
+  double min_cutoff;
+  double beta;
+  double prediction_ms;
+} XrdPoseFilterSettings;
+
+XrdPoseFilter *
+xrd_pose_filter_new (void);
+
+void
+xrd_pose_filter_apply (XrdPoseFilter               *self,
+                       const XrdPoseFilterSettings *settings,
+                       gint64                       time_us,
+                       const graphene_matrix_t     *pose,
+                       graphene_matrix_t           *filtered);
+
+void
+xrd_pose_filter_reset (XrdPoseFilter *self);
+
+G_END_DECLS
+
+#endif /* XRD_POSE_FILTER_H_ */
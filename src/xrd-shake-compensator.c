@@ -6,19 +6,49 @@
  */
 
 #include "xrd-shake-compensator.h"
+
+#include <stdio.h>
+#include <math.h>
+
 #include "graphene-ext.h"
 #include "xrd-settings.h"
 
+/* Cursor positions kept for replaying the start of a drag */
+#define QUEUE_SIZE 128
+
+/* Fraction of the threshold a consistent movement needs for an early drag */
+#define EARLY_DRAG_FRACTION 0.5f
+
 struct _XrdShakeCompensator
 {
   GObject parent;
 
   gint64 last_press_time;
   int last_press_button;
-  GQueue *queue;
 
-  double threshold_percent;
-  int button_press_duration;
+  /* ring of cursor positions since the press, oldest first */
+  graphene_point_t queue[QUEUE_SIZE];
+  guint queue_start;
+  guint queue_length;
+
+  XrdShakeParams params;
+
+  /* Rolling statistics of the samples since the press. Cursor offsets are
+   * divided by the controller distance, so they are angles in radians
+   * and shaking is measured the same on near and far windows. */
+  guint n_samples;
+  graphene_point_t press_position;
+  graphene_point_t last_offset;
+  gint64 last_sample_time;
+  float max_deviation;
+  guint n_velocities;
+  double mean_velocity_x;
+  double mean_velocity_y;
+  double velocity_m2;
+
+  FILE *log;
+  gint64 log_press_time;
+  int log_press_button;
 };
 
 G_DEFINE_TYPE (XrdShakeCompensator, xrd_shake_compensator, G_TYPE_OBJECT)
@@ -37,14 +67,21 @@ xrd_shake_compensator_class_init (XrdShakeCompensatorClass *klass)
 static void
 xrd_shake_compensator_init (XrdShakeCompensator *self)
 {
-  self->queue = NULL;
+  self->log = NULL;
+  self->log_press_button = -1;
   xrd_shake_compensator_reset (self);
   xrd_settings_connect_and_apply (G_CALLBACK (xrd_settings_update_double_val),
                                   "shake-compensation-threshold",
-                                  &self->threshold_percent);
+                                  &self->params.threshold_percent);
   xrd_settings_connect_and_apply (G_CALLBACK (xrd_settings_update_int_val),
                                   "shake-compensation-duration-ms",
-                                  &self->button_press_duration);
+                                  &self->params.duration_ms);
+  xrd_settings_connect_and_apply (G_CALLBACK (xrd_settings_update_double_val),
+                                  "shake-compensation-consistency",
+                                  &self->params.consistency);
+  xrd_settings_connect_and_apply (G_CALLBACK (xrd_settings_update_int_val),
+                                  "shake-compensation-min-samples",
+                                  &self->params.min_samples);
 }
 
 XrdShakeCompensator *
@@ -58,6 +95,8 @@ xrd_shake_compensator_finalize (GObject *gobject)
 {
   XrdShakeCompensator *self = XRD_SHAKE_COMPENSATOR (gobject);
   xrd_shake_compensator_reset (self);
+  xrd_shake_compensator_close_log (self);
+  G_OBJECT_CLASS (xrd_shake_compensator_parent_class)->finalize (gobject);
 }
 
 void
@@ -66,82 +105,163 @@ xrd_shake_compensator_replay_move_queue (XrdShakeCompensator *self,
                                          guint move_cursor_event_signal,
                                          XrdWindow *hover_window)
 {
-  for (graphene_point_t *p = g_queue_pop_tail (self->queue); p != NULL;
-       p = g_queue_pop_tail (self->queue))
+  for (guint i = 0; i < self->queue_length; i++)
     {
-      // g_print ("Replay %f,%f\n", p->x, p->y);
+      graphene_point_t *p = &self->queue[(self->queue_start + i) % QUEUE_SIZE];
       XrdMoveCursorEvent *replay  =  g_malloc (sizeof (XrdMoveCursorEvent));
       replay->window = hover_window;
       replay->position = p;
       replay->ignore = FALSE;
       g_signal_emit (synth, move_cursor_event_signal, 0, replay);
 
-      g_free (p);
-
       /* we must not replay mouse move events too fast
        * or they will be dropped */
       g_usleep ((gulong)((1. / 10.) * G_USEC_PER_SEC / 1000.));
     }
-  self->queue = NULL;
+  self->queue_start = 0;
+  self->queue_length = 0;
 }
 
-gboolean
-xrd_shake_compensator_is_drag (XrdShakeCompensator *self,
-                               XrdWindow *window,
-                               graphene_matrix_t *controller_pose,
-                               graphene_point3d_t *intersection)
+static double
+_get_consistency (XrdShakeCompensator *self)
 {
-  gint64 now = g_get_monotonic_time ();
-  double ms_since_press = (now - self->last_press_time) / 1000.;
+  if (self->n_velocities < 2)
+    return 0;
 
+  double mean_sq = self->mean_velocity_x * self->mean_velocity_x +
+                   self->mean_velocity_y * self->mean_velocity_y;
+  double variance = self->velocity_m2 / (self->n_velocities - 1);
+
+  if (mean_sq + variance <= 0)
+    return 0;
+
+  /* 1 for a steady drag, around 0 for shaking back and forth */
+  return mean_sq / (mean_sq + variance);
+}
+
+static XrdShakeDecision
+_classify (XrdShakeCompensator *self, gint64 time_us)
+{
   /* we'll only be able to predict after a few movements*/
-  guint len = g_queue_get_length (self->queue);
-  if (len  < 2)
-    return FALSE;
+  if ((int) self->n_samples < self->params.min_samples)
+    return XRD_SHAKE_DECISION_UNDECIDED;
 
   /* if longer than a usual click, it will be a drag */
-  if ((int) ms_since_press > self->button_press_duration)
-    return TRUE;
+  if (time_us / 1000 > self->params.duration_ms)
+    return XRD_SHAKE_DECISION_DRAG;
 
+  float deviation_percent = self->max_deviation * 100.f;
+  float threshold = (float) self->params.threshold_percent;
 
-  graphene_point3d_t controller_point;
-  graphene_ext_matrix_get_translation_point3d (controller_pose,
-                                              &controller_point);
+  if (deviation_percent > threshold)
+    return XRD_SHAKE_DECISION_DRAG;
 
-  float window_controller_dist = graphene_point3d_distance (intersection,
-                                                            &controller_point,
-                                                            NULL);
+  /* A steady movement in one direction is not shaking, don't wait for it
+   * to cross the full threshold. */
+  if (deviation_percent > threshold * EARLY_DRAG_FRACTION &&
+      _get_consistency (self) > self->params.consistency)
+    return XRD_SHAKE_DECISION_DRAG;
 
-  float variance_meter = 0;
+  return XRD_SHAKE_DECISION_UNDECIDED;
+}
 
-  graphene_point_t *start = g_queue_peek_tail (self->queue);
+/**
+ * xrd_shake_compensator_add_sample:
+ * @self: The #XrdShakeCompensator
+ * @sample: The next cursor movement of the current press.
+ *
+ * Updates the rolling statistics of the current press and classifies it.
+ * Does not need a window or controller, so recorded sessions can be
+ * evaluated offline.
+ *
+ * Returns: The #XrdShakeDecision after this sample.
+ */
+XrdShakeDecision
+xrd_shake_compensator_add_sample (XrdShakeCompensator  *self,
+                                  const XrdShakeSample *sample)
+{
+  if (self->n_samples == 0)
+    graphene_point_init_from_point (&self->press_position, &sample->position);
+
+  float scale = sample->ppm * fmaxf (sample->distance, 0.01f);
+  graphene_point_t offset = {
+    .x = (sample->position.x - self->press_position.x) / scale,
+    .y = (sample->position.y - self->press_position.y) / scale,
+  };
+
+  float deviation = sqrtf (offset.x * offset.x + offset.y * offset.y);
+  self->max_deviation = fmaxf (self->max_deviation, deviation);
 
-  /* If we only base the prediction on variance, we can look at only the last
-   * mouse move since prediction happens on every mouse move.
-   */
-  graphene_point_t *p = g_queue_peek_head (self->queue);
+  double dt = (double) (sample->time_us - self->last_sample_time) /
+              G_USEC_PER_SEC;
+  if (self->n_samples > 0 && dt > 0)
+    {
+      /* Welford's online mean and variance */
+      double vx = (offset.x - self->last_offset.x) / dt;
+      double vy = (offset.y - self->last_offset.y) / dt;
+      self->n_velocities++;
+      double dx = vx - self->mean_velocity_x;
+      double dy = vy - self->mean_velocity_y;
+      self->mean_velocity_x += dx / self->n_velocities;
+      self->mean_velocity_y += dy / self->n_velocities;
+      self->velocity_m2 += dx * (vx - self->mean_velocity_x) +
+                           dy * (vy - self->mean_velocity_y);
+    }
 
-  float dist_pixel = graphene_point_distance (start, p, 0, 0);
+  self->n_samples++;
+  self->last_offset = offset;
+  self->last_sample_time = sample->time_us;
 
-  float dist_meter = dist_pixel / xrd_window_get_current_ppm (window);
+  return _classify (self, sample->time_us);
+}
 
-  variance_meter = fmaxf (dist_meter, variance_meter);
+gboolean
+xrd_shake_compensator_is_drag (XrdShakeCompensator *self,
+                               XrdWindow *window,
+                               graphene_matrix_t *controller_pose,
+                               graphene_point3d_t *intersection)
+{
+  if (self->queue_length == 0)
+    return FALSE;
 
-  /* Shaking should scale linearly with controller-window distance. */
-  float variance_percent = (variance_meter / window_controller_dist) * 100.f;
+  graphene_point3d_t controller_point;
+  graphene_ext_matrix_get_translation_point3d (controller_pose,
+                                              &controller_point);
 
-  if (variance_percent > (float) self->threshold_percent)
-    return TRUE;
+  guint newest = (self->queue_start + self->queue_length - 1) % QUEUE_SIZE;
+  XrdShakeSample sample = {
+    .time_us = g_get_monotonic_time () - self->last_press_time,
+    .position = self->queue[newest],
+    .ppm = xrd_window_get_current_ppm (window),
+    .distance = graphene_point3d_distance (intersection, &controller_point,
+                                           NULL),
+  };
+
+  return xrd_shake_compensator_add_sample (self, &sample) ==
+         XRD_SHAKE_DECISION_DRAG;
+}
 
-  return FALSE;
+static void
+_reset_statistics (XrdShakeCompensator *self)
+{
+  self->queue_start = 0;
+  self->queue_length = 0;
+  self->n_samples = 0;
+  graphene_point_init (&self->press_position, 0, 0);
+  graphene_point_init (&self->last_offset, 0, 0);
+  self->last_sample_time = 0;
+  self->max_deviation = 0;
+  self->n_velocities = 0;
+  self->mean_velocity_x = 0;
+  self->mean_velocity_y = 0;
+  self->velocity_m2 = 0;
 }
 
 void
 xrd_shake_compensator_start_recording (XrdShakeCompensator *self,
                                        int button)
 {
-  if (!self->queue)
-    self->queue = g_queue_new ();
+  _reset_statistics (self);
   self->last_press_button = button;
   self->last_press_time = g_get_monotonic_time ();
 }
@@ -149,14 +269,7 @@ xrd_shake_compensator_start_recording (XrdShakeCompensator *self,
 void
 xrd_shake_compensator_reset (XrdShakeCompensator *self)
 {
-  if (self->queue)
-    {
-      for (graphene_point_t *p = g_queue_pop_tail (self->queue); p != NULL;
-           p = g_queue_pop_tail (self->queue))
-        g_free (p);
-    }
-  self->queue = NULL;
-
+  _reset_statistics (self);
   self->last_press_button = -1;
   self->last_press_time = 0;
 }
@@ -177,7 +290,123 @@ void
 xrd_shake_compensator_record (XrdShakeCompensator *self,
                               graphene_point_t *position)
 {
-  graphene_point_t *p = g_malloc (sizeof (graphene_point_t));
-  graphene_point_init_from_point (p, position);
-  g_queue_push_head (self->queue, p);
+  /* when full, the oldest positions are not replayed */
+  if (self->queue_length == QUEUE_SIZE)
+    {
+      self->queue_start = (self->queue_start + 1) % QUEUE_SIZE;
+      self->queue_length--;
+    }
+
+  guint i = (self->queue_start + self->queue_length) % QUEUE_SIZE;
+  graphene_point_init_from_point (&self->queue[i], position);
+  self->queue_length++;
+}
+
+void
+xrd_shake_compensator_get_params (XrdShakeCompensator *self,
+                                  XrdShakeParams      *params)
+{
+  *params = self->params;
+}
+
+/**
+ * xrd_shake_compensator_set_params:
+ * @self: The #XrdShakeCompensator
+ * @params: The new #XrdShakeParams.
+ *
+ * Overrides the parameters from the settings until they change.
+ */
+void
+xrd_shake_compensator_set_params (XrdShakeCompensator  *self,
+                                  const XrdShakeParams *params)
+{
+  self->params = *params;
+}
+
+/**
+ * xrd_shake_compensator_open_log:
+ * @self: The #XrdShakeCompensator
+ * @path: The file to write the session to.
+ * @label: What the user was asked to do, "click" or "drag".
+ *
+ * Logs every press, with all cursor movements until its release, to a
+ * text file for tuning #XrdShakeParams offline with the shake-eval
+ * example. Logging is independent of whether compensation is enabled.
+ *
+ * Returns: %FALSE if the file could not be opened.
+ */
+gboolean
+xrd_shake_compensator_open_log (XrdShakeCompensator *self,
+                                const gchar         *path,
+                                const gchar         *label)
+{
+  xrd_shake_compensator_close_log (self);
+
+  self->log = fopen (path, "w");
+  if (self->log == NULL)
+    {
+      g_printerr ("Could not open shake log %s\n", path);
+      return FALSE;
+    }
+
+  fprintf (self->log, "xrdesktop-shake-log 1\nlabel %s\n", label);
+  return TRUE;
+}
+
+void
+xrd_shake_compensator_close_log (XrdShakeCompensator *self)
+{
+  if (self->log == NULL)
+    return;
+
+  fclose (self->log);
+  self->log = NULL;
+  self->log_press_button = -1;
+}
+
+void
+xrd_shake_compensator_log_press (XrdShakeCompensator *self,
+                                 int                  button)
+{
+  if (self->log == NULL || self->log_press_button != -1)
+    return;
+
+  self->log_press_button = button;
+  self->log_press_time = g_get_monotonic_time ();
+  fprintf (self->log, "press %d\n", button);
+}
+
+void
+xrd_shake_compensator_log_sample (XrdShakeCompensator *self,
+                                  XrdWindow           *window,
+                                  graphene_matrix_t   *controller_pose,
+                                  graphene_point3d_t  *intersection,
+                                  graphene_point_t    *position)
+{
+  if (self->log == NULL || self->log_press_button == -1)
+    return;
+
+  graphene_point3d_t controller_point;
+  graphene_ext_matrix_get_translation_point3d (controller_pose,
+                                              &controller_point);
+
+  fprintf (self->log, "sample %" G_GINT64_FORMAT " %f %f %f %f\n",
+           g_get_monotonic_time () - self->log_press_time,
+           (double) position->x, (double) position->y,
+           (double) xrd_window_get_current_ppm (window),
+           (double) graphene_point3d_distance (intersection,
+                                               &controller_point, NULL));
+}
+
+void
+xrd_shake_compensator_log_release (XrdShakeCompensator *self,
+                                   int                  button)
+{
+  if (self->log == NULL || self->log_press_button != button)
+    return;
+
+  fprintf (self->log, "release %" G_GINT64_FORMAT "\n",
+           g_get_monotonic_time () - self->log_press_time);
+  fflush (self->log);
+  self->log_press_button = -1;
 }
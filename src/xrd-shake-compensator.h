@@ -21,6 +21,54 @@ G_BEGIN_DECLS
 #define XRD_TYPE_SHAKE_COMPENSATOR xrd_shake_compensator_get_type()
 G_DECLARE_FINAL_TYPE (XrdShakeCompensator, xrd_shake_compensator, XRD, SHAKE_COMPENSATOR, GObject)
 
+/**
+ * XrdShakeDecision:
+ * @XRD_SHAKE_DECISION_UNDECIDED: The movement so far could still be shaking.
+ * @XRD_SHAKE_DECISION_DRAG: The movement is intentional, the press is a drag.
+ *
+ * A press that is released while undecided is a click.
+ **/
+typedef enum {
+  XRD_SHAKE_DECISION_UNDECIDED,
+  XRD_SHAKE_DECISION_DRAG
+} XrdShakeDecision;
+
+/**
+ * XrdShakeSample:
+ * @time_us: Time since the button press in microseconds.
+ * @position: The cursor position on the window in pixels.
+ * @ppm: Pixels per meter of the window.
+ * @distance: Distance between controller and cursor in meters.
+ *
+ * One cursor movement during a button press.
+ **/
+typedef struct {
+  gint64           time_us;
+  graphene_point_t position;
+  float            ppm;
+  float            distance;
+} XrdShakeSample;
+
+/**
+ * XrdShakeParams:
+ * @threshold_percent: Cursor deviation from the press position that is
+ * always a drag, in percent of the controller distance.
+ * @duration_ms: Presses longer than this are always drags.
+ * @consistency: From 0 to 1. When the cursor moved at least half of
+ * @threshold_percent and the ratio of mean velocity to velocity spread is
+ * higher than this, the press is decided to be a drag early.
+ * @min_samples: Minimum number of samples before deciding.
+ *
+ * Tuning of the shake classifier. The defaults come from the
+ * "shake-compensation-*" settings.
+ **/
+typedef struct {
+  double threshold_percent;
+  int    duration_ms;
+  double consistency;
+  int    min_samples;
+} XrdShakeParams;
+
 XrdShakeCompensator *xrd_shake_compensator_new (void);
 
 void
@@ -35,6 +83,10 @@ xrd_shake_compensator_is_drag (XrdShakeCompensator *self,
                                graphene_matrix_t *controller_pose,
                                graphene_point3d_t *intersection);
 
+XrdShakeDecision
+xrd_shake_compensator_add_sample (XrdShakeCompensator  *self,
+                                  const XrdShakeSample *sample);
+
 void
 xrd_shake_compensator_start_recording (XrdShakeCompensator *self,
                                        int button);
@@ -52,6 +104,37 @@ void
 xrd_shake_compensator_record (XrdShakeCompensator *self,
                               graphene_point_t *position);
 
+void
+xrd_shake_compensator_get_params (XrdShakeCompensator *self,
+                                  XrdShakeParams      *params);
+
+void
+xrd_shake_compensator_set_params (XrdShakeCompensator  *self,
+                                  const XrdShakeParams *params);
+
+gboolean
+xrd_shake_compensator_open_log (XrdShakeCompensator *self,
+                                const gchar         *path,
+                                const gchar         *label);
+
+void
+xrd_shake_compensator_close_log (XrdShakeCompensator *self);
+
+void
+xrd_shake_compensator_log_press (XrdShakeCompensator *self,
+                                 int                  button);
+
+void
+xrd_shake_compensator_log_sample (XrdShakeCompensator *self,
+                                  XrdWindow           *window,
+                                  graphene_matrix_t   *controller_pose,
+                                  graphene_point3d_t  *intersection,
+                                  graphene_point_t    *position);
+
+void
+xrd_shake_compensator_log_release (XrdShakeCompensator *self,
+                                   int                  button);
+
 G_END_DECLS
 
 #endif /* XRD_SHAKE_COMPENSATOR_H_ */
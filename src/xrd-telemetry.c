@@ -0,0 +1,253 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "xrd-telemetry.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* The last TRACE_EVENT_COUNT timings are kept for the Chrome trace. */
+#define TRACE_EVENT_COUNT (1 << 16)
+
+typedef struct {
+  gint64 start;
+  gint32 duration_us;
+  guint8 timer;
+} XrdTelemetryEvent;
+
+static const gchar *timer_names[XRD_TELEMETRY_TIMER_COUNT] = {
+  [XRD_TELEMETRY_POLL_INPUT] = "poll-input",
+  [XRD_TELEMETRY_POLL_INTERVAL] = "poll-interval",
+  [XRD_TELEMETRY_HOVER] = "hover",
+  [XRD_TELEMETRY_DRAG] = "drag",
+  [XRD_TELEMETRY_RENDER] = "render",
+  [XRD_TELEMETRY_SUBMIT_TEXTURE] = "submit-texture",
+  [XRD_TELEMETRY_DEPTH_PASS] = "depth-pass",
+  [XRD_TELEMETRY_ACTION_HAND_POSE] = "action-hand-pose",
+  [XRD_TELEMETRY_ACTION_HAND_POSE_HAND_GRIP] = "action-hand-pose-hand-grip",
+  [XRD_TELEMETRY_ACTION_GRAB] = "action-grab-window",
+  [XRD_TELEMETRY_ACTION_RESET_ORIENTATION] = "action-reset-orientation",
+  [XRD_TELEMETRY_ACTION_MENU] = "action-menu",
+  [XRD_TELEMETRY_ACTION_SHOW_KEYBOARD] = "action-show-keyboard",
+  [XRD_TELEMETRY_ACTION_PUSH_PULL_SCALE] = "action-push-pull-scale",
+  [XRD_TELEMETRY_ACTION_PUSH_PULL] = "action-push-pull",
+};
+
+/* Only accessed from the main loop. All storage is allocated when
+ * telemetry is enabled, nothing is allocated while recording. */
+static gboolean telemetry_enabled = FALSE;
+static XrdTelemetryHistogram histograms[XRD_TELEMETRY_TIMER_COUNT];
+static XrdTelemetryEvent *events = NULL;
+static guint64 events_written = 0;
+
+/**
+ * xrd_telemetry_set_enabled:
+ * @enabled: Whether timings should be recorded.
+ *
+ * While disabled, xrd_telemetry_begin() and xrd_telemetry_end() only
+ * check a flag.
+ */
+void
+xrd_telemetry_set_enabled (gboolean enabled)
+{
+  if (enabled && events == NULL)
+    {
+      events = g_malloc0 (sizeof (XrdTelemetryEvent) * TRACE_EVENT_COUNT);
+      xrd_telemetry_reset ();
+    }
+  telemetry_enabled = enabled;
+}
+
+gboolean
+xrd_telemetry_is_enabled (void)
+{
+  return telemetry_enabled;
+}
+
+/**
+ * xrd_telemetry_begin:
+ *
+ * Returns: The start timestamp to pass to xrd_telemetry_end(),
+ * 0 when telemetry is disabled.
+ */
+gint64
+xrd_telemetry_begin (void)
+{
+  if (!telemetry_enabled)
+    return 0;
+  return g_get_monotonic_time ();
+}
+
+void
+xrd_telemetry_end (XrdTelemetryTimer timer,
+                   gint64            start)
+{
+  if (!telemetry_enabled || start == 0)
+    return;
+  xrd_telemetry_record (timer, start, g_get_monotonic_time () - start);
+}
+
+static guint
+_get_bucket (gint64 duration_us)
+{
+  guint bucket = 0;
+  while (duration_us > 1 && bucket < XRD_TELEMETRY_BUCKETS - 1)
+    {
+      duration_us >>= 1;
+      bucket++;
+    }
+  return bucket;
+}
+
+/**
+ * xrd_telemetry_record:
+ * @timer: The #XrdTelemetryTimer
+ * @start: The monotonic time the measured span started at.
+ * @duration_us: The length of the span.
+ *
+ * Records a span that was not measured with xrd_telemetry_begin(),
+ * e.g. intervals between two events.
+ */
+void
+xrd_telemetry_record (XrdTelemetryTimer timer,
+                      gint64            start,
+                      gint64            duration_us)
+{
+  if (!telemetry_enabled)
+    return;
+
+  XrdTelemetryHistogram *histogram = &histograms[timer];
+  if (histogram->count == 0 || duration_us < histogram->min_us)
+    histogram->min_us = duration_us;
+  if (duration_us > histogram->max_us)
+    histogram->max_us = duration_us;
+  histogram->count++;
+  histogram->total_us += duration_us;
+  histogram->buckets[_get_bucket (duration_us)]++;
+
+  XrdTelemetryEvent *event = &events[events_written % TRACE_EVENT_COUNT];
+  event->start = start;
+  event->duration_us = (gint32) MIN (duration_us, G_MAXINT32);
+  event->timer = (guint8) timer;
+  events_written++;
+}
+
+void
+xrd_telemetry_get_histogram (XrdTelemetryTimer      timer,
+                             XrdTelemetryHistogram *histogram)
+{
+  *histogram = histograms[timer];
+}
+
+/**
+ * xrd_telemetry_get_percentile:
+ * @timer: The #XrdTelemetryTimer
+ * @percentile: The percentile, between 0 and 100.
+ *
+ * Returns: An upper bound of the percentile in microseconds, limited by the
+ * bucket resolution and the longest sample. 0 if there are no samples.
+ */
+gint64
+xrd_telemetry_get_percentile (XrdTelemetryTimer timer,
+                              float             percentile)
+{
+  XrdTelemetryHistogram *histogram = &histograms[timer];
+  if (histogram->count == 0)
+    return 0;
+
+  guint64 rank = (guint64) ((double) percentile / 100.0 *
+                            (double) histogram->count);
+  guint64 seen = 0;
+  for (guint i = 0; i < XRD_TELEMETRY_BUCKETS; i++)
+    {
+      seen += histogram->buckets[i];
+      if (seen > rank || seen == histogram->count)
+        return MIN ((gint64) 1 << (i + 1), histogram->max_us);
+    }
+
+  return histogram->max_us;
+}
+
+const gchar *
+xrd_telemetry_timer_name (XrdTelemetryTimer timer)
+{
+  return timer_names[timer];
+}
+
+void
+xrd_telemetry_reset (void)
+{
+  memset (histograms, 0, sizeof (histograms));
+  events_written = 0;
+}
+
+void
+xrd_telemetry_print_summary (void)
+{
+  for (int i = 0; i < XRD_TELEMETRY_TIMER_COUNT; i++)
+    {
+      XrdTelemetryHistogram *histogram = &histograms[i];
+      if (histogram->count == 0)
+        continue;
+
+      g_print ("%-16s %8" G_GUINT64_FORMAT " samples, mean %8.1f us, "
+               "p50 < %6" G_GINT64_FORMAT " us, "
+               "p99 < %6" G_GINT64_FORMAT " us, "
+               "max %6" G_GINT64_FORMAT " us\n",
+               timer_names[i], histogram->count,
+               (double) histogram->total_us / (double) histogram->count,
+               xrd_telemetry_get_percentile (i, 50.f),
+               xrd_telemetry_get_percentile (i, 99.f),
+               histogram->max_us);
+    }
+}
+
+/**
+ * xrd_telemetry_write_chrome_trace:
+ * @path: The JSON file to write.
+ *
+ * Writes the most recent timings in the Chrome trace event format, which can
+ * be loaded in chrome://tracing or Perfetto.
+ *
+ * Returns: %TRUE if the trace was written.
+ */
+gboolean
+xrd_telemetry_write_chrome_trace (const gchar *path)
+{
+  FILE *file = fopen (path, "w");
+  if (!file)
+    {
+      g_printerr ("Unable to open %s for writing.\n", path);
+      return FALSE;
+    }
+
+  guint64 first = 0;
+  if (events_written > TRACE_EVENT_COUNT)
+    first = events_written - TRACE_EVENT_COUNT;
+
+  fprintf (file, "{\"traceEvents\":[\n");
+  for (guint64 i = first; i < events_written; i++)
+    {
+      XrdTelemetryEvent *event = &events[i % TRACE_EVENT_COUNT];
+      fprintf (file,
+               "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT
+               ",\"dur\":%d,"
+               "\"pid\":1,\"tid\":%d}%s\n",
+               timer_names[event->timer], event->start, event->duration_us,
+               event->timer, i + 1 < events_written ? "," : "");
+    }
+  fprintf (file, "],\"displayTimeUnit\":\"ms\"}\n");
+
+  gboolean res = ferror (file) == 0;
+  if (fclose (file) != 0)
+    res = FALSE;
+
+  if (!res)
+    g_printerr ("Unable to write %s.\n", path);
+
+  return res;
+}
@@ -0,0 +1,128 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef XRD_TELEMETRY_H_
+#define XRD_TELEMETRY_H_
+
+#if !defined (XRD_INSIDE) && !defined (XRD_COMPILATION)
+#error "Only <xrd.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * XrdTelemetryTimer:
+ * @XRD_TELEMETRY_POLL_INPUT: Time spent in xrd_client_poll_input_events(),
+ * or in xrd_headless_client_step().
+ * @XRD_TELEMETRY_POLL_INTERVAL: Time between the starts of two input polls.
+ * @XRD_TELEMETRY_HOVER: Time spent resolving the hovered window of a pose.
+ * @XRD_TELEMETRY_DRAG: Time spent dragging a window with a pose.
+ * @XRD_TELEMETRY_RENDER: Time spent in xrd_scene_renderer_draw(), or from
+ * recording to presenting a frame in the render loop of #XrdSceneClient.
+ * @XRD_TELEMETRY_SUBMIT_TEXTURE: Time spent in xrd_window_submit_texture().
+ * @XRD_TELEMETRY_DEPTH_PASS: GPU time of the depth pass drawn for
+ * xrd_scene_renderer_set_submit_depth().
+ * @XRD_TELEMETRY_ACTION_HAND_POSE: Time spent handling a hand pose,
+ * including hover and drag.
+ * @XRD_TELEMETRY_ACTION_HAND_POSE_HAND_GRIP: Time spent handling a grip pose.
+ * @XRD_TELEMETRY_ACTION_GRAB: Time spent in the grab window action callback.
+ * @XRD_TELEMETRY_ACTION_RESET_ORIENTATION: Time spent in the reset
+ * orientation action callback.
+ * @XRD_TELEMETRY_ACTION_MENU: Time spent in the menu action callback.
+ * @XRD_TELEMETRY_ACTION_SHOW_KEYBOARD: Time spent in the show keyboard
+ * action callback.
+ * @XRD_TELEMETRY_ACTION_PUSH_PULL_SCALE: Time spent in the push pull scale
+ * action callback.
+ * @XRD_TELEMETRY_ACTION_PUSH_PULL: Time spent in the push pull action
+ * callback.
+ * @XRD_TELEMETRY_TIMER_COUNT: The number of timers.
+ *
+ * The code paths that are measured when telemetry is enabled.
+ **/
+typedef enum {
+  XRD_TELEMETRY_POLL_INPUT,
+  XRD_TELEMETRY_POLL_INTERVAL,
+  XRD_TELEMETRY_HOVER,
+  XRD_TELEMETRY_DRAG,
+  XRD_TELEMETRY_RENDER,
+  XRD_TELEMETRY_SUBMIT_TEXTURE,
+  XRD_TELEMETRY_DEPTH_PASS,
+  XRD_TELEMETRY_ACTION_HAND_POSE,
+  XRD_TELEMETRY_ACTION_HAND_POSE_HAND_GRIP,
+  XRD_TELEMETRY_ACTION_GRAB,
+  XRD_TELEMETRY_ACTION_RESET_ORIENTATION,
+  XRD_TELEMETRY_ACTION_MENU,
+  XRD_TELEMETRY_ACTION_SHOW_KEYBOARD,
+  XRD_TELEMETRY_ACTION_PUSH_PULL_SCALE,
+  XRD_TELEMETRY_ACTION_PUSH_PULL,
+  XRD_TELEMETRY_TIMER_COUNT
+} XrdTelemetryTimer;
+
+#define XRD_TELEMETRY_BUCKETS 24
+
+/**
+ * XrdTelemetryHistogram:
+ * @count: The number of samples.
+ * @total_us: The sum of all samples in microseconds.
+ * @min_us: The shortest sample in microseconds.
+ * @max_us: The longest sample in microseconds.
+ * @buckets: Sample counts, bucket i holds samples of [2^i, 2^(i+1)) us,
+ * bucket 0 also holds samples shorter than 1 us.
+ *
+ * A fixed-size log2 histogram of one #XrdTelemetryTimer.
+ **/
+typedef struct {
+  guint64 count;
+  gint64 total_us;
+  gint64 min_us;
+  gint64 max_us;
+  guint64 buckets[XRD_TELEMETRY_BUCKETS];
+} XrdTelemetryHistogram;
+
+void
+xrd_telemetry_set_enabled (gboolean enabled);
+
+gboolean
+xrd_telemetry_is_enabled (void);
+
+gint64
+xrd_telemetry_begin (void);
+
+void
+xrd_telemetry_end (XrdTelemetryTimer timer,
+                   gint64            start);
+
+void
+xrd_telemetry_record (XrdTelemetryTimer timer,
+                      gint64            start,
+                      gint64            duration_us);
+
+void
+xrd_telemetry_get_histogram (XrdTelemetryTimer      timer,
+                             XrdTelemetryHistogram *histogram);
+
+gint64
+xrd_telemetry_get_percentile (XrdTelemetryTimer timer,
+                              float             percentile);
+
+const gchar *
+xrd_telemetry_timer_name (XrdTelemetryTimer timer);
+
+void
+xrd_telemetry_reset (void);
+
+void
+xrd_telemetry_print_summary (void);
+
+gboolean
+xrd_telemetry_write_chrome_trace (const gchar *path);
+
+G_END_DECLS
+
+#endif /* XRD_TELEMETRY_H_ */
@@ -15,6 +15,7 @@
 #include "graphene-ext.h"
 
 #include "xrd-controller.h"
+#include "xrd-telemetry.h"
 
 struct _XrdWindowManager
 {
@@ -35,6 +36,9 @@ struct _XrdWindowManager
   gboolean controls_shown;
 
   XrdHoverMode hover_mode;
+
+  guint64 hover_tests;
+  guint64 hover_tests_skipped;
 };
 
 G_DEFINE_TYPE (XrdWindowManager, xrd_window_manager, G_TYPE_OBJECT)
@@ -73,6 +77,8 @@ xrd_window_manager_init (XrdWindowManager *self)
   self->destroy_windows = NULL;
   self->hoverable_windows = NULL;
   self->hover_mode = XRD_HOVER_MODE_EVERYTHING;
+  self->hover_tests = 0;
+  self->hover_tests_skipped = 0;
 
   /* TODO: possible steamvr issue: When input poll rate is high and buttons are
    * immediately hidden after creation, they may not reappear on show().
@@ -412,46 +418,110 @@ xrd_window_manager_remove_window (XrdWindowManager *self,
   g_object_unref (window);
 }
 
+static gboolean
+_is_hover_candidate (XrdWindowManager *self,
+                     XrdWindow        *window)
+{
+  if (!xrd_window_is_visible (window))
+    return FALSE;
+
+  if (self->hover_mode == XRD_HOVER_MODE_BUTTONS)
+    if (g_slist_find (self->buttons, window) == NULL)
+      return FALSE;
+
+  return TRUE;
+}
+
+/* A lower bound for the distance from @origin to any point of the window,
+ * using the sphere around the window rectangle. */
+static float
+_hover_distance_bound (XrdWindow          *window,
+                       graphene_point3d_t *origin)
+{
+  graphene_matrix_t transform;
+  xrd_window_get_transformation_no_scale (window, &transform);
+
+  graphene_point3d_t center;
+  graphene_ext_matrix_get_translation_point3d (&transform, &center);
+
+  float width = xrd_window_get_current_width_meters (window);
+  float height = xrd_window_get_current_height_meters (window);
+  float radius = sqrtf (width * width + height * height) / 2.0f;
+
+  return graphene_point3d_distance (origin, &center, NULL) - radius;
+}
+
+static void
+_test_window_hover (XrdWindowManager  *self,
+                    XrdWindow         *window,
+                    XrdPointer        *pointer,
+                    graphene_matrix_t *pose,
+                    XrdHoverEvent     *hover_event,
+                    XrdWindow        **closest)
+{
+  self->hover_tests++;
+
+  graphene_point3d_t intersection_point;
+  if (!xrd_window_intersects (window, pointer, pose, &intersection_point))
+    return;
+
+  float distance = xrd_math_point_matrix_distance (&intersection_point, pose);
+  if (distance < hover_event->distance)
+    {
+      *closest = window;
+      hover_event->distance = distance;
+      graphene_matrix_init_from_matrix (&hover_event->pose, pose);
+      graphene_point3d_init_from_point (&hover_event->point,
+                                        &intersection_point);
+    }
+}
+
 static void
 _test_hover (XrdWindowManager  *self,
              graphene_matrix_t *pose,
              XrdController     *controller)
 {
+  gint64 telemetry_start = xrd_telemetry_begin ();
+
   XrdHoverEvent *hover_event = g_malloc (sizeof (XrdHoverEvent));
   hover_event->distance = FLT_MAX;
 
   XrdWindow *closest = NULL;
 
   XrdPointer *pointer = xrd_controller_get_pointer (controller);
+  XrdHoverState *hover_state = xrd_controller_get_hover_state (controller);
+
+  /* The hovered window rarely changes between two poses. Testing it first
+   * gives a close hit that lets most other windows be skipped by their
+   * bounds without intersecting them. */
+  XrdWindow *previous = hover_state->window;
+  if (previous != NULL
+      && (g_slist_find (self->hoverable_windows, previous) == NULL
+          || !_is_hover_candidate (self, previous)))
+    previous = NULL;
+
+  if (previous != NULL)
+    _test_window_hover (self, previous, pointer, pose, hover_event, &closest);
+
+  graphene_point3d_t origin;
+  graphene_ext_matrix_get_translation_point3d (pose, &origin);
 
   for (GSList *l = self->hoverable_windows; l != NULL; l = l->next)
     {
       XrdWindow *window = (XrdWindow *) l->data;
 
-      if (!xrd_window_is_visible (window))
+      if (window == previous || !_is_hover_candidate (self, window))
         continue;
 
-      if (self->hover_mode == XRD_HOVER_MODE_BUTTONS)
-        if (g_slist_find (self->buttons, window) == NULL)
-          continue;
-
-      graphene_point3d_t intersection_point;
-      if (xrd_window_intersects (window, pointer, pose, &intersection_point))
+      if (closest != NULL
+          && _hover_distance_bound (window, &origin) >= hover_event->distance)
         {
-          float distance =
-            xrd_math_point_matrix_distance (&intersection_point, pose);
-          if (distance < hover_event->distance)
-            {
-              closest = window;
-              hover_event->distance = distance;
-              graphene_matrix_init_from_matrix (&hover_event->pose, pose);
-              graphene_point3d_init_from_point (&hover_event->point,
-                                                &intersection_point);
-            }
+          self->hover_tests_skipped++;
+          continue;
         }
-    }
 
-  XrdHoverState *hover_state = xrd_controller_get_hover_state (controller);
+      _test_window_hover (self, window, pointer, pose, hover_event, &closest);
+    }
 
   xrd_pointer_set_selected_window (pointer, closest);
 
@@ -515,6 +585,8 @@ _test_hover (XrdWindowManager  *self,
       graphene_matrix_init_from_matrix (&no_hover_event->pose, pose);
       g_signal_emit (self, manager_signals[NO_HOVER_EVENT], 0, no_hover_event);
     }
+
+  xrd_telemetry_end (XRD_TELEMETRY_HOVER, telemetry_start);
 }
 
 static void
@@ -523,6 +595,8 @@ _drag_window (XrdWindowManager  *self,
               XrdController     *controller)
 {
   (void) self;
+  gint64 telemetry_start = xrd_telemetry_begin ();
+
   XrdHoverState *hover_state = xrd_controller_get_hover_state (controller);
   XrdGrabState *grab_state = xrd_controller_get_grab_state (controller);
 
@@ -590,6 +664,8 @@ _drag_window (XrdWindowManager  *self,
 
   XrdPointer *pointer = xrd_controller_get_pointer (controller);
   xrd_pointer_set_selected_window (pointer, grab_state->window);
+
+  xrd_telemetry_end (XRD_TELEMETRY_DRAG, telemetry_start);
 }
 
 void
@@ -753,3 +829,22 @@ xrd_window_manager_get_hover_mode (XrdWindowManager *self)
 {
   return self->hover_mode;
 }
+
+/**
+ * xrd_window_manager_get_hover_stats:
+ * @self: The #XrdWindowManager
+ * @tested: (out) (optional): How many windows were intersected with a
+ * pointer ray.
+ * @skipped: (out) (optional): How many windows were skipped because they
+ * could not be closer than an already hovered window.
+ */
+void
+xrd_window_manager_get_hover_stats (XrdWindowManager *self,
+                                    guint64          *tested,
+                                    guint64          *skipped)
+{
+  if (tested)
+    *tested = self->hover_tests;
+  if (skipped)
+    *skipped = self->hover_tests_skipped;
+}
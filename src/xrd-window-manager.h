@@ -147,6 +147,11 @@ xrd_window_manager_set_hover_mode (XrdWindowManager *self,
 XrdHoverMode
 xrd_window_manager_get_hover_mode (XrdWindowManager *self);
 
+void
+xrd_window_manager_get_hover_stats (XrdWindowManager *self,
+                                    guint64          *tested,
+                                    guint64          *skipped);
+
 G_END_DECLS
 
 #endif /* XRD_WINDOW_MANAGER_H_ */
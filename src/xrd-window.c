@@ -7,8 +7,10 @@
 
 #include "xrd-window.h"
 #include <gdk/gdk.h>
+#include <math.h>
 
 #include "graphene-ext.h"
+#include "xrd-telemetry.h"
 
 #define SCALE_MIN_FACTOR .05f
 #define SCALE_MAX_FACTOR 15.f
@@ -201,24 +203,168 @@ xrd_window_default_init (XrdWindowInterface *iface)
   iface->windows_created = 0;
 }
 
+/* Windows with a deferred transformation, in the order they were first
+ * set during the batch. Only used from the main loop. */
+static GPtrArray *batch_windows = NULL;
+static guint batch_depth = 0;
+
+/**
+ * xrd_window_set_transformation:
+ * @self: The #XrdWindow
+ * @mat: The transformation.
+ *
+ * Between xrd_window_begin_transform_batch() and
+ * xrd_window_end_transform_batch() the transformation is only stored and
+ * applied once when the batch ends.
+ *
+ * Returns: %FALSE if the backend failed to apply the transformation.
+ */
 gboolean
 xrd_window_set_transformation (XrdWindow *self, graphene_matrix_t *mat)
 {
+  if (batch_depth > 0)
+    {
+      XrdWindowData *data = xrd_window_get_data (self);
+      graphene_matrix_init_from_matrix (&data->pending_transform, mat);
+      if (!data->transform_pending)
+        {
+          data->transform_pending = TRUE;
+          g_ptr_array_add (batch_windows, g_object_ref (self));
+        }
+      return TRUE;
+    }
+
   XrdWindowInterface* iface = XRD_WINDOW_GET_IFACE (self);
   return iface->set_transformation (self, mat);
 }
 
+/**
+ * xrd_window_begin_transform_batch:
+ *
+ * Defers xrd_window_set_transformation() until the matching
+ * xrd_window_end_transform_batch(), so a window that is moved several
+ * times, for example by a container and by its parent, is only updated
+ * in the backend once. Overlay windows do one runtime call per update.
+ * Batches can be nested, only the outermost one is flushed.
+ */
+void
+xrd_window_begin_transform_batch (void)
+{
+  if (batch_windows == NULL)
+    batch_windows = g_ptr_array_new_with_free_func (g_object_unref);
+  batch_depth++;
+}
+
+/**
+ * xrd_window_end_transform_batch:
+ *
+ * Applies the transformations that were set since
+ * xrd_window_begin_transform_batch().
+ */
+void
+xrd_window_end_transform_batch (void)
+{
+  g_return_if_fail (batch_depth > 0);
+
+  if (batch_depth > 1)
+    {
+      batch_depth--;
+      return;
+    }
+
+  /* Still batching: child windows updated by their parents are appended
+   * and flushed in this same pass. */
+  for (guint i = 0; i < batch_windows->len; i++)
+    {
+      XrdWindow *window = g_ptr_array_index (batch_windows, i);
+      XrdWindowData *data = xrd_window_get_data (window);
+      data->transform_pending = FALSE;
+
+      graphene_matrix_t mat;
+      graphene_matrix_init_from_matrix (&mat, &data->pending_transform);
+
+      XrdWindowInterface* iface = XRD_WINDOW_GET_IFACE (window);
+      iface->set_transformation (window, &mat);
+    }
+
+  g_ptr_array_set_size (batch_windows, 0);
+  batch_depth--;
+}
+
+/* The rigid part of the pending transformation, like the backends keep it */
+static void
+_get_pending_no_scale (XrdWindowData *data, graphene_matrix_t *mat)
+{
+  graphene_quaternion_t orientation;
+  graphene_ext_matrix_get_rotation_quaternion (&data->pending_transform,
+                                               &orientation);
+  graphene_point3d_t position;
+  graphene_ext_matrix_get_translation_point3d (&data->pending_transform,
+                                               &position);
+
+  graphene_matrix_init_identity (mat);
+  graphene_matrix_rotate_quaternion (mat, &orientation);
+  graphene_matrix_translate (mat, &position);
+}
+
+/**
+ * xrd_window_get_transformation:
+ * @self: The #XrdWindow
+ * @mat: (out): The transformation, including the scale of the window.
+ *
+ * During a transform batch, this is the transformation that will be
+ * applied when the batch ends.
+ *
+ * Returns: %FALSE if the backend could not provide the transformation.
+ */
 gboolean
 xrd_window_get_transformation (XrdWindow *self, graphene_matrix_t *mat)
 {
   XrdWindowInterface* iface = XRD_WINDOW_GET_IFACE (self);
-  return iface->get_transformation (self, mat);
+  if (!iface->get_transformation (self, mat))
+    return FALSE;
+
+  XrdWindowData *data = xrd_window_get_data (self);
+  if (!data->transform_pending)
+    return TRUE;
+
+  /* The scale is not part of the transformation set on the window */
+  graphene_vec3_t scale;
+  graphene_ext_matrix_get_scale (mat, &scale);
+
+  graphene_matrix_t no_scale;
+  _get_pending_no_scale (data, &no_scale);
+
+  graphene_matrix_t scale_mat;
+  graphene_matrix_init_scale (&scale_mat,
+                              graphene_vec3_get_x (&scale),
+                              graphene_vec3_get_y (&scale),
+                              graphene_vec3_get_z (&scale));
+  graphene_matrix_multiply (&scale_mat, &no_scale, mat);
+  return TRUE;
 }
 
+/**
+ * xrd_window_get_transformation_no_scale:
+ * @self: The #XrdWindow
+ * @mat: (out): The rotation and translation of the window.
+ *
+ * Like xrd_window_get_transformation(), returns the pending
+ * transformation during a transform batch.
+ *
+ * Returns: %FALSE if the backend could not provide the transformation.
+ */
 gboolean
 xrd_window_get_transformation_no_scale (XrdWindow         *self,
                                         graphene_matrix_t *mat)
 {
+  XrdWindowData *data = xrd_window_get_data (self);
+  if (data->transform_pending)
+    {
+      _get_pending_no_scale (data, mat);
+      return TRUE;
+    }
+
   XrdWindowInterface* iface = XRD_WINDOW_GET_IFACE (self);
   return iface->get_transformation_no_scale (self, mat);
 }
@@ -236,8 +382,12 @@ xrd_window_submit_texture (XrdWindow *self,
                            GulkanClient *client,
                            GulkanTexture *texture)
 {
+  gint64 telemetry_start = xrd_telemetry_begin ();
+
   XrdWindowInterface* iface = XRD_WINDOW_GET_IFACE (self);
   iface->submit_texture (self, client, texture);
+
+  xrd_telemetry_end (XRD_TELEMETRY_SUBMIT_TEXTURE, telemetry_start);
 }
 
 float
@@ -558,10 +708,56 @@ void
 xrd_window_set_flip_y (XrdWindow *self,
                        gboolean flip_y)
 {
+  XrdWindowData *data = xrd_window_get_data (self);
+  data->flip_y = flip_y;
+
   XrdWindowInterface* iface = XRD_WINDOW_GET_IFACE (self);
   iface->set_flip_y (self, flip_y);
 }
 
+/**
+ * xrd_window_set_uv_rect:
+ * @self: The #XrdWindow
+ * @rect: The normalized region of the texture to show, the whole texture is
+ * (0, 0, 1, 1).
+ *
+ * Lets several windows share one texture, for example an icon atlas.
+ * The flip of xrd_window_set_flip_y() applies inside of @rect.
+ */
+void
+xrd_window_set_uv_rect (XrdWindow             *self,
+                        const graphene_rect_t *rect)
+{
+  XrdWindowData *data = xrd_window_get_data (self);
+  graphene_rect_init_from_rect (&data->uv_rect, rect);
+
+  XrdWindowInterface* iface = XRD_WINDOW_GET_IFACE (self);
+  iface->set_uv_rect (self, rect);
+}
+
+/**
+ * xrd_window_get_shown_texture_size:
+ * @self: The #XrdWindow
+ * @texture: The texture submitted to @self.
+ * @width: (out): The width of the region of @texture @self shows.
+ * @height: (out): The height of the region of @texture @self shows.
+ *
+ * Window implementations use this for the texture-width and texture-height
+ * properties, so pixel coordinates are relative to the shown region.
+ */
+void
+xrd_window_get_shown_texture_size (XrdWindow     *self,
+                                   GulkanTexture *texture,
+                                   uint32_t      *width,
+                                   uint32_t      *height)
+{
+  XrdWindowData *data = xrd_window_get_data (self);
+  *width = (uint32_t) roundf ((float) gulkan_texture_get_width (texture) *
+                              data->uv_rect.size.width);
+  *height = (uint32_t) roundf ((float) gulkan_texture_get_height (texture) *
+                               data->uv_rect.size.height);
+}
+
 void
 xrd_window_show (XrdWindow *self)
 {
@@ -624,10 +820,9 @@ xrd_window_update_child (XrdWindow *self)
   graphene_matrix_t child_transform;
   graphene_matrix_init_translate (&child_transform, &scaled_offset3d);
 
-  graphene_matrix_t parent_transform;
-  xrd_window_get_transformation_no_scale (self, &parent_transform);
-
-  graphene_matrix_multiply (&child_transform, &parent_transform,
+  /* Backends store the rigid transform before updating the child, no need
+   * to query it back from the runtime. */
+  graphene_matrix_multiply (&child_transform, &data->transform,
                             &child_transform);
 
   xrd_window_set_transformation (XRD_WINDOW (child), &child_transform);
@@ -770,4 +965,56 @@ xrd_window_close (XrdWindow *self)
     g_string_free (data->title, TRUE);
   if (data->texture)
     g_object_unref (data->texture);
+  g_clear_object (&data->input_mask);
+}
+
+/**
+ * xrd_window_set_input_mask:
+ * @self: The #XrdWindow
+ * @mask: (transfer full) (nullable): The mask, %NULL makes the whole window
+ * receive input again.
+ *
+ * Restricts hover and click to the solid cells of @mask, so pointers pass
+ * through transparent regions like shadows to the windows behind.
+ */
+void
+xrd_window_set_input_mask (XrdWindow    *self,
+                           XrdInputMask *mask)
+{
+  XrdWindowData *data = xrd_window_get_data (self);
+  g_clear_object (&data->input_mask);
+  data->input_mask = mask;
+}
+
+/**
+ * xrd_window_get_input_mask:
+ * @self: The #XrdWindow
+ *
+ * Returns: (transfer none) (nullable): The input mask of the window.
+ */
+XrdInputMask *
+xrd_window_get_input_mask (XrdWindow *self)
+{
+  XrdWindowData *data = xrd_window_get_data (self);
+  return data->input_mask;
+}
+
+/**
+ * xrd_window_set_input_mask_from_pixbuf:
+ * @self: The #XrdWindow
+ * @pixbuf: The pixbuf that is uploaded as the window texture.
+ *
+ * Builds the input mask from the alpha channel of @pixbuf. Call it next to
+ * uploading the texture, reading the texture back from the GPU would stall.
+ * Pixbufs without alpha clear the mask.
+ */
+void
+xrd_window_set_input_mask_from_pixbuf (XrdWindow *self,
+                                       GdkPixbuf *pixbuf)
+{
+  XrdInputMask *mask =
+    xrd_input_mask_new_from_pixbuf (pixbuf,
+                                    XRD_INPUT_MASK_DEFAULT_CELLS,
+                                    XRD_INPUT_MASK_DEFAULT_ALPHA_THRESHOLD);
+  xrd_window_set_input_mask (self, mask);
 }
@@ -18,6 +18,7 @@
 #include <gulkan.h>
 
 #include "xrd-pointer.h"
+#include "xrd-input-mask.h"
 
 /**
  * XrdPixelSize:
@@ -90,6 +91,15 @@ G_DECLARE_INTERFACE (XrdWindow, xrd_window, XRD, WINDOW, GObject)
  * @reset_transform: The transformation that the window will be reset to.
  * @pinned: Whether the window will be visible in pinned only mode.
  * @texture: Cache of the currently rendered texture.
+ * @input_mask: Optional low resolution mask of the regions that receive
+ * input, %NULL if the whole window does.
+ * @flip_y: Whether the texture is shown upside down, see
+ * xrd_window_set_flip_y().
+ * @uv_rect: The normalized region of the texture the window shows, see
+ * xrd_window_set_uv_rect().
+ * @pending_transform: The transformation that is applied when the current
+ * transform batch ends.
+ * @transform_pending: Whether @pending_transform still has to be applied.
  * @xrd_window: A pointer to the #XrdWindow this XrdWindowData belongs to.
  * After switching the overlay/scene mode, it will point to a new #XrdWindow.
  *
@@ -120,6 +130,14 @@ typedef struct XrdWindowData {
 
   GulkanTexture *texture;
 
+  XrdInputMask *input_mask;
+
+  gboolean flip_y;
+  graphene_rect_t uv_rect;
+
+  graphene_matrix_t pending_transform;
+  gboolean transform_pending;
+
   XrdWindow *xrd_window;
 } XrdWindowData;
 
@@ -140,6 +158,7 @@ typedef struct XrdWindowData {
  * @add_child: Add a child window.
  * @set_color: Set a color that is multiplied to the texture.
  * @set_flip_y: Flip the y axis of the texture.
+ * @set_uv_rect: Show only a region of the texture.
  * @show: Show the window.
  * @hide: Hide the window.
  * @is_visible: Check if the window is currently visible.
@@ -200,6 +219,10 @@ struct _XrdWindowInterface
   (*set_flip_y) (XrdWindow *self,
                  gboolean flip_y);
 
+  void
+  (*set_uv_rect) (XrdWindow             *self,
+                  const graphene_rect_t *rect);
+
   void
   (*show) (XrdWindow *self);
 
@@ -224,6 +247,12 @@ xrd_window_set_transformation (XrdWindow *self, graphene_matrix_t *mat);
 gboolean
 xrd_window_get_transformation (XrdWindow *self, graphene_matrix_t *mat);
 
+void
+xrd_window_begin_transform_batch (void);
+
+void
+xrd_window_end_transform_batch (void);
+
 gboolean
 xrd_window_get_transformation_no_scale (XrdWindow         *self,
                                         graphene_matrix_t *mat);
@@ -298,6 +327,16 @@ void
 xrd_window_set_flip_y (XrdWindow *self,
                        gboolean flip_y);
 
+void
+xrd_window_set_uv_rect (XrdWindow             *self,
+                        const graphene_rect_t *rect);
+
+void
+xrd_window_get_shown_texture_size (XrdWindow     *self,
+                                   GulkanTexture *texture,
+                                   uint32_t      *width,
+                                   uint32_t      *height);
+
 float
 xrd_window_get_current_ppm (XrdWindow *self);
 
@@ -361,6 +400,17 @@ xrd_window_is_pinned (XrdWindow *self);
 void
 xrd_window_close (XrdWindow *self);
 
+void
+xrd_window_set_input_mask (XrdWindow    *self,
+                           XrdInputMask *mask);
+
+XrdInputMask *
+xrd_window_get_input_mask (XrdWindow *self);
+
+void
+xrd_window_set_input_mask_from_pixbuf (XrdWindow *self,
+                                       GdkPixbuf *pixbuf);
+
 G_END_DECLS
 
 #endif /* XRD_WINDOW_H_ */
@@ -16,8 +16,18 @@
 #include "xrd-button.h"
 #include "xrd-client.h"
 #include "xrd-desktop-cursor.h"
+#include "xrd-icon-atlas.h"
+#include "xrd-headless-client.h"
+#include "xrd-headless-pointer.h"
+#include "xrd-headless-pointer-tip.h"
+#include "xrd-headless-runtime.h"
+#include "xrd-headless-window.h"
 #include "xrd-container.h"
 #include "xrd-input-synth.h"
+#include "xrd-input-trace.h"
+#include "xrd-input-ring.h"
+#include "xrd-input-mask.h"
+#include "xrd-pose-filter.h"
 #include "xrd-math.h"
 #include "xrd-overlay-client.h"
 #include "xrd-overlay-desktop-cursor.h"
@@ -32,6 +42,8 @@
 #include "xrd-scene-desktop-cursor.h"
 #include "xrd-scene-device.h"
 #include "xrd-scene-device-manager.h"
+#include "xrd-scene-draw-order.h"
+#include "xrd-scene-mip-chain.h"
 #include "xrd-scene-model.h"
 #include "xrd-scene-object.h"
 #include "xrd-scene-pointer.h"
@@ -42,6 +54,7 @@
 #include "xrd-scene-window.h"
 #include "xrd-settings.h"
 #include "xrd-shake-compensator.h"
+#include "xrd-telemetry.h"
 #include "xrd-window.h"
 #include "xrd-window-manager.h"
 
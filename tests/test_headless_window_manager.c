@@ -0,0 +1,293 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <glib.h>
+
+#include "xrd-client.h"
+#include "xrd-headless-client.h"
+#include "xrd-headless-window.h"
+#include "xrd-headless-runtime.h"
+#include "xrd-scene-renderer.h"
+#include "xrd-scene-window.h"
+#include "xrd-telemetry.h"
+#include "graphene-ext.h"
+
+/*
+ * Feeds poses and grab actions from XrdHeadlessRuntime through the action
+ * callbacks of an XrdHeadlessClient, without an XR runtime. With a Vulkan
+ * device the client creates scene windows, which are drawn offscreen by
+ * the scene renderer during the same run.
+ */
+
+#define GRID_COLUMNS 8
+#define GRID_ROWS 5
+#define FRAMES 5000
+#define RENDER_INTERVAL 10
+
+typedef struct {
+  XrdClient *client;
+  graphene_matrix_t vp;
+} Example;
+
+static void
+_render_eye_cb (uint32_t         eye,
+                VkCommandBuffer  cmd_buffer,
+                VkPipelineLayout pipeline_layout,
+                VkPipeline      *pipelines,
+                gpointer         data)
+{
+  Example *self = data;
+  for (GSList *l = xrd_client_get_windows (self->client); l; l = l->next)
+    xrd_scene_window_draw (XRD_SCENE_WINDOW (l->data), eye,
+                           pipelines[PIPELINE_WINDOWS], pipeline_layout,
+                           cmd_buffer, &self->vp);
+}
+
+static void
+_add_windows (Example *self, GulkanTexture *texture)
+{
+  GulkanClient *uploader = xrd_client_get_uploader (self->client);
+
+  for (int row = 0; row < GRID_ROWS; row++)
+    for (int column = 0; column < GRID_COLUMNS; column++)
+      {
+        gchar *title = g_strdup_printf ("window %d %d", column, row);
+        XrdWindow *window =
+          xrd_client_window_new_from_meters (self->client, title,
+                                             0.5f, 0.3f, 450.f);
+        g_free (title);
+
+        if (uploader)
+          {
+            g_assert (XRD_IS_SCENE_WINDOW (window));
+            xrd_window_submit_texture (window, uploader, texture);
+          }
+        else
+          {
+            g_assert (XRD_IS_HEADLESS_WINDOW (window));
+          }
+
+        graphene_point3d_t position = {
+          .x = (column - GRID_COLUMNS / 2) * 0.6f,
+          .y = 0.2f + row * 0.4f,
+          .z = -2.f
+        };
+        graphene_matrix_t transform;
+        graphene_matrix_init_translate (&transform, &position);
+        xrd_window_set_transformation (window, &transform);
+
+        xrd_client_add_window (self->client, window, TRUE, NULL);
+        g_object_unref (window);
+      }
+}
+
+static XrdWindow *
+_get_grabbed_window (XrdClient *client)
+{
+  for (GSList *l = xrd_client_get_windows (client); l; l = l->next)
+    if (xrd_client_is_grabbed (client, l->data))
+      return l->data;
+  return NULL;
+}
+
+static void
+_test_client_input ()
+{
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  if (!xrd_scene_renderer_init_vulkan_simple (renderer))
+    {
+      g_print ("No Vulkan device, not rendering the windows.\n");
+      xrd_scene_renderer_destroy_instance ();
+      renderer = NULL;
+    }
+
+  GulkanTexture *texture = NULL;
+  if (renderer)
+    {
+      GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 64, 64);
+      gdk_pixbuf_fill (pixbuf, 0xffffffff);
+      texture =
+        gulkan_client_texture_new_from_pixbuf (GULKAN_CLIENT (renderer), pixbuf,
+                                               VK_FORMAT_R8G8B8A8_UNORM,
+                                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                               false);
+      g_object_unref (pixbuf);
+    }
+
+  XrdHeadlessRuntime *runtime = xrd_headless_runtime_new ();
+
+  Example self = {
+    .client = XRD_CLIENT (xrd_headless_client_new (runtime, renderer)),
+  };
+
+  _add_windows (&self, texture);
+  g_assert_cmpuint (g_slist_length (xrd_client_get_windows (self.client)), ==,
+                    GRID_COLUMNS * GRID_ROWS);
+
+  xrd_headless_runtime_connect_controller (runtime, 1);
+  xrd_headless_runtime_connect_controller (runtime, 2);
+  g_assert_cmpuint (
+    g_hash_table_size (xrd_client_get_controllers (self.client)), ==, 2);
+
+  /* Grab with both hands every second for half a second */
+  guint grab_actions = 0;
+  for (guint64 frame = 45; frame < FRAMES; frame += 90)
+    for (guint64 handle = 1; handle <= 2; handle++)
+      {
+        xrd_headless_runtime_queue_digital (runtime, frame, handle,
+                                            "grab_window", TRUE);
+        xrd_headless_runtime_queue_digital (runtime, frame + 45, handle,
+                                            "grab_window", FALSE);
+        grab_actions += frame + 45 < FRAMES ? 2 : 1;
+      }
+
+  if (renderer)
+    {
+      graphene_matrix_t hmd_pose, view, projection;
+      xrd_headless_runtime_get_hmd_pose (runtime, &hmd_pose);
+      graphene_matrix_inverse (&hmd_pose, &view);
+      graphene_matrix_init_perspective (&projection, 90.0f, 1.0f, 0.1f, 100.0f);
+      graphene_matrix_multiply (&view, &projection, &self.vp);
+      xrd_scene_renderer_set_render_cb (renderer, _render_eye_cb, &self);
+    }
+
+  guint hover_frames = 0;
+  guint grab_frames = 0;
+  guint drag_moves = 0;
+  guint draws = 0;
+
+  xrd_telemetry_reset ();
+  xrd_telemetry_set_enabled (TRUE);
+
+  for (guint i = 0; i < FRAMES; i++)
+    {
+      XrdWindow *grabbed = _get_grabbed_window (self.client);
+      graphene_matrix_t before;
+      graphene_matrix_init_identity (&before);
+      if (grabbed)
+        xrd_window_get_transformation (grabbed, &before);
+
+      xrd_headless_client_step (XRD_HEADLESS_CLIENT (self.client));
+
+      if (xrd_client_is_hovering (self.client))
+        hover_frames++;
+      if (xrd_client_is_grabbing (self.client))
+        grab_frames++;
+
+      /* A grabbed window follows the sweeping controller */
+      if (grabbed && xrd_client_is_grabbed (self.client, grabbed))
+        {
+          graphene_matrix_t after;
+          xrd_window_get_transformation (grabbed, &after);
+          if (!graphene_ext_matrix_equals (&before, &after))
+            drag_moves++;
+        }
+
+      if (renderer && i % RENDER_INTERVAL == 0)
+        {
+          g_assert (xrd_scene_renderer_draw (renderer));
+          draws++;
+        }
+    }
+
+  xrd_telemetry_set_enabled (FALSE);
+  xrd_telemetry_print_summary ();
+
+  g_print ("%d windows, %u frames: %u hovering, %u grabbing, "
+           "%u drag moves, %u draws\n",
+           GRID_COLUMNS * GRID_ROWS, FRAMES, hover_frames, grab_frames,
+           drag_moves, draws);
+
+  guint64 hover_tests, hover_tests_skipped;
+  xrd_window_manager_get_hover_stats (xrd_client_get_manager (self.client),
+                                      &hover_tests, &hover_tests_skipped);
+  g_print ("%" G_GUINT64_FORMAT " window hover tests, %" G_GUINT64_FORMAT
+           " skipped by bounds\n",
+           hover_tests, hover_tests_skipped);
+
+  g_assert (xrd_headless_runtime_get_frame (runtime) == FRAMES);
+  g_assert_cmpuint (hover_frames, >, 0);
+  g_assert_cmpuint (grab_frames, >, 0);
+  g_assert_cmpuint (drag_moves, >, 0);
+
+  /* Every pose and grab went through the client action callbacks */
+  XrdTelemetryHistogram hand_pose;
+  xrd_telemetry_get_histogram (XRD_TELEMETRY_ACTION_HAND_POSE, &hand_pose);
+  g_assert_cmpuint (hand_pose.count, ==, 2 * FRAMES);
+  XrdTelemetryHistogram grab;
+  xrd_telemetry_get_histogram (XRD_TELEMETRY_ACTION_GRAB, &grab);
+  g_assert_cmpuint (grab.count, ==, grab_actions);
+
+  XrdTelemetryHistogram hover;
+  xrd_telemetry_get_histogram (XRD_TELEMETRY_HOVER, &hover);
+  XrdTelemetryHistogram drag;
+  xrd_telemetry_get_histogram (XRD_TELEMETRY_DRAG, &drag);
+  g_assert_cmpuint (hover.count + drag.count, ==, 2 * FRAMES);
+  g_assert_cmpuint (drag.count, >, 0);
+
+  XrdTelemetryHistogram render;
+  xrd_telemetry_get_histogram (XRD_TELEMETRY_RENDER, &render);
+  g_assert_cmpuint (render.count, ==, draws);
+
+  if (renderer)
+    xrd_scene_renderer_set_render_cb (renderer, NULL, NULL);
+
+  xrd_headless_runtime_disconnect_controller (runtime, 2);
+  g_assert_cmpuint (
+    g_hash_table_size (xrd_client_get_controllers (self.client)), ==, 1);
+
+  g_object_unref (self.client);
+  g_object_unref (runtime);
+
+  if (renderer)
+    {
+      g_object_unref (texture);
+      xrd_scene_renderer_destroy_instance ();
+    }
+}
+
+/* Hover and drag read transformations set earlier in the same batch */
+static void
+_test_batch_getters ()
+{
+  XrdWindow *window = XRD_WINDOW (
+    xrd_headless_window_new_from_meters ("batch", 0.5f, 0.3f, 450.f));
+
+  graphene_matrix_t before;
+  xrd_window_get_transformation (window, &before);
+
+  xrd_window_begin_transform_batch ();
+
+  graphene_point3d_t position = { .x = 1.f, .y = 2.f, .z = -3.f };
+  graphene_matrix_t transform;
+  graphene_matrix_init_translate (&transform, &position);
+  xrd_window_set_transformation (window, &transform);
+
+  graphene_matrix_t pending, pending_no_scale;
+  xrd_window_get_transformation (window, &pending);
+  xrd_window_get_transformation_no_scale (window, &pending_no_scale);
+
+  xrd_window_end_transform_batch ();
+
+  graphene_matrix_t applied, applied_no_scale;
+  xrd_window_get_transformation (window, &applied);
+  xrd_window_get_transformation_no_scale (window, &applied_no_scale);
+
+  g_assert (!graphene_ext_matrix_equals (&pending, &before));
+  g_assert (graphene_ext_matrix_equals (&pending, &applied));
+  g_assert (graphene_ext_matrix_equals (&pending_no_scale, &applied_no_scale));
+
+  g_object_unref (window);
+}
+
+int
+main ()
+{
+  _test_batch_getters ();
+  _test_client_input ();
+  return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Lubosz Sarnecki <lubosz.sarnecki@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "xrd-button.h"
+#include "xrd-scene-renderer.h"
+#include "xrd-scene-window.h"
+
+typedef struct {
+  XrdSceneWindow *buttons[2];
+  graphene_matrix_t vp;
+} AtlasTest;
+
+static void
+_render_eye_cb (uint32_t         eye,
+                VkCommandBuffer  cmd_buffer,
+                VkPipelineLayout pipeline_layout,
+                VkPipeline      *pipelines,
+                gpointer         data)
+{
+  AtlasTest *test = data;
+  for (guint i = 0; i < G_N_ELEMENTS (test->buttons); i++)
+    xrd_scene_window_draw (test->buttons[i], eye, pipelines[PIPELINE_WINDOWS],
+                           pipeline_layout, cmd_buffer, &test->vp);
+}
+
+static XrdSceneWindow *
+_create_button (const gchar *title, float x)
+{
+  /* 64x64 pixels */
+  XrdSceneWindow *button =
+    xrd_scene_window_new_from_meters (title, 0.1f, 0.1f, 640.0f);
+  xrd_scene_window_initialize (button);
+
+  graphene_point3d_t position;
+  graphene_point3d_init (&position, x, 0, -1.0f);
+  graphene_matrix_t transform;
+  graphene_matrix_init_translate (&transform, &position);
+  xrd_window_set_transformation (XRD_WINDOW (button), &transform);
+
+  return button;
+}
+
+/*
+ * Two icon buttons of the same size sample the same atlas texture, each
+ * from its own tile, and the atlas is written to the cache.
+ */
+static void
+_test_shared_texture ()
+{
+  /* Before anything reads the cache dir, GLib only looks it up once */
+  gchar *cache_dir = g_dir_make_tmp ("xrd-icon-atlas-XXXXXX", NULL);
+  g_assert (cache_dir != NULL);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  if (!xrd_scene_renderer_init_vulkan_simple (renderer))
+    {
+      g_print ("No Vulkan device, not testing the icon atlas.\n");
+      xrd_scene_renderer_destroy_instance ();
+      g_rmdir (cache_dir);
+      g_free (cache_dir);
+      return;
+    }
+
+  GulkanClient *gc = GULKAN_CLIENT (renderer);
+  VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+  AtlasTest test;
+  test.buttons[0] = _create_button ("undo", -0.1f);
+  test.buttons[1] = _create_button ("pin", 0.1f);
+
+  xrd_button_set_icon (XRD_WINDOW (test.buttons[0]), gc, layout,
+                       "/icons/edit-undo-symbolic.svg");
+  xrd_button_set_icon (XRD_WINDOW (test.buttons[1]), gc, layout,
+                       "/icons/view-pin-symbolic.svg");
+
+  XrdWindowData *undo = xrd_window_get_data (XRD_WINDOW (test.buttons[0]));
+  XrdWindowData *pin = xrd_window_get_data (XRD_WINDOW (test.buttons[1]));
+
+  g_assert (undo->texture != NULL);
+  g_assert (undo->texture == pin->texture);
+  g_assert (!graphene_rect_equal (&undo->uv_rect, &pin->uv_rect));
+
+  graphene_rect_t whole;
+  graphene_rect_init (&whole, 0.f, 0.f, 1.f, 1.f);
+  g_assert (graphene_rect_contains_rect (&whole, &undo->uv_rect));
+  g_assert (graphene_rect_contains_rect (&whole, &pin->uv_rect));
+
+  graphene_rect_t overlap;
+  g_assert (!graphene_rect_intersection (&undo->uv_rect, &pin->uv_rect,
+                                         &overlap));
+
+  /* Pixel coordinates are relative to the tile */
+  g_assert_cmpuint (undo->texture_width, ==, pin->texture_width);
+  g_assert_cmpuint (undo->texture_width, <,
+                    gulkan_texture_get_width (undo->texture));
+  g_assert_cmpuint (undo->texture_width, ==, undo->texture_height);
+
+  gchar *cache_file = g_build_filename (cache_dir, "xrdesktop",
+                                        "icons-64.argb", NULL);
+  g_assert (g_file_test (cache_file, G_FILE_TEST_EXISTS));
+
+  graphene_matrix_init_perspective (&test.vp, 90.0f, 1.0f, 0.1f, 100.0f);
+  xrd_scene_renderer_set_render_cb (renderer, _render_eye_cb, &test);
+  g_assert (xrd_scene_renderer_draw (renderer));
+
+  /* A text label gets a texture of its own, shown whole */
+  gchar *label[] = { "Label" };
+  xrd_button_set_text (XRD_WINDOW (test.buttons[1]), gc, layout, 1, label);
+  g_assert (pin->texture != undo->texture);
+  g_assert (graphene_rect_equal (&pin->uv_rect, &whole));
+
+  g_assert (xrd_scene_renderer_draw (renderer));
+  xrd_scene_renderer_set_render_cb (renderer, NULL, NULL);
+
+  for (guint i = 0; i < G_N_ELEMENTS (test.buttons); i++)
+    g_object_unref (test.buttons[i]);
+
+  xrd_scene_renderer_destroy_instance ();
+
+  g_remove (cache_file);
+  gchar *xrd_cache_dir = g_path_get_dirname (cache_file);
+  g_rmdir (xrd_cache_dir);
+  g_rmdir (cache_dir);
+
+  g_free (xrd_cache_dir);
+  g_free (cache_file);
+  g_free (cache_dir);
+}
+
+int
+main ()
+{
+  _test_shared_texture ();
+  return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <glib.h>
+
+#include "xrd-input-mask.h"
+#include "xrd-headless-window.h"
+#include "xrd-headless-pointer.h"
+
+/* Opaque left half, transparent right half. */
+static GdkPixbuf *
+_create_half_pixbuf (int width, int height)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8,
+                                      width, height);
+  gdk_pixbuf_fill (pixbuf, 0x00000000);
+
+  guchar *pixels = gdk_pixbuf_get_pixels (pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  for (int y = 0; y < height; y++)
+    for (int x = 0; x < width / 2; x++)
+      pixels[y * rowstride + x * 4 + 3] = 0xff;
+
+  return pixbuf;
+}
+
+static void
+_test_downsample ()
+{
+  GdkPixbuf *pixbuf = _create_half_pixbuf (1000, 500);
+  XrdInputMask *mask =
+    xrd_input_mask_new_from_pixbuf (pixbuf, 64,
+                                    XRD_INPUT_MASK_DEFAULT_ALPHA_THRESHOLD);
+  g_assert (mask);
+  g_assert_cmpuint (xrd_input_mask_get_width (mask), ==, 64);
+  g_assert_cmpuint (xrd_input_mask_get_height (mask), ==, 32);
+
+  g_assert (xrd_input_mask_test (mask, 0.0f, 0.0f));
+  g_assert (xrd_input_mask_test (mask, 0.49f, 1.0f));
+  g_assert (!xrd_input_mask_test (mask, 0.51f, 0.5f));
+  g_assert (!xrd_input_mask_test (mask, 1.0f, 1.0f));
+  g_assert (!xrd_input_mask_test (mask, -0.1f, 0.5f));
+
+  xrd_input_mask_set (mask, 63, 31, TRUE);
+  g_assert (xrd_input_mask_test (mask, 1.0f, 1.0f));
+
+  g_object_unref (mask);
+  g_object_unref (pixbuf);
+
+  GdkPixbuf *opaque = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 16, 16);
+  g_assert_null (xrd_input_mask_new_from_pixbuf (opaque, 64, 0));
+  g_object_unref (opaque);
+}
+
+/* Opaque top half, transparent bottom half. */
+static GdkPixbuf *
+_create_top_pixbuf (int width, int height)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8,
+                                      width, height);
+  gdk_pixbuf_fill (pixbuf, 0x00000000);
+
+  guchar *pixels = gdk_pixbuf_get_pixels (pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  for (int y = 0; y < height / 2; y++)
+    for (int x = 0; x < width; x++)
+      pixels[y * rowstride + x * 4 + 3] = 0xff;
+
+  return pixbuf;
+}
+
+static gboolean
+_hits (XrdWindow *window, XrdPointer *pointer, float x, float y)
+{
+  graphene_point3d_t position = { .x = x, .y = y, .z = 0.f };
+  graphene_matrix_t pose;
+  graphene_matrix_init_translate (&pose, &position);
+  xrd_pointer_move (pointer, &pose);
+
+  graphene_point3d_t intersection;
+  return xrd_window_intersects (window, pointer, &pose, &intersection);
+}
+
+static void
+_test_pointer ()
+{
+  XrdHeadlessWindow *headless =
+    xrd_headless_window_new_from_meters ("mask", 1.0f, 1.0f, 100.f);
+  XrdWindow *window = XRD_WINDOW (headless);
+
+  graphene_point3d_t position = { .x = 0.f, .y = 0.f, .z = -2.f };
+  graphene_matrix_t transform;
+  graphene_matrix_init_translate (&transform, &position);
+  xrd_window_set_transformation (window, &transform);
+
+  XrdPointer *pointer = XRD_POINTER (xrd_headless_pointer_new ());
+
+  g_assert (_hits (window, pointer, -0.25f, 0.f));
+  g_assert (_hits (window, pointer, 0.25f, 0.f));
+
+  GdkPixbuf *pixbuf = _create_half_pixbuf (100, 100);
+  xrd_window_set_input_mask_from_pixbuf (window, pixbuf);
+  g_object_unref (pixbuf);
+  g_assert (xrd_window_get_input_mask (window));
+
+  g_assert (_hits (window, pointer, -0.25f, 0.f));
+  g_assert (!_hits (window, pointer, 0.25f, 0.f));
+
+  xrd_window_set_input_mask (window, NULL);
+  g_assert (_hits (window, pointer, 0.25f, 0.f));
+
+  /* A flipped window shows the top rows of the mask at the bottom */
+  pixbuf = _create_top_pixbuf (100, 100);
+  xrd_window_set_input_mask_from_pixbuf (window, pixbuf);
+  g_object_unref (pixbuf);
+
+  g_assert (_hits (window, pointer, 0.f, 0.25f));
+  g_assert (!_hits (window, pointer, 0.f, -0.25f));
+
+  xrd_window_set_flip_y (window, TRUE);
+  g_assert (!_hits (window, pointer, 0.f, 0.25f));
+  g_assert (_hits (window, pointer, 0.f, -0.25f));
+
+  g_object_unref (pointer);
+  xrd_window_close (window);
+  g_object_unref (headless);
+}
+
+int
+main ()
+{
+  _test_downsample ();
+  _test_pointer ();
+  return 0;
+}
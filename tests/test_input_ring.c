@@ -0,0 +1,123 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <glib.h>
+
+#include "xrd-input-ring.h"
+
+#define EVENTS 100000
+
+static gpointer
+_produce (gpointer data)
+{
+  XrdInputRing *ring = data;
+
+  for (guint64 i = 0; i < EVENTS; i++)
+    {
+      XrdInputRingEvent event = {
+        .action = XRD_INPUT_TRACE_GRAB_WINDOW,
+        .event.digital = {
+          .controller_handle = i,
+          .state = (i % 2) == 0,
+          .changed = TRUE,
+        },
+      };
+      while (!xrd_input_ring_push (ring, &event))
+        g_thread_yield ();
+    }
+
+  return NULL;
+}
+
+static void
+_test_full ()
+{
+  XrdInputRing *ring = xrd_input_ring_new (3);
+
+  XrdInputRingEvent event = { .action = XRD_INPUT_TRACE_MENU };
+  for (guint i = 0; i < 4; i++)
+    g_assert (xrd_input_ring_push (ring, &event));
+  g_assert (!xrd_input_ring_push (ring, &event));
+
+  for (guint i = 0; i < 4; i++)
+    g_assert (xrd_input_ring_pop (ring, &event));
+  g_assert (!xrd_input_ring_pop (ring, &event));
+
+  g_object_unref (ring);
+}
+
+/* Poses never fill the ring, only the latest per controller is kept */
+static void
+_test_poses ()
+{
+  XrdInputRing *ring = xrd_input_ring_new (2);
+
+  for (guint64 i = 0; i < 10; i++)
+    {
+      XrdInputRingEvent event = {
+        .action = XRD_INPUT_TRACE_HAND_POSE,
+        .event.pose.controller_handle = i % 2,
+      };
+      graphene_point3d_t position = { .x = (float) i, .y = 0.f, .z = 0.f };
+      graphene_matrix_init_translate (&event.event.pose.pose, &position);
+      g_assert (xrd_input_ring_push (ring, &event));
+    }
+
+  XrdInputRingEvent event = { .action = XRD_INPUT_TRACE_MENU };
+  g_assert (xrd_input_ring_push (ring, &event));
+
+  XrdInputRingEvent poses[4];
+  g_assert_cmpuint (xrd_input_ring_take_poses (ring, poses, 4), ==, 2);
+  for (guint i = 0; i < 2; i++)
+    {
+      OpenVRPoseEvent *pose = &poses[i].event.pose;
+      g_assert_cmpfloat (graphene_matrix_get_x_translation (&pose->pose), ==,
+                         8 + pose->controller_handle);
+    }
+  g_assert_cmpuint (xrd_input_ring_take_poses (ring, poses, 4), ==, 0);
+
+  g_assert (xrd_input_ring_pop (ring, &event));
+  g_assert_cmpint (event.action, ==, XRD_INPUT_TRACE_MENU);
+  g_assert (!xrd_input_ring_pop (ring, &event));
+
+  g_object_unref (ring);
+}
+
+static void
+_test_threaded ()
+{
+  XrdInputRing *ring = xrd_input_ring_new (64);
+  GThread *producer = g_thread_new ("producer", _produce, ring);
+
+  guint64 expected = 0;
+  while (expected < EVENTS)
+    {
+      XrdInputRingEvent event;
+      if (!xrd_input_ring_pop (ring, &event))
+        {
+          g_thread_yield ();
+          continue;
+        }
+      g_assert_cmpint (event.action, ==, XRD_INPUT_TRACE_GRAB_WINDOW);
+      g_assert_cmpuint (event.event.digital.controller_handle, ==, expected);
+      g_assert (event.event.digital.state == ((expected % 2) == 0));
+      expected++;
+    }
+
+  g_thread_join (producer);
+
+  g_object_unref (ring);
+}
+
+int
+main ()
+{
+  _test_full ();
+  _test_poses ();
+  _test_threaded ();
+  return 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "xrd-input-trace.h"
+
+#define POLLS 100
+
+typedef struct {
+  GMainLoop *loop;
+  guint poses;
+  guint grabs;
+  guint scrolls;
+  guint polls;
+} Example;
+
+static void
+_pose_cb (XrdInputTrace *trace, OpenVRPoseEvent *event, Example *self)
+{
+  (void) trace;
+  g_assert (event->valid && event->active && event->device_connected);
+  g_assert_cmpuint (event->controller_handle, ==, 1);
+
+  graphene_point3d_t expected = {
+    .x = 0.f, .y = 1.f, .z = -(float) self->poses
+  };
+  graphene_matrix_t expected_pose;
+  graphene_matrix_init_translate (&expected_pose, &expected);
+  g_assert (graphene_matrix_equal (&event->pose, &expected_pose));
+
+  self->poses++;
+  g_free (event);
+}
+
+static void
+_grab_cb (XrdInputTrace *trace, OpenVRDigitalEvent *event, Example *self)
+{
+  (void) trace;
+  g_assert (event->changed);
+  g_assert (event->state == (self->grabs % 2 == 0));
+  self->grabs++;
+  g_free (event);
+}
+
+static void
+_scroll_cb (XrdInputTrace *trace, OpenVRAnalogEvent *event, Example *self)
+{
+  (void) trace;
+  g_assert_cmpfloat (graphene_vec3_get_y (&event->delta), ==, 0.25f);
+  self->scrolls++;
+  g_free (event);
+}
+
+static void
+_poll_cb (XrdInputTrace *trace, Example *self)
+{
+  (void) trace;
+  /* one poll per main loop iteration when playing at maximum speed */
+  g_assert_cmpuint (self->poses, ==, self->polls + 1);
+  self->polls++;
+}
+
+static void
+_finished_cb (XrdInputTrace *trace, Example *self)
+{
+  (void) trace;
+  g_main_loop_quit (self->loop);
+}
+
+static XrdInputTrace *
+_record (void)
+{
+  XrdInputTrace *trace = xrd_input_trace_new ();
+  xrd_input_trace_start_recording (trace);
+
+  for (int i = 0; i < POLLS; i++)
+    {
+      OpenVRPoseEvent pose = {
+        .controller_handle = 1,
+        .valid = TRUE,
+        .active = TRUE,
+        .device_connected = TRUE,
+      };
+      graphene_point3d_t position = { .x = 0.f, .y = 1.f, .z = (float) -i };
+      graphene_matrix_init_translate (&pose.pose, &position);
+      xrd_input_trace_record_pose (trace, XRD_INPUT_TRACE_HAND_POSE, &pose);
+
+      if (i % 10 == 0)
+        {
+          OpenVRDigitalEvent grab = {
+            .controller_handle = 1,
+            .state = (i % 20 == 0),
+            .changed = TRUE,
+          };
+          xrd_input_trace_record_digital (trace, XRD_INPUT_TRACE_GRAB_WINDOW,
+                                          &grab);
+        }
+
+      OpenVRAnalogEvent scroll = { .controller_handle = 1 };
+      graphene_vec3_init (&scroll.state, 0.f, 0.5f, 0.f);
+      graphene_vec3_init (&scroll.delta, 0.f, 0.25f, 0.f);
+      xrd_input_trace_record_analog (trace, XRD_INPUT_TRACE_SCROLL, &scroll);
+
+      xrd_input_trace_record_poll (trace);
+    }
+
+  xrd_input_trace_stop_recording (trace);
+
+  /* not recorded after stopping */
+  xrd_input_trace_record_poll (trace);
+
+  return trace;
+}
+
+static void
+_test_input_trace ()
+{
+  XrdInputTrace *recorded = _record ();
+  g_assert_cmpuint (xrd_input_trace_get_n_records (recorded), ==,
+                    POLLS * 3 + POLLS / 10);
+
+  gchar *path = g_build_filename (g_get_tmp_dir (),
+                                  "xrdesktop-test-input-trace.bin", NULL);
+  g_assert (xrd_input_trace_save (recorded, path));
+
+  XrdInputTrace *trace = xrd_input_trace_new_from_file (path);
+  g_assert (trace);
+  g_assert_cmpuint (xrd_input_trace_get_n_records (trace), ==,
+                    xrd_input_trace_get_n_records (recorded));
+  g_assert_cmpint (xrd_input_trace_get_duration (trace), ==,
+                   xrd_input_trace_get_duration (recorded));
+
+  g_unlink (path);
+  g_free (path);
+  g_object_unref (recorded);
+
+  Example self = {
+    .loop = g_main_loop_new (NULL, FALSE),
+  };
+
+  g_signal_connect (trace, "pose-event::hand-pose",
+                    (GCallback) _pose_cb, &self);
+  g_signal_connect (trace, "digital-event::grab-window",
+                    (GCallback) _grab_cb, &self);
+  g_signal_connect (trace, "analog-event::scroll",
+                    (GCallback) _scroll_cb, &self);
+  g_signal_connect (trace, "poll-event",
+                    (GCallback) _poll_cb, &self);
+  g_signal_connect (trace, "finished-event",
+                    (GCallback) _finished_cb, &self);
+
+  xrd_input_trace_play (trace, FALSE);
+  g_main_loop_run (self.loop);
+
+  g_assert (!xrd_input_trace_is_playing (trace));
+  g_assert_cmpuint (self.poses, ==, POLLS);
+  g_assert_cmpuint (self.polls, ==, POLLS);
+  g_assert_cmpuint (self.scrolls, ==, POLLS);
+  g_assert_cmpuint (self.grabs, ==, POLLS / 10);
+
+  g_main_loop_unref (self.loop);
+  g_object_unref (trace);
+}
+
+int
+main ()
+{
+  _test_input_trace ();
+  return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <glib.h>
+#include <math.h>
+
+#include "xrd-pose-filter.h"
+#include "graphene-ext.h"
+
+#define STEP_US 11111
+
+static void
+_pose_at (float x, float yaw_deg, graphene_matrix_t *pose)
+{
+  graphene_matrix_init_rotate (pose, yaw_deg, graphene_vec3_y_axis ());
+  graphene_point3d_t position = { x, 1.0f, -0.5f };
+  graphene_matrix_translate (pose, &position);
+}
+
+static void
+_test_jitter ()
+{
+  XrdPoseFilter *filter = xrd_pose_filter_new ();
+  XrdPoseFilterSettings settings = {
+    .min_cutoff = 1.0,
+    .beta = 0.5,
+    .prediction_ms = 0.0,
+  };
+
+  float max_raw = 0, max_filtered = 0;
+  for (gint i = 0; i < 500; i++)
+    {
+      float jitter = (i % 2 == 0) ? 0.002f : -0.002f;
+      graphene_matrix_t pose;
+      _pose_at (jitter, 0, &pose);
+
+      graphene_matrix_t filtered;
+      xrd_pose_filter_apply (filter, &settings, (gint64) i * STEP_US,
+                             &pose, &filtered);
+
+      if (i < 100)
+        continue;
+
+      graphene_vec3_t position;
+      graphene_ext_matrix_get_translation_vec3 (&filtered, &position);
+      max_raw = fmaxf (max_raw, fabsf (jitter));
+      max_filtered = fmaxf (max_filtered, fabsf (graphene_vec3_get_x (&position)));
+    }
+
+  g_assert_cmpfloat (max_filtered, <, max_raw * 0.5f);
+
+  g_object_unref (filter);
+}
+
+static void
+_test_prediction ()
+{
+  XrdPoseFilter *filter = xrd_pose_filter_new ();
+  /* barely smooth, so only the prediction moves the pose */
+  XrdPoseFilterSettings settings = {
+    .min_cutoff = 1000.0,
+    .beta = 0.0,
+    .prediction_ms = 20.0,
+  };
+
+  /* 0.5 m/s and 30 degrees/s */
+  graphene_matrix_t filtered;
+  gint i;
+  for (i = 0; i < 300; i++)
+    {
+      float t = (float) i * STEP_US / G_USEC_PER_SEC;
+      graphene_matrix_t pose;
+      _pose_at (0.5f * t, 30.0f * t, &pose);
+      xrd_pose_filter_apply (filter, &settings, (gint64) i * STEP_US,
+                             &pose, &filtered);
+    }
+
+  float t = (float) (i - 1) * STEP_US / G_USEC_PER_SEC + 0.02f;
+  graphene_matrix_t expected;
+  _pose_at (0.5f * t, 30.0f * t, &expected);
+
+  graphene_vec3_t a, b;
+  graphene_ext_matrix_get_translation_vec3 (&filtered, &a);
+  graphene_ext_matrix_get_translation_vec3 (&expected, &b);
+  g_assert_cmpfloat (fabsf (graphene_vec3_get_x (&a) - graphene_vec3_get_x (&b)),
+                     <, 0.002f);
+
+  graphene_quaternion_t qa, qb;
+  graphene_ext_matrix_get_rotation_quaternion (&filtered, &qa);
+  graphene_ext_matrix_get_rotation_quaternion (&expected, &qb);
+  g_assert_cmpfloat (fabsf (graphene_quaternion_dot (&qa, &qb)), >, 0.999995f);
+
+  g_object_unref (filter);
+}
+
+/* Replayed traces restart their time, the filter must not get stuck */
+static void
+_test_time_reset ()
+{
+  XrdPoseFilter *filter = xrd_pose_filter_new ();
+  XrdPoseFilterSettings settings = {
+    .min_cutoff = 1.0,
+    .beta = 0.5,
+    .prediction_ms = 0.0,
+  };
+
+  graphene_matrix_t pose, filtered;
+  _pose_at (0.0f, 0, &pose);
+  xrd_pose_filter_apply (filter, &settings, 10 * G_USEC_PER_SEC,
+                         &pose, &filtered);
+
+  _pose_at (1.0f, 0, &pose);
+  xrd_pose_filter_apply (filter, &settings, 0, &pose, &filtered);
+
+  graphene_vec3_t position;
+  graphene_ext_matrix_get_translation_vec3 (&filtered, &position);
+  g_assert_cmpfloat (graphene_vec3_get_x (&position), ==, 1.0f);
+
+  g_object_unref (filter);
+}
+
+int
+main ()
+{
+  _test_jitter ();
+  _test_prediction ();
+  _test_time_reset ();
+  return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <glib.h>
+
+#include "xrd-scene-draw-order.h"
+#include "xrd-scene-object.h"
+#include "xrd-scene-renderer.h"
+#include "xrd-scene-window.h"
+
+#define N_OBJECTS 8
+
+static void
+_set_depth (XrdSceneObject *object, float z)
+{
+  graphene_point3d_t position;
+  graphene_point3d_init (&position, 0, 0, z);
+  xrd_scene_object_set_position (object, &position);
+}
+
+static void
+_test_sort ()
+{
+  XrdSceneObject *objects[N_OBJECTS];
+  GSList *list = NULL;
+
+  /* inserted far to near */
+  for (int i = 0; i < N_OBJECTS; i++)
+    {
+      objects[i] = xrd_scene_object_new ();
+      _set_depth (objects[i], -10.0f + (float) i);
+      list = g_slist_append (list, objects[i]);
+    }
+
+  graphene_matrix_t view;
+  graphene_matrix_init_identity (&view);
+
+  XrdSceneDrawOrder *front_to_back =
+    xrd_scene_draw_order_new (XRD_SCENE_DRAW_ORDER_FRONT_TO_BACK);
+  XrdSceneDrawOrder *back_to_front =
+    xrd_scene_draw_order_new (XRD_SCENE_DRAW_ORDER_BACK_TO_FRONT);
+
+  GPtrArray *sorted = xrd_scene_draw_order_update (front_to_back, list, &view);
+  g_assert_cmpuint (sorted->len, ==, N_OBJECTS);
+  for (int i = 0; i < N_OBJECTS; i++)
+    g_assert (sorted->pdata[i] == objects[N_OBJECTS - 1 - i]);
+
+  sorted = xrd_scene_draw_order_update (back_to_front, list, &view);
+  for (int i = 0; i < N_OBJECTS; i++)
+    g_assert (sorted->pdata[i] == objects[i]);
+
+  /* nothing moved, the previous order holds */
+  xrd_scene_draw_order_update (front_to_back, list, &view);
+  g_assert_cmpuint (xrd_scene_draw_order_get_moves (front_to_back), ==, 0);
+
+  /* the farthest object comes to the front */
+  _set_depth (objects[0], 0.0f);
+  sorted = xrd_scene_draw_order_update (front_to_back, list, &view);
+  g_assert (sorted->pdata[0] == objects[0]);
+  g_assert_cmpuint (xrd_scene_draw_order_get_moves (front_to_back), ==, 1);
+
+  /* removing an object resorts the rest */
+  list = g_slist_remove (list, objects[0]);
+  sorted = xrd_scene_draw_order_update (front_to_back, list, &view);
+  g_assert_cmpuint (sorted->len, ==, N_OBJECTS - 1);
+  g_assert (sorted->pdata[0] == objects[N_OBJECTS - 1]);
+
+  g_slist_free (list);
+  g_object_unref (front_to_back);
+  g_object_unref (back_to_front);
+  for (int i = 0; i < N_OBJECTS; i++)
+    g_object_unref (objects[i]);
+}
+
+typedef struct {
+  GPtrArray *order;
+  graphene_matrix_t vp;
+} SampleTest;
+
+static void
+_render_eye_cb (uint32_t         eye,
+                VkCommandBuffer  cmd_buffer,
+                VkPipelineLayout pipeline_layout,
+                VkPipeline      *pipelines,
+                gpointer         data)
+{
+  SampleTest *test = data;
+  for (guint i = 0; i < test->order->len; i++)
+    xrd_scene_window_draw (XRD_SCENE_WINDOW (test->order->pdata[i]), eye,
+                           pipelines[PIPELINE_WINDOWS], pipeline_layout,
+                           cmd_buffer, &test->vp);
+}
+
+static guint64
+_count_samples (XrdSceneRenderer *renderer, SampleTest *test, GPtrArray *order)
+{
+  test->order = order;
+  if (!xrd_scene_renderer_draw (renderer))
+    return 0;
+  return xrd_scene_renderer_get_samples_passed (renderer);
+}
+
+/*
+ * Stacked windows that cover each other. Drawn back to front, every window
+ * passes the depth test, drawn front to back only the nearest one does.
+ */
+static void
+_test_samples ()
+{
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  if (!xrd_scene_renderer_init_vulkan_simple (renderer))
+    {
+      g_print ("No Vulkan device, not counting samples.\n");
+      xrd_scene_renderer_destroy_instance ();
+      return;
+    }
+
+  GulkanClient *gc = GULKAN_CLIENT (renderer);
+
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 64, 64);
+  gdk_pixbuf_fill (pixbuf, 0xffffffff);
+  GulkanTexture *texture =
+    gulkan_client_texture_new_from_pixbuf (gc, pixbuf,
+                                           VK_FORMAT_R8G8B8A8_UNORM,
+                                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                           false);
+  g_object_unref (pixbuf);
+
+  GSList *windows = NULL;
+  for (int i = 0; i < N_OBJECTS; i++)
+    {
+      XrdSceneWindow *window =
+        xrd_scene_window_new_from_meters ("stacked", 1.0f, 1.0f, 64.0f);
+      xrd_scene_window_initialize (window);
+      xrd_window_submit_texture (XRD_WINDOW (window), gc, texture);
+
+      graphene_point3d_t position;
+      graphene_point3d_init (&position, 0, 0, -1.0f - 0.25f * (float) i);
+      graphene_matrix_t transform;
+      graphene_matrix_init_translate (&transform, &position);
+      xrd_window_set_transformation (XRD_WINDOW (window), &transform);
+
+      windows = g_slist_append (windows, window);
+    }
+
+  SampleTest test;
+  graphene_matrix_init_perspective (&test.vp, 90.0f, 1.0f, 0.1f, 100.0f);
+  xrd_scene_renderer_set_render_cb (renderer, _render_eye_cb, &test);
+  xrd_scene_renderer_set_count_samples (renderer, TRUE);
+
+  graphene_matrix_t view;
+  graphene_matrix_init_identity (&view);
+
+  XrdSceneDrawOrder *back_to_front =
+    xrd_scene_draw_order_new (XRD_SCENE_DRAW_ORDER_BACK_TO_FRONT);
+  XrdSceneDrawOrder *front_to_back =
+    xrd_scene_draw_order_new (XRD_SCENE_DRAW_ORDER_FRONT_TO_BACK);
+
+  guint64 unsorted_samples =
+    _count_samples (renderer, &test,
+                    xrd_scene_draw_order_update (back_to_front,
+                                                 windows, &view));
+  guint64 sorted_samples =
+    _count_samples (renderer, &test,
+                    xrd_scene_draw_order_update (front_to_back,
+                                                 windows, &view));
+
+  g_print ("Samples passing the depth test: back to front %" G_GUINT64_FORMAT
+           ", front to back %" G_GUINT64_FORMAT "\n",
+           unsorted_samples, sorted_samples);
+  g_assert_cmpuint (sorted_samples, <=, unsorted_samples);
+
+  xrd_scene_renderer_set_render_cb (renderer, NULL, NULL);
+
+  g_object_unref (back_to_front);
+  g_object_unref (front_to_back);
+  g_slist_free_full (windows, g_object_unref);
+  g_object_unref (texture);
+  xrd_scene_renderer_destroy_instance ();
+}
+
+int
+main ()
+{
+  _test_sort ();
+  _test_samples ();
+  return 0;
+}
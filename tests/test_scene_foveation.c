@@ -0,0 +1,110 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <glib.h>
+
+#include "xrd-scene-renderer.h"
+#include "xrd-scene-window.h"
+
+typedef struct {
+  XrdSceneWindow *window;
+  graphene_matrix_t vp;
+} FoveationTest;
+
+static void
+_render_eye_cb (uint32_t         eye,
+                VkCommandBuffer  cmd_buffer,
+                VkPipelineLayout pipeline_layout,
+                VkPipeline      *pipelines,
+                gpointer         data)
+{
+  FoveationTest *test = data;
+  xrd_scene_window_draw (test->window, eye, pipelines[PIPELINE_WINDOWS],
+                         pipeline_layout, cmd_buffer, &test->vp);
+}
+
+static guint64
+_draw (XrdSceneRenderer *renderer)
+{
+  g_assert (xrd_scene_renderer_draw (renderer));
+  return xrd_scene_renderer_get_samples_passed (renderer);
+}
+
+/*
+ * A window filling the view, drawn with and without foveation, with and
+ * without multisampling, so the composite resolves as well as copies.
+ * Samples are counted in the periphery pass, which has a quarter of the
+ * pixels.
+ */
+static void
+_test_foveation ()
+{
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  if (!xrd_scene_renderer_init_vulkan_simple (renderer))
+    {
+      g_print ("No Vulkan device, not testing foveation.\n");
+      xrd_scene_renderer_destroy_instance ();
+      return;
+    }
+
+  GulkanClient *gc = GULKAN_CLIENT (renderer);
+
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 64, 64);
+  gdk_pixbuf_fill (pixbuf, 0xffffffff);
+  GulkanTexture *texture =
+    gulkan_client_texture_new_from_pixbuf (gc, pixbuf,
+                                           VK_FORMAT_R8G8B8A8_UNORM,
+                                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                           false);
+  g_object_unref (pixbuf);
+
+  FoveationTest test;
+  test.window = xrd_scene_window_new_from_meters ("fovea", 4.0f, 4.0f, 16.0f);
+  xrd_scene_window_initialize (test.window);
+  xrd_window_submit_texture (XRD_WINDOW (test.window), gc, texture);
+
+  graphene_point3d_t position;
+  graphene_point3d_init (&position, 0, 0, -1.0f);
+  graphene_matrix_t transform;
+  graphene_matrix_init_translate (&transform, &position);
+  xrd_window_set_transformation (XRD_WINDOW (test.window), &transform);
+
+  graphene_matrix_init_perspective (&test.vp, 90.0f, 1.0f, 0.1f, 100.0f);
+  xrd_scene_renderer_set_render_cb (renderer, _render_eye_cb, &test);
+  xrd_scene_renderer_set_count_samples (renderer, TRUE);
+
+  uint32_t samples[] = { 4, 1 };
+  for (guint i = 0; i < G_N_ELEMENTS (samples); i++)
+    {
+      g_assert (xrd_scene_renderer_set_msaa_samples (renderer, samples[i]));
+
+      g_assert (xrd_scene_renderer_set_foveated (renderer, FALSE));
+      guint64 full_samples = _draw (renderer);
+
+      g_assert (xrd_scene_renderer_set_foveated (renderer, TRUE));
+      guint64 foveated_samples = _draw (renderer);
+
+      g_print ("Samples with %u MSAA samples: full %" G_GUINT64_FORMAT
+               ", foveated periphery %" G_GUINT64_FORMAT "\n",
+               xrd_scene_renderer_get_msaa_samples (renderer),
+               full_samples, foveated_samples);
+      g_assert_cmpuint (foveated_samples, <, full_samples);
+    }
+
+  xrd_scene_renderer_set_render_cb (renderer, NULL, NULL);
+
+  g_object_unref (test.window);
+  g_object_unref (texture);
+  xrd_scene_renderer_destroy_instance ();
+}
+
+int
+main ()
+{
+  _test_foveation ();
+  return 0;
+}
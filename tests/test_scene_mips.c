@@ -0,0 +1,145 @@
+/*
+ * xrdesktop
+ * Copyright 2019 Collabora Ltd.
+ * Author: Christoph Haag <christoph.haag@collabora.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <glib.h>
+
+#include "xrd-scene-renderer.h"
+#include "xrd-scene-window.h"
+
+typedef struct {
+  XrdSceneWindow *window;
+  graphene_matrix_t vp;
+} MipsTest;
+
+static void
+_render_eye_cb (uint32_t         eye,
+                VkCommandBuffer  cmd_buffer,
+                VkPipelineLayout pipeline_layout,
+                VkPipeline      *pipelines,
+                gpointer         data)
+{
+  MipsTest *test = data;
+  xrd_scene_window_draw (test->window, eye, pipelines[PIPELINE_WINDOWS],
+                         pipeline_layout, cmd_buffer, &test->vp);
+}
+
+/* Like the structure key of XrdSceneClient, for a single window */
+static guint64
+_structure_key_cb (gpointer data)
+{
+  MipsTest *test = data;
+  guint64 key = xrd_scene_object_get_structure_serial ();
+  key = key * 1099511628211ull;
+  key ^= xrd_scene_window_get_mip_damage_serial (test->window);
+  return key;
+}
+
+static void
+_record_mips_cb (VkCommandBuffer cmd_buffer, gpointer data)
+{
+  MipsTest *test = data;
+  xrd_scene_window_record_mips (test->window, cmd_buffer);
+}
+
+static guint64
+_draw_recorded (XrdSceneRenderer *renderer)
+{
+  g_assert (xrd_scene_renderer_draw (renderer));
+  guint64 recorded;
+  xrd_scene_renderer_get_command_stats (renderer, &recorded, NULL);
+  return recorded;
+}
+
+/*
+ * A minified window damaged on two frames in a row, with reused command
+ * buffers. Each damaged frame has to be recorded with its own blits, a
+ * resubmitted frame would blit the previous damage again and leave the
+ * new damage pending.
+ */
+static void
+_test_damage_reuse ()
+{
+  XrdSceneRenderer *renderer = xrd_scene_renderer_get_instance ();
+  if (!xrd_scene_renderer_init_vulkan_simple (renderer))
+    {
+      g_print ("No Vulkan device, not testing mip damage.\n");
+      xrd_scene_renderer_destroy_instance ();
+      return;
+    }
+
+  GulkanClient *gc = GULKAN_CLIENT (renderer);
+
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 256, 256);
+  gdk_pixbuf_fill (pixbuf, 0xffffffff);
+  GulkanTexture *texture =
+    gulkan_client_texture_new_from_pixbuf (gc, pixbuf,
+                                           VK_FORMAT_R8G8B8A8_UNORM,
+                                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                           false);
+  g_object_unref (pixbuf);
+
+  MipsTest test;
+  test.window = xrd_scene_window_new_from_meters ("mips", 1.0f, 1.0f, 256.0f);
+  xrd_scene_window_initialize (test.window);
+  xrd_window_submit_texture (XRD_WINDOW (test.window), gc, texture);
+
+  graphene_point3d_t position;
+  graphene_point3d_init (&position, 0, 0, -10.0f);
+  graphene_matrix_t transform;
+  graphene_matrix_init_translate (&transform, &position);
+  xrd_window_set_transformation (XRD_WINDOW (test.window), &transform);
+
+  graphene_matrix_init_perspective (&test.vp, 90.0f, 1.0f, 0.1f, 100.0f);
+  xrd_scene_renderer_set_render_cb (renderer, _render_eye_cb, &test);
+  xrd_scene_renderer_set_structure_key_cb (renderer, _structure_key_cb, &test);
+  xrd_scene_renderer_set_record_transfers_cb (renderer, _record_mips_cb,
+                                              &test);
+  xrd_scene_renderer_set_reuse_commands (renderer, TRUE);
+
+  /* Allocating the chain damages all of it */
+  xrd_scene_window_set_minified (test.window, TRUE);
+  g_assert (xrd_scene_window_has_mip_damage (test.window));
+
+  guint64 recorded = _draw_recorded (renderer);
+  g_assert (!xrd_scene_window_has_mip_damage (test.window));
+
+  /* Nothing changed */
+  g_assert_cmpuint (_draw_recorded (renderer), ==, recorded);
+
+  VkRect2D damage[] = {
+    { .offset = { 0, 0 }, .extent = { 16, 16 } },
+    { .offset = { 128, 128 }, .extent = { 32, 32 } },
+  };
+  for (guint i = 0; i < G_N_ELEMENTS (damage); i++)
+    {
+      xrd_scene_window_add_damage (test.window, &damage[i]);
+      g_assert (xrd_scene_window_has_mip_damage (test.window));
+
+      g_assert_cmpuint (_draw_recorded (renderer), ==, ++recorded);
+      g_assert (!xrd_scene_window_has_mip_damage (test.window));
+    }
+
+  /* Recorded without blits once, then reused again */
+  g_assert_cmpuint (_draw_recorded (renderer), ==, ++recorded);
+  g_assert_cmpuint (_draw_recorded (renderer), ==, recorded);
+
+  xrd_scene_renderer_set_reuse_commands (renderer, FALSE);
+  xrd_scene_renderer_set_record_transfers_cb (renderer, NULL, NULL);
+  xrd_scene_renderer_set_structure_key_cb (renderer, NULL, NULL);
+  xrd_scene_renderer_set_render_cb (renderer, NULL, NULL);
+
+  g_object_unref (test.window);
+  g_object_unref (texture);
+  xrd_scene_renderer_destroy_instance ();
+}
+
+int
+main ()
+{
+  _test_damage_reuse ();
+  return 0;
+}